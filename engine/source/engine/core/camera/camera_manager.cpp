@@ -24,6 +24,8 @@ void Camera::Destroy() noexcept
     m_matViewProjection = M3D_MAT4_IDENTITY;
     m_matProjection     = M3D_MAT4_IDENTITY;
     m_matWCS            = M3D_MAT4_IDENTITY;
+
+    m_frustum = {};
     
     m_rotation = M3D_QUAT_IDENTITY;
     m_position = M3D_ZEROF3;
@@ -311,6 +313,7 @@ void Camera::RecalcViewMatrix() noexcept
 void Camera::RecalcViewProjMatrix() noexcept
 {
     m_matViewProjection = m_matProjection * m_matWCS;
+    m_frustum.ExtractPlanes(m_matViewProjection);
 }
 
 
@@ -355,6 +358,7 @@ void CameraManager::UnregisterCamera(Camera* pCam) noexcept
 
 void CameraManager::Update(float dt) noexcept
 {
+    // There are at most MAX_CAM_COUNT cameras, job scheduling would cost more than the update itself
     for (Camera& cam : m_camerasStorage) {
         cam.Update(dt);
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/event_system/event_dispatcher.h"
+#include "core/culling/frustum_culling.h"
 
 #include "utils/data_structures/strid.h"
 #include "utils/data_structures/base_id.h"
@@ -72,6 +73,9 @@ public:
     const glm::mat4x4& GetProjectionMatrix() const noexcept { return m_matProjection; }
     const glm::mat4x4& GetViewProjectionMatrix() const noexcept { return m_matViewProjection; }
 
+    // Updated together with the view projection matrix
+    const Frustum& GetFrustum() const noexcept { return m_frustum; }
+
     bool IsRegistered() const noexcept { return m_ID.IsValid(); }
     bool IsPerspProj() const noexcept { return !IsOrthoProj(); }
     bool IsOrthoProj() const noexcept { return m_flags.test(CameraFlagBits::FLAG_IS_ORTHO_PROJ); }
@@ -111,6 +115,8 @@ private:
     glm::mat4x4 m_matProjection     = M3D_MAT4_IDENTITY;
     glm::mat4x4 m_matWCS            = M3D_MAT4_IDENTITY;
 
+    Frustum m_frustum = {};
+
     glm::quat m_rotation = M3D_QUAT_IDENTITY;
     glm::vec3 m_position = M3D_ZEROF3;
 
@@ -0,0 +1,581 @@
+#include "pch.h"
+#include "frustum_culling.h"
+
+#include "core/job_system/job_system.h"
+
+#include "utils/debug/assertion.h"
+#include "utils/math/common_math.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+  #define CULL_X86
+#endif
+
+#if defined(CULL_X86)
+  #include <immintrin.h>
+#endif
+
+#if defined(CULL_X86) && (defined(__GNUC__) || defined(__clang__))
+  #define CULL_TARGET_SSE2 __attribute__((target("sse2")))
+  #define CULL_TARGET_AVX  __attribute__((target("avx")))
+#else
+  #define CULL_TARGET_SSE2
+  #define CULL_TARGET_AVX
+#endif
+
+
+// Negative radius and extents of padding volumes. Fails any plane test and still can't overflow to infinity in the kernels
+static constexpr float PADDING_VOLUME_SIZE = -0.25f * std::numeric_limits<float>::max();
+
+
+// Writes every lane index and advances the count only for visible lanes, so there are no branches on the mask.
+// Writes never pass the group itself, since the visible count can't exceed the number of already tested volumes
+static inline uint32_t WriteVisibleIndices(uint32_t* pOutIndices, uint32_t visibleCount, uint32_t firstIdx, uint32_t mask, uint32_t lanesCount) noexcept
+{
+    for (uint32_t lane = 0; lane < lanesCount; ++lane) {
+        pOutIndices[visibleCount] = firstIdx + lane;
+        visibleCount += (mask >> lane) & 1u;
+    }
+
+    return visibleCount;
+}
+
+
+static uint32_t CullSpheresScalar(const Frustum& frustum, const void* pVolumes, uint32_t begin, uint32_t end, uint32_t* pOutIndices) noexcept
+{
+    const BoundingSpheresSoA& spheres = *static_cast<const BoundingSpheresSoA*>(pVolumes);
+
+    const float* pX = spheres.GetCentersX();
+    const float* pY = spheres.GetCentersY();
+    const float* pZ = spheres.GetCentersZ();
+    const float* pR = spheres.GetRadii();
+
+    uint32_t visibleCount = 0;
+
+    for (uint32_t i = begin; i < end; ++i) {
+        uint32_t isVisible = 1;
+
+        for (const glm::vec4& plane : frustum.planes) {
+            const float dist = plane.x * pX[i] + plane.y * pY[i] + plane.z * pZ[i] + plane.w;
+            isVisible &= dist >= -pR[i] ? 1u : 0u;
+        }
+
+        visibleCount = WriteVisibleIndices(pOutIndices, visibleCount, i, isVisible, 1);
+    }
+
+    return visibleCount;
+}
+
+
+static uint32_t CullAABBsScalar(const Frustum& frustum, const void* pVolumes, uint32_t begin, uint32_t end, uint32_t* pOutIndices) noexcept
+{
+    const BoundingAABBsSoA& aabbs = *static_cast<const BoundingAABBsSoA*>(pVolumes);
+
+    const float* pCX = aabbs.GetCentersX();
+    const float* pCY = aabbs.GetCentersY();
+    const float* pCZ = aabbs.GetCentersZ();
+    const float* pEX = aabbs.GetExtentsX();
+    const float* pEY = aabbs.GetExtentsY();
+    const float* pEZ = aabbs.GetExtentsZ();
+
+    uint32_t visibleCount = 0;
+
+    for (uint32_t i = begin; i < end; ++i) {
+        uint32_t isVisible = 1;
+
+        for (const glm::vec4& plane : frustum.planes) {
+            const float dist = plane.x * pCX[i] + plane.y * pCY[i] + plane.z * pCZ[i] + plane.w;
+            // Projection of the half extents onto the plane normal
+            const float radius = std::abs(plane.x) * pEX[i] + std::abs(plane.y) * pEY[i] + std::abs(plane.z) * pEZ[i];
+
+            isVisible &= dist >= -radius ? 1u : 0u;
+        }
+
+        visibleCount = WriteVisibleIndices(pOutIndices, visibleCount, i, isVisible, 1);
+    }
+
+    return visibleCount;
+}
+
+
+#if defined(CULL_X86)
+CULL_TARGET_SSE2 static uint32_t CullSpheresSSE2(const Frustum& frustum, const void* pVolumes, uint32_t begin, uint32_t end, uint32_t* pOutIndices) noexcept
+{
+    const BoundingSpheresSoA& spheres = *static_cast<const BoundingSpheresSoA*>(pVolumes);
+
+    __m128 planes[FRUSTUM_PLANE_COUNT][4];
+
+    for (uint32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+        }
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t visibleCount = 0;
+
+    for (uint32_t i = begin; i < end; i += 4) {
+        const __m128 x = _mm_loadu_ps(spheres.GetCentersX() + i);
+        const __m128 y = _mm_loadu_ps(spheres.GetCentersY() + i);
+        const __m128 z = _mm_loadu_ps(spheres.GetCentersZ() + i);
+        const __m128 negRadius = _mm_sub_ps(zero, _mm_loadu_ps(spheres.GetRadii() + i));
+
+        __m128 visible = _mm_cmpeq_ps(zero, zero);
+
+        for (uint32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+            __m128 dist = _mm_add_ps(_mm_mul_ps(x, planes[p][0]), planes[p][3]);
+            dist = _mm_add_ps(dist, _mm_mul_ps(y, planes[p][1]));
+            dist = _mm_add_ps(dist, _mm_mul_ps(z, planes[p][2]));
+
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(dist, negRadius));
+        }
+
+        visibleCount = WriteVisibleIndices(pOutIndices, visibleCount, i, static_cast<uint32_t>(_mm_movemask_ps(visible)), 4);
+    }
+
+    return visibleCount;
+}
+
+
+CULL_TARGET_SSE2 static uint32_t CullAABBsSSE2(const Frustum& frustum, const void* pVolumes, uint32_t begin, uint32_t end, uint32_t* pOutIndices) noexcept
+{
+    const BoundingAABBsSoA& aabbs = *static_cast<const BoundingAABBsSoA*>(pVolumes);
+
+    __m128 planes[FRUSTUM_PLANE_COUNT][4];
+    __m128 absNormals[FRUSTUM_PLANE_COUNT][3];
+
+    for (uint32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+        }
+
+        for (uint32_t c = 0; c < 3; ++c) {
+            absNormals[p][c] = _mm_set1_ps(std::abs(frustum.planes[p][c]));
+        }
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t visibleCount = 0;
+
+    for (uint32_t i = begin; i < end; i += 4) {
+        const __m128 cx = _mm_loadu_ps(aabbs.GetCentersX() + i);
+        const __m128 cy = _mm_loadu_ps(aabbs.GetCentersY() + i);
+        const __m128 cz = _mm_loadu_ps(aabbs.GetCentersZ() + i);
+        const __m128 ex = _mm_loadu_ps(aabbs.GetExtentsX() + i);
+        const __m128 ey = _mm_loadu_ps(aabbs.GetExtentsY() + i);
+        const __m128 ez = _mm_loadu_ps(aabbs.GetExtentsZ() + i);
+
+        __m128 visible = _mm_cmpeq_ps(zero, zero);
+
+        for (uint32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+            __m128 dist = _mm_add_ps(_mm_mul_ps(cx, planes[p][0]), planes[p][3]);
+            dist = _mm_add_ps(dist, _mm_mul_ps(cy, planes[p][1]));
+            dist = _mm_add_ps(dist, _mm_mul_ps(cz, planes[p][2]));
+
+            __m128 radius = _mm_mul_ps(ex, absNormals[p][0]);
+            radius = _mm_add_ps(radius, _mm_mul_ps(ey, absNormals[p][1]));
+            radius = _mm_add_ps(radius, _mm_mul_ps(ez, absNormals[p][2]));
+
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(dist, radius), zero));
+        }
+
+        visibleCount = WriteVisibleIndices(pOutIndices, visibleCount, i, static_cast<uint32_t>(_mm_movemask_ps(visible)), 4);
+    }
+
+    return visibleCount;
+}
+
+
+CULL_TARGET_AVX static uint32_t CullSpheresAVX(const Frustum& frustum, const void* pVolumes, uint32_t begin, uint32_t end, uint32_t* pOutIndices) noexcept
+{
+    const BoundingSpheresSoA& spheres = *static_cast<const BoundingSpheresSoA*>(pVolumes);
+
+    __m256 planes[FRUSTUM_PLANE_COUNT][4];
+
+    for (uint32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+        }
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+
+    uint32_t visibleCount = 0;
+
+    for (uint32_t i = begin; i < end; i += 8) {
+        const __m256 x = _mm256_loadu_ps(spheres.GetCentersX() + i);
+        const __m256 y = _mm256_loadu_ps(spheres.GetCentersY() + i);
+        const __m256 z = _mm256_loadu_ps(spheres.GetCentersZ() + i);
+        const __m256 negRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(spheres.GetRadii() + i));
+
+        __m256 visible = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+
+        for (uint32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+            __m256 dist = _mm256_add_ps(_mm256_mul_ps(x, planes[p][0]), planes[p][3]);
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(y, planes[p][1]));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(z, planes[p][2]));
+
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(dist, negRadius, _CMP_GE_OQ));
+        }
+
+        visibleCount = WriteVisibleIndices(pOutIndices, visibleCount, i, static_cast<uint32_t>(_mm256_movemask_ps(visible)), 8);
+    }
+
+    return visibleCount;
+}
+
+
+CULL_TARGET_AVX static uint32_t CullAABBsAVX(const Frustum& frustum, const void* pVolumes, uint32_t begin, uint32_t end, uint32_t* pOutIndices) noexcept
+{
+    const BoundingAABBsSoA& aabbs = *static_cast<const BoundingAABBsSoA*>(pVolumes);
+
+    __m256 planes[FRUSTUM_PLANE_COUNT][4];
+    __m256 absNormals[FRUSTUM_PLANE_COUNT][3];
+
+    for (uint32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+        }
+
+        for (uint32_t c = 0; c < 3; ++c) {
+            absNormals[p][c] = _mm256_set1_ps(std::abs(frustum.planes[p][c]));
+        }
+    }
+
+    const __m256 zero = _mm256_setzero_ps();
+
+    uint32_t visibleCount = 0;
+
+    for (uint32_t i = begin; i < end; i += 8) {
+        const __m256 cx = _mm256_loadu_ps(aabbs.GetCentersX() + i);
+        const __m256 cy = _mm256_loadu_ps(aabbs.GetCentersY() + i);
+        const __m256 cz = _mm256_loadu_ps(aabbs.GetCentersZ() + i);
+        const __m256 ex = _mm256_loadu_ps(aabbs.GetExtentsX() + i);
+        const __m256 ey = _mm256_loadu_ps(aabbs.GetExtentsY() + i);
+        const __m256 ez = _mm256_loadu_ps(aabbs.GetExtentsZ() + i);
+
+        __m256 visible = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+
+        for (uint32_t p = 0; p < FRUSTUM_PLANE_COUNT; ++p) {
+            __m256 dist = _mm256_add_ps(_mm256_mul_ps(cx, planes[p][0]), planes[p][3]);
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(cy, planes[p][1]));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(cz, planes[p][2]));
+
+            __m256 radius = _mm256_mul_ps(ex, absNormals[p][0]);
+            radius = _mm256_add_ps(radius, _mm256_mul_ps(ey, absNormals[p][1]));
+            radius = _mm256_add_ps(radius, _mm256_mul_ps(ez, absNormals[p][2]));
+
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(dist, radius), zero, _CMP_GE_OQ));
+        }
+
+        visibleCount = WriteVisibleIndices(pOutIndices, visibleCount, i, static_cast<uint32_t>(_mm256_movemask_ps(visible)), 8);
+    }
+
+    return visibleCount;
+}
+#endif
+
+
+template <typename ScalarFunc, typename SSE2Func, typename AVXFunc>
+static ScalarFunc SelectCullFunc(CPUSIMDLevel level, ScalarFunc scalarFunc, ENG_MAYBE_UNUSED SSE2Func sse2Func, ENG_MAYBE_UNUSED AVXFunc avxFunc) noexcept
+{
+#if defined(CULL_X86)
+    if (level >= CPUSIMDLevel::AVX) {
+        return avxFunc;
+    }
+
+    if (level >= CPUSIMDLevel::SSE2) {
+        return sse2Func;
+    }
+#endif
+
+    return scalarFunc;
+}
+
+
+void Frustum::ExtractPlanes(const glm::mat4x4& viewProjMatrix) noexcept
+{
+    // Gribb-Hartmann: clip space bounds are planes built from the matrix rows. glm matrices are column major
+    const glm::mat4x4 rows = glm::transpose(viewProjMatrix);
+
+    planes[FRUSTUM_PLANE_LEFT]   = rows[3] + rows[0];
+    planes[FRUSTUM_PLANE_RIGHT]  = rows[3] - rows[0];
+    planes[FRUSTUM_PLANE_BOTTOM] = rows[3] + rows[1];
+    planes[FRUSTUM_PLANE_TOP]    = rows[3] - rows[1];
+
+#if defined(GLM_FORCE_DEPTH_ZERO_TO_ONE)
+    const glm::vec4 minDepthPlane = rows[2];
+#else
+    const glm::vec4 minDepthPlane = rows[3] + rows[2];
+#endif
+    const glm::vec4 maxDepthPlane = rows[3] - rows[2];
+
+#if defined(ENG_USE_INVERTED_Z)
+    planes[FRUSTUM_PLANE_NEAR] = maxDepthPlane;
+    planes[FRUSTUM_PLANE_FAR]  = minDepthPlane;
+#else
+    planes[FRUSTUM_PLANE_NEAR] = minDepthPlane;
+    planes[FRUSTUM_PLANE_FAR]  = maxDepthPlane;
+#endif
+
+    for (glm::vec4& plane : planes) {
+        const float normalLength = glm::length(glm::vec3(plane));
+
+        // Degenerate planes come from not yet set up projections, they are left as is
+        if (normalLength > M3D_EPS) {
+            plane /= normalLength;
+        }
+    }
+}
+
+
+void BoundingSpheresSoA::Reserve(uint32_t count) noexcept
+{
+    const uint32_t paddedCount = amAlignUp(count, CULLING_SIMD_WIDTH);
+
+    m_centersX.reserve(paddedCount);
+    m_centersY.reserve(paddedCount);
+    m_centersZ.reserve(paddedCount);
+    m_radii.reserve(paddedCount);
+}
+
+
+void BoundingSpheresSoA::Resize(uint32_t count) noexcept
+{
+    m_count = count;
+    PadTo(amAlignUp(count, CULLING_SIMD_WIDTH));
+}
+
+
+void BoundingSpheresSoA::Clear() noexcept
+{
+    m_centersX.clear();
+    m_centersY.clear();
+    m_centersZ.clear();
+    m_radii.clear();
+
+    m_count = 0;
+}
+
+
+uint32_t BoundingSpheresSoA::Add(const glm::vec3& center, float radius) noexcept
+{
+    const uint32_t idx = m_count;
+
+    if (idx == GetPaddedCount()) {
+        PadTo(idx + CULLING_SIMD_WIDTH);
+    }
+
+    ++m_count;
+    Set(idx, center, radius);
+
+    return idx;
+}
+
+
+void BoundingSpheresSoA::Set(uint32_t idx, const glm::vec3& center, float radius) noexcept
+{
+    ENG_ASSERT(idx < m_count, "Bounding sphere index {} is out of range [0, {})", idx, m_count);
+    ENG_ASSERT(radius >= 0.f, "Negative bounding sphere radius: {}", radius);
+
+    m_centersX[idx] = center.x;
+    m_centersY[idx] = center.y;
+    m_centersZ[idx] = center.z;
+    m_radii[idx] = radius;
+}
+
+
+void BoundingSpheresSoA::PadTo(uint32_t paddedCount) noexcept
+{
+    m_centersX.resize(paddedCount);
+    m_centersY.resize(paddedCount);
+    m_centersZ.resize(paddedCount);
+    m_radii.resize(paddedCount);
+
+    for (uint32_t i = m_count; i < paddedCount; ++i) {
+        m_centersX[i] = 0.f;
+        m_centersY[i] = 0.f;
+        m_centersZ[i] = 0.f;
+        m_radii[i] = PADDING_VOLUME_SIZE;
+    }
+}
+
+
+void BoundingAABBsSoA::Reserve(uint32_t count) noexcept
+{
+    const uint32_t paddedCount = amAlignUp(count, CULLING_SIMD_WIDTH);
+
+    m_centersX.reserve(paddedCount);
+    m_centersY.reserve(paddedCount);
+    m_centersZ.reserve(paddedCount);
+    m_extentsX.reserve(paddedCount);
+    m_extentsY.reserve(paddedCount);
+    m_extentsZ.reserve(paddedCount);
+}
+
+
+void BoundingAABBsSoA::Resize(uint32_t count) noexcept
+{
+    m_count = count;
+    PadTo(amAlignUp(count, CULLING_SIMD_WIDTH));
+}
+
+
+void BoundingAABBsSoA::Clear() noexcept
+{
+    m_centersX.clear();
+    m_centersY.clear();
+    m_centersZ.clear();
+    m_extentsX.clear();
+    m_extentsY.clear();
+    m_extentsZ.clear();
+
+    m_count = 0;
+}
+
+
+uint32_t BoundingAABBsSoA::Add(const glm::vec3& min, const glm::vec3& max) noexcept
+{
+    const uint32_t idx = m_count;
+
+    if (idx == GetPaddedCount()) {
+        PadTo(idx + CULLING_SIMD_WIDTH);
+    }
+
+    ++m_count;
+    Set(idx, min, max);
+
+    return idx;
+}
+
+
+void BoundingAABBsSoA::Set(uint32_t idx, const glm::vec3& min, const glm::vec3& max) noexcept
+{
+    ENG_ASSERT(idx < m_count, "Bounding AABB index {} is out of range [0, {})", idx, m_count);
+    ENG_ASSERT(glm::all(glm::lessThanEqual(min, max)), "Invalid bounding AABB, min is greater than max");
+
+    const glm::vec3 center = (min + max) * 0.5f;
+    const glm::vec3 extents = (max - min) * 0.5f;
+
+    m_centersX[idx] = center.x;
+    m_centersY[idx] = center.y;
+    m_centersZ[idx] = center.z;
+    m_extentsX[idx] = extents.x;
+    m_extentsY[idx] = extents.y;
+    m_extentsZ[idx] = extents.z;
+}
+
+
+void BoundingAABBsSoA::PadTo(uint32_t paddedCount) noexcept
+{
+    m_centersX.resize(paddedCount);
+    m_centersY.resize(paddedCount);
+    m_centersZ.resize(paddedCount);
+    m_extentsX.resize(paddedCount);
+    m_extentsY.resize(paddedCount);
+    m_extentsZ.resize(paddedCount);
+
+    for (uint32_t i = m_count; i < paddedCount; ++i) {
+        m_centersX[i] = 0.f;
+        m_centersY[i] = 0.f;
+        m_centersZ[i] = 0.f;
+        m_extentsX[i] = PADDING_VOLUME_SIZE;
+        m_extentsY[i] = PADDING_VOLUME_SIZE;
+        m_extentsZ[i] = PADDING_VOLUME_SIZE;
+    }
+}
+
+
+void FrustumCuller::CullSpheres(const Frustum& frustum, const BoundingSpheresSoA& spheres, std::vector<uint32_t>& outVisibleIndices) noexcept
+{
+#if defined(CULL_X86)
+    const CullBatchFunc cullFunc = SelectCullFunc(m_SIMDLevel, CullSpheresScalar, CullSpheresSSE2, CullSpheresAVX);
+#else
+    const CullBatchFunc cullFunc = CullSpheresScalar;
+#endif
+
+    Cull(cullFunc, frustum, &spheres, spheres.GetCount(), spheres.GetPaddedCount(), outVisibleIndices);
+}
+
+
+void FrustumCuller::CullAABBs(const Frustum& frustum, const BoundingAABBsSoA& aabbs, std::vector<uint32_t>& outVisibleIndices) noexcept
+{
+#if defined(CULL_X86)
+    const CullBatchFunc cullFunc = SelectCullFunc(m_SIMDLevel, CullAABBsScalar, CullAABBsSSE2, CullAABBsAVX);
+#else
+    const CullBatchFunc cullFunc = CullAABBsScalar;
+#endif
+
+    Cull(cullFunc, frustum, &aabbs, aabbs.GetCount(), aabbs.GetPaddedCount(), outVisibleIndices);
+}
+
+
+void FrustumCuller::SetBatchSize(uint32_t batchSize) noexcept
+{
+    ENG_ASSERT(batchSize > 0, "Frustum culling batch size is 0");
+    m_batchSize = amAlignUp(batchSize, CULLING_SIMD_WIDTH);
+}
+
+
+void FrustumCuller::SetMaxSIMDLevel(CPUSIMDLevel level) noexcept
+{
+    m_SIMDLevel = std::min(level, GetCPUSIMDLevel());
+}
+
+
+void FrustumCuller::Cull(CullBatchFunc cullFunc, const Frustum& frustum, const void* pVolumes, uint32_t count, uint32_t paddedCount,
+    std::vector<uint32_t>& outVisibleIndices) noexcept
+{
+    m_stats = {};
+
+    if (count == 0) {
+        outVisibleIndices.clear();
+        return;
+    }
+
+    ENG_ASSERT(paddedCount % CULLING_SIMD_WIDTH == 0 && paddedCount >= count, "Bounding volumes aren't padded to SIMD width");
+
+    // Every batch writes its visible indices to the beginning of its own range, no synchronization is needed
+    outVisibleIndices.resize(paddedCount);
+
+    const uint32_t batchesCount = (paddedCount + m_batchSize - 1) / m_batchSize;
+    m_batchVisibleCounts.resize(batchesCount);
+
+    struct CullContext
+    {
+        CullBatchFunc   cullFunc;
+        const Frustum*  pFrustum;
+        const void*     pVolumes;
+        uint32_t*       pOutIndices;
+        uint32_t*       pBatchVisibleCounts;
+        uint32_t        batchSize;
+        uint32_t        paddedCount;
+    };
+
+    const CullContext context = { cullFunc, &frustum, pVolumes, outVisibleIndices.data(), m_batchVisibleCounts.data(), m_batchSize, paddedCount };
+
+    auto cullBatch = [pContext = &context](uint32_t batchIdx) {
+        const uint32_t begin = batchIdx * pContext->batchSize;
+        const uint32_t end = std::min(begin + pContext->batchSize, pContext->paddedCount);
+
+        pContext->pBatchVisibleCounts[batchIdx] = pContext->cullFunc(*pContext->pFrustum, pContext->pVolumes, begin, end, pContext->pOutIndices + begin);
+    };
+
+    engRunJobBatches(batchesCount, cullBatch);
+
+    uint32_t visibleCount = m_batchVisibleCounts[0];
+
+    for (uint32_t batchIdx = 1; batchIdx < batchesCount; ++batchIdx) {
+        const uint32_t batchVisibleCount = m_batchVisibleCounts[batchIdx];
+
+        memmove(outVisibleIndices.data() + visibleCount, outVisibleIndices.data() + batchIdx * m_batchSize, batchVisibleCount * sizeof(uint32_t));
+        visibleCount += batchVisibleCount;
+    }
+
+    outVisibleIndices.resize(visibleCount);
+
+    m_stats.testedCount = count;
+    m_stats.visibleCount = visibleCount;
+    m_stats.batchesCount = batchesCount;
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "utils/cpu/cpu_features.h"
+#include "utils/math/common_math.h"
+
+#include "core.h"
+
+#include <vector>
+#include <array>
+
+#include <cstdint>
+
+
+enum FrustumPlane : uint32_t
+{
+    FRUSTUM_PLANE_LEFT,
+    FRUSTUM_PLANE_RIGHT,
+    FRUSTUM_PLANE_BOTTOM,
+    FRUSTUM_PLANE_TOP,
+    FRUSTUM_PLANE_NEAR,
+    FRUSTUM_PLANE_FAR,
+
+    FRUSTUM_PLANE_COUNT,
+};
+
+
+// Planes are in world space and face inside: dot(plane.xyz, point) + plane.w >= 0 for inner points. plane.xyz is normalized
+struct Frustum
+{
+    void ExtractPlanes(const glm::mat4x4& viewProjMatrix) noexcept;
+
+    std::array<glm::vec4, FRUSTUM_PLANE_COUNT> planes = {};
+};
+
+
+// Bounding volumes are processed in groups of CULLING_SIMD_WIDTH. Volume arrays are padded up to it with volumes
+// which fail any plane test, so culling kernels have no scalar tails
+inline constexpr uint32_t CULLING_SIMD_WIDTH = 8;
+
+
+// Bounding spheres stored per component
+class BoundingSpheresSoA
+{
+public:
+    void Reserve(uint32_t count) noexcept;
+    void Resize(uint32_t count) noexcept;
+    void Clear() noexcept;
+
+    // Returns index of the added sphere
+    uint32_t Add(const glm::vec3& center, float radius) noexcept;
+    void Set(uint32_t idx, const glm::vec3& center, float radius) noexcept;
+
+    const float* GetCentersX() const noexcept { return m_centersX.data(); }
+    const float* GetCentersY() const noexcept { return m_centersY.data(); }
+    const float* GetCentersZ() const noexcept { return m_centersZ.data(); }
+    const float* GetRadii() const noexcept { return m_radii.data(); }
+
+    uint32_t GetCount() const noexcept { return m_count; }
+    uint32_t GetPaddedCount() const noexcept { return static_cast<uint32_t>(m_radii.size()); }
+
+    bool IsEmpty() const noexcept { return m_count == 0; }
+
+private:
+    void PadTo(uint32_t paddedCount) noexcept;
+
+private:
+    std::vector<float> m_centersX;
+    std::vector<float> m_centersY;
+    std::vector<float> m_centersZ;
+    std::vector<float> m_radii;
+
+    uint32_t m_count = 0;
+};
+
+
+// AABBs stored per component as centers and half extents, plane tests need them in that form
+class BoundingAABBsSoA
+{
+public:
+    void Reserve(uint32_t count) noexcept;
+    void Resize(uint32_t count) noexcept;
+    void Clear() noexcept;
+
+    // Returns index of the added AABB
+    uint32_t Add(const glm::vec3& min, const glm::vec3& max) noexcept;
+    void Set(uint32_t idx, const glm::vec3& min, const glm::vec3& max) noexcept;
+
+    const float* GetCentersX() const noexcept { return m_centersX.data(); }
+    const float* GetCentersY() const noexcept { return m_centersY.data(); }
+    const float* GetCentersZ() const noexcept { return m_centersZ.data(); }
+    const float* GetExtentsX() const noexcept { return m_extentsX.data(); }
+    const float* GetExtentsY() const noexcept { return m_extentsY.data(); }
+    const float* GetExtentsZ() const noexcept { return m_extentsZ.data(); }
+
+    uint32_t GetCount() const noexcept { return m_count; }
+    uint32_t GetPaddedCount() const noexcept { return static_cast<uint32_t>(m_extentsX.size()); }
+
+    bool IsEmpty() const noexcept { return m_count == 0; }
+
+private:
+    void PadTo(uint32_t paddedCount) noexcept;
+
+private:
+    std::vector<float> m_centersX;
+    std::vector<float> m_centersY;
+    std::vector<float> m_centersZ;
+    std::vector<float> m_extentsX;
+    std::vector<float> m_extentsY;
+    std::vector<float> m_extentsZ;
+
+    uint32_t m_count = 0;
+};
+
+
+struct FrustumCullingStats
+{
+    uint32_t testedCount;
+    uint32_t visibleCount;
+    uint32_t batchesCount;
+};
+
+
+// Tests bounding volumes against frustum planes with SSE2 or AVX kernels, the variant is picked at runtime.
+// Volumes are split into batches which are culled in parallel by the job system (in place if it isn't initialized),
+// visible indices of all batches are then compacted into the output in ascending order.
+// The culler doesn't touch GL and can be used from any thread, but a single culler mustn't be used by several threads at once
+class FrustumCuller
+{
+public:
+    static inline constexpr uint32_t DEFAULT_BATCH_SIZE = 16 * 1024;
+
+public:
+    // outVisibleIndices is resized to the visible volumes count
+    void CullSpheres(const Frustum& frustum, const BoundingSpheresSoA& spheres, std::vector<uint32_t>& outVisibleIndices) noexcept;
+    void CullAABBs(const Frustum& frustum, const BoundingAABBsSoA& aabbs, std::vector<uint32_t>& outVisibleIndices) noexcept;
+
+    // Rounded up to CULLING_SIMD_WIDTH
+    void SetBatchSize(uint32_t batchSize) noexcept;
+    uint32_t GetBatchSize() const noexcept { return m_batchSize; }
+
+    // Caps culling kernels at the level, e.g. to compare them with each other. Levels above the CPU support are clamped
+    void SetMaxSIMDLevel(CPUSIMDLevel level) noexcept;
+    CPUSIMDLevel GetSIMDLevel() const noexcept { return m_SIMDLevel; }
+
+    const FrustumCullingStats& GetStats() const noexcept { return m_stats; }
+
+private:
+    using CullBatchFunc = uint32_t(*)(const Frustum& frustum, const void* pVolumes, uint32_t begin, uint32_t end, uint32_t* pOutIndices);
+
+    void Cull(CullBatchFunc cullFunc, const Frustum& frustum, const void* pVolumes, uint32_t count, uint32_t paddedCount,
+        std::vector<uint32_t>& outVisibleIndices) noexcept;
+
+private:
+    std::vector<uint32_t> m_batchVisibleCounts;
+
+    FrustumCullingStats m_stats = {};
+
+    uint32_t m_batchSize = DEFAULT_BATCH_SIZE;
+
+    CPUSIMDLevel m_SIMDLevel = GetCPUSIMDLevel();
+};
@@ -0,0 +1,386 @@
+#include "pch.h"
+#include "hiz_buffer.h"
+
+#include "core/job_system/job_system.h"
+
+#include "utils/debug/assertion.h"
+
+#include <chrono>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define HIZ_SSE2
+  #include <emmintrin.h>
+#endif
+
+
+namespace chr = std::chrono;
+
+
+#if defined(ENG_USE_INVERTED_Z)
+static inline float FartherDepth(float left, float right) noexcept { return std::min(left, right); }
+static inline float NearerDepth(float left, float right) noexcept { return std::max(left, right); }
+static inline bool IsFarther(float left, float right) noexcept { return left < right; }
+#else
+static inline float FartherDepth(float left, float right) noexcept { return std::max(left, right); }
+static inline float NearerDepth(float left, float right) noexcept { return std::min(left, right); }
+static inline bool IsFarther(float left, float right) noexcept { return left > right; }
+#endif
+
+
+#if defined(HIZ_SSE2)
+#if defined(ENG_USE_INVERTED_Z)
+static inline __m128 FartherDepth(__m128 left, __m128 right) noexcept { return _mm_min_ps(left, right); }
+static inline __m128 NearerDepth(__m128 left, __m128 right) noexcept { return _mm_max_ps(left, right); }
+#else
+static inline __m128 FartherDepth(__m128 left, __m128 right) noexcept { return _mm_max_ps(left, right); }
+static inline __m128 NearerDepth(__m128 left, __m128 right) noexcept { return _mm_min_ps(left, right); }
+#endif
+
+
+// Reduces 2x2 blocks of 8 pixels wide strips of two rows into 4 texels
+template <typename ReduceFunc>
+static inline __m128 Reduce2x2(const float* pRow0, const float* pRow1, ReduceFunc reduce) noexcept
+{
+    const __m128 low = reduce(_mm_loadu_ps(pRow0), _mm_loadu_ps(pRow1));
+    const __m128 high = reduce(_mm_loadu_ps(pRow0 + 4), _mm_loadu_ps(pRow1 + 4));
+
+    const __m128 even = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 odd = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+
+    return reduce(even, odd);
+}
+#endif
+
+
+struct ReduceLevelContext
+{
+    const float* pSrcFarthest;
+    const float* pSrcNearest;
+    float*       pDstFarthest;
+    float*       pDstNearest;
+    uint32_t     srcWidth;
+    uint32_t     srcHeight;
+    uint32_t     dstWidth;
+};
+
+
+// Odd sized sources clamp reads, so the last texel of a row or column covers a single source pixel of that axis
+static void ReduceRow(const ReduceLevelContext& context, uint32_t dstY) noexcept
+{
+    const uint64_t srcRowOffset0 = uint64_t(2 * dstY) * context.srcWidth;
+    const uint64_t srcRowOffset1 = uint64_t(std::min(2 * dstY + 1, context.srcHeight - 1)) * context.srcWidth;
+
+    const float* pFarthest0 = context.pSrcFarthest + srcRowOffset0;
+    const float* pFarthest1 = context.pSrcFarthest + srcRowOffset1;
+    const float* pNearest0 = context.pSrcNearest + srcRowOffset0;
+    const float* pNearest1 = context.pSrcNearest + srcRowOffset1;
+
+    float* pDstFarthest = context.pDstFarthest + uint64_t(dstY) * context.dstWidth;
+    float* pDstNearest = context.pDstNearest + uint64_t(dstY) * context.dstWidth;
+
+    uint32_t x = 0;
+
+#if defined(HIZ_SSE2)
+    const auto farther = [](__m128 left, __m128 right) { return FartherDepth(left, right); };
+    const auto nearer = [](__m128 left, __m128 right) { return NearerDepth(left, right); };
+
+    for (; 2 * x + 8 <= context.srcWidth; x += 4) {
+        _mm_storeu_ps(pDstFarthest + x, Reduce2x2(pFarthest0 + 2 * x, pFarthest1 + 2 * x, farther));
+        _mm_storeu_ps(pDstNearest + x, Reduce2x2(pNearest0 + 2 * x, pNearest1 + 2 * x, nearer));
+    }
+#endif
+
+    for (; x < context.dstWidth; ++x) {
+        const uint32_t x0 = 2 * x;
+        const uint32_t x1 = std::min(x0 + 1, context.srcWidth - 1);
+
+        pDstFarthest[x] = FartherDepth(FartherDepth(pFarthest0[x0], pFarthest0[x1]), FartherDepth(pFarthest1[x0], pFarthest1[x1]));
+        pDstNearest[x] = NearerDepth(NearerDepth(pNearest0[x0], pNearest0[x1]), NearerDepth(pNearest1[x0], pNearest1[x1]));
+    }
+}
+
+
+static uint32_t NDCToPixel(float ndc, uint32_t size) noexcept
+{
+    return static_cast<uint32_t>(glm::clamp((ndc * 0.5f + 0.5f) * size, 0.f, size - 1.f));
+}
+
+
+static float GetElapsedTimeMs(const chr::steady_clock::time_point& startTime) noexcept
+{
+    return chr::duration<float, std::milli>(chr::steady_clock::now() - startTime).count();
+}
+
+
+void HiZBuffer::Build(const float* pDepth, uint32_t width, uint32_t height, const glm::mat4x4& viewProjMatrix) noexcept
+{
+    ENG_ASSERT(pDepth, "pDepth is nullptr");
+    ENG_ASSERT(width > 0 && height > 0, "Invalid HiZ buffer source depth size: {}x{}", width, height);
+
+    const chr::steady_clock::time_point startTime = chr::steady_clock::now();
+
+    if (width != m_depthWidth || height != m_depthHeight) {
+        m_levels.clear();
+
+        uint32_t levelWidth = width;
+        uint32_t levelHeight = height;
+        uint64_t levelOffset = 0;
+
+        do {
+            levelWidth = (levelWidth + 1) / 2;
+            levelHeight = (levelHeight + 1) / 2;
+
+            m_levels.emplace_back(Level { levelOffset, levelWidth, levelHeight });
+            levelOffset += uint64_t(levelWidth) * levelHeight;
+        } while (levelWidth > 1 || levelHeight > 1);
+
+        m_farthestDepth.resize(levelOffset);
+        m_nearestDepth.resize(levelOffset);
+
+        m_depthWidth = width;
+        m_depthHeight = height;
+    }
+
+    m_viewProjMatrix = viewProjMatrix;
+
+    // The source depth is both the farthest and the nearest depth of level 0 pixels
+    ReduceLevelContext context = {};
+    context.pSrcFarthest = pDepth;
+    context.pSrcNearest = pDepth;
+    context.srcWidth = width;
+    context.srcHeight = height;
+
+    for (const Level& level : m_levels) {
+        context.pDstFarthest = m_farthestDepth.data() + level.offset;
+        context.pDstNearest = m_nearestDepth.data() + level.offset;
+        context.dstWidth = level.width;
+
+        const uint32_t batchesCount = (level.height + BUILD_BATCH_ROWS_COUNT - 1) / BUILD_BATCH_ROWS_COUNT;
+        const uint32_t levelHeight = level.height;
+
+        engRunJobBatches(batchesCount, [pContext = &context, levelHeight](uint32_t batchIdx) {
+            const uint32_t beginY = batchIdx * BUILD_BATCH_ROWS_COUNT;
+            const uint32_t endY = std::min(beginY + BUILD_BATCH_ROWS_COUNT, levelHeight);
+
+            for (uint32_t y = beginY; y < endY; ++y) {
+                ReduceRow(*pContext, y);
+            }
+        });
+
+        context.pSrcFarthest = context.pDstFarthest;
+        context.pSrcNearest = context.pDstNearest;
+        context.srcWidth = level.width;
+        context.srcHeight = level.height;
+    }
+
+    m_stats.buildTimeMs = GetElapsedTimeMs(startTime);
+}
+
+
+void HiZBuffer::ResetTestStats() noexcept
+{
+    m_stats.testedCount = 0;
+    m_stats.occludedCount = 0;
+    m_stats.testTimeMs = 0.f;
+}
+
+
+void HiZBuffer::Clear() noexcept
+{
+    m_levels.clear();
+    m_farthestDepth.clear();
+    m_nearestDepth.clear();
+
+    m_viewProjMatrix = M3D_MAT4_IDENTITY;
+
+    m_stats = {};
+
+    m_depthWidth = 0;
+    m_depthHeight = 0;
+}
+
+
+void HiZBuffer::CullSpheres(const BoundingSpheresSoA& spheres, std::vector<uint32_t>& inOutVisibleIndices) noexcept
+{
+    BoundsView bounds = {};
+    bounds.pCentersX = spheres.GetCentersX();
+    bounds.pCentersY = spheres.GetCentersY();
+    bounds.pCentersZ = spheres.GetCentersZ();
+    bounds.pExtentsX = spheres.GetRadii();
+    bounds.pExtentsY = spheres.GetRadii();
+    bounds.pExtentsZ = spheres.GetRadii();
+
+    Cull(bounds, inOutVisibleIndices);
+}
+
+
+void HiZBuffer::CullAABBs(const BoundingAABBsSoA& aabbs, std::vector<uint32_t>& inOutVisibleIndices) noexcept
+{
+    BoundsView bounds = {};
+    bounds.pCentersX = aabbs.GetCentersX();
+    bounds.pCentersY = aabbs.GetCentersY();
+    bounds.pCentersZ = aabbs.GetCentersZ();
+    bounds.pExtentsX = aabbs.GetExtentsX();
+    bounds.pExtentsY = aabbs.GetExtentsY();
+    bounds.pExtentsZ = aabbs.GetExtentsZ();
+
+    Cull(bounds, inOutVisibleIndices);
+}
+
+
+bool HiZBuffer::IsAABBOccluded(const glm::vec3& center, const glm::vec3& extents) const noexcept
+{
+    if (!IsValid()) {
+        return false;
+    }
+
+    BoundsView bounds = {};
+    bounds.pCentersX = &center.x;
+    bounds.pCentersY = &center.y;
+    bounds.pCentersZ = &center.z;
+    bounds.pExtentsX = &extents.x;
+    bounds.pExtentsY = &extents.y;
+    bounds.pExtentsZ = &extents.z;
+
+    return IsOccluded(bounds, 0);
+}
+
+
+float HiZBuffer::GetFarthestDepth(uint32_t level, uint32_t x, uint32_t y) const noexcept
+{
+    ENG_ASSERT(level < m_levels.size(), "HiZ level {} is out of range", level);
+    ENG_ASSERT(x < m_levels[level].width && y < m_levels[level].height, "HiZ texel ({}, {}) is out of level {} range", x, y, level);
+
+    return m_farthestDepth[m_levels[level].offset + uint64_t(y) * m_levels[level].width + x];
+}
+
+
+float HiZBuffer::GetNearestDepth(uint32_t level, uint32_t x, uint32_t y) const noexcept
+{
+    ENG_ASSERT(level < m_levels.size(), "HiZ level {} is out of range", level);
+    ENG_ASSERT(x < m_levels[level].width && y < m_levels[level].height, "HiZ texel ({}, {}) is out of level {} range", x, y, level);
+
+    return m_nearestDepth[m_levels[level].offset + uint64_t(y) * m_levels[level].width + x];
+}
+
+
+void HiZBuffer::Cull(const BoundsView& bounds, std::vector<uint32_t>& inOutVisibleIndices) noexcept
+{
+    if (!IsValid() || inOutVisibleIndices.empty()) {
+        return;
+    }
+
+    const chr::steady_clock::time_point startTime = chr::steady_clock::now();
+
+    const uint32_t count = static_cast<uint32_t>(inOutVisibleIndices.size());
+    const uint32_t batchesCount = (count + CULL_BATCH_SIZE - 1) / CULL_BATCH_SIZE;
+
+    m_batchVisibleCounts.resize(batchesCount);
+
+    struct CullContext
+    {
+        const HiZBuffer*  pHiZBuffer;
+        const BoundsView* pBounds;
+        uint32_t*         pIndices;
+        uint32_t*         pBatchVisibleCounts;
+        uint32_t          count;
+    };
+
+    const CullContext context = { this, &bounds, inOutVisibleIndices.data(), m_batchVisibleCounts.data(), count };
+
+    // Every batch compacts its own range in place, writes never pass reads
+    engRunJobBatches(batchesCount, [pContext = &context](uint32_t batchIdx) {
+        const uint32_t begin = batchIdx * CULL_BATCH_SIZE;
+        const uint32_t end = std::min(begin + CULL_BATCH_SIZE, pContext->count);
+
+        uint32_t* pIndices = pContext->pIndices;
+        uint32_t visibleEnd = begin;
+
+        for (uint32_t i = begin; i < end; ++i) {
+            const uint32_t idx = pIndices[i];
+
+            pIndices[visibleEnd] = idx;
+            visibleEnd += pContext->pHiZBuffer->IsOccluded(*pContext->pBounds, idx) ? 0 : 1;
+        }
+
+        pContext->pBatchVisibleCounts[batchIdx] = visibleEnd - begin;
+    });
+
+    uint32_t visibleCount = m_batchVisibleCounts[0];
+
+    for (uint32_t batchIdx = 1; batchIdx < batchesCount; ++batchIdx) {
+        const uint32_t batchVisibleCount = m_batchVisibleCounts[batchIdx];
+
+        memmove(inOutVisibleIndices.data() + visibleCount, inOutVisibleIndices.data() + batchIdx * CULL_BATCH_SIZE, batchVisibleCount * sizeof(uint32_t));
+        visibleCount += batchVisibleCount;
+    }
+
+    inOutVisibleIndices.resize(visibleCount);
+
+    m_stats.testedCount += count;
+    m_stats.occludedCount += count - visibleCount;
+    m_stats.testTimeMs += GetElapsedTimeMs(startTime);
+}
+
+
+bool HiZBuffer::IsOccluded(const BoundsView& bounds, uint32_t idx) const noexcept
+{
+    // Corners are the clip space center plus or minus clip space half extent axes
+    const glm::vec4 center = m_viewProjMatrix * glm::vec4(bounds.pCentersX[idx], bounds.pCentersY[idx], bounds.pCentersZ[idx], 1.f);
+    const glm::vec4 axisX = m_viewProjMatrix[0] * bounds.pExtentsX[idx];
+    const glm::vec4 axisY = m_viewProjMatrix[1] * bounds.pExtentsY[idx];
+    const glm::vec4 axisZ = m_viewProjMatrix[2] * bounds.pExtentsZ[idx];
+
+    glm::vec3 ndcMin(std::numeric_limits<float>::max());
+    glm::vec3 ndcMax(-std::numeric_limits<float>::max());
+
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+        const glm::vec4 clip = center + ((corner & 1) ? axisX : -axisX) + ((corner & 2) ? axisY : -axisY) + ((corner & 4) ? axisZ : -axisZ);
+
+        // The bounds cross the near plane, their projection is unbounded
+        if (clip.w <= M3D_EPS) {
+            return false;
+        }
+
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+
+        ndcMin = glm::min(ndcMin, ndc);
+        ndcMax = glm::max(ndcMax, ndc);
+    }
+
+    // Off screen bounds are left to frustum culling
+    if (ndcMax.x < -1.f || ndcMin.x > 1.f || ndcMax.y < -1.f || ndcMin.y > 1.f) {
+        return false;
+    }
+
+    // Level 0 texel covers 2x2 pixels
+    uint32_t x0 = NDCToPixel(ndcMin.x, m_depthWidth) >> 1;
+    uint32_t y0 = NDCToPixel(ndcMin.y, m_depthHeight) >> 1;
+    uint32_t x1 = NDCToPixel(ndcMax.x, m_depthWidth) >> 1;
+    uint32_t y1 = NDCToPixel(ndcMax.y, m_depthHeight) >> 1;
+
+    uint32_t level = 0;
+
+    while ((x1 - x0 > 1 || y1 - y0 > 1) && level + 1 < m_levels.size()) {
+        x0 >>= 1;
+        y0 >>= 1;
+        x1 >>= 1;
+        y1 >>= 1;
+        ++level;
+    }
+
+    const Level& hizLevel = m_levels[level];
+    const float* pFarthest = m_farthestDepth.data() + hizLevel.offset;
+
+    const float regionFarthestDepth = FartherDepth(
+        FartherDepth(pFarthest[uint64_t(y0) * hizLevel.width + x0], pFarthest[uint64_t(y0) * hizLevel.width + x1]),
+        FartherDepth(pFarthest[uint64_t(y1) * hizLevel.width + x0], pFarthest[uint64_t(y1) * hizLevel.width + x1]));
+
+#if defined(GLM_FORCE_DEPTH_ZERO_TO_ONE)
+    const float boundsNearestDepth = NearerDepth(ndcMin.z, ndcMax.z);
+#else
+    const float boundsNearestDepth = NearerDepth(ndcMin.z, ndcMax.z) * 0.5f + 0.5f;
+#endif
+
+    return IsFarther(boundsNearestDepth, regionFarthestDepth);
+}
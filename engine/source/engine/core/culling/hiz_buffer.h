@@ -0,0 +1,104 @@
+#pragma once
+
+#include "core/culling/frustum_culling.h"
+
+#include "utils/math/common_math.h"
+
+#include "core.h"
+
+#include <vector>
+
+#include <cstdint>
+
+
+// Test stats accumulate until ResetTestStats(), build time is of the last Build()
+struct HiZBufferStats
+{
+    uint32_t testedCount;
+    uint32_t occludedCount;
+    float    buildTimeMs;
+    float    testTimeMs;
+};
+
+
+// Hierarchical Z buffer built on CPU from a window space depth buffer: [0, 1] depth, rows bottom to top as glGetTextureImage returns them.
+// Level 0 has half the depth buffer resolution, every next level halves the previous one (rounding up) down to 1x1.
+// Every texel keeps the farthest and the nearest depth of the pixels it covers, near and far follow ENG_USE_INVERTED_Z.
+// Bounds are projected with the view projection matrix the depth was rendered with, their nearest depth is compared against
+// the farthest depth of the level where the projected rect covers at most 2x2 texels. Bounds crossing the near plane are never occluded.
+// Build and tests split work into jobs if the job system is initialized, a single HiZ buffer mustn't be used by several threads at once
+class HiZBuffer
+{
+public:
+    void Build(const float* pDepth, uint32_t width, uint32_t height, const glm::mat4x4& viewProjMatrix) noexcept;
+    void Clear() noexcept;
+
+    // Expected to be called once per frame, so test stats describe a single frame whether the buffer was rebuilt or not
+    void ResetTestStats() noexcept;
+
+    // Removes indices of occluded volumes from inOutVisibleIndices, the order of the rest is kept
+    void CullSpheres(const BoundingSpheresSoA& spheres, std::vector<uint32_t>& inOutVisibleIndices) noexcept;
+    void CullAABBs(const BoundingAABBsSoA& aabbs, std::vector<uint32_t>& inOutVisibleIndices) noexcept;
+
+    // Single AABB test, doesn't touch stats. Nothing is occluded while the HiZ buffer is invalid
+    bool IsAABBOccluded(const glm::vec3& center, const glm::vec3& extents) const noexcept;
+
+    float GetFarthestDepth(uint32_t level, uint32_t x, uint32_t y) const noexcept;
+    float GetNearestDepth(uint32_t level, uint32_t x, uint32_t y) const noexcept;
+
+    uint32_t GetLevelsCount() const noexcept { return static_cast<uint32_t>(m_levels.size()); }
+    uint32_t GetLevelWidth(uint32_t level) const noexcept { return m_levels[level].width; }
+    uint32_t GetLevelHeight(uint32_t level) const noexcept { return m_levels[level].height; }
+
+    uint32_t GetDepthWidth() const noexcept { return m_depthWidth; }
+    uint32_t GetDepthHeight() const noexcept { return m_depthHeight; }
+
+    const glm::mat4x4& GetViewProjectionMatrix() const noexcept { return m_viewProjMatrix; }
+
+    const HiZBufferStats& GetStats() const noexcept { return m_stats; }
+    float GetOccludedRatio() const noexcept { return m_stats.testedCount > 0 ? float(m_stats.occludedCount) / m_stats.testedCount : 0.f; }
+
+    bool IsValid() const noexcept { return !m_levels.empty(); }
+
+private:
+    struct Level
+    {
+        uint64_t offset;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // Extents pointers may alias, spheres pass their radii for all three axes
+    struct BoundsView
+    {
+        const float* pCentersX;
+        const float* pCentersY;
+        const float* pCentersZ;
+        const float* pExtentsX;
+        const float* pExtentsY;
+        const float* pExtentsZ;
+    };
+
+    void Cull(const BoundsView& bounds, std::vector<uint32_t>& inOutVisibleIndices) noexcept;
+    bool IsOccluded(const BoundsView& bounds, uint32_t idx) const noexcept;
+
+private:
+    static inline constexpr uint32_t BUILD_BATCH_ROWS_COUNT = 32;
+    static inline constexpr uint32_t CULL_BATCH_SIZE = 4 * 1024;
+
+private:
+    std::vector<Level> m_levels;
+
+    // All levels one after another
+    std::vector<float> m_farthestDepth;
+    std::vector<float> m_nearestDepth;
+
+    std::vector<uint32_t> m_batchVisibleCounts;
+
+    glm::mat4x4 m_viewProjMatrix = M3D_MAT4_IDENTITY;
+
+    HiZBufferStats m_stats = {};
+
+    uint32_t m_depthWidth = 0;
+    uint32_t m_depthHeight = 0;
+};
@@ -0,0 +1,481 @@
+#include "pch.h"
+#include "occlusion_rasterizer.h"
+
+#include "core/job_system/job_system.h"
+
+#include "utils/cpu/cpu_features.h"
+#include "utils/debug/assertion.h"
+
+#include <chrono>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+  #define RAST_X86
+#endif
+
+#if defined(RAST_X86)
+  #include <immintrin.h>
+#endif
+
+#if defined(RAST_X86) && (defined(__GNUC__) || defined(__clang__))
+  #define RAST_TARGET_SSE2 __attribute__((target("sse2")))
+  #define RAST_TARGET_AVX  __attribute__((target("avx")))
+#else
+  #define RAST_TARGET_SSE2
+  #define RAST_TARGET_AVX
+#endif
+
+
+namespace chr = std::chrono;
+
+
+#if defined(ENG_USE_INVERTED_Z)
+static constexpr float CLEAR_DEPTH = 0.f;
+static constexpr float NEAR_PLANE_DEPTH = 1.f;
+
+static inline float NearerDepth(float left, float right) noexcept { return std::max(left, right); }
+static inline bool IsNearer(float left, float right) noexcept { return left > right; }
+#else
+static constexpr float CLEAR_DEPTH = 1.f;
+static constexpr float NEAR_PLANE_DEPTH = 0.f;
+
+static inline float NearerDepth(float left, float right) noexcept { return std::min(left, right); }
+static inline bool IsNearer(float left, float right) noexcept { return left < right; }
+#endif
+
+// Triangles with smaller area in pixels cover no pixel centers in practice and make the depth plane unstable
+static constexpr float MIN_TRIANGLE_AREA = 1e-4f;
+
+
+using Triangle = OcclusionRasterizer::Triangle;
+using RasterizeTileFunc = void (*)(const Triangle* pTriangles, const uint32_t* pBin, uint32_t binSize, float* pDepth, uint32_t stride, uint32_t tileX, uint32_t tileY);
+
+
+struct TileRange
+{
+    uint32_t minX;
+    uint32_t minY;
+    uint32_t maxX;
+    uint32_t maxY;
+};
+
+
+// Inclusive pixel range of the triangle inside the tile, empty if minX > maxX or minY > maxY
+static inline TileRange GetTriangleTileRange(const Triangle& triangle, uint32_t tileX, uint32_t tileY) noexcept
+{
+    TileRange range = {};
+    range.minX = std::max(triangle.minX, tileX);
+    range.minY = std::max(triangle.minY, tileY);
+    range.maxX = std::min(triangle.maxX, tileX + OcclusionRasterizer::TILE_WIDTH - 1);
+    range.maxY = std::min(triangle.maxY, tileY + OcclusionRasterizer::TILE_HEIGHT - 1);
+
+    return range;
+}
+
+
+static void RasterizeTileScalar(const Triangle* pTriangles, const uint32_t* pBin, uint32_t binSize, float* pDepth, uint32_t stride, uint32_t tileX, uint32_t tileY) noexcept
+{
+    for (uint32_t binIdx = 0; binIdx < binSize; ++binIdx) {
+        const Triangle& triangle = pTriangles[pBin[binIdx]];
+        const TileRange range = GetTriangleTileRange(triangle, tileX, tileY);
+
+        for (uint32_t y = range.minY; y <= range.maxY; ++y) {
+            const float py = y + 0.5f;
+
+            const float rowEdge0 = triangle.edgeB[0] * py + triangle.edgeC[0];
+            const float rowEdge1 = triangle.edgeB[1] * py + triangle.edgeC[1];
+            const float rowEdge2 = triangle.edgeB[2] * py + triangle.edgeC[2];
+            const float rowDepth = triangle.depthB * py + triangle.depthC;
+
+            float* pRow = pDepth + uint64_t(y) * stride;
+
+            for (uint32_t x = range.minX; x <= range.maxX; ++x) {
+                const float px = x + 0.5f;
+
+                const bool isInside = triangle.edgeA[0] * px + rowEdge0 >= 0.f
+                    && triangle.edgeA[1] * px + rowEdge1 >= 0.f
+                    && triangle.edgeA[2] * px + rowEdge2 >= 0.f;
+
+                if (isInside) {
+                    const float depth = glm::clamp(triangle.depthA * px + rowDepth, triangle.minDepth, triangle.maxDepth);
+                    pRow[x] = NearerDepth(pRow[x], depth);
+                }
+            }
+        }
+    }
+}
+
+
+#if defined(RAST_X86)
+// Spans start at a lane aligned pixel. Tile sizes are multiples of the lane count, so spans never leave the tile,
+// lanes outside the triangle bounds are rejected by the edge functions
+RAST_TARGET_SSE2 static void RasterizeTileSSE2(const Triangle* pTriangles, const uint32_t* pBin, uint32_t binSize, float* pDepth, uint32_t stride, uint32_t tileX, uint32_t tileY) noexcept
+{
+    const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (uint32_t binIdx = 0; binIdx < binSize; ++binIdx) {
+        const Triangle& triangle = pTriangles[pBin[binIdx]];
+        const TileRange range = GetTriangleTileRange(triangle, tileX, tileY);
+
+        const __m128 edgeA0 = _mm_set1_ps(triangle.edgeA[0]);
+        const __m128 edgeA1 = _mm_set1_ps(triangle.edgeA[1]);
+        const __m128 edgeA2 = _mm_set1_ps(triangle.edgeA[2]);
+        const __m128 depthA = _mm_set1_ps(triangle.depthA);
+        const __m128 minDepth = _mm_set1_ps(triangle.minDepth);
+        const __m128 maxDepth = _mm_set1_ps(triangle.maxDepth);
+
+        const uint32_t spanMinX = range.minX & ~3u;
+
+        for (uint32_t y = range.minY; y <= range.maxY; ++y) {
+            const float py = y + 0.5f;
+
+            const __m128 rowEdge0 = _mm_set1_ps(triangle.edgeB[0] * py + triangle.edgeC[0]);
+            const __m128 rowEdge1 = _mm_set1_ps(triangle.edgeB[1] * py + triangle.edgeC[1]);
+            const __m128 rowEdge2 = _mm_set1_ps(triangle.edgeB[2] * py + triangle.edgeC[2]);
+            const __m128 rowDepth = _mm_set1_ps(triangle.depthB * py + triangle.depthC);
+
+            float* pRow = pDepth + uint64_t(y) * stride;
+
+            for (uint32_t x = spanMinX; x <= range.maxX; x += 4) {
+                const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+
+                __m128 mask = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, px), rowEdge0), zero);
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, px), rowEdge1), zero));
+                mask = _mm_and_ps(mask, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, px), rowEdge2), zero));
+
+                if (_mm_movemask_ps(mask) == 0) {
+                    continue;
+                }
+
+                __m128 depth = _mm_add_ps(_mm_mul_ps(depthA, px), rowDepth);
+                depth = _mm_min_ps(_mm_max_ps(depth, minDepth), maxDepth);
+
+                const __m128 oldDepth = _mm_loadu_ps(pRow + x);
+            #if defined(ENG_USE_INVERTED_Z)
+                const __m128 nearerDepth = _mm_max_ps(oldDepth, depth);
+            #else
+                const __m128 nearerDepth = _mm_min_ps(oldDepth, depth);
+            #endif
+
+                _mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(mask, nearerDepth), _mm_andnot_ps(mask, oldDepth)));
+            }
+        }
+    }
+}
+
+
+RAST_TARGET_AVX static void RasterizeTileAVX(const Triangle* pTriangles, const uint32_t* pBin, uint32_t binSize, float* pDepth, uint32_t stride, uint32_t tileX, uint32_t tileY) noexcept
+{
+    const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (uint32_t binIdx = 0; binIdx < binSize; ++binIdx) {
+        const Triangle& triangle = pTriangles[pBin[binIdx]];
+        const TileRange range = GetTriangleTileRange(triangle, tileX, tileY);
+
+        const __m256 edgeA0 = _mm256_set1_ps(triangle.edgeA[0]);
+        const __m256 edgeA1 = _mm256_set1_ps(triangle.edgeA[1]);
+        const __m256 edgeA2 = _mm256_set1_ps(triangle.edgeA[2]);
+        const __m256 depthA = _mm256_set1_ps(triangle.depthA);
+        const __m256 minDepth = _mm256_set1_ps(triangle.minDepth);
+        const __m256 maxDepth = _mm256_set1_ps(triangle.maxDepth);
+
+        const uint32_t spanMinX = range.minX & ~7u;
+
+        for (uint32_t y = range.minY; y <= range.maxY; ++y) {
+            const float py = y + 0.5f;
+
+            const __m256 rowEdge0 = _mm256_set1_ps(triangle.edgeB[0] * py + triangle.edgeC[0]);
+            const __m256 rowEdge1 = _mm256_set1_ps(triangle.edgeB[1] * py + triangle.edgeC[1]);
+            const __m256 rowEdge2 = _mm256_set1_ps(triangle.edgeB[2] * py + triangle.edgeC[2]);
+            const __m256 rowDepth = _mm256_set1_ps(triangle.depthB * py + triangle.depthC);
+
+            float* pRow = pDepth + uint64_t(y) * stride;
+
+            for (uint32_t x = spanMinX; x <= range.maxX; x += 8) {
+                const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets);
+
+                __m256 mask = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA0, px), rowEdge0), zero, _CMP_GE_OQ);
+                mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA1, px), rowEdge1), zero, _CMP_GE_OQ));
+                mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(edgeA2, px), rowEdge2), zero, _CMP_GE_OQ));
+
+                if (_mm256_movemask_ps(mask) == 0) {
+                    continue;
+                }
+
+                __m256 depth = _mm256_add_ps(_mm256_mul_ps(depthA, px), rowDepth);
+                depth = _mm256_min_ps(_mm256_max_ps(depth, minDepth), maxDepth);
+
+                const __m256 oldDepth = _mm256_loadu_ps(pRow + x);
+            #if defined(ENG_USE_INVERTED_Z)
+                const __m256 nearerDepth = _mm256_max_ps(oldDepth, depth);
+            #else
+                const __m256 nearerDepth = _mm256_min_ps(oldDepth, depth);
+            #endif
+
+                // Bitwise select instead of blendv, GCC lowers blendv of the function targeted AVX into per lane branches
+                _mm256_storeu_ps(pRow + x, _mm256_or_ps(_mm256_and_ps(mask, nearerDepth), _mm256_andnot_ps(mask, oldDepth)));
+            }
+        }
+    }
+}
+#endif
+
+
+static RasterizeTileFunc SelectRasterizeTileFunc(CPUSIMDLevel level) noexcept
+{
+#if defined(RAST_X86)
+    if (level >= CPUSIMDLevel::AVX) {
+        return RasterizeTileAVX;
+    }
+
+    if (level >= CPUSIMDLevel::SSE2) {
+        return RasterizeTileSSE2;
+    }
+#endif
+
+    return RasterizeTileScalar;
+}
+
+
+void OcclusionRasterizer::SetResolution(uint32_t width, uint32_t height) noexcept
+{
+    ENG_ASSERT(width > 0 && height > 0, "Invalid occlusion rasterizer resolution: {}x{}", width, height);
+
+    m_tilesCountX = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+    m_tilesCountY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+
+    m_width = m_tilesCountX * TILE_WIDTH;
+    m_height = m_tilesCountY * TILE_HEIGHT;
+
+    m_depth.assign(uint64_t(m_width) * m_height, CLEAR_DEPTH);
+    m_tileBins.resize(uint64_t(m_tilesCountX) * m_tilesCountY);
+
+    m_hiZBuffer.Clear();
+}
+
+
+void OcclusionRasterizer::BeginFrame(const glm::mat4x4& viewProjMatrix) noexcept
+{
+    if (m_width == 0) {
+        SetResolution(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    }
+
+    m_viewProjMatrix = viewProjMatrix;
+
+    m_occluders.clear();
+    m_triangles.clear();
+
+    for (std::vector<uint32_t>& bin : m_tileBins) {
+        bin.clear();
+    }
+
+    m_stats = {};
+}
+
+
+void OcclusionRasterizer::AddOccluder(const glm::vec3* pPositions, uint32_t verticesCount, const uint32_t* pIndices, uint32_t indicesCount, const glm::mat4x4& worldMatrix) noexcept
+{
+    ENG_ASSERT(m_width > 0, "Occlusion rasterizer frame isn't begun");
+    ENG_ASSERT(pPositions && verticesCount > 0, "Invalid occluder positions");
+    ENG_ASSERT(pIndices && indicesCount % 3 == 0, "Occluder indices count must be multiple of 3");
+
+    Occluder occluder = {};
+    occluder.worldMatrix = worldMatrix;
+    occluder.pPositions = pPositions;
+    occluder.pIndices = pIndices;
+    occluder.verticesCount = verticesCount;
+    occluder.indicesCount = indicesCount;
+
+    m_occluders.emplace_back(occluder);
+
+    ++m_stats.occludersCount;
+    m_stats.trianglesCount += indicesCount / 3;
+}
+
+
+void OcclusionRasterizer::Rasterize() noexcept
+{
+    ENG_ASSERT(m_width > 0, "Occlusion rasterizer frame isn't begun");
+
+    const chr::steady_clock::time_point startTime = chr::steady_clock::now();
+
+    for (const Occluder& occluder : m_occluders) {
+        SetupOccluder(occluder);
+    }
+
+    // Empty depth occludes nothing, skip tests entirely
+    if (m_triangles.empty()) {
+        std::fill(m_depth.begin(), m_depth.end(), CLEAR_DEPTH);
+        m_hiZBuffer.Clear();
+
+        m_stats.rasterTimeMs = chr::duration<float, std::milli>(chr::steady_clock::now() - startTime).count();
+        return;
+    }
+
+    const RasterizeTileFunc RasterizeTile = SelectRasterizeTileFunc(m_SIMDLevel);
+
+    engRunJobBatches(m_tilesCountX * m_tilesCountY, [this, RasterizeTile](uint32_t tileIdx) {
+        const uint32_t tileX = (tileIdx % m_tilesCountX) * TILE_WIDTH;
+        const uint32_t tileY = (tileIdx / m_tilesCountX) * TILE_HEIGHT;
+
+        for (uint32_t y = tileY; y < tileY + TILE_HEIGHT; ++y) {
+            float* pRow = m_depth.data() + uint64_t(y) * m_width + tileX;
+            std::fill(pRow, pRow + TILE_WIDTH, CLEAR_DEPTH);
+        }
+
+        const std::vector<uint32_t>& bin = m_tileBins[tileIdx];
+        RasterizeTile(m_triangles.data(), bin.data(), static_cast<uint32_t>(bin.size()), m_depth.data(), m_width, tileX, tileY);
+    });
+
+    m_hiZBuffer.Build(m_depth.data(), m_width, m_height, m_viewProjMatrix);
+
+    m_stats.rasterTimeMs = chr::duration<float, std::milli>(chr::steady_clock::now() - startTime).count();
+}
+
+
+bool OcclusionRasterizer::IsVisible(const glm::vec3& aabbMin, const glm::vec3& aabbMax) const noexcept
+{
+    const glm::vec3 center = (aabbMin + aabbMax) * 0.5f;
+    const glm::vec3 extents = (aabbMax - aabbMin) * 0.5f;
+
+    return !m_hiZBuffer.IsAABBOccluded(center, extents);
+}
+
+
+void OcclusionRasterizer::CullSpheres(const BoundingSpheresSoA& spheres, std::vector<uint32_t>& inOutVisibleIndices) noexcept
+{
+    m_hiZBuffer.CullSpheres(spheres, inOutVisibleIndices);
+}
+
+
+void OcclusionRasterizer::CullAABBs(const BoundingAABBsSoA& aabbs, std::vector<uint32_t>& inOutVisibleIndices) noexcept
+{
+    m_hiZBuffer.CullAABBs(aabbs, inOutVisibleIndices);
+}
+
+
+void OcclusionRasterizer::SetMaxSIMDLevel(CPUSIMDLevel level) noexcept
+{
+    m_SIMDLevel = std::min(level, GetCPUSIMDLevel());
+}
+
+
+void OcclusionRasterizer::SetupOccluder(const Occluder& occluder) noexcept
+{
+    const glm::mat4x4 worldViewProjMatrix = m_viewProjMatrix * occluder.worldMatrix;
+
+    m_clipPositions.resize(occluder.verticesCount);
+
+    for (uint32_t i = 0; i < occluder.verticesCount; ++i) {
+        m_clipPositions[i] = worldViewProjMatrix * glm::vec4(occluder.pPositions[i], 1.f);
+    }
+
+    const float width = static_cast<float>(m_width);
+    const float height = static_cast<float>(m_height);
+
+    for (uint32_t i = 0; i < occluder.indicesCount; i += 3) {
+        float screenX[3];
+        float screenY[3];
+        float depth[3];
+
+        bool isRejected = false;
+
+        for (uint32_t v = 0; v < 3; ++v) {
+            const uint32_t vertexIdx = occluder.pIndices[i + v];
+            ENG_ASSERT(vertexIdx < occluder.verticesCount, "Occluder vertex index {} is out of range", vertexIdx);
+
+            const glm::vec4& clip = m_clipPositions[vertexIdx];
+
+            if (clip.w <= M3D_EPS) {
+                isRejected = true;
+                break;
+            }
+
+            const float invW = 1.f / clip.w;
+
+            screenX[v] = (clip.x * invW * 0.5f + 0.5f) * width;
+            screenY[v] = (clip.y * invW * 0.5f + 0.5f) * height;
+        #if defined(GLM_FORCE_DEPTH_ZERO_TO_ONE)
+            depth[v] = clip.z * invW;
+        #else
+            depth[v] = clip.z * invW * 0.5f + 0.5f;
+        #endif
+
+            // Hardware clips geometry in front of the near plane, so it can't occlude anything
+            isRejected = isRejected || IsNearer(depth[v], NEAR_PLANE_DEPTH);
+        }
+
+        if (isRejected) {
+            continue;
+        }
+
+        const float area = (screenX[1] - screenX[0]) * (screenY[2] - screenY[0]) - (screenX[2] - screenX[0]) * (screenY[1] - screenY[0]);
+
+        if (std::abs(area) < MIN_TRIANGLE_AREA) {
+            continue;
+        }
+
+        // Pixel centers are at half integer coordinates
+        const float minPixelX = std::ceil(std::min({ screenX[0], screenX[1], screenX[2] }) - 0.5f);
+        const float minPixelY = std::ceil(std::min({ screenY[0], screenY[1], screenY[2] }) - 0.5f);
+        const float maxPixelX = std::floor(std::max({ screenX[0], screenX[1], screenX[2] }) - 0.5f);
+        const float maxPixelY = std::floor(std::max({ screenY[0], screenY[1], screenY[2] }) - 0.5f);
+
+        if (maxPixelX < 0.f || maxPixelY < 0.f || minPixelX > width - 1.f || minPixelY > height - 1.f || minPixelX > maxPixelX || minPixelY > maxPixelY) {
+            continue;
+        }
+
+        Triangle triangle = {};
+
+        triangle.minX = static_cast<uint32_t>(std::max(minPixelX, 0.f));
+        triangle.minY = static_cast<uint32_t>(std::max(minPixelY, 0.f));
+        triangle.maxX = static_cast<uint32_t>(std::min(maxPixelX, width - 1.f));
+        triangle.maxY = static_cast<uint32_t>(std::min(maxPixelY, height - 1.f));
+
+        // Edge functions of counter clockwise triangles are positive inside, clockwise ones are flipped
+        const float orientation = area > 0.f ? 1.f : -1.f;
+
+        for (uint32_t e = 0; e < 3; ++e) {
+            const uint32_t v0 = e;
+            const uint32_t v1 = (e + 1) % 3;
+
+            triangle.edgeA[e] = (screenY[v0] - screenY[v1]) * orientation;
+            triangle.edgeB[e] = (screenX[v1] - screenX[v0]) * orientation;
+            triangle.edgeC[e] = (screenX[v0] * screenY[v1] - screenY[v0] * screenX[v1]) * orientation;
+        }
+
+        const float invArea = 1.f / area;
+
+        triangle.depthA = ((depth[1] - depth[0]) * (screenY[2] - screenY[0]) - (depth[2] - depth[0]) * (screenY[1] - screenY[0])) * invArea;
+        triangle.depthB = ((depth[2] - depth[0]) * (screenX[1] - screenX[0]) - (depth[1] - depth[0]) * (screenX[2] - screenX[0])) * invArea;
+        triangle.depthC = depth[0] - triangle.depthA * screenX[0] - triangle.depthB * screenY[0];
+
+        triangle.minDepth = std::min({ depth[0], depth[1], depth[2] });
+        triangle.maxDepth = std::max({ depth[0], depth[1], depth[2] });
+
+        m_triangles.emplace_back(triangle);
+        BinTriangle(static_cast<uint32_t>(m_triangles.size() - 1));
+
+        ++m_stats.setupTrianglesCount;
+    }
+}
+
+
+void OcclusionRasterizer::BinTriangle(uint32_t triangleIdx) noexcept
+{
+    const Triangle& triangle = m_triangles[triangleIdx];
+
+    const uint32_t minTileX = triangle.minX / TILE_WIDTH;
+    const uint32_t minTileY = triangle.minY / TILE_HEIGHT;
+    const uint32_t maxTileX = triangle.maxX / TILE_WIDTH;
+    const uint32_t maxTileY = triangle.maxY / TILE_HEIGHT;
+
+    for (uint32_t tileY = minTileY; tileY <= maxTileY; ++tileY) {
+        for (uint32_t tileX = minTileX; tileX <= maxTileX; ++tileX) {
+            m_tileBins[tileY * m_tilesCountX + tileX].emplace_back(triangleIdx);
+        }
+    }
+
+    m_stats.binnedTrianglesCount += (maxTileX - minTileX + 1) * (maxTileY - minTileY + 1);
+}
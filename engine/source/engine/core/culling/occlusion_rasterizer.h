@@ -0,0 +1,123 @@
+#pragma once
+
+#include "core/culling/hiz_buffer.h"
+
+#include "utils/cpu/cpu_features.h"
+#include "utils/math/common_math.h"
+
+#include "core.h"
+
+#include <vector>
+
+#include <cstdint>
+
+
+struct OcclusionRasterizerStats
+{
+    uint32_t occludersCount;
+    uint32_t trianglesCount;        // Triangles of all occluders
+    uint32_t setupTrianglesCount;   // Triangles left after near plane, off screen and zero area rejection
+    uint32_t binnedTrianglesCount;  // Sum of triangles over all tile bins
+    float    rasterTimeMs;          // Setup, binning, rasterization and HiZ build
+};
+
+
+// CPU depth rasterizer for low poly occluders. Occluder triangles are transformed, set up and binned into screen tiles,
+// then tiles are rasterized in parallel with SSE2 or AVX (selected at runtime), every tile owns its pixels so jobs never share writes.
+// The depth buffer has low resolution, follows ENG_USE_INVERTED_Z and has rows bottom to top, the same as the hardware one.
+// Triangles crossing the near plane are skipped instead of clipped, that only loses occlusion, never adds it.
+// Visibility queries go through a HiZBuffer built from the rasterized depth
+class OcclusionRasterizer
+{
+public:
+    // Sizes are rounded up to the tile size
+    void SetResolution(uint32_t width, uint32_t height) noexcept;
+
+    void BeginFrame(const glm::mat4x4& viewProjMatrix) noexcept;
+
+    // Occluder data isn't copied and must stay alive until Rasterize()
+    void AddOccluder(const glm::vec3* pPositions, uint32_t verticesCount, const uint32_t* pIndices, uint32_t indicesCount, const glm::mat4x4& worldMatrix) noexcept;
+
+    void Rasterize() noexcept;
+
+    // Bounds are visible until the first Rasterize() and when there are no occluders
+    bool IsVisible(const glm::vec3& aabbMin, const glm::vec3& aabbMax) const noexcept;
+
+    // Remove occluded volumes from inOutVisibleIndices, the order of the rest is kept
+    void CullSpheres(const BoundingSpheresSoA& spheres, std::vector<uint32_t>& inOutVisibleIndices) noexcept;
+    void CullAABBs(const BoundingAABBsSoA& aabbs, std::vector<uint32_t>& inOutVisibleIndices) noexcept;
+
+    // Caps tile rasterization kernels at the level, e.g. to compare them with each other. Levels above the CPU support are clamped
+    void SetMaxSIMDLevel(CPUSIMDLevel level) noexcept;
+    CPUSIMDLevel GetSIMDLevel() const noexcept { return m_SIMDLevel; }
+
+    const float* GetDepth() const noexcept { return m_depth.data(); }
+    uint32_t GetWidth() const noexcept { return m_width; }
+    uint32_t GetHeight() const noexcept { return m_height; }
+
+    const HiZBuffer& GetHiZBuffer() const noexcept { return m_hiZBuffer; }
+    const OcclusionRasterizerStats& GetStats() const noexcept { return m_stats; }
+
+public:
+    static inline constexpr uint32_t TILE_WIDTH = 32;
+    static inline constexpr uint32_t TILE_HEIGHT = 16;
+
+    static inline constexpr uint32_t DEFAULT_WIDTH = 320;
+    static inline constexpr uint32_t DEFAULT_HEIGHT = 192;
+
+public:
+    // Screen space triangle in pixels. Edge functions are positive inside, depth is a plane over the screen
+    // clamped to the vertices depth range. Bounds are inclusive pixel ranges of covered pixel centers
+    struct Triangle
+    {
+        float    edgeA[3];
+        float    edgeB[3];
+        float    edgeC[3];
+        float    depthA;
+        float    depthB;
+        float    depthC;
+        float    minDepth;
+        float    maxDepth;
+        uint32_t minX;
+        uint32_t minY;
+        uint32_t maxX;
+        uint32_t maxY;
+    };
+
+private:
+    struct Occluder
+    {
+        glm::mat4x4       worldMatrix;
+        const glm::vec3*  pPositions;
+        const uint32_t*   pIndices;
+        uint32_t          verticesCount;
+        uint32_t          indicesCount;
+    };
+
+    void SetupOccluder(const Occluder& occluder) noexcept;
+    void BinTriangle(uint32_t triangleIdx) noexcept;
+
+private:
+    std::vector<Occluder> m_occluders;
+
+    std::vector<glm::vec4> m_clipPositions;
+    std::vector<Triangle> m_triangles;
+
+    // Triangle indices per tile, in submission order
+    std::vector<std::vector<uint32_t>> m_tileBins;
+
+    std::vector<float> m_depth;
+
+    HiZBuffer m_hiZBuffer;
+
+    glm::mat4x4 m_viewProjMatrix = M3D_MAT4_IDENTITY;
+
+    OcclusionRasterizerStats m_stats = {};
+
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_tilesCountX = 0;
+    uint32_t m_tilesCountY = 0;
+
+    CPUSIMDLevel m_SIMDLevel = GetCPUSIMDLevel();
+};
@@ -0,0 +1,214 @@
+#include "pch.h"
+#include "ecs_world.h"
+
+#include "utils/math/common_math.h"
+
+
+void EcsWorld::Clear() noexcept
+{
+    m_archetypes.clear();
+    m_maskToArchetypeIdx.clear();
+
+    m_IDPool.Reset();
+    m_records.clear();
+
+    m_queryChunks.clear();
+}
+
+
+void EcsWorld::DestroyEntity(EntityID ID) noexcept
+{
+    if (!IsEntityValid(ID)) {
+        ENG_ASSERT_FAIL("Invalid entity ID");
+        return;
+    }
+
+    const EntityRecord record = m_records[ID.Index()];
+    FreeRow(record.archetypeIdx, record.row);
+
+    m_IDPool.Deallocate(ID);
+}
+
+
+uint32_t EcsWorld::GetEntitiesCount(ComponentMask mask) const noexcept
+{
+    uint32_t count = 0;
+
+    for (const std::unique_ptr<Archetype>& pArchetype : m_archetypes) {
+        if ((pArchetype->mask & mask) == mask) {
+            count += pArchetype->entitiesCount;
+        }
+    }
+
+    return count;
+}
+
+
+uint32_t EcsWorld::RegisterComponentType(uint32_t size, uint32_t alignment) noexcept
+{
+    const uint32_t typeID = s_componentTypesCount.fetch_add(1, std::memory_order_relaxed);
+
+    ENG_ASSERT(typeID < ECS_MAX_COMPONENT_TYPES_COUNT, "ECS component types count exceeds {}", ECS_MAX_COMPONENT_TYPES_COUNT);
+    ENG_ASSERT(alignment <= alignof(Chunk), "ECS component alignment {} exceeds chunk alignment", alignment);
+
+    s_componentTypes[typeID] = ComponentTypeInfo { size, alignment };
+
+    return typeID;
+}
+
+
+EntityID* EcsWorld::GetIDs(const Archetype& archetype, uint32_t chunkIdx) noexcept
+{
+    // IDs are the first column
+    return reinterpret_cast<EntityID*>(archetype.chunks[chunkIdx]->data);
+}
+
+
+uint8_t* EcsWorld::GetComponentData(const Archetype& archetype, uint32_t componentTypeID, uint32_t row) noexcept
+{
+    const uint32_t chunkIdx = row / archetype.chunkCapacity;
+    const uint32_t chunkRow = row % archetype.chunkCapacity;
+
+    return archetype.chunks[chunkIdx]->data + archetype.columnOffsets[componentTypeID] + chunkRow * s_componentTypes[componentTypeID].size;
+}
+
+
+uint32_t EcsWorld::GetChunkEntitiesCount(const Archetype& archetype, uint32_t chunkIdx) noexcept
+{
+    return std::min(archetype.chunkCapacity, archetype.entitiesCount - chunkIdx * archetype.chunkCapacity);
+}
+
+
+uint32_t EcsWorld::GetOrCreateArchetype(ComponentMask mask) noexcept
+{
+    const auto archetypeIt = m_maskToArchetypeIdx.find(mask);
+
+    if (archetypeIt != m_maskToArchetypeIdx.end()) {
+        return archetypeIt->second;
+    }
+
+    std::unique_ptr<Archetype> pArchetype = std::make_unique<Archetype>();
+    pArchetype->mask = mask;
+    pArchetype->entitiesCount = 0;
+    pArchetype->columnOffsets.fill(UINT32_MAX);
+
+    uint32_t entitySize = sizeof(EntityID);
+
+    for (uint32_t typeID = 0; typeID < ECS_MAX_COMPONENT_TYPES_COUNT; ++typeID) {
+        if (mask & (ComponentMask(1) << typeID)) {
+            pArchetype->componentTypeIDs.emplace_back(typeID);
+            entitySize += s_componentTypes[typeID].size;
+        }
+    }
+
+    // Column alignment padding may not fit with the ideal capacity, shrink it until the layout fits
+    for (uint32_t capacity = ECS_CHUNK_SIZE / entitySize; capacity > 0; --capacity) {
+        uint32_t offset = capacity * sizeof(EntityID);
+
+        for (uint32_t typeID : pArchetype->componentTypeIDs) {
+            offset = amAlignUp(offset, s_componentTypes[typeID].alignment);
+            pArchetype->columnOffsets[typeID] = offset;
+            offset += capacity * s_componentTypes[typeID].size;
+        }
+
+        if (offset <= ECS_CHUNK_SIZE) {
+            pArchetype->chunkCapacity = capacity;
+            break;
+        }
+    }
+
+    ENG_ASSERT(pArchetype->chunkCapacity > 0, "ECS archetype entity doesn't fit into a {} bytes chunk", ECS_CHUNK_SIZE);
+
+    const uint32_t archetypeIdx = static_cast<uint32_t>(m_archetypes.size());
+
+    m_archetypes.emplace_back(std::move(pArchetype));
+    m_maskToArchetypeIdx.emplace(mask, archetypeIdx);
+
+    return archetypeIdx;
+}
+
+
+uint32_t EcsWorld::AllocateRow(uint32_t archetypeIdx, EntityID ID) noexcept
+{
+    Archetype& archetype = *m_archetypes[archetypeIdx];
+
+    const uint32_t row = archetype.entitiesCount;
+
+    if (row == archetype.chunks.size() * archetype.chunkCapacity) {
+        // Chunk memory is left uninitialized, rows are written before they are read
+        archetype.chunks.emplace_back(new Chunk);
+    }
+
+    ++archetype.entitiesCount;
+
+    GetIDs(archetype, row / archetype.chunkCapacity)[row % archetype.chunkCapacity] = ID;
+
+    if (ID.Index() >= m_records.size()) {
+        m_records.resize(ID.Index() + 1);
+    }
+
+    m_records[ID.Index()] = EntityRecord { archetypeIdx, row };
+
+    return row;
+}
+
+
+void EcsWorld::FreeRow(uint32_t archetypeIdx, uint32_t row) noexcept
+{
+    Archetype& archetype = *m_archetypes[archetypeIdx];
+
+    const uint32_t lastRow = archetype.entitiesCount - 1;
+
+    if (row != lastRow) {
+        EntityID& ID = GetIDs(archetype, row / archetype.chunkCapacity)[row % archetype.chunkCapacity];
+        ID = GetIDs(archetype, lastRow / archetype.chunkCapacity)[lastRow % archetype.chunkCapacity];
+
+        for (uint32_t typeID : archetype.componentTypeIDs) {
+            memcpy(GetComponentData(archetype, typeID, row), GetComponentData(archetype, typeID, lastRow), s_componentTypes[typeID].size);
+        }
+
+        m_records[ID.Index()].row = row;
+    }
+
+    --archetype.entitiesCount;
+
+    if (archetype.entitiesCount == (archetype.chunks.size() - 1) * archetype.chunkCapacity) {
+        archetype.chunks.pop_back();
+    }
+}
+
+
+void EcsWorld::MoveEntity(EntityID ID, ComponentMask newMask) noexcept
+{
+    const EntityRecord oldRecord = m_records[ID.Index()];
+
+    const uint32_t newArchetypeIdx = GetOrCreateArchetype(newMask);
+    const uint32_t newRow = AllocateRow(newArchetypeIdx, ID);
+
+    const Archetype& oldArchetype = *m_archetypes[oldRecord.archetypeIdx];
+    const Archetype& newArchetype = *m_archetypes[newArchetypeIdx];
+
+    for (uint32_t typeID : newArchetype.componentTypeIDs) {
+        if (oldArchetype.mask & (ComponentMask(1) << typeID)) {
+            memcpy(GetComponentData(newArchetype, typeID, newRow), GetComponentData(oldArchetype, typeID, oldRecord.row), s_componentTypes[typeID].size);
+        }
+    }
+
+    FreeRow(oldRecord.archetypeIdx, oldRecord.row);
+}
+
+
+void EcsWorld::CollectChunks(ComponentMask mask) noexcept
+{
+    m_queryChunks.clear();
+
+    for (const std::unique_ptr<Archetype>& pArchetype : m_archetypes) {
+        if ((pArchetype->mask & mask) != mask) {
+            continue;
+        }
+
+        for (uint32_t chunkIdx = 0; chunkIdx < pArchetype->chunks.size(); ++chunkIdx) {
+            m_queryChunks.emplace_back(ChunkRef { pArchetype.get(), chunkIdx });
+        }
+    }
+}
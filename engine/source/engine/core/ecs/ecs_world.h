@@ -0,0 +1,160 @@
+#pragma once
+
+#include "utils/data_structures/generational_id.h"
+
+#include "core.h"
+
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <array>
+
+#include <type_traits>
+#include <atomic>
+#include <cstdint>
+
+
+using EntityID = ds::GenerationalID<uint32_t>;
+using ComponentMask = uint64_t;
+
+
+inline constexpr uint32_t ECS_MAX_COMPONENT_TYPES_COUNT = sizeof(ComponentMask) * 8;
+inline constexpr uint32_t ECS_CHUNK_SIZE = 16 * 1024;
+
+
+struct ComponentTypeInfo
+{
+    uint32_t size;
+    uint32_t alignment;
+};
+
+
+// Archetype based entity storage. Entities with the same set of component types share an archetype, which keeps them
+// in 16 KB chunks with one SoA column per component type and a column of entity IDs. Archetype entities are packed:
+// all chunks are full except the last one, removal moves the last entity into the hole.
+// Components must be trivially copyable, they are moved between chunks and archetypes with memcpy.
+// Component pointers are stable until the next structural change (create, destroy, add or remove component). Not thread safe
+class EcsWorld
+{
+public:
+    // Component type IDs are assigned on first use, the same for all worlds
+    template <typename T>
+    static uint32_t GetComponentTypeID() noexcept;
+
+    template <typename... Ts>
+    static ComponentMask GetComponentMask() noexcept;
+
+public:
+    EcsWorld() = default;
+
+    EcsWorld(const EcsWorld& other) = delete;
+    EcsWorld& operator=(const EcsWorld& other) = delete;
+
+    void Clear() noexcept;
+
+    template <typename... Ts>
+    EntityID CreateEntity(const Ts&... components) noexcept;
+    void DestroyEntity(EntityID ID) noexcept;
+
+    // Move the entity to another archetype
+    template <typename T>
+    void AddComponent(EntityID ID, const T& component) noexcept;
+    template <typename T>
+    void RemoveComponent(EntityID ID) noexcept;
+
+    // nullptr if the entity has no such component
+    template <typename T>
+    T* GetComponent(EntityID ID) noexcept;
+    template <typename T>
+    bool HasComponent(EntityID ID) const noexcept;
+
+    // Calls func(const EntityID* pIDs, Ts* pComponents..., uint32_t count) for every chunk of archetypes with all Ts
+    template <typename... Ts, typename Func>
+    void ForEachChunk(Func&& func) noexcept;
+
+    // Same as ForEachChunk, but chunks are split between jobs if the job system is initialized,
+    // so func is called concurrently and mustn't change the world structure
+    template <typename... Ts, typename Func>
+    void ParallelForEachChunk(Func&& func) noexcept;
+
+    // Calls func(EntityID ID, Ts& components...) for every entity with all Ts
+    template <typename... Ts, typename Func>
+    void ForEach(Func&& func) noexcept;
+
+    // Entities with all components of the mask
+    uint32_t GetEntitiesCount(ComponentMask mask = 0) const noexcept;
+    uint32_t GetArchetypesCount() const noexcept { return static_cast<uint32_t>(m_archetypes.size()); }
+
+    bool IsEntityValid(EntityID ID) const noexcept { return m_IDPool.IsAllocated(ID); }
+
+private:
+    struct alignas(64) Chunk
+    {
+        uint8_t data[ECS_CHUNK_SIZE];
+    };
+
+    struct Archetype
+    {
+        std::vector<std::unique_ptr<Chunk>> chunks;
+
+        // Column offsets inside a chunk by component type ID, valid for types of the mask only
+        std::array<uint32_t, ECS_MAX_COMPONENT_TYPES_COUNT> columnOffsets;
+        std::vector<uint32_t> componentTypeIDs;
+
+        ComponentMask mask;
+
+        uint32_t chunkCapacity;
+        uint32_t entitiesCount;
+    };
+
+    struct EntityRecord
+    {
+        uint32_t archetypeIdx;
+        uint32_t row;
+    };
+
+    struct ChunkRef
+    {
+        Archetype* pArchetype;
+        uint32_t   chunkIdx;
+    };
+
+    static uint32_t RegisterComponentType(uint32_t size, uint32_t alignment) noexcept;
+
+    static EntityID* GetIDs(const Archetype& archetype, uint32_t chunkIdx) noexcept;
+    static uint8_t* GetComponentData(const Archetype& archetype, uint32_t componentTypeID, uint32_t row) noexcept;
+    static uint32_t GetChunkEntitiesCount(const Archetype& archetype, uint32_t chunkIdx) noexcept;
+
+    template <typename... Ts, typename Func>
+    static void CallChunkFunc(const Archetype& archetype, uint32_t chunkIdx, Func& func) noexcept;
+
+    uint32_t GetOrCreateArchetype(ComponentMask mask) noexcept;
+
+    // Returns the row of the new entity, its components are left uninitialized
+    uint32_t AllocateRow(uint32_t archetypeIdx, EntityID ID) noexcept;
+    void FreeRow(uint32_t archetypeIdx, uint32_t row) noexcept;
+
+    // Moves the entity to the archetype of newMask, components of both archetypes are copied
+    void MoveEntity(EntityID ID, ComponentMask newMask) noexcept;
+
+    void CollectChunks(ComponentMask mask) noexcept;
+
+private:
+    static inline std::array<ComponentTypeInfo, ECS_MAX_COMPONENT_TYPES_COUNT> s_componentTypes = {};
+    static inline std::atomic<uint32_t> s_componentTypesCount = 0;
+
+private:
+    std::vector<std::unique_ptr<Archetype>> m_archetypes;
+    std::unordered_map<ComponentMask, uint32_t> m_maskToArchetypeIdx;
+
+    ds::GenerationalIDPool<EntityID> m_IDPool;
+
+    // By entity ID index
+    std::vector<EntityRecord> m_records;
+
+    // Parallel query scratch
+    std::vector<ChunkRef> m_queryChunks;
+};
+
+
+#include "ecs_world.hpp"
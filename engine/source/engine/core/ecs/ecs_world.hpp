@@ -0,0 +1,180 @@
+#include "core/job_system/job_system.h"
+
+#include "utils/debug/assertion.h"
+
+#include <cstring>
+
+
+template <typename T>
+inline uint32_t EcsWorld::GetComponentTypeID() noexcept
+{
+    if constexpr (!std::is_same_v<T, std::remove_cv_t<T>>) {
+        return GetComponentTypeID<std::remove_cv_t<T>>();
+    } else {
+        static_assert(std::is_trivially_copyable_v<T>, "ECS components must be trivially copyable");
+
+        static const uint32_t typeID = RegisterComponentType(sizeof(T), alignof(T));
+        return typeID;
+    }
+}
+
+
+template <typename... Ts>
+inline ComponentMask EcsWorld::GetComponentMask() noexcept
+{
+    return (ComponentMask(0) | ... | (ComponentMask(1) << GetComponentTypeID<Ts>()));
+}
+
+
+template <typename... Ts>
+inline EntityID EcsWorld::CreateEntity(const Ts&... components) noexcept
+{
+    const EntityID ID = m_IDPool.Allocate();
+
+    if (!ID.IsValid()) {
+        ENG_ASSERT_FAIL("Failed to allocate entity ID");
+        return ID;
+    }
+
+    const uint32_t archetypeIdx = GetOrCreateArchetype(GetComponentMask<Ts...>());
+    const uint32_t row = AllocateRow(archetypeIdx, ID);
+
+    const Archetype& archetype = *m_archetypes[archetypeIdx];
+    (memcpy(GetComponentData(archetype, GetComponentTypeID<Ts>(), row), &components, sizeof(Ts)), ...);
+
+    return ID;
+}
+
+
+template <typename T>
+inline void EcsWorld::AddComponent(EntityID ID, const T& component) noexcept
+{
+    ENG_ASSERT(IsEntityValid(ID), "Invalid entity ID");
+
+    const uint32_t componentTypeID = GetComponentTypeID<T>();
+    const ComponentMask mask = m_archetypes[m_records[ID.Index()].archetypeIdx]->mask;
+
+    if ((mask & (ComponentMask(1) << componentTypeID)) == 0) {
+        MoveEntity(ID, mask | (ComponentMask(1) << componentTypeID));
+    }
+
+    const EntityRecord& record = m_records[ID.Index()];
+    memcpy(GetComponentData(*m_archetypes[record.archetypeIdx], componentTypeID, record.row), &component, sizeof(T));
+}
+
+
+template <typename T>
+inline void EcsWorld::RemoveComponent(EntityID ID) noexcept
+{
+    ENG_ASSERT(IsEntityValid(ID), "Invalid entity ID");
+
+    const ComponentMask componentBit = ComponentMask(1) << GetComponentTypeID<T>();
+    const ComponentMask mask = m_archetypes[m_records[ID.Index()].archetypeIdx]->mask;
+
+    if ((mask & componentBit) != 0) {
+        MoveEntity(ID, mask & ~componentBit);
+    }
+}
+
+
+template <typename T>
+inline T* EcsWorld::GetComponent(EntityID ID) noexcept
+{
+    if (!IsEntityValid(ID)) {
+        ENG_ASSERT_FAIL("Invalid entity ID");
+        return nullptr;
+    }
+
+    const uint32_t componentTypeID = GetComponentTypeID<T>();
+
+    const EntityRecord& record = m_records[ID.Index()];
+    const Archetype& archetype = *m_archetypes[record.archetypeIdx];
+
+    if ((archetype.mask & (ComponentMask(1) << componentTypeID)) == 0) {
+        return nullptr;
+    }
+
+    return reinterpret_cast<T*>(GetComponentData(archetype, componentTypeID, record.row));
+}
+
+
+template <typename T>
+inline bool EcsWorld::HasComponent(EntityID ID) const noexcept
+{
+    if (!IsEntityValid(ID)) {
+        return false;
+    }
+
+    return (m_archetypes[m_records[ID.Index()].archetypeIdx]->mask & (ComponentMask(1) << GetComponentTypeID<T>())) != 0;
+}
+
+
+template <typename... Ts, typename Func>
+inline void EcsWorld::CallChunkFunc(const Archetype& archetype, uint32_t chunkIdx, Func& func) noexcept
+{
+    uint8_t* pChunkData = archetype.chunks[chunkIdx]->data;
+
+    func(GetIDs(archetype, chunkIdx), reinterpret_cast<Ts*>(pChunkData + archetype.columnOffsets[GetComponentTypeID<Ts>()])...,
+        GetChunkEntitiesCount(archetype, chunkIdx));
+}
+
+
+template <typename... Ts, typename Func>
+inline void EcsWorld::ForEachChunk(Func&& func) noexcept
+{
+    const ComponentMask mask = GetComponentMask<Ts...>();
+
+    for (const std::unique_ptr<Archetype>& pArchetype : m_archetypes) {
+        if ((pArchetype->mask & mask) != mask) {
+            continue;
+        }
+
+        for (uint32_t chunkIdx = 0; chunkIdx < pArchetype->chunks.size(); ++chunkIdx) {
+            CallChunkFunc<Ts...>(*pArchetype, chunkIdx, func);
+        }
+    }
+}
+
+
+template <typename... Ts, typename Func>
+inline void EcsWorld::ParallelForEachChunk(Func&& func) noexcept
+{
+    CollectChunks(GetComponentMask<Ts...>());
+
+    const uint32_t chunksCount = static_cast<uint32_t>(m_queryChunks.size());
+
+    if (chunksCount > 1 && engIsJobSystemInitialized()) {
+        struct QueryContext
+        {
+            const ChunkRef*             pChunks;
+            std::remove_reference_t<Func>* pFunc;
+        };
+
+        const QueryContext context = { m_queryChunks.data(), &func };
+
+        JobSystem& jobSystem = JobSystem::GetInstance();
+        JobCounter chunksCounter;
+
+        jobSystem.ParallelFor(chunksCount, 1, [pContext = &context](uint32_t chunkRefIdx) {
+            const ChunkRef& chunkRef = pContext->pChunks[chunkRefIdx];
+            CallChunkFunc<Ts...>(*chunkRef.pArchetype, chunkRef.chunkIdx, *pContext->pFunc);
+        }, chunksCounter);
+
+        jobSystem.Wait(chunksCounter);
+    } else {
+        for (const ChunkRef& chunkRef : m_queryChunks) {
+            CallChunkFunc<Ts...>(*chunkRef.pArchetype, chunkRef.chunkIdx, func);
+        }
+    }
+}
+
+
+template <typename... Ts, typename Func>
+inline void EcsWorld::ForEach(Func&& func) noexcept
+{
+    ForEachChunk<Ts...>([&func](const EntityID* pIDs, Ts*... pComponents, uint32_t count) {
+        for (uint32_t i = 0; i < count; ++i) {
+            func(pIDs[i], pComponents[i]...);
+        }
+    });
+}
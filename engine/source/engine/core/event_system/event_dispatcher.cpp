@@ -24,6 +24,14 @@ namespace es
     }
 
 
+    void EventDispatcher::ListenersStorage::Reserve(uint64_t capacity) noexcept
+    {
+        m_callbacks.reserve(capacity);
+        m_denseToListenerIdx.reserve(capacity);
+        m_listenerIdxToDense.reserve(capacity);
+    }
+
+
     uint64_t EventDispatcher::ListenersStorage::Add(const ListenerCallback& callback) noexcept
     {
         ENG_ASSERT(bool(callback), "Invalid callback");
@@ -31,23 +39,34 @@ namespace es
         const uint64_t idx = m_idxPool.Allocate().Value();
         ENG_ASSERT(idx < MAX_LISTENERS_STORAGE_CAPACITY, "Listeners limit has been reached");
 
-        const size_t storageCapacity = m_storage.capacity();
-
-        if (idx >= storageCapacity) {
-            m_storage.reserve(storageCapacity * 2ULL);
-        }
-
-        if (idx >= m_storage.size()) {
-            m_storage.resize(idx + 1);
+        if (idx >= m_listenerIdxToDense.size()) {
+            m_listenerIdxToDense.resize(idx + 1, INVALID_DENSE_IDX);
         }
 
-        m_storage[idx] = callback;
+        m_listenerIdxToDense[idx] = static_cast<uint32_t>(m_callbacks.size());
+        m_denseToListenerIdx.emplace_back(static_cast<uint32_t>(idx));
+        m_callbacks.emplace_back(callback);
         
         return idx;
     }
 
 
     void EventDispatcher::ListenersStorage::Remove(uint64_t index) noexcept
+    {
+        if (!m_idxPool.IsAllocated(ListenerIndex(index))) {
+            return;
+        }
+
+        if (m_notifyDepth > 0) {
+            m_pendingRemovals.emplace_back(static_cast<uint32_t>(index));
+            return;
+        }
+
+        RemoveImmediate(index);
+    }
+
+
+    void EventDispatcher::ListenersStorage::RemoveImmediate(uint64_t index) noexcept
     {
         ListenerIndex listenerIdx(index);
 
@@ -55,11 +74,20 @@ namespace es
             return;
         }
 
-        if (index == m_storage.size() - 1) {
-            m_storage.pop_back();
-        } else {
-            m_storage[index] = DEFAULT_EVENT_CALLBACK;
+        const uint32_t denseIdx = m_listenerIdxToDense[index];
+        const uint32_t lastDenseIdx = static_cast<uint32_t>(m_callbacks.size() - 1);
+
+        if (denseIdx != lastDenseIdx) {
+            const uint32_t lastListenerIdx = m_denseToListenerIdx[lastDenseIdx];
+
+            m_callbacks[denseIdx] = std::move(m_callbacks[lastDenseIdx]);
+            m_denseToListenerIdx[denseIdx] = lastListenerIdx;
+            m_listenerIdxToDense[lastListenerIdx] = denseIdx;
         }
+
+        m_callbacks.pop_back();
+        m_denseToListenerIdx.pop_back();
+        m_listenerIdxToDense[index] = INVALID_DENSE_IDX;
         
         m_idxPool.Deallocate(listenerIdx);
     }
@@ -69,19 +97,171 @@ namespace es
     {
         ENG_ASSERT(pEvent, "pEvent is nullptr");
 
-        for (const ListenerCallback& callback : m_storage) {
-            callback(pEvent);
+        ++m_notifyDepth;
+
+        // Listeners added during the fan-out don't receive the current event
+        const size_t callbacksCount = m_callbacks.size();
+
+        for (size_t i = 0; i < callbacksCount; ++i) {
+            m_callbacks[i](pEvent);
+        }
+
+        --m_notifyDepth;
+
+        if (m_notifyDepth == 0 && !m_pendingRemovals.empty()) {
+            for (uint32_t index : m_pendingRemovals) {
+                RemoveImmediate(index);
+            }
+
+            m_pendingRemovals.clear();
         }
     }
 
 
     void EventDispatcher::ListenersStorage::Reset() noexcept
     {
-        m_storage.clear();
+        ENG_ASSERT(m_notifyDepth == 0, "Listeners storage reset during notification");
+
+        m_callbacks.clear();
+        m_denseToListenerIdx.clear();
+        m_listenerIdxToDense.clear();
+        m_pendingRemovals.clear();
         m_idxPool.Reset();
     }
 
 
+    void EventDispatcher::EventQueue::Push(uint64_t eventTypeIndex, const void* pEvent, size_t eventSize) noexcept
+    {
+        const size_t eventBlocksCount = (eventSize + sizeof(BlockType) - 1) / sizeof(BlockType);
+        const size_t newSize = m_size + HEADER_BLOCKS_COUNT + eventBlocksCount;
+
+        ENG_ASSERT(newSize < INVALID_OFFSET, "Event queue overflow");
+
+        if (newSize > m_buffer.size()) {
+            m_buffer.resize(std::max<size_t>(newSize, m_buffer.size() * 2));
+        }
+
+        if (eventTypeIndex >= m_lastEventOffsets.size()) {
+            m_lastEventOffsets.resize(eventTypeIndex + 1, INVALID_OFFSET);
+        }
+
+        if (m_lastEventOffsets[eventTypeIndex] == INVALID_OFFSET) {
+            m_queuedEventTypes.emplace_back(static_cast<uint32_t>(eventTypeIndex));
+        }
+
+        EventHeader* pHeader = reinterpret_cast<EventHeader*>(m_buffer.data() + m_size);
+        pHeader->eventTypeIndex = static_cast<uint32_t>(eventTypeIndex);
+        pHeader->eventSize = static_cast<uint32_t>(eventSize);
+        pHeader->isAlive = 1;
+        pHeader->padding = 0;
+
+        memcpy(m_buffer.data() + m_size + HEADER_BLOCKS_COUNT, pEvent, eventSize);
+
+        m_lastEventOffsets[eventTypeIndex] = static_cast<uint32_t>(m_size);
+        m_size = newSize;
+    }
+
+
+    void* EventDispatcher::EventQueue::FindLast(uint64_t eventTypeIndex) noexcept
+    {
+        if (eventTypeIndex >= m_lastEventOffsets.size()) {
+            return nullptr;
+        }
+
+        const uint32_t offset = m_lastEventOffsets[eventTypeIndex];
+        if (offset == INVALID_OFFSET) {
+            return nullptr;
+        }
+
+        const EventHeader* pHeader = reinterpret_cast<const EventHeader*>(m_buffer.data() + offset);
+        return pHeader->isAlive ? m_buffer.data() + offset + HEADER_BLOCKS_COUNT : nullptr;
+    }
+
+
+    void EventDispatcher::EventQueue::RemoveLast(uint64_t eventTypeIndex) noexcept
+    {
+        if (FindLast(eventTypeIndex) == nullptr) {
+            return;
+        }
+
+        EventHeader* pHeader = reinterpret_cast<EventHeader*>(m_buffer.data() + m_lastEventOffsets[eventTypeIndex]);
+        pHeader->isAlive = 0;
+    }
+
+
+    void EventDispatcher::EventQueue::Clear() noexcept
+    {
+        for (uint32_t eventTypeIndex : m_queuedEventTypes) {
+            m_lastEventOffsets[eventTypeIndex] = INVALID_OFFSET;
+        }
+
+        m_queuedEventTypes.clear();
+        m_size = 0;
+    }
+
+
+    EventDispatcher::ThreadEventQueue::ThreadEventQueue()
+    {
+        m_pTailBlock = new Block;
+        m_pHeadBlock = m_pTailBlock;
+    }
+
+
+    EventDispatcher::ThreadEventQueue::~ThreadEventQueue()
+    {
+        Block* pBlock = m_pHeadBlock;
+
+        while (pBlock) {
+            Block* pNextBlock = pBlock->pNext.load(std::memory_order_relaxed);
+            delete pBlock;
+            pBlock = pNextBlock;
+        }
+    }
+
+
+    void EventDispatcher::ThreadEventQueue::Push(uint64_t eventTypeIndex, const void* pEvent, size_t eventSize) noexcept
+    {
+        ENG_ASSERT(eventSize <= MAX_EVENT_SIZE, "Event is too big");
+
+        uint32_t writeIndex = m_pTailBlock->writeIndex.load(std::memory_order_relaxed);
+
+        if (writeIndex == BLOCK_SLOTS_COUNT) {
+            Block* pNewBlock = new Block;
+            
+            m_pTailBlock->pNext.store(pNewBlock, std::memory_order_release);
+            m_pTailBlock = pNewBlock;
+            
+            writeIndex = 0;
+        }
+
+        EventSlot& slot = m_pTailBlock->slots[writeIndex];
+        slot.eventTypeIndex = static_cast<uint32_t>(eventTypeIndex);
+        slot.eventSize = static_cast<uint32_t>(eventSize);
+        memcpy(slot.event, pEvent, eventSize);
+
+        m_pTailBlock->writeIndex.store(writeIndex + 1, std::memory_order_release);
+    }
+
+
+    EventDispatcher::ThreadEventQueue& EventDispatcher::GetThreadEventQueue() noexcept
+    {
+        // Queue is owned by the dispatcher and outlives the producer thread, events posted right before
+        // thread exit are still delivered
+        thread_local ThreadEventQueue* pQueue = nullptr;
+
+        if (!pQueue) {
+            pQueue = new ThreadEventQueue;
+
+            ThreadEventQueue* pHead = m_pThreadEventQueuesHead.load(std::memory_order_relaxed);
+            do {
+                pQueue->m_pNextQueue = pHead;
+            } while (!m_pThreadEventQueuesHead.compare_exchange_weak(pHead, pQueue, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        return *pQueue;
+    }
+
+
     EventDispatcher& EventDispatcher::GetInstance()
     {
         static EventDispatcher dispatcher;
@@ -102,11 +282,41 @@ namespace es
     }
 
 
+    void EventDispatcher::DispatchQueuedEvents() noexcept
+    {
+        const auto notify = [this](uint32_t eventTypeIndex, const void* pEvent) {
+            m_storages[eventTypeIndex].Notify(pEvent);
+        };
+
+        EventQueue& queue = m_eventQueues[m_activeEventQueueIdx];
+
+        if (!queue.IsEmpty()) {
+            m_activeEventQueueIdx = (m_activeEventQueueIdx + 1) % m_eventQueues.size();
+
+            queue.ForEach(notify);
+            queue.Clear();
+        }
+
+        for (ThreadEventQueue* pQueue = m_pThreadEventQueuesHead.load(std::memory_order_acquire); pQueue; pQueue = pQueue->m_pNextQueue) {
+            pQueue->ConsumeAll(notify);
+        }
+    }
+
+
     void EventDispatcher::Reset() noexcept
     {
         for (ListenersStorage& storage : m_storages) {
             storage.Reset();
         }
+
+        for (EventQueue& queue : m_eventQueues) {
+            queue.Clear();
+        }
+
+        // Events posted by other threads before the reset mustn't reach listeners subscribed after it
+        for (ThreadEventQueue* pQueue = m_pThreadEventQueuesHead.load(std::memory_order_acquire); pQueue; pQueue = pQueue->m_pNextQueue) {
+            pQueue->ConsumeAll([](uint32_t, const void*) {});
+        }
     }
 
 
@@ -115,5 +325,21 @@ namespace es
         for (ListenersStorage& storage : m_storages) {
             storage.Reserve(1024);
         }
+
+        for (EventQueue& queue : m_eventQueues) {
+            queue.m_buffer.resize(EVENT_QUEUE_INITIAL_CAPACITY);
+        }
+    }
+
+
+    EventDispatcher::~EventDispatcher()
+    {
+        ThreadEventQueue* pQueue = m_pThreadEventQueuesHead.exchange(nullptr, std::memory_order_acquire);
+
+        while (pQueue) {
+            ThreadEventQueue* pNextQueue = pQueue->m_pNextQueue;
+            delete pQueue;
+            pQueue = pNextQueue;
+        }
     }
 }
\ No newline at end of file
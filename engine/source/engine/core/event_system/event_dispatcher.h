@@ -1,14 +1,17 @@
 #pragma once
 
 #include <vector>
+#include <array>
 #include <unordered_map>
-
-#include <functional>
+#include <atomic>
 
 #include <cstdint>
 
 #include "utils/debug/assertion.h"
 #include "utils/data_structures/base_id.h"
+#include "utils/data_structures/inline_function.h"
+
+#include "event_traits.h"
 
 #include "core.h"
 
@@ -72,7 +75,8 @@ namespace es
     };
 
 
-    using ListenerCallback = std::function<void(const void* pEvent)>;
+    // Inline storage fits lambdas capturing up to four pointers. Bigger callables fail to compile instead of allocating
+    using ListenerCallback = ds::InlineFunction<void(const void* pEvent), 32>;
 
 
     class EventDispatcher
@@ -97,6 +101,20 @@ namespace es
         template<typename EventType, typename... Args>
         void Notify(Args&&... args) noexcept;
 
+        // Queues event until the next DispatchQueuedEvents call. Coalescible events (see EventCoalescingTraits)
+        // which are already queued are merged into a single event dispatched at the position of the latest one
+        template<typename EventType, typename... Args>
+        void Post(Args&&... args) noexcept;
+
+        // Can be called from any thread. Each producer thread gets its own lock free queue, events are dispatched
+        // on the thread which calls DispatchQueuedEvents. Events aren't coalesced
+        template<typename EventType, typename... Args>
+        void PostThreadSafe(Args&&... args) noexcept;
+
+        // Must be called from the main thread. Dispatches events queued by Post and then by PostThreadSafe.
+        // Events posted by listeners during dispatching are deferred to the next call
+        void DispatchQueuedEvents() noexcept;
+
         void Reset() noexcept;
 
     private:
@@ -104,14 +122,18 @@ namespace es
 
     private:
         EventDispatcher();
+        ~EventDispatcher();
 
     private:
+        // Callbacks are kept densely packed, so Notify walks a contiguous array without holes.
+        // Listener indices handed out to ListenerID are mapped to the dense positions. Removal swaps the last callback in,
+        // so notification order is not preserved after unsubscription
         class ListenersStorage
         {
             friend class EventDispatcher;
             
         public:
-            void Reserve(uint64_t capacity) noexcept { m_storage.reserve(capacity); }
+            void Reserve(uint64_t capacity) noexcept;
 
             uint64_t Add(const ListenerCallback& callback) noexcept;
             void Remove(uint64_t index) noexcept;
@@ -120,26 +142,137 @@ namespace es
 
             void Reset() noexcept;
 
-            uint64_t GetSize() const noexcept { return m_storage.size(); }
-            uint64_t GetCapacity() noexcept { return m_storage.capacity(); }
+            uint64_t GetSize() const noexcept { return m_callbacks.size(); }
+            uint64_t GetCapacity() noexcept { return m_callbacks.capacity(); }
+
+        private:
+            void RemoveImmediate(uint64_t index) noexcept;
 
         private:
             static inline constexpr uint64_t MAX_LISTENERS_STORAGE_CAPACITY = ListenerID::MAX_STORAGE_IDX + 1;
-            static inline const ListenerCallback DEFAULT_EVENT_CALLBACK = [](const void*) -> void {}; 
+            static inline constexpr uint32_t INVALID_DENSE_IDX = UINT32_MAX;
 
         private:
             using ListenerIndex = ds::BaseID<ListenerID::UnderlyingType>;
             using ListenerIndexPool = ds::BaseIDPool<ListenerIndex>;
 
-            std::vector<ListenerCallback> m_storage;
+            std::vector<ListenerCallback> m_callbacks;
+            std::vector<uint32_t> m_denseToListenerIdx;
+            std::vector<uint32_t> m_listenerIdxToDense;
+
+            // Removals requested by listeners during Notify are applied after the fan-out is finished
+            std::vector<uint32_t> m_pendingRemovals;
+            uint32_t m_notifyDepth = 0;
+
             ListenerIndexPool m_idxPool;
         };
 
+        // Linear per-frame buffer of type erased events. Memory is kept between frames, so after warm up posting doesn't allocate
+        class EventQueue
+        {
+            friend class EventDispatcher;
+
+        public:
+            void Push(uint64_t eventTypeIndex, const void* pEvent, size_t eventSize) noexcept;
+
+            // Returns last queued event of the type which wasn't merged yet
+            void* FindLast(uint64_t eventTypeIndex) noexcept;
+            void RemoveLast(uint64_t eventTypeIndex) noexcept;
+
+            template <typename Func>
+            void ForEach(Func&& func) const noexcept;
+
+            void Clear() noexcept;
+
+            bool IsEmpty() const noexcept { return m_size == 0; }
+
+        private:
+            struct EventHeader
+            {
+                uint32_t eventTypeIndex;
+                uint32_t eventSize;
+                uint32_t isAlive;
+                uint32_t padding;
+            };
+
+            using BlockType = uint64_t;
+
+            static inline constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+            static inline constexpr size_t HEADER_BLOCKS_COUNT = sizeof(EventHeader) / sizeof(BlockType);
+
+        private:
+            std::vector<BlockType> m_buffer;
+            size_t m_size = 0;
+
+            std::vector<uint32_t> m_lastEventOffsets;
+            std::vector<uint32_t> m_queuedEventTypes;
+        };
+
+        // Single producer single consumer unbounded queue made of fixed size blocks. The producer publishes slots
+        // with release stores of the block write index, the consumer frees the block once it's fully read
+        class ThreadEventQueue
+        {
+            friend class EventDispatcher;
+
+        public:
+            static inline constexpr size_t MAX_EVENT_SIZE = 56;
+
+        public:
+            ThreadEventQueue();
+            ~ThreadEventQueue();
+
+            ThreadEventQueue(const ThreadEventQueue& other) = delete;
+            ThreadEventQueue& operator=(const ThreadEventQueue& other) = delete;
+
+            // Producer side
+            void Push(uint64_t eventTypeIndex, const void* pEvent, size_t eventSize) noexcept;
+
+            // Consumer side
+            template <typename Func>
+            void ConsumeAll(Func&& func) noexcept;
+
+        private:
+            struct alignas(64) EventSlot
+            {
+                uint32_t eventTypeIndex;
+                uint32_t eventSize;
+                alignas(8) uint8_t event[MAX_EVENT_SIZE];
+            };
+
+            static inline constexpr size_t BLOCK_SLOTS_COUNT = 256;
+
+            struct Block
+            {
+                std::array<EventSlot, BLOCK_SLOTS_COUNT> slots;
+                alignas(64) std::atomic<uint32_t> writeIndex = 0;
+                std::atomic<Block*> pNext = nullptr;
+            };
+
+        private:
+            // Producer state
+            alignas(64) Block* m_pTailBlock = nullptr;
+
+            // Consumer state
+            alignas(64) Block* m_pHeadBlock = nullptr;
+            uint32_t m_readIndex = 0;
+
+            ThreadEventQueue* m_pNextQueue = nullptr;
+        };
+
+        ThreadEventQueue& GetThreadEventQueue() noexcept;
+
     private:
         static inline constexpr uint64_t MAX_EVENT_TYPES_COUNT = ListenerID::MAX_EVENT_TYPE_IDX + 1;
+        static inline constexpr size_t EVENT_QUEUE_INITIAL_CAPACITY = 4096;
 
     private:
         std::array<ListenersStorage, MAX_EVENT_TYPES_COUNT> m_storages;
+
+        std::array<EventQueue, 2> m_eventQueues;
+        uint32_t m_activeEventQueueIdx = 0;
+
+        // Intrusive list of all producer thread queues. Queues are only added, so it's a lock free stack push
+        std::atomic<ThreadEventQueue*> m_pThreadEventQueuesHead = nullptr;
     };
 
 
@@ -2,8 +2,9 @@ namespace es
 {
     inline uint64_t EventDispatcher::AllocateEventTypeIndex() noexcept
     {
-        static uint64_t index = 0;
-        return index++;
+        // Event type indices can be requested from producer threads via PostThreadSafe
+        static std::atomic<uint64_t> index = 0;
+        return index.fetch_add(1, std::memory_order_relaxed);
     }
 
 
@@ -37,4 +38,89 @@ namespace es
         const EventType event(std::forward<Args>(args)...);
         m_storages[eventTypeIndex].Notify(&event);
     }
+
+
+    template <typename EventType, typename... Args>
+    inline void EventDispatcher::Post(Args&&... args) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<EventType> && std::is_trivially_destructible_v<EventType>, "Only trivial events can be queued");
+        static_assert(alignof(EventType) <= alignof(EventQueue::BlockType), "Queued event type is overaligned");
+
+        static const auto eventTypeIndex = GetEventTypeIndex<EventType>();
+        ENG_ASSERT(eventTypeIndex < m_storages.size(), "Event dispatcher available event types count overflow");
+
+        using CoalescingTraits = EventCoalescingTraits<EventType>;
+
+        EventType event(std::forward<Args>(args)...);
+        EventQueue& queue = m_eventQueues[m_activeEventQueueIdx];
+
+        if constexpr (CoalescingTraits::IS_COALESCIBLE) {
+            if (const void* pQueuedEvent = queue.FindLast(eventTypeIndex)) {
+                CoalescingTraits::Merge(event, *static_cast<const EventType*>(pQueuedEvent));
+                queue.RemoveLast(eventTypeIndex);
+            }
+        }
+
+        queue.Push(eventTypeIndex, &event, sizeof(EventType));
+    }
+
+
+    template <typename Func>
+    inline void EventDispatcher::EventQueue::ForEach(Func&& func) const noexcept
+    {
+        for (size_t offset = 0; offset < m_size; ) {
+            const EventHeader* pHeader = reinterpret_cast<const EventHeader*>(m_buffer.data() + offset);
+            const BlockType* pEvent = m_buffer.data() + offset + HEADER_BLOCKS_COUNT;
+
+            if (pHeader->isAlive) {
+                func(pHeader->eventTypeIndex, static_cast<const void*>(pEvent));
+            }
+
+            offset += HEADER_BLOCKS_COUNT + (pHeader->eventSize + sizeof(BlockType) - 1) / sizeof(BlockType);
+        }
+    }
+
+
+    template <typename EventType, typename... Args>
+    inline void EventDispatcher::PostThreadSafe(Args&&... args) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<EventType> && std::is_trivially_destructible_v<EventType>, "Only trivial events can be queued");
+        static_assert(sizeof(EventType) <= ThreadEventQueue::MAX_EVENT_SIZE, "Event type is too big to be posted from another thread");
+        static_assert(alignof(EventType) <= 8, "Event type is overaligned");
+
+        static const auto eventTypeIndex = GetEventTypeIndex<EventType>();
+        ENG_ASSERT(eventTypeIndex < m_storages.size(), "Event dispatcher available event types count overflow");
+
+        const EventType event(std::forward<Args>(args)...);
+        GetThreadEventQueue().Push(eventTypeIndex, &event, sizeof(EventType));
+    }
+
+
+    template <typename Func>
+    inline void EventDispatcher::ThreadEventQueue::ConsumeAll(Func&& func) noexcept
+    {
+        while (true) {
+            const uint32_t writeIndex = m_pHeadBlock->writeIndex.load(std::memory_order_acquire);
+
+            for (; m_readIndex < writeIndex; ++m_readIndex) {
+                const EventSlot& slot = m_pHeadBlock->slots[m_readIndex];
+                func(slot.eventTypeIndex, static_cast<const void*>(slot.event));
+            }
+
+            if (m_readIndex < BLOCK_SLOTS_COUNT) {
+                return;
+            }
+
+            // The producer links the next block only after it has filled the current one, so the current block
+            // can be freed as soon as the link is visible
+            Block* pNextBlock = m_pHeadBlock->pNext.load(std::memory_order_acquire);
+            if (!pNextBlock) {
+                return;
+            }
+
+            delete m_pHeadBlock;
+            m_pHeadBlock = pNextBlock;
+            m_readIndex = 0;
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+
+namespace es
+{
+    // Specialize for event types which can be merged while waiting in the EventDispatcher queue.
+    // Merge folds the older queued event into the newer one, only the merged event is dispatched
+    template <typename EventType>
+    struct EventCoalescingTraits
+    {
+        static inline constexpr bool IS_COALESCIBLE = false;
+
+        static void Merge(EventType&, const EventType&) noexcept {}
+    };
+
+
+    // Coalescible event which state is fully described by the latest event (cursor position, window size, etc.)
+    template <typename EventType>
+    struct LatestEventCoalescingTraits
+    {
+        static inline constexpr bool IS_COALESCIBLE = true;
+
+        static void Merge(EventType&, const EventType&) noexcept {}
+    };
+}
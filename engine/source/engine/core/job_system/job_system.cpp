@@ -0,0 +1,352 @@
+#include "pch.h"
+#include "job_system.h"
+
+#include "utils/debug/assertion.h"
+
+
+static std::unique_ptr<JobSystem> pJobSystemInst = nullptr;
+
+// Index of the calling thread context inside the job system. Workers and the main thread are registered in JobSystem::Init
+static thread_local uint32_t s_threadIdx = UINT32_MAX;
+
+
+#define ASSERT_JOB_SYSTEM_INIT_STATUS() ENG_ASSERT(engIsJobSystemInitialized(), "Job system is not initialized")
+
+
+static uint32_t XorShift32(uint32_t& state) noexcept
+{
+    uint32_t x = state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+
+    return x;
+}
+
+
+bool JobDeque::Push(Job* pJob) noexcept
+{
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_acquire);
+
+    if (bottom - top >= CAPACITY) {
+        return false;
+    }
+
+    m_jobs[bottom & MASK].store(pJob, std::memory_order_relaxed);
+    m_bottom.store(bottom + 1, std::memory_order_seq_cst);
+
+    return true;
+}
+
+
+Job* JobDeque::Pop() noexcept
+{
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_seq_cst);
+
+    int64_t top = m_top.load(std::memory_order_seq_cst);
+
+    if (top > bottom) {
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* pJob = m_jobs[bottom & MASK].load(std::memory_order_relaxed);
+
+    if (top == bottom) {
+        // The last job, race against thieves for it
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            pJob = nullptr;
+        }
+
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return pJob;
+}
+
+
+Job* JobDeque::Steal() noexcept
+{
+    int64_t top = m_top.load(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_seq_cst);
+
+    if (top >= bottom) {
+        return nullptr;
+    }
+
+    Job* pJob = m_jobs[top & MASK].load(std::memory_order_relaxed);
+
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+
+    return pJob;
+}
+
+
+JobSystem& JobSystem::GetInstance() noexcept
+{
+    ASSERT_JOB_SYSTEM_INIT_STATUS();
+    return *pJobSystemInst;
+}
+
+
+JobSystem::~JobSystem()
+{
+    Terminate();
+}
+
+
+void JobSystem::Submit(const JobFunc& func, JobCounter* pCounter) noexcept
+{
+    ENG_ASSERT(s_threadIdx < m_threadContexts.size(), "Jobs can be submitted only from the main thread or from other jobs");
+    ENG_ASSERT(func, "Invalid job function");
+
+    ThreadContext& context = *m_threadContexts[s_threadIdx];
+
+    Job* pJob = AllocateJob();
+
+    if (!pJob) {
+        func();
+        return;
+    }
+
+    pJob->m_func = func;
+    pJob->m_pCounter = pCounter;
+    pJob->m_isPending.store(true, std::memory_order_relaxed);
+
+    if (pCounter) {
+        pCounter->m_value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Counted before the push so that thieves never decrement it below the real queued jobs count
+    m_queuedJobsCount.fetch_add(1, std::memory_order_seq_cst);
+
+    if (!context.deque.Push(pJob)) {
+        m_queuedJobsCount.fetch_sub(1, std::memory_order_relaxed);
+        ExecuteJob(pJob);
+        return;
+    }
+
+    if (m_sleepingWorkersCount.load(std::memory_order_seq_cst) > 0) {
+        std::scoped_lock lock(m_sleepMutex);
+        m_wakeCondition.notify_one();
+    }
+}
+
+
+void JobSystem::Wait(const JobCounter& counter) noexcept
+{
+    ENG_ASSERT(s_threadIdx < m_threadContexts.size(), "Jobs can be waited only from the main thread or from other jobs");
+
+    while (!counter.IsDone()) {
+        if (!TryExecuteJob()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+bool JobSystem::Init() noexcept
+{
+    if (IsInitialized()) {
+        return true;
+    }
+
+    const uint32_t hardwareThreadsCount = std::thread::hardware_concurrency();
+    const uint32_t workersCount = hardwareThreadsCount > 2 ? hardwareThreadsCount - 1 : 1;
+
+    m_threadContexts.reserve(workersCount + 1);
+
+    for (uint32_t i = 0; i < workersCount + 1; ++i) {
+        std::unique_ptr<ThreadContext>& pContext = m_threadContexts.emplace_back(new ThreadContext);
+
+        if (!pContext) {
+            ENG_ASSERT_FAIL("Failed to allocate memory for job system thread context");
+            return false;
+        }
+
+        pContext->pJobs = std::unique_ptr<Job[]>(new Job[MAX_JOBS_PER_THREAD]);
+        pContext->stealSeed = 0x9E3779B9u * (i + 1);
+    }
+
+    s_threadIdx = MAIN_THREAD_IDX;
+    m_isStopping.store(false, std::memory_order_relaxed);
+
+    m_workers.reserve(workersCount);
+
+    for (uint32_t i = 1; i <= workersCount; ++i) {
+        m_workers.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+
+    ENG_LOG_INFO("Job system: {} worker threads", workersCount);
+
+    m_isInitialized = true;
+
+    return true;
+}
+
+
+void JobSystem::Terminate() noexcept
+{
+    {
+        std::scoped_lock lock(m_sleepMutex);
+        m_isStopping.store(true, std::memory_order_seq_cst);
+    }
+    m_wakeCondition.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    m_workers.clear();
+
+    if (s_threadIdx == MAIN_THREAD_IDX) {
+        // Main thread may still own queued jobs
+        while (TryExecuteJob()) { }
+    }
+
+    m_threadContexts.clear();
+    s_threadIdx = INVALID_THREAD_IDX;
+
+    m_queuedJobsCount.store(0, std::memory_order_relaxed);
+    m_sleepingWorkersCount.store(0, std::memory_order_relaxed);
+
+    m_isInitialized = false;
+}
+
+
+Job* JobSystem::AllocateJob() noexcept
+{
+    ThreadContext& context = *m_threadContexts[s_threadIdx];
+
+    static_assert((MAX_JOBS_PER_THREAD & (MAX_JOBS_PER_THREAD - 1)) == 0, "MAX_JOBS_PER_THREAD must be power of 2");
+    Job* pJob = &context.pJobs[context.allocatedJobsCount & (MAX_JOBS_PER_THREAD - 1)];
+
+    // Ring wrapped around onto a job which is still queued or running. It can't be waited for here since it may be
+    // running further up the call stack of this very thread
+    if (pJob->m_isPending.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    ++context.allocatedJobsCount;
+
+    return pJob;
+}
+
+
+Job* JobSystem::FindJob() noexcept
+{
+    ThreadContext& context = *m_threadContexts[s_threadIdx];
+
+    Job* pJob = context.deque.Pop();
+
+    if (!pJob) {
+        const uint32_t threadsCount = GetThreadsCount();
+        const uint32_t firstVictimIdx = XorShift32(context.stealSeed) % threadsCount;
+
+        for (uint32_t i = 0; i < threadsCount && !pJob; ++i) {
+            const uint32_t victimIdx = (firstVictimIdx + i) % threadsCount;
+
+            if (victimIdx != s_threadIdx) {
+                pJob = m_threadContexts[victimIdx]->deque.Steal();
+            }
+        }
+    }
+
+    if (pJob) {
+        m_queuedJobsCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    return pJob;
+}
+
+
+bool JobSystem::TryExecuteJob() noexcept
+{
+    Job* pJob = FindJob();
+
+    if (!pJob) {
+        return false;
+    }
+
+    ExecuteJob(pJob);
+
+    return true;
+}
+
+
+void JobSystem::ExecuteJob(Job* pJob) noexcept
+{
+    pJob->m_func();
+    pJob->m_func.Reset();
+
+    if (pJob->m_pCounter) {
+        pJob->m_pCounter->m_value.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    pJob->m_isPending.store(false, std::memory_order_release);
+}
+
+
+void JobSystem::WorkerLoop(uint32_t threadIdx) noexcept
+{
+    s_threadIdx = threadIdx;
+
+    while (!m_isStopping.load(std::memory_order_relaxed)) {
+        if (TryExecuteJob()) {
+            continue;
+        }
+
+        std::unique_lock lock(m_sleepMutex);
+
+        // Submit() increments the queued jobs count before it checks the sleeping workers count, so either it sees
+        // this worker sleeping and notifies it, or the predicate below sees the new job
+        m_sleepingWorkersCount.fetch_add(1, std::memory_order_seq_cst);
+        m_wakeCondition.wait(lock, [this]() {
+            return m_queuedJobsCount.load(std::memory_order_seq_cst) > 0 || m_isStopping.load(std::memory_order_relaxed);
+        });
+        m_sleepingWorkersCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    s_threadIdx = INVALID_THREAD_IDX;
+}
+
+
+bool engInitJobSystem() noexcept
+{
+    if (engIsJobSystemInitialized()) {
+        ENG_LOG_WARN("Job system is already initialized!");
+        return true;
+    }
+
+    pJobSystemInst = std::unique_ptr<JobSystem>(new JobSystem);
+
+    if (!pJobSystemInst) {
+        ENG_ASSERT_FAIL("Failed to allocate memory for job system");
+        return false;
+    }
+
+    if (!pJobSystemInst->Init()) {
+        ENG_ASSERT_FAIL("Failed to initialized job system");
+        return false;
+    }
+
+    return true;
+}
+
+
+void engTerminateJobSystem() noexcept
+{
+    pJobSystemInst = nullptr;
+}
+
+
+bool engIsJobSystemInitialized() noexcept
+{
+    return pJobSystemInst && pJobSystemInst->IsInitialized();
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "utils/data_structures/inline_function.h"
+
+#include "core.h"
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <cstdint>
+
+
+using JobFunc = ds::InlineFunction<void(), 48>;
+
+
+// Counts unfinished jobs submitted with it. Must outlive all of them, so it's usually allocated on the stack of the waiting function
+class JobCounter
+{
+    friend class JobSystem;
+
+public:
+    JobCounter() = default;
+
+    JobCounter(const JobCounter& other) = delete;
+    JobCounter& operator=(const JobCounter& other) = delete;
+
+    bool IsDone() const noexcept { return m_value.load(std::memory_order_acquire) == 0; }
+
+private:
+    std::atomic<uint32_t> m_value = 0;
+};
+
+
+class Job
+{
+    friend class JobSystem;
+    friend class JobDeque;
+
+private:
+    JobFunc m_func;
+    JobCounter* m_pCounter = nullptr;
+
+    // Set while the job is queued or running, the slot can't be reused until it's cleared
+    std::atomic<bool> m_isPending = false;
+};
+
+
+// Chase-Lev work stealing deque. The owner thread pushes and pops jobs at the bottom, other threads steal from the top
+class JobDeque
+{
+public:
+    bool Push(Job* pJob) noexcept;
+    Job* Pop() noexcept;
+    Job* Steal() noexcept;
+
+private:
+    static inline constexpr int64_t CAPACITY = 4096;
+    static inline constexpr int64_t MASK = CAPACITY - 1;
+
+    static_assert((CAPACITY & MASK) == 0, "Job deque capacity must be power of 2");
+
+private:
+    alignas(64) std::atomic<int64_t> m_top = 0;
+    alignas(64) std::atomic<int64_t> m_bottom = 0;
+    alignas(64) std::array<std::atomic<Job*>, CAPACITY> m_jobs = {};
+};
+
+
+class JobSystem
+{
+    friend bool engInitJobSystem() noexcept;
+    friend void engTerminateJobSystem() noexcept;
+    friend bool engIsJobSystemInitialized() noexcept;
+
+public:
+    static JobSystem& GetInstance() noexcept;
+
+public:
+    JobSystem(const JobSystem& other) = delete;
+    JobSystem& operator=(const JobSystem& other) = delete;
+    JobSystem(JobSystem&& other) noexcept = delete;
+    JobSystem& operator=(JobSystem&& other) noexcept = delete;
+
+    ~JobSystem();
+
+    // Can be called from the main thread or from jobs
+    void Submit(const JobFunc& func, JobCounter* pCounter = nullptr) noexcept;
+
+    // Splits [0, count) into batches of batchSize and calls func(index) for each index. Call Wait(counter) to join.
+    // func is copied into each job, so it must fit JobFunc storage together with the batch range
+    // If everything fits in a single batch it's executed in place
+    template <typename Func>
+    void ParallelFor(uint32_t count, uint32_t batchSize, Func&& func, JobCounter& counter) noexcept;
+
+    // Executes queued jobs instead of blocking while counter isn't done
+    void Wait(const JobCounter& counter) noexcept;
+
+    uint32_t GetWorkersCount() const noexcept { return static_cast<uint32_t>(m_workers.size()); }
+    uint32_t GetThreadsCount() const noexcept { return static_cast<uint32_t>(m_threadContexts.size()); }
+
+    bool IsInitialized() const noexcept { return m_isInitialized; }
+
+private:
+    JobSystem() = default;
+
+    bool Init() noexcept;
+    void Terminate() noexcept;
+
+    // Returns nullptr if the calling thread has too many jobs in flight, the job is executed in place then
+    Job* AllocateJob() noexcept;
+    Job* FindJob() noexcept;
+    bool TryExecuteJob() noexcept;
+    void ExecuteJob(Job* pJob) noexcept;
+
+    void WorkerLoop(uint32_t threadIdx) noexcept;
+
+private:
+    static inline constexpr size_t MAX_JOBS_PER_THREAD = 4096;
+    static inline constexpr uint32_t MAIN_THREAD_IDX = 0;
+    static inline constexpr uint32_t INVALID_THREAD_IDX = UINT32_MAX;
+
+private:
+    struct alignas(64) ThreadContext
+    {
+        JobDeque deque;
+        std::unique_ptr<Job[]> pJobs;
+        size_t allocatedJobsCount = 0;
+        uint32_t stealSeed = 0;
+    };
+
+    // Index 0 is the main thread, the rest are workers
+    std::vector<std::unique_ptr<ThreadContext>> m_threadContexts;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeCondition;
+
+    std::atomic<uint32_t> m_queuedJobsCount = 0;
+    std::atomic<uint32_t> m_sleepingWorkersCount = 0;
+    std::atomic<bool> m_isStopping = false;
+
+    bool m_isInitialized = false;
+};
+
+
+bool engInitJobSystem() noexcept;
+void engTerminateJobSystem() noexcept;
+bool engIsJobSystemInitialized() noexcept;
+
+// Calls func(batchIdx) for every batch in [0, batchesCount) and returns once all of them are done.
+// Batches are spread over the job system if it's initialized, so func must fit JobFunc storage, otherwise they run in place
+template <typename Func>
+void engRunJobBatches(uint32_t batchesCount, const Func& func) noexcept;
+
+
+#include "job_system.hpp"
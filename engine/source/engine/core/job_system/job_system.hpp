@@ -0,0 +1,43 @@
+template <typename Func>
+inline void JobSystem::ParallelFor(uint32_t count, uint32_t batchSize, Func&& func, JobCounter& counter) noexcept
+{
+    if (count == 0) {
+        return;
+    }
+
+    batchSize = batchSize > 0 ? batchSize : 1;
+
+    // The last batch is executed by the calling thread
+    const uint32_t lastBatchBegin = ((count - 1) / batchSize) * batchSize;
+
+    for (uint32_t begin = 0; begin < lastBatchBegin; begin += batchSize) {
+        const uint32_t end = begin + batchSize;
+
+        Submit([func, begin, end]() {
+            for (uint32_t i = begin; i < end; ++i) {
+                func(i);
+            }
+        }, &counter);
+    }
+
+    for (uint32_t i = lastBatchBegin; i < count; ++i) {
+        func(i);
+    }
+}
+
+
+template <typename Func>
+inline void engRunJobBatches(uint32_t batchesCount, const Func& func) noexcept
+{
+    if (engIsJobSystemInitialized()) {
+        JobSystem& jobSystem = JobSystem::GetInstance();
+        JobCounter batchesCounter;
+
+        jobSystem.ParallelFor(batchesCount, 1, func, batchesCounter);
+        jobSystem.Wait(batchesCounter);
+    } else {
+        for (uint32_t batchIdx = 0; batchIdx < batchesCount; ++batchIdx) {
+            func(batchIdx);
+        }
+    }
+}
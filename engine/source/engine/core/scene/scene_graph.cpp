@@ -0,0 +1,462 @@
+#include "pch.h"
+#include "scene_graph.h"
+
+#include "core/job_system/job_system.h"
+
+#include "utils/debug/assertion.h"
+
+#include <atomic>
+#include <chrono>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define SCENE_SSE2
+  #include <emmintrin.h>
+#endif
+
+
+namespace chr = std::chrono;
+
+
+// Same as glm::translate(glm::mat4_cast(rotation)) * glm::scale(scale) without the intermediate matrices. Rotation must be normalized
+static inline void ComposeLocalMatrix(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, glm::mat4x4& outMatrix) noexcept
+{
+    const float xx = rotation.x * rotation.x;
+    const float yy = rotation.y * rotation.y;
+    const float zz = rotation.z * rotation.z;
+    const float xy = rotation.x * rotation.y;
+    const float xz = rotation.x * rotation.z;
+    const float yz = rotation.y * rotation.z;
+    const float wx = rotation.w * rotation.x;
+    const float wy = rotation.w * rotation.y;
+    const float wz = rotation.w * rotation.z;
+
+    outMatrix[0] = glm::vec4(1.f - 2.f * (yy + zz), 2.f * (xy + wz), 2.f * (xz - wy), 0.f) * scale.x;
+    outMatrix[1] = glm::vec4(2.f * (xy - wz), 1.f - 2.f * (xx + zz), 2.f * (yz + wx), 0.f) * scale.y;
+    outMatrix[2] = glm::vec4(2.f * (xz + wy), 2.f * (yz - wx), 1.f - 2.f * (xx + yy), 0.f) * scale.z;
+    outMatrix[3] = glm::vec4(position, 1.f);
+}
+
+
+// outMatrix = left * right, outMatrix mustn't alias the operands
+static inline void MultiplyMatrices(const glm::mat4x4& left, const glm::mat4x4& right, glm::mat4x4& outMatrix) noexcept
+{
+#if defined(SCENE_SSE2)
+    // Every result column is a combination of the left matrix columns weighted by the right matrix column
+    const __m128 left0 = _mm_loadu_ps(&left[0][0]);
+    const __m128 left1 = _mm_loadu_ps(&left[1][0]);
+    const __m128 left2 = _mm_loadu_ps(&left[2][0]);
+    const __m128 left3 = _mm_loadu_ps(&left[3][0]);
+
+    for (uint32_t column = 0; column < 4; ++column) {
+        const __m128 rightColumn = _mm_loadu_ps(&right[column][0]);
+
+        __m128 result = _mm_mul_ps(left0, _mm_shuffle_ps(rightColumn, rightColumn, _MM_SHUFFLE(0, 0, 0, 0)));
+        result = _mm_add_ps(result, _mm_mul_ps(left1, _mm_shuffle_ps(rightColumn, rightColumn, _MM_SHUFFLE(1, 1, 1, 1))));
+        result = _mm_add_ps(result, _mm_mul_ps(left2, _mm_shuffle_ps(rightColumn, rightColumn, _MM_SHUFFLE(2, 2, 2, 2))));
+        result = _mm_add_ps(result, _mm_mul_ps(left3, _mm_shuffle_ps(rightColumn, rightColumn, _MM_SHUFFLE(3, 3, 3, 3))));
+
+        _mm_storeu_ps(&outMatrix[column][0], result);
+    }
+#else
+    outMatrix = left * right;
+#endif
+}
+
+
+// Reorders data so that data[i] becomes old data[order[i]]
+template <typename T>
+static void PermuteArray(std::vector<T>& data, const std::vector<uint32_t>& order) noexcept
+{
+    std::vector<T> permutedData(order.size());
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        permutedData[i] = data[order[i]];
+    }
+
+    data.swap(permutedData);
+}
+
+
+void SceneGraph::Reserve(uint32_t count) noexcept
+{
+    m_localPositions.reserve(count);
+    m_localRotations.reserve(count);
+    m_localScales.reserve(count);
+    m_worldMatrices.reserve(count);
+    m_parents.reserve(count);
+    m_worldUpdateIndices.reserve(count);
+    m_flags.reserve(count);
+    m_IDs.reserve(count);
+    m_nodeIndices.reserve(count);
+}
+
+
+void SceneGraph::Clear() noexcept
+{
+    m_IDPool.Reset();
+    m_nodeIndices.clear();
+
+    m_localPositions.clear();
+    m_localRotations.clear();
+    m_localScales.clear();
+    m_worldMatrices.clear();
+    m_parents.clear();
+    m_worldUpdateIndices.clear();
+    m_flags.clear();
+    m_IDs.clear();
+
+    m_levelOffsets.clear();
+
+    m_stats = {};
+
+    m_firstDirtyIdx = INVALID_NODE_INDEX;
+    m_isHierarchyDirty = false;
+}
+
+
+SceneNodeID SceneGraph::CreateNode(SceneNodeID parentID) noexcept
+{
+    const uint32_t parentIdx = parentID.IsValid() ? GetNodeIndex(parentID) : INVALID_NODE_INDEX;
+
+    SceneNodeID ID = m_IDPool.Allocate();
+
+    if (!ID.IsValid()) {
+        ENG_ASSERT_FAIL("Failed to allocate scene node ID");
+        return ID;
+    }
+
+    if (ID.Index() >= m_nodeIndices.size()) {
+        m_nodeIndices.resize(ID.Index() + 1, INVALID_NODE_INDEX);
+    }
+
+    const uint32_t nodeIdx = GetNodesCount();
+    m_nodeIndices[ID.Index()] = nodeIdx;
+
+    m_localPositions.emplace_back(M3D_ZEROF3);
+    m_localRotations.emplace_back(M3D_QUAT_IDENTITY);
+    m_localScales.emplace_back(M3D_ONEF3);
+    m_worldMatrices.emplace_back(M3D_MAT4_IDENTITY);
+    m_parents.emplace_back(parentIdx);
+    m_worldUpdateIndices.emplace_back(0);
+    m_flags.emplace_back(0);
+    m_IDs.emplace_back(ID);
+
+    MarkLocalDirty(nodeIdx);
+
+    // The node is appended after deeper levels, so levels must be rebuilt
+    m_isHierarchyDirty = true;
+
+    return ID;
+}
+
+
+void SceneGraph::DestroyNode(SceneNodeID ID) noexcept
+{
+    const uint32_t nodeIdx = GetNodeIndex(ID);
+
+    m_flags[nodeIdx] |= NODE_FLAG_DESTROYED;
+    m_IDPool.Deallocate(ID);
+
+    // Subtree nodes are removed by the rebuild, they become unreachable from roots
+    m_isHierarchyDirty = true;
+}
+
+
+void SceneGraph::SetParent(SceneNodeID ID, SceneNodeID parentID) noexcept
+{
+    const uint32_t nodeIdx = GetNodeIndex(ID);
+    const uint32_t parentIdx = parentID.IsValid() ? GetNodeIndex(parentID) : INVALID_NODE_INDEX;
+
+#if defined(ENG_DEBUG)
+    for (uint32_t ancestorIdx = parentIdx; ancestorIdx != INVALID_NODE_INDEX; ancestorIdx = m_parents[ancestorIdx]) {
+        ENG_ASSERT(ancestorIdx != nodeIdx, "Scene node can't be parented to its own subtree");
+    }
+#endif
+
+    if (m_parents[nodeIdx] == parentIdx) {
+        return;
+    }
+
+    m_parents[nodeIdx] = parentIdx;
+    MarkLocalDirty(nodeIdx);
+
+    m_isHierarchyDirty = true;
+}
+
+
+SceneNodeID SceneGraph::GetParent(SceneNodeID ID) const noexcept
+{
+    const uint32_t parentIdx = m_parents[GetNodeIndex(ID)];
+    return parentIdx != INVALID_NODE_INDEX ? m_IDs[parentIdx] : SceneNodeID{};
+}
+
+
+void SceneGraph::SetLocalPosition(SceneNodeID ID, const glm::vec3& position) noexcept
+{
+    const uint32_t nodeIdx = GetNodeIndex(ID);
+
+    m_localPositions[nodeIdx] = position;
+    MarkLocalDirty(nodeIdx);
+}
+
+
+void SceneGraph::SetLocalRotation(SceneNodeID ID, const glm::quat& rotation) noexcept
+{
+    ENG_ASSERT(amIsNormalized(rotation), "Scene node rotation must be normalized");
+
+    const uint32_t nodeIdx = GetNodeIndex(ID);
+
+    m_localRotations[nodeIdx] = rotation;
+    MarkLocalDirty(nodeIdx);
+}
+
+
+void SceneGraph::SetLocalScale(SceneNodeID ID, const glm::vec3& scale) noexcept
+{
+    const uint32_t nodeIdx = GetNodeIndex(ID);
+
+    m_localScales[nodeIdx] = scale;
+    MarkLocalDirty(nodeIdx);
+}
+
+
+void SceneGraph::SetLocalTransform(SceneNodeID ID, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) noexcept
+{
+    ENG_ASSERT(amIsNormalized(rotation), "Scene node rotation must be normalized");
+
+    const uint32_t nodeIdx = GetNodeIndex(ID);
+
+    m_localPositions[nodeIdx] = position;
+    m_localRotations[nodeIdx] = rotation;
+    m_localScales[nodeIdx] = scale;
+    MarkLocalDirty(nodeIdx);
+}
+
+
+const glm::vec3& SceneGraph::GetLocalPosition(SceneNodeID ID) const noexcept
+{
+    return m_localPositions[GetNodeIndex(ID)];
+}
+
+
+const glm::quat& SceneGraph::GetLocalRotation(SceneNodeID ID) const noexcept
+{
+    return m_localRotations[GetNodeIndex(ID)];
+}
+
+
+const glm::vec3& SceneGraph::GetLocalScale(SceneNodeID ID) const noexcept
+{
+    return m_localScales[GetNodeIndex(ID)];
+}
+
+
+const glm::mat4x4& SceneGraph::GetWorldMatrix(SceneNodeID ID) const noexcept
+{
+    return m_worldMatrices[GetNodeIndex(ID)];
+}
+
+
+bool SceneGraph::IsWorldMatrixChanged(SceneNodeID ID) const noexcept
+{
+    return m_worldUpdateIndices[GetNodeIndex(ID)] == m_updateIdx;
+}
+
+
+void SceneGraph::Update() noexcept
+{
+    const chr::steady_clock::time_point startTime = chr::steady_clock::now();
+
+    ++m_updateIdx;
+    m_stats = {};
+
+    if (m_isHierarchyDirty) {
+        RebuildHierarchy();
+        m_stats.isHierarchyRebuilt = true;
+    }
+
+    if (m_firstDirtyIdx != INVALID_NODE_INDEX) {
+        std::atomic<uint32_t> updatedNodesCount = 0;
+
+        // Levels above the first dirty node have nothing to update
+        const uint32_t firstLevel = static_cast<uint32_t>(std::upper_bound(m_levelOffsets.begin(), m_levelOffsets.end(), m_firstDirtyIdx) - m_levelOffsets.begin()) - 1;
+
+        for (uint32_t level = firstLevel; level < GetLevelsCount(); ++level) {
+            const uint32_t begin = std::max(m_levelOffsets[level], m_firstDirtyIdx);
+            const uint32_t end = m_levelOffsets[level + 1];
+            const uint32_t batchesCount = (end - begin + UPDATE_BATCH_SIZE - 1) / UPDATE_BATCH_SIZE;
+
+            // Nodes of a level depend on the previous level only, so its batches are independent
+            if (batchesCount > 1 && engIsJobSystemInitialized()) {
+                struct UpdateContext
+                {
+                    SceneGraph*            pGraph;
+                    std::atomic<uint32_t>* pUpdatedNodesCount;
+                    uint32_t               begin;
+                    uint32_t               end;
+                };
+
+                const UpdateContext context = { this, &updatedNodesCount, begin, end };
+
+                JobSystem& jobSystem = JobSystem::GetInstance();
+                JobCounter batchesCounter;
+
+                jobSystem.ParallelFor(batchesCount, 1, [pContext = &context](uint32_t batchIdx) {
+                    const uint32_t batchBegin = pContext->begin + batchIdx * UPDATE_BATCH_SIZE;
+                    const uint32_t batchEnd = std::min(batchBegin + UPDATE_BATCH_SIZE, pContext->end);
+
+                    pContext->pUpdatedNodesCount->fetch_add(pContext->pGraph->UpdateWorldMatrices(batchBegin, batchEnd), std::memory_order_relaxed);
+                }, batchesCounter);
+
+                jobSystem.Wait(batchesCounter);
+            } else {
+                updatedNodesCount.fetch_add(UpdateWorldMatrices(begin, end), std::memory_order_relaxed);
+            }
+        }
+
+        m_stats.updatedNodesCount = updatedNodesCount.load(std::memory_order_relaxed);
+        m_firstDirtyIdx = INVALID_NODE_INDEX;
+    }
+
+    m_stats.nodesCount = GetNodesCount();
+    m_stats.levelsCount = GetLevelsCount();
+    m_stats.updateTimeMs = chr::duration<float, std::milli>(chr::steady_clock::now() - startTime).count();
+}
+
+
+uint32_t SceneGraph::GetNodeIndex(SceneNodeID ID) const noexcept
+{
+    ENG_ASSERT(IsNodeValid(ID), "Invalid scene node ID");
+    return m_nodeIndices[ID.Index()];
+}
+
+
+void SceneGraph::MarkLocalDirty(uint32_t nodeIdx) noexcept
+{
+    m_flags[nodeIdx] |= NODE_FLAG_LOCAL_DIRTY;
+    m_firstDirtyIdx = std::min(m_firstDirtyIdx, nodeIdx);
+}
+
+
+void SceneGraph::RebuildHierarchy() noexcept
+{
+    const uint32_t count = GetNodesCount();
+
+    // Children lists in CSR form, m_newIndices is used as the fill cursor
+    m_childOffsets.assign(count + 1, 0);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (m_parents[i] != INVALID_NODE_INDEX) {
+            ++m_childOffsets[m_parents[i] + 1];
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        m_childOffsets[i + 1] += m_childOffsets[i];
+    }
+
+    m_children.resize(m_childOffsets[count]);
+    m_newIndices.assign(m_childOffsets.begin(), m_childOffsets.end() - 1);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (m_parents[i] != INVALID_NODE_INDEX) {
+            m_children[m_newIndices[m_parents[i]]++] = i;
+        }
+    }
+
+    // Breadth first order from roots. Destroyed nodes aren't visited, so their subtrees are dropped
+    m_newOrder.clear();
+    m_levelOffsets.clear();
+    m_levelOffsets.emplace_back(0);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (m_parents[i] == INVALID_NODE_INDEX && (m_flags[i] & NODE_FLAG_DESTROYED) == 0) {
+            m_newOrder.emplace_back(i);
+        }
+    }
+
+    uint32_t levelBegin = 0;
+
+    while (levelBegin < m_newOrder.size()) {
+        const uint32_t levelEnd = static_cast<uint32_t>(m_newOrder.size());
+        m_levelOffsets.emplace_back(levelEnd);
+
+        for (uint32_t k = levelBegin; k < levelEnd; ++k) {
+            const uint32_t nodeIdx = m_newOrder[k];
+
+            for (uint32_t c = m_childOffsets[nodeIdx]; c < m_childOffsets[nodeIdx + 1]; ++c) {
+                if ((m_flags[m_children[c]] & NODE_FLAG_DESTROYED) == 0) {
+                    m_newOrder.emplace_back(m_children[c]);
+                }
+            }
+        }
+
+        levelBegin = levelEnd;
+    }
+
+    m_newIndices.assign(count, INVALID_NODE_INDEX);
+
+    for (uint32_t k = 0; k < m_newOrder.size(); ++k) {
+        m_newIndices[m_newOrder[k]] = k;
+    }
+
+    // Destroyed nodes already freed their IDs, nodes of their subtrees free them here
+    for (uint32_t i = 0; i < count; ++i) {
+        if (m_newIndices[i] == INVALID_NODE_INDEX && (m_flags[i] & NODE_FLAG_DESTROYED) == 0) {
+            SceneNodeID ID = m_IDs[i];
+            m_IDPool.Deallocate(ID);
+        }
+    }
+
+    PermuteArray(m_localPositions, m_newOrder);
+    PermuteArray(m_localRotations, m_newOrder);
+    PermuteArray(m_localScales, m_newOrder);
+    PermuteArray(m_worldMatrices, m_newOrder);
+    PermuteArray(m_parents, m_newOrder);
+    PermuteArray(m_worldUpdateIndices, m_newOrder);
+    PermuteArray(m_flags, m_newOrder);
+    PermuteArray(m_IDs, m_newOrder);
+
+    for (uint32_t k = 0; k < m_newOrder.size(); ++k) {
+        if (m_parents[k] != INVALID_NODE_INDEX) {
+            m_parents[k] = m_newIndices[m_parents[k]];
+        }
+
+        m_nodeIndices[m_IDs[k].Index()] = k;
+    }
+
+    // Dirty nodes moved, the whole range is scanned once
+    m_firstDirtyIdx = m_newOrder.empty() ? INVALID_NODE_INDEX : 0;
+    m_isHierarchyDirty = false;
+}
+
+
+uint32_t SceneGraph::UpdateWorldMatrices(uint32_t begin, uint32_t end) noexcept
+{
+    uint32_t updatedNodesCount = 0;
+
+    for (uint32_t i = begin; i < end; ++i) {
+        const uint32_t parentIdx = m_parents[i];
+        const bool isParentChanged = parentIdx != INVALID_NODE_INDEX && m_worldUpdateIndices[parentIdx] == m_updateIdx;
+
+        if ((m_flags[i] & NODE_FLAG_LOCAL_DIRTY) == 0 && !isParentChanged) {
+            continue;
+        }
+
+        if (parentIdx == INVALID_NODE_INDEX) {
+            ComposeLocalMatrix(m_localPositions[i], m_localRotations[i], m_localScales[i], m_worldMatrices[i]);
+        } else {
+            glm::mat4x4 localMatrix;
+            ComposeLocalMatrix(m_localPositions[i], m_localRotations[i], m_localScales[i], localMatrix);
+
+            MultiplyMatrices(m_worldMatrices[parentIdx], localMatrix, m_worldMatrices[i]);
+        }
+
+        m_worldUpdateIndices[i] = m_updateIdx;
+        m_flags[i] &= ~NODE_FLAG_LOCAL_DIRTY;
+
+        ++updatedNodesCount;
+    }
+
+    return updatedNodesCount;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "utils/data_structures/generational_id.h"
+
+#include "utils/math/common_math.h"
+
+#include "core.h"
+
+#include <vector>
+
+#include <cstdint>
+
+
+using SceneNodeID = ds::GenerationalID<uint32_t>;
+
+
+struct SceneGraphStats
+{
+    uint32_t nodesCount;
+    uint32_t levelsCount;
+    uint32_t updatedNodesCount;   // Nodes whose world matrix was recomputed by the last update
+    bool     isHierarchyRebuilt;  // Nodes were reordered by the last update
+    float    updateTimeMs;
+};
+
+
+// Transform hierarchy stored as SoA arrays sorted breadth first: every level of the hierarchy is a contiguous range
+// and parents always precede their children. Hierarchy changes only mark the order dirty, Update() reorders nodes once.
+// Update() recomputes world matrices of nodes whose local transform changed and of their whole subtrees only,
+// levels are processed one after another and nodes of a level are split into jobs if the job system is initialized.
+// World matrices are valid after Update(). Not thread safe
+class SceneGraph
+{
+public:
+    SceneGraph() = default;
+
+    SceneGraph(const SceneGraph& other) = delete;
+    SceneGraph& operator=(const SceneGraph& other) = delete;
+
+    void Reserve(uint32_t count) noexcept;
+    void Clear() noexcept;
+
+    // Node gets identity local transform. Invalid parentID creates a root
+    SceneNodeID CreateNode(SceneNodeID parentID = {}) noexcept;
+
+    // Destroys the node with its whole subtree. Handles of the subtree nodes stay valid until the next Update()
+    void DestroyNode(SceneNodeID ID) noexcept;
+
+    // Keeps the local transform, so the world one changes
+    void SetParent(SceneNodeID ID, SceneNodeID parentID) noexcept;
+    SceneNodeID GetParent(SceneNodeID ID) const noexcept;
+
+    void SetLocalPosition(SceneNodeID ID, const glm::vec3& position) noexcept;
+    void SetLocalRotation(SceneNodeID ID, const glm::quat& rotation) noexcept;
+    void SetLocalScale(SceneNodeID ID, const glm::vec3& scale) noexcept;
+    void SetLocalTransform(SceneNodeID ID, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) noexcept;
+
+    const glm::vec3& GetLocalPosition(SceneNodeID ID) const noexcept;
+    const glm::quat& GetLocalRotation(SceneNodeID ID) const noexcept;
+    const glm::vec3& GetLocalScale(SceneNodeID ID) const noexcept;
+
+    const glm::mat4x4& GetWorldMatrix(SceneNodeID ID) const noexcept;
+
+    // True if the last Update() recomputed the node world matrix
+    bool IsWorldMatrixChanged(SceneNodeID ID) const noexcept;
+
+    void Update() noexcept;
+
+    bool IsNodeValid(SceneNodeID ID) const noexcept { return m_IDPool.IsAllocated(ID); }
+
+    uint32_t GetNodesCount() const noexcept { return static_cast<uint32_t>(m_parents.size()); }
+    uint32_t GetLevelsCount() const noexcept { return m_levelOffsets.empty() ? 0 : static_cast<uint32_t>(m_levelOffsets.size() - 1); }
+
+    const SceneGraphStats& GetStats() const noexcept { return m_stats; }
+
+private:
+    enum NodeFlags : uint8_t
+    {
+        NODE_FLAG_LOCAL_DIRTY = 1 << 0,
+        NODE_FLAG_DESTROYED   = 1 << 1,
+    };
+
+    uint32_t GetNodeIndex(SceneNodeID ID) const noexcept;
+    void MarkLocalDirty(uint32_t nodeIdx) noexcept;
+
+    void RebuildHierarchy() noexcept;
+    uint32_t UpdateWorldMatrices(uint32_t begin, uint32_t end) noexcept;
+
+private:
+    static inline constexpr uint32_t INVALID_NODE_INDEX = UINT32_MAX;
+    static inline constexpr uint32_t UPDATE_BATCH_SIZE = 4 * 1024;
+
+private:
+    ds::GenerationalIDPool<SceneNodeID> m_IDPool;
+
+    // Node index by ID slot index
+    std::vector<uint32_t> m_nodeIndices;
+
+    // Nodes data, parents precede children
+    std::vector<glm::vec3>   m_localPositions;
+    std::vector<glm::quat>   m_localRotations;
+    std::vector<glm::vec3>   m_localScales;
+    std::vector<glm::mat4x4> m_worldMatrices;
+    std::vector<uint32_t>    m_parents;
+    std::vector<uint32_t>    m_worldUpdateIndices;  // m_updateIdx of the last world matrix recompute
+    std::vector<uint8_t>     m_flags;
+    std::vector<SceneNodeID> m_IDs;
+
+    // Level i is [m_levelOffsets[i], m_levelOffsets[i + 1])
+    std::vector<uint32_t> m_levelOffsets;
+
+    // Rebuild scratch
+    std::vector<uint32_t> m_newOrder;
+    std::vector<uint32_t> m_newIndices;
+    std::vector<uint32_t> m_childOffsets;
+    std::vector<uint32_t> m_children;
+
+    SceneGraphStats m_stats = {};
+
+    uint32_t m_firstDirtyIdx = INVALID_NODE_INDEX;
+    uint32_t m_updateIdx = 0;
+
+    bool m_isHierarchyDirty = false;
+};
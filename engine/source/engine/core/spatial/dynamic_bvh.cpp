@@ -0,0 +1,1132 @@
+#include "pch.h"
+#include "dynamic_bvh.h"
+
+#include "utils/debug/assertion.h"
+
+#include <chrono>
+#include <limits>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define BVH_SSE2
+  #include <emmintrin.h>
+#endif
+
+
+namespace chr = std::chrono;
+
+
+static constexpr float BVH_FLT_MAX = std::numeric_limits<float>::max();
+static constexpr float BVH_FLT_EPSILON = std::numeric_limits<float>::epsilon();
+
+// Zero direction components are replaced with it, so slab distances never become NaN
+static constexpr float BVH_MIN_RAY_DIR = 1e-20f;
+
+// Query stack entries of subtrees fully inside the frustum, their children need no tests
+static constexpr uint32_t STACK_INSIDE_BIT = 1u << 31;
+
+
+static inline float ComputeArea(const glm::vec3& min, const glm::vec3& max) noexcept
+{
+    const glm::vec3 size = max - min;
+    return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+
+static inline bool IsContained(const glm::vec3& innerMin, const glm::vec3& innerMax, const glm::vec3& outerMin, const glm::vec3& outerMax) noexcept
+{
+    return innerMin.x >= outerMin.x && innerMin.y >= outerMin.y && innerMin.z >= outerMin.z &&
+        innerMax.x <= outerMax.x && innerMax.y <= outerMax.y && innerMax.z <= outerMax.z;
+}
+
+
+struct RaySetup
+{
+    glm::vec3 origin;
+    glm::vec3 invDirection;
+    float maxDistance;
+};
+
+
+static RaySetup SetupRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) noexcept
+{
+    RaySetup ray = {};
+    ray.origin = origin;
+    ray.maxDistance = maxDistance;
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        const float dir = glm::abs(direction[i]) < BVH_MIN_RAY_DIR ? (direction[i] < 0.f ? -BVH_MIN_RAY_DIR : BVH_MIN_RAY_DIR) : direction[i];
+        ray.invDirection[i] = 1.f / dir;
+    }
+
+    return ray;
+}
+
+
+// Node child tests, return the mask of passed lanes. Callers mask out empty lanes
+
+template <typename NodeT>
+static inline uint32_t TestNodeFrustum(const NodeT& node, const Frustum& frustum, bool isInsideTestNeeded, uint32_t& outInsideMask) noexcept
+{
+    // For every plane only the AABB corner farthest along the plane normal has to be tested to reject a box,
+    // the nearest one has to pass every plane for the box to be fully inside
+#if defined(BVH_SSE2)
+    __m128 outside = _mm_setzero_ps();
+    __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+    for (const glm::vec4& plane : frustum.planes) {
+        const __m128 farX = _mm_load_ps(plane.x >= 0.f ? node.maxX : node.minX);
+        const __m128 farY = _mm_load_ps(plane.y >= 0.f ? node.maxY : node.minY);
+        const __m128 farZ = _mm_load_ps(plane.z >= 0.f ? node.maxZ : node.minZ);
+
+        const __m128 planeX = _mm_set1_ps(plane.x);
+        const __m128 planeY = _mm_set1_ps(plane.y);
+        const __m128 planeZ = _mm_set1_ps(plane.z);
+        const __m128 planeW = _mm_set1_ps(plane.w);
+
+        __m128 farDist = _mm_add_ps(_mm_mul_ps(farX, planeX), planeW);
+        farDist = _mm_add_ps(farDist, _mm_mul_ps(farY, planeY));
+        farDist = _mm_add_ps(farDist, _mm_mul_ps(farZ, planeZ));
+
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(farDist, _mm_setzero_ps()));
+
+        if (isInsideTestNeeded) {
+            const __m128 nearX = _mm_load_ps(plane.x >= 0.f ? node.minX : node.maxX);
+            const __m128 nearY = _mm_load_ps(plane.y >= 0.f ? node.minY : node.maxY);
+            const __m128 nearZ = _mm_load_ps(plane.z >= 0.f ? node.minZ : node.maxZ);
+
+            __m128 nearDist = _mm_add_ps(_mm_mul_ps(nearX, planeX), planeW);
+            nearDist = _mm_add_ps(nearDist, _mm_mul_ps(nearY, planeY));
+            nearDist = _mm_add_ps(nearDist, _mm_mul_ps(nearZ, planeZ));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(nearDist, _mm_setzero_ps()));
+        }
+    }
+
+    outInsideMask = isInsideTestNeeded ? static_cast<uint32_t>(_mm_movemask_ps(inside)) : 0;
+    return static_cast<uint32_t>(_mm_movemask_ps(outside)) ^ 0xF;
+#else
+    uint32_t visibleMask = 0;
+    outInsideMask = 0;
+
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        bool isVisible = true;
+        bool isInside = isInsideTestNeeded;
+
+        for (const glm::vec4& plane : frustum.planes) {
+            const float farDist = plane.x * (plane.x >= 0.f ? node.maxX[lane] : node.minX[lane]) +
+                plane.y * (plane.y >= 0.f ? node.maxY[lane] : node.minY[lane]) +
+                plane.z * (plane.z >= 0.f ? node.maxZ[lane] : node.minZ[lane]) + plane.w;
+
+            const float nearDist = plane.x * (plane.x >= 0.f ? node.minX[lane] : node.maxX[lane]) +
+                plane.y * (plane.y >= 0.f ? node.minY[lane] : node.maxY[lane]) +
+                plane.z * (plane.z >= 0.f ? node.minZ[lane] : node.maxZ[lane]) + plane.w;
+
+            isVisible = isVisible && farDist >= 0.f;
+            isInside = isInside && nearDist >= 0.f;
+        }
+
+        visibleMask |= isVisible ? 1u << lane : 0;
+        outInsideMask |= isInside ? 1u << lane : 0;
+    }
+
+    return visibleMask;
+#endif
+}
+
+
+template <typename NodeT>
+static inline uint32_t TestNodeAABB(const NodeT& node, const glm::vec3& aabbMin, const glm::vec3& aabbMax) noexcept
+{
+#if defined(BVH_SSE2)
+    __m128 overlap = _mm_cmple_ps(_mm_load_ps(node.minX), _mm_set1_ps(aabbMax.x));
+    overlap = _mm_and_ps(overlap, _mm_cmple_ps(_mm_load_ps(node.minY), _mm_set1_ps(aabbMax.y)));
+    overlap = _mm_and_ps(overlap, _mm_cmple_ps(_mm_load_ps(node.minZ), _mm_set1_ps(aabbMax.z)));
+    overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_load_ps(node.maxX), _mm_set1_ps(aabbMin.x)));
+    overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_load_ps(node.maxY), _mm_set1_ps(aabbMin.y)));
+    overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_load_ps(node.maxZ), _mm_set1_ps(aabbMin.z)));
+
+    return static_cast<uint32_t>(_mm_movemask_ps(overlap));
+#else
+    uint32_t overlapMask = 0;
+
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        const bool isOverlapped = node.minX[lane] <= aabbMax.x && node.minY[lane] <= aabbMax.y && node.minZ[lane] <= aabbMax.z &&
+            node.maxX[lane] >= aabbMin.x && node.maxY[lane] >= aabbMin.y && node.maxZ[lane] >= aabbMin.z;
+
+        overlapMask |= isOverlapped ? 1u << lane : 0;
+    }
+
+    return overlapMask;
+#endif
+}
+
+
+// Slab test, outEntryDistances are valid for passed lanes only
+template <typename NodeT>
+static inline uint32_t TestNodeRay(const NodeT& node, const RaySetup& ray, float maxDistance, float* outEntryDistances) noexcept
+{
+#if defined(BVH_SSE2)
+    const __m128 originX = _mm_set1_ps(ray.origin.x);
+    const __m128 originY = _mm_set1_ps(ray.origin.y);
+    const __m128 originZ = _mm_set1_ps(ray.origin.z);
+    const __m128 invDirX = _mm_set1_ps(ray.invDirection.x);
+    const __m128 invDirY = _mm_set1_ps(ray.invDirection.y);
+    const __m128 invDirZ = _mm_set1_ps(ray.invDirection.z);
+
+    const __m128 t0X = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), originX), invDirX);
+    const __m128 t1X = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), originX), invDirX);
+    const __m128 t0Y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), originY), invDirY);
+    const __m128 t1Y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), originY), invDirY);
+    const __m128 t0Z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), originZ), invDirZ);
+    const __m128 t1Z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), originZ), invDirZ);
+
+    __m128 entry = _mm_max_ps(_mm_min_ps(t0X, t1X), _mm_min_ps(t0Y, t1Y));
+    entry = _mm_max_ps(entry, _mm_max_ps(_mm_min_ps(t0Z, t1Z), _mm_setzero_ps()));
+
+    __m128 exit = _mm_min_ps(_mm_max_ps(t0X, t1X), _mm_max_ps(t0Y, t1Y));
+    exit = _mm_min_ps(exit, _mm_min_ps(_mm_max_ps(t0Z, t1Z), _mm_set1_ps(maxDistance)));
+
+    _mm_storeu_ps(outEntryDistances, entry);
+
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(entry, exit)));
+#else
+    uint32_t hitMask = 0;
+
+    for (uint32_t lane = 0; lane < 4; ++lane) {
+        const float t0X = (node.minX[lane] - ray.origin.x) * ray.invDirection.x;
+        const float t1X = (node.maxX[lane] - ray.origin.x) * ray.invDirection.x;
+        const float t0Y = (node.minY[lane] - ray.origin.y) * ray.invDirection.y;
+        const float t1Y = (node.maxY[lane] - ray.origin.y) * ray.invDirection.y;
+        const float t0Z = (node.minZ[lane] - ray.origin.z) * ray.invDirection.z;
+        const float t1Z = (node.maxZ[lane] - ray.origin.z) * ray.invDirection.z;
+
+        const float entry = glm::max(glm::max(glm::min(t0X, t1X), glm::min(t0Y, t1Y)), glm::max(glm::min(t0Z, t1Z), 0.f));
+        const float exit = glm::min(glm::min(glm::max(t0X, t1X), glm::max(t0Y, t1Y)), glm::min(glm::max(t0Z, t1Z), maxDistance));
+
+        outEntryDistances[lane] = entry;
+        hitMask |= entry <= exit ? 1u << lane : 0;
+    }
+
+    return hitMask;
+#endif
+}
+
+
+void DynamicBVH::Reserve(uint32_t proxiesCount) noexcept
+{
+    m_proxyMins.reserve(proxiesCount);
+    m_proxyMaxs.reserve(proxiesCount);
+    m_proxyUserData.reserve(proxiesCount);
+    m_proxyNodes.reserve(proxiesCount);
+    m_proxySlots.reserve(proxiesCount);
+    m_proxyIDs.reserve(proxiesCount);
+
+    // A built tree has about a node per 2-3 proxies
+    m_nodes.reserve(proxiesCount / 2 + 1);
+}
+
+
+void DynamicBVH::Clear() noexcept
+{
+    m_IDPool.Reset();
+
+    m_proxyMins.clear();
+    m_proxyMaxs.clear();
+    m_proxyUserData.clear();
+    m_proxyNodes.clear();
+    m_proxySlots.clear();
+    m_proxyIDs.clear();
+
+    m_nodes.clear();
+    m_freeNodes.clear();
+
+    m_root = INVALID_REF;
+
+    m_stats = {};
+}
+
+
+BVHProxyID DynamicBVH::CreateProxy(const glm::vec3& aabbMin, const glm::vec3& aabbMax, uint32_t userData) noexcept
+{
+    ENG_ASSERT(glm::all(glm::lessThanEqual(aabbMin, aabbMax)), "Invalid BVH proxy AABB");
+
+    const BVHProxyID ID = m_IDPool.Allocate();
+
+    if (!ID.IsValid()) {
+        ENG_ASSERT_FAIL("Failed to allocate BVH proxy ID");
+        return ID;
+    }
+
+    const uint32_t proxyIdx = ID.Index();
+    ENG_ASSERT((proxyIdx & PROXY_BIT) == 0, "BVH proxy index overflow");
+
+    if (proxyIdx >= m_proxyIDs.size()) {
+        m_proxyMins.resize(proxyIdx + 1);
+        m_proxyMaxs.resize(proxyIdx + 1);
+        m_proxyUserData.resize(proxyIdx + 1);
+        m_proxyNodes.resize(proxyIdx + 1, INVALID_REF);
+        m_proxySlots.resize(proxyIdx + 1);
+        m_proxyIDs.resize(proxyIdx + 1);
+    }
+
+    m_proxyMins[proxyIdx] = aabbMin;
+    m_proxyMaxs[proxyIdx] = aabbMax;
+    m_proxyUserData[proxyIdx] = userData;
+    m_proxyIDs[proxyIdx] = ID;
+
+    InsertProxy(proxyIdx);
+
+    return ID;
+}
+
+
+void DynamicBVH::DestroyProxy(BVHProxyID ID) noexcept
+{
+    if (!IsProxyValid(ID)) {
+        ENG_ASSERT_FAIL("Invalid BVH proxy ID");
+        return;
+    }
+
+    const uint32_t proxyIdx = ID.Index();
+
+    RemoveProxy(proxyIdx);
+
+    m_proxyNodes[proxyIdx] = INVALID_REF;
+    m_proxyIDs[proxyIdx].Invalidate();
+
+    m_IDPool.Deallocate(ID);
+}
+
+
+void DynamicBVH::UpdateProxy(BVHProxyID ID, const glm::vec3& aabbMin, const glm::vec3& aabbMax) noexcept
+{
+    ENG_ASSERT(glm::all(glm::lessThanEqual(aabbMin, aabbMax)), "Invalid BVH proxy AABB");
+
+    const uint32_t proxyIdx = GetProxyIndex(ID);
+
+    m_proxyMins[proxyIdx] = aabbMin;
+    m_proxyMaxs[proxyIdx] = aabbMax;
+
+    const uint32_t nodeIdx = m_proxyNodes[proxyIdx];
+
+    // Proxy slots always have exact bounds
+    SetSlotBounds(m_nodes[nodeIdx], m_proxySlots[proxyIdx], Bounds { aabbMin, aabbMax });
+
+    // Ancestor slots are grown to keep queries conservative, Refit() shrinks them
+    for (uint32_t childIdx = nodeIdx; ; ) {
+        Node& child = m_nodes[childIdx];
+
+        const bool isDirty = (child.flags & NODE_FLAG_DIRTY) != 0;
+        child.flags |= NODE_FLAG_DIRTY;
+
+        if (child.parent == INVALID_REF) {
+            break;
+        }
+
+        Node& parent = m_nodes[child.parent];
+        const Bounds slotBounds = GetSlotBounds(parent, child.parentSlot);
+
+        // Ancestors of dirty nodes are dirty, and ancestor slots contain the descendant ones
+        if (isDirty && IsContained(aabbMin, aabbMax, slotBounds.min, slotBounds.max)) {
+            break;
+        }
+
+        SetSlotBounds(parent, child.parentSlot, Bounds { glm::min(slotBounds.min, aabbMin), glm::max(slotBounds.max, aabbMax) });
+
+        childIdx = child.parent;
+    }
+}
+
+
+const glm::vec3& DynamicBVH::GetProxyMin(BVHProxyID ID) const noexcept
+{
+    return m_proxyMins[GetProxyIndex(ID)];
+}
+
+
+const glm::vec3& DynamicBVH::GetProxyMax(BVHProxyID ID) const noexcept
+{
+    return m_proxyMaxs[GetProxyIndex(ID)];
+}
+
+
+uint32_t DynamicBVH::GetProxyUserData(BVHProxyID ID) const noexcept
+{
+    return m_proxyUserData[GetProxyIndex(ID)];
+}
+
+
+void DynamicBVH::Build() noexcept
+{
+    const auto startTime = chr::steady_clock::now();
+
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_root = INVALID_REF;
+
+    m_buildRefs.clear();
+
+    Bounds bounds = { glm::vec3(BVH_FLT_MAX), glm::vec3(-BVH_FLT_MAX) };
+
+    for (uint32_t proxyIdx = 0; proxyIdx < m_proxyIDs.size(); ++proxyIdx) {
+        if (!m_proxyIDs[proxyIdx].IsValid()) {
+            continue;
+        }
+
+        const Bounds proxyBounds = GetProxyBounds(proxyIdx);
+        m_buildRefs.emplace_back(BuildRef { proxyBounds, (proxyBounds.min + proxyBounds.max) * 0.5f, proxyIdx });
+
+        bounds.min = glm::min(bounds.min, proxyBounds.min);
+        bounds.max = glm::max(bounds.max, proxyBounds.max);
+    }
+
+    if (!m_buildRefs.empty()) {
+        m_nodes.reserve(m_buildRefs.size() / 2 + 1);
+        m_root = BuildNode(0, static_cast<uint32_t>(m_buildRefs.size()), bounds, INVALID_REF, 0);
+    }
+
+    m_stats.proxiesCount = GetProxiesCount();
+    m_stats.nodesCount = GetNodesCount();
+    m_stats.buildTimeMs = chr::duration<float, std::milli>(chr::steady_clock::now() - startTime).count();
+}
+
+
+void DynamicBVH::Refit() noexcept
+{
+    const auto startTime = chr::steady_clock::now();
+
+    m_stats.refitNodesCount = 0;
+    m_stats.rotationsCount = 0;
+
+    if (m_root != INVALID_REF && (m_nodes[m_root].flags & NODE_FLAG_DIRTY)) {
+        RefitNode(m_root);
+    }
+
+    m_stats.proxiesCount = GetProxiesCount();
+    m_stats.nodesCount = GetNodesCount();
+    m_stats.refitTimeMs = chr::duration<float, std::milli>(chr::steady_clock::now() - startTime).count();
+}
+
+
+void DynamicBVH::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& outUserData) const noexcept
+{
+    outUserData.clear();
+
+    if (m_root == INVALID_REF) {
+        return;
+    }
+
+    m_queryStack.clear();
+    m_queryStack.emplace_back(m_root);
+
+    while (!m_queryStack.empty()) {
+        const uint32_t entry = m_queryStack.back();
+        m_queryStack.pop_back();
+
+        const bool isInside = (entry & STACK_INSIDE_BIT) != 0;
+        const Node& node = m_nodes[entry & ~STACK_INSIDE_BIT];
+
+        const uint32_t childrenMask = (1u << node.childrenCount) - 1;
+
+        uint32_t insideMask = childrenMask;
+        const uint32_t visibleMask = isInside ? childrenMask : TestNodeFrustum(node, frustum, true, insideMask) & childrenMask;
+
+        for (uint32_t slot = 0; slot < node.childrenCount; ++slot) {
+            if ((visibleMask & (1u << slot)) == 0) {
+                continue;
+            }
+
+            const uint32_t childRef = node.children[slot];
+
+            if (childRef & PROXY_BIT) {
+                outUserData.emplace_back(m_proxyUserData[childRef & ~PROXY_BIT]);
+            } else {
+                m_queryStack.emplace_back((insideMask & (1u << slot)) ? childRef | STACK_INSIDE_BIT : childRef);
+            }
+        }
+    }
+}
+
+
+void DynamicBVH::QueryAABB(const glm::vec3& aabbMin, const glm::vec3& aabbMax, std::vector<uint32_t>& outUserData) const noexcept
+{
+    outUserData.clear();
+
+    if (m_root == INVALID_REF) {
+        return;
+    }
+
+    m_queryStack.clear();
+    m_queryStack.emplace_back(m_root);
+
+    while (!m_queryStack.empty()) {
+        const Node& node = m_nodes[m_queryStack.back()];
+        m_queryStack.pop_back();
+
+        const uint32_t overlapMask = TestNodeAABB(node, aabbMin, aabbMax) & ((1u << node.childrenCount) - 1);
+
+        for (uint32_t slot = 0; slot < node.childrenCount; ++slot) {
+            if ((overlapMask & (1u << slot)) == 0) {
+                continue;
+            }
+
+            const uint32_t childRef = node.children[slot];
+
+            if (childRef & PROXY_BIT) {
+                outUserData.emplace_back(m_proxyUserData[childRef & ~PROXY_BIT]);
+            } else {
+                m_queryStack.emplace_back(childRef);
+            }
+        }
+    }
+}
+
+
+void DynamicBVH::QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<uint32_t>& outUserData) const noexcept
+{
+    outUserData.clear();
+
+    if (m_root == INVALID_REF) {
+        return;
+    }
+
+    const RaySetup ray = SetupRay(origin, direction, maxDistance);
+
+    m_queryStack.clear();
+    m_queryStack.emplace_back(m_root);
+
+    while (!m_queryStack.empty()) {
+        const Node& node = m_nodes[m_queryStack.back()];
+        m_queryStack.pop_back();
+
+        float entryDistances[NODE_WIDTH];
+        const uint32_t hitMask = TestNodeRay(node, ray, ray.maxDistance, entryDistances) & ((1u << node.childrenCount) - 1);
+
+        for (uint32_t slot = 0; slot < node.childrenCount; ++slot) {
+            if ((hitMask & (1u << slot)) == 0) {
+                continue;
+            }
+
+            const uint32_t childRef = node.children[slot];
+
+            if (childRef & PROXY_BIT) {
+                outUserData.emplace_back(m_proxyUserData[childRef & ~PROXY_BIT]);
+            } else {
+                m_queryStack.emplace_back(childRef);
+            }
+        }
+    }
+}
+
+
+bool DynamicBVH::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BVHRayHit& outHit) const noexcept
+{
+    if (m_root == INVALID_REF) {
+        return false;
+    }
+
+    const RaySetup ray = SetupRay(origin, direction, maxDistance);
+
+    uint32_t closestProxyIdx = INVALID_REF;
+    float closestDistance = maxDistance;
+
+    m_rayStack.clear();
+    m_rayStack.emplace_back(m_root, 0.f);
+
+    while (!m_rayStack.empty()) {
+        const auto [nodeIdx, nodeEntryDistance] = m_rayStack.back();
+        m_rayStack.pop_back();
+
+        if (nodeEntryDistance > closestDistance) {
+            continue;
+        }
+
+        const Node& node = m_nodes[nodeIdx];
+
+        float entryDistances[NODE_WIDTH];
+        const uint32_t hitMask = TestNodeRay(node, ray, closestDistance, entryDistances) & ((1u << node.childrenCount) - 1);
+
+        const size_t firstPushedIdx = m_rayStack.size();
+
+        for (uint32_t slot = 0; slot < node.childrenCount; ++slot) {
+            if ((hitMask & (1u << slot)) == 0) {
+                continue;
+            }
+
+            const uint32_t childRef = node.children[slot];
+
+            if (childRef & PROXY_BIT) {
+                if (entryDistances[slot] <= closestDistance) {
+                    closestDistance = entryDistances[slot];
+                    closestProxyIdx = childRef & ~PROXY_BIT;
+                }
+            } else {
+                m_rayStack.emplace_back(childRef, entryDistances[slot]);
+            }
+        }
+
+        // The nearest child is popped first, so farther subtrees are likely rejected by the closest distance
+        std::sort(m_rayStack.begin() + firstPushedIdx, m_rayStack.end(), [](const auto& left, const auto& right) {
+            return left.second > right.second;
+        });
+    }
+
+    if (closestProxyIdx == INVALID_REF) {
+        return false;
+    }
+
+    outHit.proxyID = m_proxyIDs[closestProxyIdx];
+    outHit.userData = m_proxyUserData[closestProxyIdx];
+    outHit.distance = closestDistance;
+
+    return true;
+}
+
+
+float DynamicBVH::ComputeSAHCost() const noexcept
+{
+    if (m_root == INVALID_REF) {
+        return 0.f;
+    }
+
+    const Bounds rootBounds = ComputeNodeBounds(m_nodes[m_root]);
+    const float rootArea = glm::max(ComputeArea(rootBounds.min, rootBounds.max), BVH_FLT_EPSILON);
+
+    // Visiting a node tests all its children at once, so the cost is a node visit plus a test per proxy child
+    float cost = 1.f + static_cast<float>(m_nodes[m_root].childrenCount);
+
+    m_queryStack.clear();
+    m_queryStack.emplace_back(m_root);
+
+    while (!m_queryStack.empty()) {
+        const Node& node = m_nodes[m_queryStack.back()];
+        m_queryStack.pop_back();
+
+        for (uint32_t slot = 0; slot < node.childrenCount; ++slot) {
+            const uint32_t childRef = node.children[slot];
+
+            if (childRef & PROXY_BIT) {
+                continue;
+            }
+
+            const Bounds childBounds = GetSlotBounds(node, slot);
+            const Node& child = m_nodes[childRef];
+
+            uint32_t proxyChildrenCount = 0;
+
+            for (uint32_t childSlot = 0; childSlot < child.childrenCount; ++childSlot) {
+                proxyChildrenCount += (child.children[childSlot] & PROXY_BIT) ? 1 : 0;
+            }
+
+            cost += ComputeArea(childBounds.min, childBounds.max) / rootArea * (1.f + static_cast<float>(proxyChildrenCount));
+
+            m_queryStack.emplace_back(childRef);
+        }
+    }
+
+    return cost;
+}
+
+
+DynamicBVH::Bounds DynamicBVH::GetSlotBounds(const Node& node, uint32_t slot) noexcept
+{
+    return Bounds {
+        glm::vec3(node.minX[slot], node.minY[slot], node.minZ[slot]),
+        glm::vec3(node.maxX[slot], node.maxY[slot], node.maxZ[slot])
+    };
+}
+
+
+void DynamicBVH::SetSlotBounds(Node& node, uint32_t slot, const Bounds& bounds) noexcept
+{
+    node.minX[slot] = bounds.min.x;
+    node.minY[slot] = bounds.min.y;
+    node.minZ[slot] = bounds.min.z;
+    node.maxX[slot] = bounds.max.x;
+    node.maxY[slot] = bounds.max.y;
+    node.maxZ[slot] = bounds.max.z;
+}
+
+
+DynamicBVH::Bounds DynamicBVH::ComputeNodeBounds(const Node& node) noexcept
+{
+    Bounds bounds = { glm::vec3(BVH_FLT_MAX), glm::vec3(-BVH_FLT_MAX) };
+
+    for (uint32_t slot = 0; slot < node.childrenCount; ++slot) {
+        const Bounds slotBounds = GetSlotBounds(node, slot);
+
+        bounds.min = glm::min(bounds.min, slotBounds.min);
+        bounds.max = glm::max(bounds.max, slotBounds.max);
+    }
+
+    return bounds;
+}
+
+
+uint32_t DynamicBVH::GetProxyIndex(BVHProxyID ID) const noexcept
+{
+    ENG_ASSERT(IsProxyValid(ID), "Invalid BVH proxy ID");
+    return ID.Index();
+}
+
+
+DynamicBVH::Bounds DynamicBVH::GetProxyBounds(uint32_t proxyIdx) const noexcept
+{
+    return Bounds { m_proxyMins[proxyIdx], m_proxyMaxs[proxyIdx] };
+}
+
+
+uint32_t DynamicBVH::AllocateNode(uint32_t parent, uint32_t parentSlot) noexcept
+{
+    uint32_t nodeIdx = INVALID_REF;
+
+    if (!m_freeNodes.empty()) {
+        nodeIdx = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    } else {
+        nodeIdx = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+
+    ENG_ASSERT((nodeIdx & PROXY_BIT) == 0, "BVH node index overflow");
+
+    Node& node = m_nodes[nodeIdx];
+
+    for (uint32_t slot = 0; slot < NODE_WIDTH; ++slot) {
+        SetSlotBounds(node, slot, Bounds { glm::vec3(BVH_FLT_MAX), glm::vec3(-BVH_FLT_MAX) });
+        node.children[slot] = INVALID_REF;
+    }
+
+    node.parent = parent;
+    node.parentSlot = static_cast<uint8_t>(parentSlot);
+    node.childrenCount = 0;
+    node.flags = 0;
+
+    return nodeIdx;
+}
+
+
+void DynamicBVH::FreeNode(uint32_t nodeIdx) noexcept
+{
+    m_freeNodes.emplace_back(nodeIdx);
+}
+
+
+void DynamicBVH::SetSlot(uint32_t nodeIdx, uint32_t slot, uint32_t childRef, const Bounds& bounds) noexcept
+{
+    Node& node = m_nodes[nodeIdx];
+
+    node.children[slot] = childRef;
+    SetSlotBounds(node, slot, bounds);
+
+    if (childRef & PROXY_BIT) {
+        m_proxyNodes[childRef & ~PROXY_BIT] = nodeIdx;
+        m_proxySlots[childRef & ~PROXY_BIT] = static_cast<uint8_t>(slot);
+    } else {
+        m_nodes[childRef].parent = nodeIdx;
+        m_nodes[childRef].parentSlot = static_cast<uint8_t>(slot);
+    }
+}
+
+
+void DynamicBVH::RemoveSlot(uint32_t nodeIdx, uint32_t slot) noexcept
+{
+    Node& node = m_nodes[nodeIdx];
+
+    const uint32_t lastSlot = node.childrenCount - 1u;
+
+    if (slot != lastSlot) {
+        SetSlot(nodeIdx, slot, node.children[lastSlot], GetSlotBounds(node, lastSlot));
+    }
+
+    node.children[lastSlot] = INVALID_REF;
+    SetSlotBounds(node, lastSlot, Bounds { glm::vec3(BVH_FLT_MAX), glm::vec3(-BVH_FLT_MAX) });
+
+    --node.childrenCount;
+}
+
+
+void DynamicBVH::InsertProxy(uint32_t proxyIdx) noexcept
+{
+    const Bounds proxyBounds = GetProxyBounds(proxyIdx);
+    const uint32_t proxyRef = proxyIdx | PROXY_BIT;
+
+    if (m_root == INVALID_REF) {
+        m_root = AllocateNode(INVALID_REF, 0);
+
+        SetSlot(m_root, 0, proxyRef, proxyBounds);
+        m_nodes[m_root].childrenCount = 1;
+
+        return;
+    }
+
+    for (uint32_t nodeIdx = m_root; ; ) {
+        Node& node = m_nodes[nodeIdx];
+
+        if (node.childrenCount < NODE_WIDTH) {
+            SetSlot(nodeIdx, node.childrenCount, proxyRef, proxyBounds);
+            ++node.childrenCount;
+
+            // Lets the next Refit() rotate the grown path
+            MarkDirty(nodeIdx);
+
+            return;
+        }
+
+        // Descend into the child whose bounds grow the least
+        uint32_t bestSlot = 0;
+        float bestGrowth = BVH_FLT_MAX;
+        float bestArea = BVH_FLT_MAX;
+
+        for (uint32_t slot = 0; slot < NODE_WIDTH; ++slot) {
+            const Bounds slotBounds = GetSlotBounds(node, slot);
+
+            const float area = ComputeArea(slotBounds.min, slotBounds.max);
+            const float growth = ComputeArea(glm::min(slotBounds.min, proxyBounds.min), glm::max(slotBounds.max, proxyBounds.max)) - area;
+
+            if (growth < bestGrowth || (growth == bestGrowth && area < bestArea)) {
+                bestSlot = slot;
+                bestGrowth = growth;
+                bestArea = area;
+            }
+        }
+
+        const Bounds slotBounds = GetSlotBounds(node, bestSlot);
+        const uint32_t childRef = node.children[bestSlot];
+
+        SetSlotBounds(node, bestSlot, Bounds { glm::min(slotBounds.min, proxyBounds.min), glm::max(slotBounds.max, proxyBounds.max) });
+
+        if ((childRef & PROXY_BIT) == 0) {
+            nodeIdx = childRef;
+            continue;
+        }
+
+        // A proxy slot is replaced by a node with both proxies
+        const uint32_t newNodeIdx = AllocateNode(nodeIdx, bestSlot);
+
+        SetSlot(newNodeIdx, 0, childRef, GetProxyBounds(childRef & ~PROXY_BIT));
+        SetSlot(newNodeIdx, 1, proxyRef, proxyBounds);
+        m_nodes[newNodeIdx].childrenCount = 2;
+
+        m_nodes[nodeIdx].children[bestSlot] = newNodeIdx;
+
+        MarkDirty(newNodeIdx);
+
+        return;
+    }
+}
+
+
+void DynamicBVH::RemoveProxy(uint32_t proxyIdx) noexcept
+{
+    uint32_t nodeIdx = m_proxyNodes[proxyIdx];
+    RemoveSlot(nodeIdx, m_proxySlots[proxyIdx]);
+
+    // Empty nodes are removed from their parents, single child nodes are replaced with the child
+    while (nodeIdx != m_root && m_nodes[nodeIdx].childrenCount <= 1) {
+        const Node& node = m_nodes[nodeIdx];
+
+        const uint32_t parentIdx = node.parent;
+        const uint32_t parentSlot = node.parentSlot;
+
+        if (node.childrenCount == 0) {
+            RemoveSlot(parentIdx, parentSlot);
+        } else {
+            SetSlot(parentIdx, parentSlot, node.children[0], GetSlotBounds(node, 0));
+        }
+
+        FreeNode(nodeIdx);
+        nodeIdx = parentIdx;
+    }
+
+    if (nodeIdx == m_root && m_nodes[m_root].childrenCount == 0) {
+        FreeNode(m_root);
+        m_root = INVALID_REF;
+
+        return;
+    }
+
+    MarkDirty(nodeIdx);
+}
+
+
+void DynamicBVH::MarkDirty(uint32_t nodeIdx) noexcept
+{
+    // Ancestors of dirty nodes are dirty already
+    while (nodeIdx != INVALID_REF && (m_nodes[nodeIdx].flags & NODE_FLAG_DIRTY) == 0) {
+        m_nodes[nodeIdx].flags |= NODE_FLAG_DIRTY;
+        nodeIdx = m_nodes[nodeIdx].parent;
+    }
+}
+
+
+uint32_t DynamicBVH::BuildNode(uint32_t begin, uint32_t end, const Bounds& bounds, uint32_t parent, uint32_t parentSlot) noexcept
+{
+    struct BuildRange
+    {
+        uint32_t begin;
+        uint32_t end;
+        Bounds   bounds;
+    };
+
+    // The range is split into up to 4 children, the child with the largest area is split first
+    std::array<BuildRange, NODE_WIDTH> ranges = {};
+    ranges[0] = BuildRange { begin, end, bounds };
+
+    uint32_t rangesCount = 1;
+
+    while (rangesCount < NODE_WIDTH) {
+        uint32_t splitRangeIdx = INVALID_REF;
+        float maxArea = -1.f;
+
+        for (uint32_t rangeIdx = 0; rangeIdx < rangesCount; ++rangeIdx) {
+            const BuildRange& range = ranges[rangeIdx];
+            const float area = ComputeArea(range.bounds.min, range.bounds.max);
+
+            if (range.end - range.begin > 1 && area > maxArea) {
+                splitRangeIdx = rangeIdx;
+                maxArea = area;
+            }
+        }
+
+        if (splitRangeIdx == INVALID_REF) {
+            break;
+        }
+
+        BuildRange& range = ranges[splitRangeIdx];
+        BuildRange& newRange = ranges[rangesCount++];
+
+        newRange.end = range.end;
+        newRange.begin = SplitBuildRange(range.begin, range.end, range.bounds, newRange.bounds);
+        range.end = newRange.begin;
+    }
+
+    const uint32_t nodeIdx = AllocateNode(parent, parentSlot);
+    m_nodes[nodeIdx].childrenCount = static_cast<uint8_t>(rangesCount);
+
+    for (uint32_t slot = 0; slot < rangesCount; ++slot) {
+        const BuildRange& range = ranges[slot];
+
+        if (range.end - range.begin == 1) {
+            const BuildRef& ref = m_buildRefs[range.begin];
+            SetSlot(nodeIdx, slot, ref.proxyIdx | PROXY_BIT, ref.bounds);
+        } else {
+            // Allocations of the subtree may move m_nodes, so the node isn't referenced across the call
+            const uint32_t childIdx = BuildNode(range.begin, range.end, range.bounds, nodeIdx, slot);
+
+            m_nodes[nodeIdx].children[slot] = childIdx;
+            SetSlotBounds(m_nodes[nodeIdx], slot, range.bounds);
+        }
+    }
+
+    return nodeIdx;
+}
+
+
+uint32_t DynamicBVH::SplitBuildRange(uint32_t begin, uint32_t end, Bounds& outLeftBounds, Bounds& outRightBounds) noexcept
+{
+    const Bounds emptyBounds = { glm::vec3(BVH_FLT_MAX), glm::vec3(-BVH_FLT_MAX) };
+
+    Bounds centroidBounds = emptyBounds;
+
+    for (uint32_t refIdx = begin; refIdx < end; ++refIdx) {
+        centroidBounds.min = glm::min(centroidBounds.min, m_buildRefs[refIdx].centroid);
+        centroidBounds.max = glm::max(centroidBounds.max, m_buildRefs[refIdx].centroid);
+    }
+
+    const glm::vec3 centroidExtent = centroidBounds.max - centroidBounds.min;
+
+    uint32_t axis = centroidExtent.x > centroidExtent.y ? 0 : 1;
+    axis = centroidExtent.z > centroidExtent[axis] ? 2 : axis;
+
+    uint32_t mid = INVALID_REF;
+
+    if (centroidExtent[axis] > BVH_FLT_EPSILON) {
+        struct Bin
+        {
+            Bounds   bounds;
+            uint32_t count;
+        };
+
+        std::array<Bin, SAH_BINS_COUNT> bins;
+        bins.fill(Bin { emptyBounds, 0 });
+
+        const float binScale = static_cast<float>(SAH_BINS_COUNT) * (1.f - BVH_FLT_EPSILON) / centroidExtent[axis];
+        const float binOrigin = centroidBounds.min[axis];
+
+        const auto GetBinIdx = [&](const BuildRef& ref) {
+            return std::min(static_cast<uint32_t>((ref.centroid[axis] - binOrigin) * binScale), SAH_BINS_COUNT - 1);
+        };
+
+        for (uint32_t refIdx = begin; refIdx < end; ++refIdx) {
+            const BuildRef& ref = m_buildRefs[refIdx];
+            Bin& bin = bins[GetBinIdx(ref)];
+
+            bin.bounds.min = glm::min(bin.bounds.min, ref.bounds.min);
+            bin.bounds.max = glm::max(bin.bounds.max, ref.bounds.max);
+            ++bin.count;
+        }
+
+        // Right side area and count of splits after every bin
+        std::array<float, SAH_BINS_COUNT> rightCosts = {};
+        Bounds rightBounds = emptyBounds;
+        uint32_t rightCount = 0;
+
+        for (uint32_t binIdx = SAH_BINS_COUNT - 1; binIdx > 0; --binIdx) {
+            rightBounds.min = glm::min(rightBounds.min, bins[binIdx].bounds.min);
+            rightBounds.max = glm::max(rightBounds.max, bins[binIdx].bounds.max);
+            rightCount += bins[binIdx].count;
+
+            rightCosts[binIdx - 1] = rightCount > 0 ? ComputeArea(rightBounds.min, rightBounds.max) * static_cast<float>(rightCount) : BVH_FLT_MAX;
+        }
+
+        Bounds leftBounds = emptyBounds;
+        uint32_t leftCount = 0;
+
+        uint32_t bestBinIdx = INVALID_REF;
+        float bestCost = BVH_FLT_MAX;
+
+        for (uint32_t binIdx = 0; binIdx < SAH_BINS_COUNT - 1; ++binIdx) {
+            leftBounds.min = glm::min(leftBounds.min, bins[binIdx].bounds.min);
+            leftBounds.max = glm::max(leftBounds.max, bins[binIdx].bounds.max);
+            leftCount += bins[binIdx].count;
+
+            if (leftCount == 0 || rightCosts[binIdx] == BVH_FLT_MAX) {
+                continue;
+            }
+
+            const float cost = ComputeArea(leftBounds.min, leftBounds.max) * static_cast<float>(leftCount) + rightCosts[binIdx];
+
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestBinIdx = binIdx;
+            }
+        }
+
+        if (bestBinIdx != INVALID_REF) {
+            const auto rightBeginIt = std::partition(m_buildRefs.begin() + begin, m_buildRefs.begin() + end, [&](const BuildRef& ref) {
+                return GetBinIdx(ref) <= bestBinIdx;
+            });
+
+            mid = static_cast<uint32_t>(rightBeginIt - m_buildRefs.begin());
+        }
+    }
+
+    // Coincident centroids can't be binned, the range is halved
+    if (mid == INVALID_REF) {
+        mid = begin + (end - begin) / 2;
+    }
+
+    outLeftBounds = emptyBounds;
+    outRightBounds = emptyBounds;
+
+    for (uint32_t refIdx = begin; refIdx < end; ++refIdx) {
+        const BuildRef& ref = m_buildRefs[refIdx];
+        Bounds& bounds = refIdx < mid ? outLeftBounds : outRightBounds;
+
+        bounds.min = glm::min(bounds.min, ref.bounds.min);
+        bounds.max = glm::max(bounds.max, ref.bounds.max);
+    }
+
+    return mid;
+}
+
+
+void DynamicBVH::RefitNode(uint32_t nodeIdx) noexcept
+{
+    Node& node = m_nodes[nodeIdx];
+
+    // Proxy slots are kept exact by UpdateProxy(), only dirty child nodes have to be recomputed
+    for (uint32_t slot = 0; slot < node.childrenCount; ++slot) {
+        const uint32_t childRef = node.children[slot];
+
+        if ((childRef & PROXY_BIT) == 0 && (m_nodes[childRef].flags & NODE_FLAG_DIRTY)) {
+            RefitNode(childRef);
+            SetSlotBounds(node, slot, ComputeNodeBounds(m_nodes[childRef]));
+        }
+    }
+
+    node.flags &= ~NODE_FLAG_DIRTY;
+    ++m_stats.refitNodesCount;
+
+    RotateNode(nodeIdx);
+}
+
+
+void DynamicBVH::RotateNode(uint32_t nodeIdx) noexcept
+{
+    // Swapping a node child with a grandchild under another child keeps the node bounds, but may shrink the child.
+    // The swap which shrinks the child surface area the most is done
+    Node& node = m_nodes[nodeIdx];
+
+    uint32_t bestChildSlot = INVALID_REF;
+    uint32_t bestSiblingSlot = INVALID_REF;
+    uint32_t bestGrandchildSlot = INVALID_REF;
+    float bestGain = 0.f;
+
+    for (uint32_t childSlot = 0; childSlot < node.childrenCount; ++childSlot) {
+        const uint32_t childRef = node.children[childSlot];
+
+        if (childRef & PROXY_BIT) {
+            continue;
+        }
+
+        const Node& child = m_nodes[childRef];
+
+        const Bounds childBounds = GetSlotBounds(node, childSlot);
+        const float childArea = ComputeArea(childBounds.min, childBounds.max);
+
+        for (uint32_t siblingSlot = 0; siblingSlot < node.childrenCount; ++siblingSlot) {
+            if (siblingSlot == childSlot) {
+                continue;
+            }
+
+            const Bounds siblingBounds = GetSlotBounds(node, siblingSlot);
+
+            for (uint32_t grandchildSlot = 0; grandchildSlot < child.childrenCount; ++grandchildSlot) {
+                Bounds newChildBounds = siblingBounds;
+
+                for (uint32_t slot = 0; slot < child.childrenCount; ++slot) {
+                    if (slot != grandchildSlot) {
+                        const Bounds slotBounds = GetSlotBounds(child, slot);
+
+                        newChildBounds.min = glm::min(newChildBounds.min, slotBounds.min);
+                        newChildBounds.max = glm::max(newChildBounds.max, slotBounds.max);
+                    }
+                }
+
+                const float gain = childArea - ComputeArea(newChildBounds.min, newChildBounds.max);
+
+                if (gain > bestGain) {
+                    bestGain = gain;
+                    bestChildSlot = childSlot;
+                    bestSiblingSlot = siblingSlot;
+                    bestGrandchildSlot = grandchildSlot;
+                }
+            }
+        }
+    }
+
+    if (bestChildSlot == INVALID_REF) {
+        return;
+    }
+
+    // Tiny gains aren't worth the swap
+    const Bounds nodeBounds = ComputeNodeBounds(node);
+
+    if (bestGain <= ComputeArea(nodeBounds.min, nodeBounds.max) * 1e-3f) {
+        return;
+    }
+
+    const uint32_t childIdx = node.children[bestChildSlot];
+
+    const uint32_t siblingRef = node.children[bestSiblingSlot];
+    const Bounds siblingBounds = GetSlotBounds(node, bestSiblingSlot);
+
+    SetSlot(nodeIdx, bestSiblingSlot, m_nodes[childIdx].children[bestGrandchildSlot], GetSlotBounds(m_nodes[childIdx], bestGrandchildSlot));
+    SetSlot(childIdx, bestGrandchildSlot, siblingRef, siblingBounds);
+
+    SetSlotBounds(m_nodes[nodeIdx], bestChildSlot, ComputeNodeBounds(m_nodes[childIdx]));
+
+    ++m_stats.rotationsCount;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "core/culling/frustum_culling.h"
+
+#include "utils/data_structures/generational_id.h"
+
+#include "utils/math/common_math.h"
+
+#include "core.h"
+
+#include <vector>
+#include <utility>
+
+#include <cstdint>
+
+
+using BVHProxyID = ds::GenerationalID<uint32_t>;
+
+
+struct BVHRayHit
+{
+    BVHProxyID proxyID;
+    uint32_t   userData;
+    float      distance;  // Ray parameter of the AABB entry point: hit point = origin + direction * distance
+};
+
+
+struct DynamicBVHStats
+{
+    uint32_t proxiesCount;
+    uint32_t nodesCount;
+    uint32_t refitNodesCount;  // Nodes whose bounds were recomputed by the last Refit()
+    uint32_t rotationsCount;   // Rotations done by the last Refit()
+    float    buildTimeMs;
+    float    refitTimeMs;
+};
+
+
+// Bounding volume hierarchy over proxy AABBs with 4 wide nodes: child bounds of a node are stored per component,
+// so a node tests all its children against a query with one SSE2 pass. Node children are either nodes or proxies.
+// Build() does a full binned SAH build. Between builds proxies are inserted by descending into the children
+// with the smallest area growth, UpdateProxy() grows ancestor bounds at once, so queries never miss proxies,
+// and Refit() tightens the bounds of changed subtrees bottom up, rotating subtrees of every refitted node
+// when a swap shrinks the surface area of a child. Queries return proxy user data. Not thread safe
+class DynamicBVH
+{
+public:
+    DynamicBVH() = default;
+
+    DynamicBVH(const DynamicBVH& other) = delete;
+    DynamicBVH& operator=(const DynamicBVH& other) = delete;
+
+    void Reserve(uint32_t proxiesCount) noexcept;
+    void Clear() noexcept;
+
+    BVHProxyID CreateProxy(const glm::vec3& aabbMin, const glm::vec3& aabbMax, uint32_t userData) noexcept;
+    void DestroyProxy(BVHProxyID ID) noexcept;
+
+    // Bounds of the proxy ancestors stay loose until the next Refit()
+    void UpdateProxy(BVHProxyID ID, const glm::vec3& aabbMin, const glm::vec3& aabbMax) noexcept;
+
+    const glm::vec3& GetProxyMin(BVHProxyID ID) const noexcept;
+    const glm::vec3& GetProxyMax(BVHProxyID ID) const noexcept;
+    uint32_t GetProxyUserData(BVHProxyID ID) const noexcept;
+
+    // Rebuilds the tree of all proxies from scratch
+    void Build() noexcept;
+    void Refit() noexcept;
+
+    // Out vectors are cleared first
+    void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& outUserData) const noexcept;
+    void QueryAABB(const glm::vec3& aabbMin, const glm::vec3& aabbMax, std::vector<uint32_t>& outUserData) const noexcept;
+    void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<uint32_t>& outUserData) const noexcept;
+
+    // Finds the proxy with the closest AABB entry point in [0, maxDistance], direction doesn't have to be normalized
+    bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BVHRayHit& outHit) const noexcept;
+
+    // Expected node and proxy tests count of a random query relative to the root bounds, lower is better
+    float ComputeSAHCost() const noexcept;
+
+    bool IsProxyValid(BVHProxyID ID) const noexcept { return m_IDPool.IsAllocated(ID); }
+
+    uint32_t GetProxiesCount() const noexcept { return static_cast<uint32_t>(m_IDPool.GetAllocatedCount()); }
+    uint32_t GetNodesCount() const noexcept { return static_cast<uint32_t>(m_nodes.size() - m_freeNodes.size()); }
+
+    const DynamicBVHStats& GetStats() const noexcept { return m_stats; }
+
+private:
+    static inline constexpr uint32_t NODE_WIDTH = 4;
+
+    // Node child reference: node index, or proxy index with PROXY_BIT set
+    static inline constexpr uint32_t INVALID_REF = UINT32_MAX;
+    static inline constexpr uint32_t PROXY_BIT = 1u << 31;
+
+    enum NodeFlags : uint8_t
+    {
+        NODE_FLAG_DIRTY = 1 << 0,
+    };
+
+    // Children occupy the first childrenCount slots. Bounds of empty slots are inverted
+    struct alignas(64) Node
+    {
+        float minX[NODE_WIDTH];
+        float minY[NODE_WIDTH];
+        float minZ[NODE_WIDTH];
+        float maxX[NODE_WIDTH];
+        float maxY[NODE_WIDTH];
+        float maxZ[NODE_WIDTH];
+
+        uint32_t children[NODE_WIDTH];
+
+        uint32_t parent;
+        uint8_t  parentSlot;
+        uint8_t  childrenCount;
+        uint8_t  flags;
+    };
+
+    struct Bounds
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // Proxy bounds are copied, so the build reads refs sequentially
+    struct BuildRef
+    {
+        Bounds    bounds;
+        glm::vec3 centroid;
+        uint32_t  proxyIdx;
+    };
+
+    static Bounds GetSlotBounds(const Node& node, uint32_t slot) noexcept;
+    static void SetSlotBounds(Node& node, uint32_t slot, const Bounds& bounds) noexcept;
+    static Bounds ComputeNodeBounds(const Node& node) noexcept;
+
+    uint32_t GetProxyIndex(BVHProxyID ID) const noexcept;
+    Bounds GetProxyBounds(uint32_t proxyIdx) const noexcept;
+
+    uint32_t AllocateNode(uint32_t parent, uint32_t parentSlot) noexcept;
+    void FreeNode(uint32_t nodeIdx) noexcept;
+
+    // Sets the slot child and points the child back to the slot
+    void SetSlot(uint32_t nodeIdx, uint32_t slot, uint32_t childRef, const Bounds& bounds) noexcept;
+    // Moves the last child into the slot
+    void RemoveSlot(uint32_t nodeIdx, uint32_t slot) noexcept;
+
+    void InsertProxy(uint32_t proxyIdx) noexcept;
+    void RemoveProxy(uint32_t proxyIdx) noexcept;
+
+    void MarkDirty(uint32_t nodeIdx) noexcept;
+
+    uint32_t BuildNode(uint32_t begin, uint32_t end, const Bounds& bounds, uint32_t parent, uint32_t parentSlot) noexcept;
+    // Binned SAH split of m_buildRefs range, returns the first ref of the right part
+    uint32_t SplitBuildRange(uint32_t begin, uint32_t end, Bounds& outLeftBounds, Bounds& outRightBounds) noexcept;
+
+    void RefitNode(uint32_t nodeIdx) noexcept;
+    void RotateNode(uint32_t nodeIdx) noexcept;
+
+private:
+    static inline constexpr uint32_t SAH_BINS_COUNT = 16;
+
+private:
+    ds::GenerationalIDPool<BVHProxyID> m_IDPool;
+
+    // Proxies data by ID index
+    std::vector<glm::vec3>  m_proxyMins;
+    std::vector<glm::vec3>  m_proxyMaxs;
+    std::vector<uint32_t>   m_proxyUserData;
+    std::vector<uint32_t>   m_proxyNodes;
+    std::vector<uint8_t>    m_proxySlots;
+    std::vector<BVHProxyID> m_proxyIDs;
+
+    std::vector<Node>     m_nodes;
+    std::vector<uint32_t> m_freeNodes;
+
+    uint32_t m_root = INVALID_REF;
+
+    // Build and traversal scratch
+    std::vector<BuildRef> m_buildRefs;
+    mutable std::vector<uint32_t> m_queryStack;
+    mutable std::vector<std::pair<uint32_t, float>> m_rayStack;
+
+    DynamicBVHStats m_stats = {};
+};
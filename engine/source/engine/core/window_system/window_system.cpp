@@ -249,13 +249,13 @@ bool Input::Init(Window* pWindow) noexcept
         
         switch (action) {
             case GLFW_PRESS:
-                dispatcher.Notify<EventKeyPressed>(key, scancode);
+                dispatcher.Post<EventKeyPressed>(key, scancode);
                 break;
             case GLFW_RELEASE:
-                dispatcher.Notify<EventKeyReleased>(key, scancode);
+                dispatcher.Post<EventKeyReleased>(key, scancode);
                 break;
             case GLFW_REPEAT:
-                dispatcher.Notify<EventKeyHold>(key, scancode);
+                dispatcher.Post<EventKeyHold>(key, scancode);
                 break;
             default:
                 break;
@@ -265,16 +265,16 @@ bool Input::Init(Window* pWindow) noexcept
     glfwSetCursorPosCallback(pNativeWindow, [](GLFWwindow* pWindow, double xpos, double ypos){
         static es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
 
-        dispatcher.Notify<EventCursorMoved>((float)xpos, (float)ypos);
+        dispatcher.Post<EventCursorMoved>((float)xpos, (float)ypos);
     });
 
     glfwSetCursorEnterCallback(pNativeWindow, [](GLFWwindow* pWindow, int32_t entered){
         static es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
 
         if (entered) {
-            dispatcher.Notify<EventCursorEntered>();
+            dispatcher.Post<EventCursorEntered>();
         } else {
-            dispatcher.Notify<EventCursorLeaved>();
+            dispatcher.Post<EventCursorLeaved>();
         }
     });
     
@@ -284,13 +284,13 @@ bool Input::Init(Window* pWindow) noexcept
         
         switch (action) {
             case GLFW_PRESS:
-                dispatcher.Notify<EventMousePressed>(button);
+                dispatcher.Post<EventMousePressed>(button);
                 break;
             case GLFW_RELEASE:
-                dispatcher.Notify<EventMouseReleased>(button);
+                dispatcher.Post<EventMouseReleased>(button);
                 break;
             case GLFW_REPEAT:
-                dispatcher.Notify<EventMouseHold>(button);
+                dispatcher.Post<EventMouseHold>(button);
                 break;
             default:
                 break;
@@ -300,7 +300,7 @@ bool Input::Init(Window* pWindow) noexcept
     glfwSetScrollCallback(pNativeWindow, [](GLFWwindow* pWindow, double xoffset, double yoffset){
         static es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
 
-        dispatcher.Notify<EventMouseWheel>((float)xoffset, (float)yoffset);
+        dispatcher.Post<EventMouseWheel>((float)xoffset, (float)yoffset);
     });
 
     m_isIntialized = true;
@@ -398,16 +398,21 @@ bool Window::Init(const WindowCreateInfo& createInfo) noexcept
     ASSERT_WINDOW_SYSTEM_INIT_STATUS();
     ENG_ASSERT_WINDOW(createInfo.pTitle != nullptr, "Window title is nullptr");
 
+#if defined(ENG_GL_RECORDING_BACKEND)
+    // GL calls go to the recording backend, the window doesn't need a context
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+#else
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
-
-#if defined(ENG_DEBUG) && defined(ENG_LOGGING_ENABLED)
+    #if defined(ENG_DEBUG) && defined(ENG_LOGGING_ENABLED)
     glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
+    #endif
 #endif
 
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
     m_pNativeWindow = glfwCreateWindow(createInfo.width, createInfo.height, createInfo.pTitle, nullptr, nullptr);
     ENG_ASSERT_WINDOW(m_pNativeWindow, "Window creation failed");
     GLFWwindow* pGLFWWindow = static_cast<GLFWwindow*>(m_pNativeWindow);
@@ -420,8 +425,10 @@ bool Window::Init(const WindowCreateInfo& createInfo) noexcept
     m_framebufferWidth = framebufferWidth;
     m_framebufferHeight = framebufferHeight;
 
+#if !defined(ENG_GL_RECORDING_BACKEND)
     glfwMakeContextCurrent(pGLFWWindow);
     glfwSwapInterval(createInfo.enableVSync);
+#endif
 
     glfwSetWindowUserPointer(pGLFWWindow, this);
 
@@ -487,16 +494,16 @@ bool Window::Init(const WindowCreateInfo& createInfo) noexcept
     glfwSetWindowCloseCallback(pGLFWWindow, [](GLFWwindow* pWindow){
         static es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
 
-        dispatcher.Notify<EventWindowClosed>();
+        dispatcher.Post<EventWindowClosed>();
     });
 
     glfwSetWindowIconifyCallback(pGLFWWindow, [](GLFWwindow* pWindow, int32_t iconified){
         static es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
         
         if (iconified) {
-            dispatcher.Notify<EventWindowMinimized>();
+            dispatcher.Post<EventWindowMinimized>();
         } else {
-            dispatcher.Notify<EventWindowSizeRestored>();
+            dispatcher.Post<EventWindowSizeRestored>();
         }
     });
 
@@ -504,9 +511,9 @@ bool Window::Init(const WindowCreateInfo& createInfo) noexcept
         static es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
         
         if (maximized) {
-            dispatcher.Notify<EventWindowMaximized>();
+            dispatcher.Post<EventWindowMaximized>();
         } else {
-            dispatcher.Notify<EventWindowSizeRestored>();
+            dispatcher.Post<EventWindowSizeRestored>();
         }
     });
 
@@ -514,22 +521,22 @@ bool Window::Init(const WindowCreateInfo& createInfo) noexcept
         static es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
         
         if (focused) {
-            dispatcher.Notify<EventWindowFocused>();
+            dispatcher.Post<EventWindowFocused>();
         } else {
-            dispatcher.Notify<EventWindowUnfocused>();
+            dispatcher.Post<EventWindowUnfocused>();
         }
     });
 
     glfwSetWindowSizeCallback(pGLFWWindow, [](GLFWwindow* pWindow, int32_t width, int32_t height){
         static es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
 
-        dispatcher.Notify<EventWindowResized>(width, height);
+        dispatcher.Post<EventWindowResized>(width, height);
     });
 
     glfwSetFramebufferSizeCallback(pGLFWWindow, [](GLFWwindow* pWindow, int32_t width, int32_t height){
         static es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
 
-        dispatcher.Notify<EventFramebufferResized>(width, height);
+        dispatcher.Post<EventFramebufferResized>(width, height);
     });
 
     m_input.Init(this);
@@ -613,7 +620,10 @@ void Window::Update() noexcept
 void Window::SwapBuffers() noexcept
 {
     ASSERT_WINDOW_INIT_STATUS(this);
+
+#if !defined(ENG_GL_RECORDING_BACKEND)
     glfwSwapBuffers(static_cast<GLFWwindow*>(m_pNativeWindow));
+#endif
 }
 
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "core/event_system/event_traits.h"
+
 #include <cstdint>
 
 
@@ -135,4 +137,24 @@ DECALRE_EMPTY_EVENT(EventWindowMaximized);
 DECALRE_EMPTY_EVENT(EventWindowSizeRestored);
 DECALRE_EMPTY_EVENT(EventWindowClosed);
 DECALRE_EMPTY_EVENT(EventWindowFocused);
-DECALRE_EMPTY_EVENT(EventWindowUnfocused);
\ No newline at end of file
+DECALRE_EMPTY_EVENT(EventWindowUnfocused);
+
+
+namespace es
+{
+    template <> struct EventCoalescingTraits<EventCursorMoved> : LatestEventCoalescingTraits<EventCursorMoved> {};
+    template <> struct EventCoalescingTraits<EventWindowResized> : LatestEventCoalescingTraits<EventWindowResized> {};
+    template <> struct EventCoalescingTraits<EventFramebufferResized> : LatestEventCoalescingTraits<EventFramebufferResized> {};
+
+
+    template <>
+    struct EventCoalescingTraits<EventMouseWheel>
+    {
+        static inline constexpr bool IS_COALESCIBLE = true;
+
+        static void Merge(EventMouseWheel& newEvent, const EventMouseWheel& oldEvent) noexcept
+        {
+            newEvent = EventMouseWheel(newEvent.GetDX() + oldEvent.GetDX(), newEvent.GetDY() + oldEvent.GetDY());
+        }
+    };
+}
\ No newline at end of file
@@ -3,10 +3,12 @@
 #include "engine/engine.h"
 #include "core/event_system/event_dispatcher.h"
 #include "core/window_system/window_system.h"
+#include "core/job_system/job_system.h"
 
 #include "render/render_system/render_system.h"
 #include "core/camera/camera_manager.h"
 
+#include "utils/file/async_file_reader.h"
 #include "utils/debug/assertion.h"
 
 
@@ -58,7 +60,9 @@ Engine::~Engine()
     pMainWindowInst = nullptr;
     engTerminateRenderSystem();
     engTerminateCameraManager();
-    engTerminateWindowSystem();    
+    engTerminateWindowSystem();
+    engTerminateAsyncFileReader();
+    engTerminateJobSystem();
     engTerminateLogSystem();
 }
 
@@ -66,6 +70,13 @@ Engine::~Engine()
 void Engine::Update() noexcept
 {
     pMainWindowInst->Update();
+    
+    // Window callbacks only queue events, so bursts of cursor moves or resizes during window drag are coalesced
+    // and dispatched once per frame
+    es::EventDispatcher::GetInstance().DispatchQueuedEvents();
+
+    AsyncFileReader::GetInstance().DispatchCompletions();
+
     CameraManager::GetInstance().Update(1.f);
 }
 
@@ -121,6 +132,14 @@ Engine::Engine(const char* title, uint32_t width, uint32_t height, bool enableVS
 {
     engInitLogSystem();
 
+    if (!engInitJobSystem()) {
+        return;
+    }
+
+    if (!engInitAsyncFileReader()) {
+        return;
+    }
+
     if (!engInitWindowSystem()) {
         return;
     }
@@ -0,0 +1,339 @@
+#include "pch.h"
+#include "command_list.h"
+
+#include "render/pipeline_manager/pipeline_mng.h"
+#include "render/mesh_manager/mesh_manager.h"
+#include "render/texture_manager/texture_mng.h"
+#include "render/mem_manager/buffer_manager.h"
+
+#include "render/platform/OpenGL/opengl_driver.h"
+
+#include "utils/debug/assertion.h"
+#include "utils/math/common_math.h"
+
+
+static constexpr size_t RENDER_COMMAND_ALIGNMENT = alignof(uint64_t);
+
+
+struct RenderCommandHeader
+{
+    uint32_t          size; // Including the header and the payload
+    RenderCommandType type;
+};
+
+
+struct BindPipelineRenderCommand
+{
+    RenderCommandHeader header;
+    Pipeline*           pPipeline;
+};
+
+
+struct BindMeshRenderCommand
+{
+    RenderCommandHeader header;
+    const MeshObj*      pMesh;
+};
+
+
+struct BindTextureRenderCommand
+{
+    RenderCommandHeader  header;
+    Texture*             pTexture;
+    TextureSamplerState* pSampler;
+    uint32_t             unit;
+};
+
+
+struct BindConstantBufferRenderCommand
+{
+    RenderCommandHeader header;
+    MemoryBuffer*       pBuffer;
+    uint32_t            binding;
+};
+
+
+struct BindBufferRangeRenderCommand
+{
+    RenderCommandHeader header;
+    MemoryBuffer*       pBuffer;
+    uint64_t            offset;
+    uint64_t            size;
+    uint32_t            binding;
+};
+
+
+// Followed by size bytes of data
+struct UpdateBufferRenderCommand
+{
+    RenderCommandHeader header;
+    MemoryBuffer*       pBuffer;
+    uint64_t            offset;
+    uint64_t            size;
+};
+
+
+struct DrawRenderCommand
+{
+    RenderCommandHeader header;
+    uint32_t            first;
+    uint32_t            count;
+    uint32_t            instanceCount;
+    uint32_t            baseVertex;
+    DrawIndexType       indexType;
+};
+
+
+struct DrawIndirectRenderCommand
+{
+    RenderCommandHeader header;
+    MemoryBuffer*       pCommandsBuffer;
+    uint64_t            offset;
+    uint32_t            drawsCount;
+    DrawIndexType       indexType;
+};
+
+
+static constexpr GLenum DrawIndexTypeToGLEnum(DrawIndexType type) noexcept
+{
+    switch(type) {
+        case DrawIndexType::INDEX_TYPE_UINT8: return GL_UNSIGNED_BYTE;
+        case DrawIndexType::INDEX_TYPE_UINT16: return GL_UNSIGNED_SHORT;
+        case DrawIndexType::INDEX_TYPE_UINT32: return GL_UNSIGNED_INT;
+        default:
+            ENG_ASSERT_GRAPHICS_API_FAIL("Invalid draw index type");
+            return GL_NONE;
+    }
+}
+
+
+static constexpr uint64_t GetDrawIndexSize(DrawIndexType type) noexcept
+{
+    switch(type) {
+        case DrawIndexType::INDEX_TYPE_UINT8: return sizeof(uint8_t);
+        case DrawIndexType::INDEX_TYPE_UINT16: return sizeof(uint16_t);
+        case DrawIndexType::INDEX_TYPE_UINT32: return sizeof(uint32_t);
+        default: return 0;
+    }
+}
+
+
+template <typename CommandT>
+CommandT& RenderCommandList::AllocateCommand(RenderCommandType type, size_t payloadSize) noexcept
+{
+    static_assert(std::is_trivially_copyable_v<CommandT>, "Render commands must be POD");
+    static_assert(alignof(CommandT) <= RENDER_COMMAND_ALIGNMENT);
+
+    const size_t commandSize = amAlignUp(sizeof(CommandT) + payloadSize, RENDER_COMMAND_ALIGNMENT);
+    ENG_ASSERT(commandSize <= UINT32_MAX, "Render command is too large");
+
+    const size_t offset = m_buffer.size();
+    m_buffer.resize(offset + commandSize);
+
+    CommandT& command = *reinterpret_cast<CommandT*>(m_buffer.data() + offset);
+    command.header.size = static_cast<uint32_t>(commandSize);
+    command.header.type = type;
+
+    ++m_commandsCount;
+
+    return command;
+}
+
+
+void RenderCommandList::Reserve(size_t sizeInBytes) noexcept
+{
+    m_buffer.reserve(sizeInBytes);
+}
+
+
+void RenderCommandList::BindPipeline(Pipeline* pPipeline) noexcept
+{
+    ENG_ASSERT(pPipeline, "pPipeline is nullptr");
+
+    BindPipelineRenderCommand& command = AllocateCommand<BindPipelineRenderCommand>(RenderCommandType::CMD_BIND_PIPELINE);
+    command.pPipeline = pPipeline;
+}
+
+
+void RenderCommandList::BindMesh(const MeshObj* pMesh) noexcept
+{
+    ENG_ASSERT(pMesh, "pMesh is nullptr");
+
+    BindMeshRenderCommand& command = AllocateCommand<BindMeshRenderCommand>(RenderCommandType::CMD_BIND_MESH);
+    command.pMesh = pMesh;
+}
+
+
+void RenderCommandList::BindTexture(uint32_t unit, Texture* pTexture, TextureSamplerState* pSampler) noexcept
+{
+    ENG_ASSERT(pTexture, "pTexture is nullptr");
+
+    BindTextureRenderCommand& command = AllocateCommand<BindTextureRenderCommand>(RenderCommandType::CMD_BIND_TEXTURE);
+    command.pTexture = pTexture;
+    command.pSampler = pSampler;
+    command.unit = unit;
+}
+
+
+void RenderCommandList::BindConstantBuffer(uint32_t binding, MemoryBuffer* pBuffer) noexcept
+{
+    ENG_ASSERT(pBuffer, "pBuffer is nullptr");
+
+    BindConstantBufferRenderCommand& command = AllocateCommand<BindConstantBufferRenderCommand>(RenderCommandType::CMD_BIND_CONSTANT_BUFFER);
+    command.pBuffer = pBuffer;
+    command.binding = binding;
+}
+
+
+void RenderCommandList::BindBufferRange(uint32_t binding, MemoryBuffer* pBuffer, uint64_t offset, uint64_t size) noexcept
+{
+    ENG_ASSERT(pBuffer, "pBuffer is nullptr");
+
+    BindBufferRangeRenderCommand& command = AllocateCommand<BindBufferRangeRenderCommand>(RenderCommandType::CMD_BIND_BUFFER_RANGE);
+    command.pBuffer = pBuffer;
+    command.offset = offset;
+    command.size = size;
+    command.binding = binding;
+}
+
+
+void RenderCommandList::UpdateBuffer(MemoryBuffer* pBuffer, uint64_t offset, const void* pData, uint64_t size) noexcept
+{
+    ENG_ASSERT(pBuffer, "pBuffer is nullptr");
+    ENG_ASSERT(pData && size > 0, "Invalid buffer update data");
+
+    UpdateBufferRenderCommand& command = AllocateCommand<UpdateBufferRenderCommand>(RenderCommandType::CMD_UPDATE_BUFFER, size);
+    command.pBuffer = pBuffer;
+    command.offset = offset;
+    command.size = size;
+
+    memcpy(&command + 1, pData, size);
+}
+
+
+void RenderCommandList::Draw(uint32_t firstVertex, uint32_t verticesCount, uint32_t instanceCount) noexcept
+{
+    DrawRenderCommand& command = AllocateCommand<DrawRenderCommand>(RenderCommandType::CMD_DRAW);
+    command.first = firstVertex;
+    command.count = verticesCount;
+    command.instanceCount = instanceCount;
+    command.baseVertex = 0;
+    command.indexType = DrawIndexType::INDEX_TYPE_NONE;
+}
+
+
+void RenderCommandList::DrawIndexed(DrawIndexType indexType, uint32_t firstIndex, uint32_t indicesCount, uint32_t instanceCount, uint32_t baseVertex) noexcept
+{
+    ENG_ASSERT(indexType != DrawIndexType::INDEX_TYPE_NONE && indexType < DrawIndexType::INDEX_TYPE_COUNT, "Invalid draw index type");
+
+    DrawRenderCommand& command = AllocateCommand<DrawRenderCommand>(RenderCommandType::CMD_DRAW_INDEXED);
+    command.first = firstIndex;
+    command.count = indicesCount;
+    command.instanceCount = instanceCount;
+    command.baseVertex = baseVertex;
+    command.indexType = indexType;
+}
+
+
+void RenderCommandList::DrawIndexedIndirect(DrawIndexType indexType, MemoryBuffer* pCommandsBuffer, uint64_t offset, uint32_t drawsCount) noexcept
+{
+    ENG_ASSERT(indexType != DrawIndexType::INDEX_TYPE_NONE && indexType < DrawIndexType::INDEX_TYPE_COUNT, "Invalid draw index type");
+    ENG_ASSERT(pCommandsBuffer, "pCommandsBuffer is nullptr");
+
+    DrawIndirectRenderCommand& command = AllocateCommand<DrawIndirectRenderCommand>(RenderCommandType::CMD_DRAW_INDEXED_INDIRECT);
+    command.pCommandsBuffer = pCommandsBuffer;
+    command.offset = offset;
+    command.drawsCount = drawsCount;
+    command.indexType = indexType;
+}
+
+
+void RenderCommandList::Execute() const noexcept
+{
+    const uint8_t* pBufferBegin = m_buffer.data();
+    const uint8_t* pBufferEnd = pBufferBegin + m_buffer.size();
+
+    for (const uint8_t* pCommand = pBufferBegin; pCommand < pBufferEnd; ) {
+        const RenderCommandHeader& header = *reinterpret_cast<const RenderCommandHeader*>(pCommand);
+
+        switch(header.type) {
+            case RenderCommandType::CMD_BIND_PIPELINE:
+            {
+                const BindPipelineRenderCommand& command = *reinterpret_cast<const BindPipelineRenderCommand*>(pCommand);
+                command.pPipeline->Bind();
+                break;
+            }
+            case RenderCommandType::CMD_BIND_MESH:
+            {
+                const BindMeshRenderCommand& command = *reinterpret_cast<const BindMeshRenderCommand*>(pCommand);
+                command.pMesh->Bind();
+                break;
+            }
+            case RenderCommandType::CMD_BIND_TEXTURE:
+            {
+                const BindTextureRenderCommand& command = *reinterpret_cast<const BindTextureRenderCommand*>(pCommand);
+                command.pTexture->Bind(command.unit);
+
+                if (command.pSampler) {
+                    command.pSampler->Bind(command.unit);
+                }
+                break;
+            }
+            case RenderCommandType::CMD_BIND_CONSTANT_BUFFER:
+            {
+                const BindConstantBufferRenderCommand& command = *reinterpret_cast<const BindConstantBufferRenderCommand*>(pCommand);
+                command.pBuffer->BindIndexed(command.binding);
+                break;
+            }
+            case RenderCommandType::CMD_BIND_BUFFER_RANGE:
+            {
+                const BindBufferRangeRenderCommand& command = *reinterpret_cast<const BindBufferRangeRenderCommand*>(pCommand);
+                command.pBuffer->BindIndexedRange(command.binding, command.offset, command.size);
+                break;
+            }
+            case RenderCommandType::CMD_UPDATE_BUFFER:
+            {
+                const UpdateBufferRenderCommand& command = *reinterpret_cast<const UpdateBufferRenderCommand*>(pCommand);
+                command.pBuffer->FillSubdata(command.offset, command.size, &command + 1);
+                break;
+            }
+            case RenderCommandType::CMD_DRAW:
+            {
+                const DrawRenderCommand& command = *reinterpret_cast<const DrawRenderCommand*>(pCommand);
+                glDrawArraysInstanced(GL_TRIANGLES, command.first, command.count, command.instanceCount);
+                break;
+            }
+            case RenderCommandType::CMD_DRAW_INDEXED:
+            {
+                const DrawRenderCommand& command = *reinterpret_cast<const DrawRenderCommand*>(pCommand);
+
+                const uint64_t indicesOffset = command.first * GetDrawIndexSize(command.indexType);
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, DrawIndexTypeToGLEnum(command.indexType),
+                    reinterpret_cast<const void*>(indicesOffset), command.instanceCount, static_cast<GLint>(command.baseVertex));
+                break;
+            }
+            case RenderCommandType::CMD_DRAW_INDEXED_INDIRECT:
+            {
+                const DrawIndirectRenderCommand& command = *reinterpret_cast<const DrawIndirectRenderCommand*>(pCommand);
+
+                // Tightly packed DrawElementsIndirectCommand records, stride 0
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command.pCommandsBuffer->GetRenderID());
+                glMultiDrawElementsIndirect(GL_TRIANGLES, DrawIndexTypeToGLEnum(command.indexType),
+                    reinterpret_cast<const void*>(command.offset), command.drawsCount, 0);
+                break;
+            }
+            default:
+                ENG_ASSERT_GRAPHICS_API_FAIL("Invalid render command type: {}", static_cast<uint32_t>(header.type));
+                return;
+        }
+
+        pCommand += header.size;
+    }
+}
+
+
+void RenderCommandList::Reset() noexcept
+{
+    m_buffer.clear();
+    m_commandsCount = 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "core.h"
+
+#include <vector>
+
+#include <cstdint>
+
+
+class Pipeline;
+class MeshObj;
+class Texture;
+class TextureSamplerState;
+class MemoryBuffer;
+
+
+enum class DrawIndexType : uint8_t
+{
+    INDEX_TYPE_NONE,    // Non indexed draw
+    INDEX_TYPE_UINT8,
+    INDEX_TYPE_UINT16,
+    INDEX_TYPE_UINT32,
+
+    INDEX_TYPE_COUNT
+};
+
+
+enum class RenderCommandType : uint8_t
+{
+    CMD_BIND_PIPELINE,
+    CMD_BIND_MESH,
+    CMD_BIND_TEXTURE,
+    CMD_BIND_CONSTANT_BUFFER,
+    CMD_BIND_BUFFER_RANGE,
+    CMD_UPDATE_BUFFER,
+    CMD_DRAW,
+    CMD_DRAW_INDEXED,
+    CMD_DRAW_INDEXED_INDIRECT,
+
+    CMD_COUNT
+};
+
+
+// Linear arena of POD render commands. Recording doesn't touch GL, so jobs can fill their own lists in parallel
+// and the render thread replays them with Execute() in the order it needs.
+// A single list must not be recorded from several threads at once. Recorded objects must outlive the execution
+class RenderCommandList
+{
+public:
+    RenderCommandList() = default;
+
+    RenderCommandList(const RenderCommandList& other) = delete;
+    RenderCommandList& operator=(const RenderCommandList& other) = delete;
+
+    RenderCommandList(RenderCommandList&& other) noexcept = default;
+    RenderCommandList& operator=(RenderCommandList&& other) noexcept = default;
+
+    void Reserve(size_t sizeInBytes) noexcept;
+
+    void BindPipeline(Pipeline* pPipeline) noexcept;
+    void BindMesh(const MeshObj* pMesh) noexcept;
+    void BindTexture(uint32_t unit, Texture* pTexture, TextureSamplerState* pSampler) noexcept;
+    void BindConstantBuffer(uint32_t binding, MemoryBuffer* pBuffer) noexcept;
+    void BindBufferRange(uint32_t binding, MemoryBuffer* pBuffer, uint64_t offset, uint64_t size) noexcept;
+
+    // pData is copied into the list
+    void UpdateBuffer(MemoryBuffer* pBuffer, uint64_t offset, const void* pData, uint64_t size) noexcept;
+
+    void Draw(uint32_t firstVertex, uint32_t verticesCount, uint32_t instanceCount) noexcept;
+    // baseVertex is added to every fetched index, meshes sharing one vertex buffer are drawn without rebinding
+    void DrawIndexed(DrawIndexType indexType, uint32_t firstIndex, uint32_t indicesCount, uint32_t instanceCount, uint32_t baseVertex = 0) noexcept;
+    // Submits drawsCount DrawElementsIndirectCommand records starting at offset of pCommandsBuffer with a single multi draw call
+    void DrawIndexedIndirect(DrawIndexType indexType, MemoryBuffer* pCommandsBuffer, uint64_t offset, uint32_t drawsCount) noexcept;
+
+    // Replays recorded commands against the GL driver. Must be called on the render thread
+    void Execute() const noexcept;
+
+    // Keeps the allocated memory, so lists recorded every frame stop allocating after a few frames
+    void Reset() noexcept;
+
+    size_t GetCommandsCount() const noexcept { return m_commandsCount; }
+    size_t GetSize() const noexcept { return m_buffer.size(); }
+
+    bool IsEmpty() const noexcept { return m_commandsCount == 0; }
+
+private:
+    template <typename CommandT>
+    CommandT& AllocateCommand(RenderCommandType type, size_t payloadSize = 0) noexcept;
+
+private:
+    std::vector<uint8_t> m_buffer;
+    size_t m_commandsCount = 0;
+};
@@ -0,0 +1,213 @@
+#include "pch.h"
+#include "draw_bucket.h"
+
+#include "render/pipeline_manager/pipeline_mng.h"
+#include "render/mesh_manager/mesh_manager.h"
+#include "render/texture_manager/texture_mng.h"
+
+#include "utils/debug/assertion.h"
+
+
+// Texture units above it are rebound for every draw
+static constexpr uint32_t MAX_TRACKED_TEXTURE_UNITS_COUNT = 32;
+
+
+static constexpr uint64_t MaskBits(uint64_t value, uint32_t bitsCount) noexcept
+{
+    return value & ((1ull << bitsCount) - 1ull);
+}
+
+
+static void RecordDraw(RenderCommandList& commandList, const DrawCommand& command) noexcept
+{
+    if (command.indexType == DrawIndexType::INDEX_TYPE_NONE) {
+        commandList.Draw(command.first, command.count, command.instanceCount);
+    } else {
+        const uint32_t firstIndex = command.pMesh ? command.pMesh->GetFirstIndex() + command.first : command.first;
+        const uint32_t baseVertex = command.pMesh ? command.pMesh->GetBaseVertex() : 0;
+
+        commandList.DrawIndexed(command.indexType, firstIndex, command.count, command.instanceCount, baseVertex);
+    }
+}
+
+
+uint64_t DrawBucket::EncodeSortKey(DrawPass pass, const DrawCommand& command, float depth) noexcept
+{
+    constexpr uint32_t DEPTH_SHIFT = 0;
+    constexpr uint32_t MESH_SHIFT = DEPTH_SHIFT + BITS_PER_DEPTH;
+    constexpr uint32_t MATERIAL_SHIFT = MESH_SHIFT + BITS_PER_MESH;
+    constexpr uint32_t PIPELINE_SHIFT = MATERIAL_SHIFT + BITS_PER_MATERIAL;
+    constexpr uint32_t PASS_SHIFT = PIPELINE_SHIFT + BITS_PER_PIPELINE;
+
+    constexpr float MAX_QUANTIZED_DEPTH = static_cast<float>((1u << BITS_PER_DEPTH) - 1u);
+
+    const uint64_t pipelineIdx = command.pPipeline->GetID().Index();
+    const uint64_t meshIdx = command.pMesh ? command.pMesh->GetID().Index() : 0;
+
+    const DrawMaterial* pMaterial = command.pMaterial;
+    const uint64_t materialIdx = pMaterial && pMaterial->texturesCount > 0 ? pMaterial->pTextures[0]->GetID().Index() : 0;
+
+    const uint64_t quantizedDepth = static_cast<uint64_t>(std::clamp(depth, 0.f, 1.f) * MAX_QUANTIZED_DEPTH);
+
+    return (MaskBits(static_cast<uint64_t>(pass), BITS_PER_PASS) << PASS_SHIFT)
+        | (MaskBits(pipelineIdx, BITS_PER_PIPELINE) << PIPELINE_SHIFT)
+        | (MaskBits(materialIdx, BITS_PER_MATERIAL) << MATERIAL_SHIFT)
+        | (MaskBits(meshIdx, BITS_PER_MESH) << MESH_SHIFT)
+        | (MaskBits(quantizedDepth, BITS_PER_DEPTH) << DEPTH_SHIFT);
+}
+
+
+void DrawBucket::Reserve(size_t commandsCount) noexcept
+{
+    m_commands.reserve(commandsCount);
+    m_entries.reserve(commandsCount);
+    m_tempEntries.reserve(commandsCount);
+}
+
+
+void DrawBucket::AddDraw(DrawPass pass, float depth, const DrawCommand& command) noexcept
+{
+    ENG_ASSERT(pass < DrawPass::PASS_COUNT, "Invalid draw pass");
+    ENG_ASSERT(command.pPipeline && command.pPipeline->IsValid(), "Invalid draw command pipeline");
+    ENG_ASSERT(!command.pMesh || command.pMesh->IsValid(), "Invalid draw command mesh");
+    ENG_ASSERT(!command.pMaterial || command.pMaterial->texturesCount <= DrawMaterial::MAX_TEXTURES_COUNT, "Invalid draw command material");
+    ENG_ASSERT(m_commands.size() < UINT32_MAX, "Draw bucket overflow");
+
+    const uint32_t commandIdx = static_cast<uint32_t>(m_commands.size());
+
+    m_commands.emplace_back(command);
+    m_entries.emplace_back(SortEntry { EncodeSortKey(pass, command, depth), commandIdx });
+
+    m_isSorted = false;
+}
+
+
+void DrawBucket::Sort() noexcept
+{
+    if (m_isSorted) {
+        return;
+    }
+
+    const size_t entriesCount = m_entries.size();
+
+    if (entriesCount < 2) {
+        m_isSorted = true;
+        return;
+    }
+
+    constexpr uint32_t BITS_PER_DIGIT = 8;
+    constexpr uint32_t DIGITS_COUNT = sizeof(uint64_t) * 8 / BITS_PER_DIGIT;
+    constexpr uint32_t RADIX = 1u << BITS_PER_DIGIT;
+
+    // Histograms of all digits are built in a single pass over the keys
+    std::array<std::array<uint32_t, RADIX>, DIGITS_COUNT> histograms = {};
+
+    for (const SortEntry& entry : m_entries) {
+        for (uint32_t digit = 0; digit < DIGITS_COUNT; ++digit) {
+            ++histograms[digit][(entry.key >> (digit * BITS_PER_DIGIT)) & (RADIX - 1)];
+        }
+    }
+
+    m_tempEntries.resize(entriesCount);
+
+    for (uint32_t digit = 0; digit < DIGITS_COUNT; ++digit) {
+        std::array<uint32_t, RADIX>& histogram = histograms[digit];
+
+        const uint32_t digitShift = digit * BITS_PER_DIGIT;
+        const uint32_t firstKeyDigit = (m_entries[0].key >> digitShift) & (RADIX - 1);
+
+        // All keys have the same digit, the pass wouldn't change the order
+        if (histogram[firstKeyDigit] == entriesCount) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t& bucket : histogram) {
+            const uint32_t count = bucket;
+            bucket = offset;
+            offset += count;
+        }
+
+        for (const SortEntry& entry : m_entries) {
+            m_tempEntries[histogram[(entry.key >> digitShift) & (RADIX - 1)]++] = entry;
+        }
+
+        std::swap(m_entries, m_tempEntries);
+    }
+
+    m_isSorted = true;
+}
+
+
+void DrawBucket::Record(RenderCommandList& commandList) noexcept
+{
+    Sort();
+
+    m_stats = {};
+
+    Pipeline* pBoundPipeline = nullptr;
+    // Meshes of one vertex arena share VAO, switching between them doesn't need a rebind
+    uint32_t boundVAORenderID = 0;
+
+    std::array<const Texture*, MAX_TRACKED_TEXTURE_UNITS_COUNT> boundTextures = {};
+    std::array<const TextureSamplerState*, MAX_TRACKED_TEXTURE_UNITS_COUNT> boundSamplers = {};
+
+    for (const SortEntry& entry : m_entries) {
+        const DrawCommand& command = m_commands[entry.commandIdx];
+
+        if (command.pPipeline != pBoundPipeline) {
+            commandList.BindPipeline(command.pPipeline);
+            pBoundPipeline = command.pPipeline;
+
+            ++m_stats.pipelineBindsCount;
+        }
+
+        if (command.pMesh && command.pMesh->GetVAORenderID() != boundVAORenderID) {
+            commandList.BindMesh(command.pMesh);
+            boundVAORenderID = command.pMesh->GetVAORenderID();
+
+            ++m_stats.meshBindsCount;
+        }
+
+        if (command.pMaterial) {
+            const DrawMaterial& material = *command.pMaterial;
+
+            for (uint32_t i = 0; i < material.texturesCount; ++i) {
+                const uint32_t unit = material.units[i];
+                const bool isUnitTracked = unit < MAX_TRACKED_TEXTURE_UNITS_COUNT;
+
+                if (!isUnitTracked || boundTextures[unit] != material.pTextures[i] || boundSamplers[unit] != material.pSamplers[i]) {
+                    commandList.BindTexture(unit, material.pTextures[i], material.pSamplers[i]);
+                    ++m_stats.textureBindsCount;
+
+                    if (isUnitTracked) {
+                        boundTextures[unit] = material.pTextures[i];
+                        boundSamplers[unit] = material.pSamplers[i];
+                    }
+                }
+            }
+        }
+
+        RecordDraw(commandList, command);
+        ++m_stats.drawsCount;
+    }
+}
+
+
+void DrawBucket::Submit() noexcept
+{
+    m_commandList.Reset();
+
+    Record(m_commandList);
+    m_commandList.Execute();
+}
+
+
+void DrawBucket::Clear() noexcept
+{
+    m_commands.clear();
+    m_entries.clear();
+    m_tempEntries.clear();
+
+    m_isSorted = true;
+}
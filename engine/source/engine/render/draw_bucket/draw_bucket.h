@@ -0,0 +1,129 @@
+#pragma once
+
+#include "render/command_list/command_list.h"
+
+#include "core.h"
+
+#include <vector>
+#include <array>
+
+#include <cstdint>
+
+
+class Pipeline;
+class MeshObj;
+class Texture;
+class TextureSamplerState;
+
+
+enum class DrawPass : uint8_t
+{
+    PASS_DEPTH_PREPASS,
+    PASS_GBUFFER,
+    PASS_COLOR,
+    PASS_POST_PROCESS,
+
+    PASS_COUNT
+};
+
+
+// Textures bound for a draw. Owned by the caller and must stay alive until the bucket is submitted
+struct DrawMaterial
+{
+    static inline constexpr uint32_t MAX_TEXTURES_COUNT = 8;
+
+    std::array<Texture*, MAX_TEXTURES_COUNT>             pTextures = {};
+    std::array<TextureSamplerState*, MAX_TEXTURES_COUNT> pSamplers = {};
+    std::array<uint32_t, MAX_TEXTURES_COUNT>             units = {};
+    uint32_t                                             texturesCount = 0;
+};
+
+
+struct DrawCommand
+{
+    Pipeline*           pPipeline = nullptr;
+    const MeshObj*      pMesh = nullptr;     // nullptr for draws which generate vertices in shader, current VAO is kept then
+    const DrawMaterial* pMaterial = nullptr; // Optional
+    uint32_t            first = 0;           // First vertex or first index depending on indexType
+    uint32_t            count = 0;
+    uint32_t            instanceCount = 1;
+    DrawIndexType       indexType = DrawIndexType::INDEX_TYPE_NONE;
+};
+
+
+struct DrawBucketStats
+{
+    uint32_t drawsCount;
+    uint32_t pipelineBindsCount;
+    uint32_t meshBindsCount;
+    uint32_t textureBindsCount;
+};
+
+
+// Collects draws of a frame, sorts them by 64 bit keys and submits them in that order, so state switches are grouped.
+// Key layout from the most significant bits: pass | pipeline | material | mesh | depth.
+// Pipeline, mesh and material (first material texture) are keyed by their ID indices, depth is quantized [0, 1] view depth.
+// Per draw data and draw merging are handled by IndirectDrawBatch, the bucket records every command as is.
+// Only (key, command index) pairs are moved by the sort, commands themselves stay in place
+class DrawBucket
+{
+public:
+    static uint64_t EncodeSortKey(DrawPass pass, const DrawCommand& command, float depth) noexcept;
+
+public:
+    DrawBucket() = default;
+
+    DrawBucket(const DrawBucket& other) = delete;
+    DrawBucket& operator=(const DrawBucket& other) = delete;
+
+    void Reserve(size_t commandsCount) noexcept;
+
+    // depth is expected to be normalized view space depth. Draws with equal keys keep the order they were added in
+    void AddDraw(DrawPass pass, float depth, const DrawCommand& command) noexcept;
+
+    // LSD radix sort over 8 bit digits. Digits which are the same for all keys are skipped
+    void Sort() noexcept;
+
+    // Sorts the commands if needed and records them into the list. Doesn't touch GL, so buckets can be recorded by jobs
+    void Record(RenderCommandList& commandList) noexcept;
+
+    // Records the commands into the internal list and executes it. Must be called on the render thread. The bucket isn't cleared
+    void Submit() noexcept;
+
+    void Clear() noexcept;
+
+    const DrawBucketStats& GetStats() const noexcept { return m_stats; }
+    size_t GetDrawsCount() const noexcept { return m_commands.size(); }
+
+    bool IsSorted() const noexcept { return m_isSorted; }
+    bool IsEmpty() const noexcept { return m_commands.empty(); }
+
+public:
+    static inline constexpr uint32_t BITS_PER_PASS = 3;
+    static inline constexpr uint32_t BITS_PER_PIPELINE = 13;
+    static inline constexpr uint32_t BITS_PER_MATERIAL = 14;
+    static inline constexpr uint32_t BITS_PER_MESH = 14;
+    static inline constexpr uint32_t BITS_PER_DEPTH = 20;
+
+    static_assert(BITS_PER_PASS + BITS_PER_PIPELINE + BITS_PER_MATERIAL + BITS_PER_MESH + BITS_PER_DEPTH == 64);
+    static_assert(static_cast<uint32_t>(DrawPass::PASS_COUNT) <= (1u << BITS_PER_PASS));
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t commandIdx;
+    };
+
+private:
+    std::vector<DrawCommand> m_commands;
+
+    std::vector<SortEntry> m_entries;
+    std::vector<SortEntry> m_tempEntries;
+
+    RenderCommandList m_commandList;
+
+    DrawBucketStats m_stats = {};
+
+    bool m_isSorted = true;
+};
@@ -0,0 +1,268 @@
+#include "pch.h"
+#include "indirect_draw_batch.h"
+
+#include "render/mesh_manager/mesh_manager.h"
+#include "render/mem_manager/buffer_manager.h"
+
+#include "render/platform/OpenGL/opengl_driver.h"
+
+#include "utils/debug/assertion.h"
+
+#include <tuple>
+
+
+static uint64_t EncodeDrawKey(const IndirectDrawCommand& command) noexcept
+{
+    return (static_cast<uint64_t>(command.pMesh->GetVAORenderID()) << 8) | static_cast<uint64_t>(command.indexType);
+}
+
+
+static bool IsSameIndexRange(const DrawElementsIndirectCommand& left, const DrawElementsIndirectCommand& right) noexcept
+{
+    return left.firstIndex == right.firstIndex && left.count == right.count && left.baseVertex == right.baseVertex;
+}
+
+
+bool IndirectDrawBatch::Create(const IndirectDrawBatchCreateInfo& createInfo) noexcept
+{
+    ENG_ASSERT(!IsValid(), "Attempt to create already valid indirect draw batch");
+    ENG_ASSERT(createInfo.maxDrawsCount > 0, "Invalid indirect draw batch max draws count");
+    ENG_ASSERT(createInfo.drawDataSize > 0 && createInfo.drawDataSize <= UINT16_MAX, "Invalid indirect draw batch draw data size: {}", createInfo.drawDataSize);
+
+    MemoryBufferManager& memBuffManager = MemoryBufferManager::GetInstance();
+
+    // Both arrays are sub-allocated from the storage heap, its views are aligned to the storage buffer offset alignment
+    m_indirectView = memBuffManager.AllocateView(MemoryBufferType::TYPE_UNORDERED_ACCESS_BUFFER, uint64_t(createInfo.maxDrawsCount) * sizeof(DrawElementsIndirectCommand));
+
+    if (!m_indirectView.IsValid()) {
+        ENG_ASSERT_FAIL("Failed to allocate indirect draw batch commands view");
+        Destroy();
+        return false;
+    }
+
+    // Instanced draws may need more, the view grows in Upload() then
+    m_drawDataView = memBuffManager.AllocateView(MemoryBufferType::TYPE_UNORDERED_ACCESS_BUFFER, uint64_t(createInfo.maxDrawsCount) * createInfo.drawDataSize);
+
+    if (!m_drawDataView.IsValid()) {
+        ENG_ASSERT_FAIL("Failed to allocate indirect draw batch draw data view");
+        Destroy();
+        return false;
+    }
+
+    m_maxDrawsCount = createInfo.maxDrawsCount;
+    m_drawDataSize = createInfo.drawDataSize;
+    m_drawDataBinding = createInfo.drawDataBinding;
+
+    m_draws.reserve(m_maxDrawsCount);
+    m_drawData.reserve(uint64_t(m_maxDrawsCount) * m_drawDataSize);
+    m_indirectCommands.reserve(m_maxDrawsCount);
+    m_sortedDrawData.reserve(uint64_t(m_maxDrawsCount) * m_drawDataSize);
+
+    Clear();
+
+    return true;
+}
+
+
+void IndirectDrawBatch::Destroy() noexcept
+{
+    if (m_indirectView.IsValid() || m_drawDataView.IsValid()) {
+        MemoryBufferManager& memBuffManager = MemoryBufferManager::GetInstance();
+
+        memBuffManager.DeallocateView(m_indirectView);
+        memBuffManager.DeallocateView(m_drawDataView);
+    }
+
+    m_draws.clear();
+    m_drawData.clear();
+    m_indirectCommands.clear();
+    m_sortedDrawData.clear();
+    m_groups.clear();
+
+    m_commandList.Reset();
+
+    m_stats = {};
+
+    m_maxDrawsCount = 0;
+    m_drawDataSize = 0;
+    m_drawDataBinding = 0;
+
+    m_isBuilt = false;
+}
+
+
+void IndirectDrawBatch::AddDraw(const IndirectDrawCommand& command, const void* pDrawData) noexcept
+{
+    ENG_ASSERT(IsValid(), "Indirect draw batch is invalid");
+    ENG_ASSERT(command.pMesh && command.pMesh->IsValid(), "Invalid indirect draw command mesh");
+    ENG_ASSERT(command.indexType != DrawIndexType::INDEX_TYPE_NONE && command.indexType < DrawIndexType::INDEX_TYPE_COUNT, "Invalid indirect draw command index type");
+    ENG_ASSERT(command.instanceCount > 0, "Invalid indirect draw command instance count");
+    ENG_ASSERT(pDrawData, "pDrawData is nullptr");
+
+    if (m_draws.size() >= m_maxDrawsCount) {
+        ++m_stats.droppedDrawsCount;
+        return;
+    }
+
+    DrawEntry entry = {};
+    entry.key = EncodeDrawKey(command);
+    entry.pMesh = command.pMesh;
+    entry.indirectCommand.count = command.count;
+    entry.indirectCommand.instanceCount = command.instanceCount;
+    entry.indirectCommand.firstIndex = command.pMesh->GetFirstIndex() + command.first;
+    entry.indirectCommand.baseVertex = static_cast<int32_t>(command.pMesh->GetBaseVertex());
+    entry.drawDataIdx = static_cast<uint32_t>(m_drawData.size() / m_drawDataSize);
+    entry.indexType = command.indexType;
+
+    m_draws.emplace_back(entry);
+
+    const uint8_t* pDrawDataBytes = static_cast<const uint8_t*>(pDrawData);
+    m_drawData.insert(m_drawData.end(), pDrawDataBytes, pDrawDataBytes + uint64_t(command.instanceCount) * m_drawDataSize);
+
+    m_isBuilt = false;
+}
+
+
+void IndirectDrawBatch::Build() noexcept
+{
+    if (m_isBuilt) {
+        return;
+    }
+
+    // Draws of the same index range become adjacent, draw data index keeps the order of equal draws stable
+    std::sort(m_draws.begin(), m_draws.end(), [](const DrawEntry& left, const DrawEntry& right) {
+        const DrawElementsIndirectCommand& leftCommand = left.indirectCommand;
+        const DrawElementsIndirectCommand& rightCommand = right.indirectCommand;
+
+        return std::tie(left.key, leftCommand.firstIndex, leftCommand.count, leftCommand.baseVertex, left.drawDataIdx)
+            < std::tie(right.key, rightCommand.firstIndex, rightCommand.count, rightCommand.baseVertex, right.drawDataIdx);
+    });
+
+    m_indirectCommands.clear();
+    m_sortedDrawData.clear();
+    m_groups.clear();
+
+    uint64_t prevKey = UINT64_MAX;
+
+    for (const DrawEntry& entry : m_draws) {
+        if (entry.key != prevKey) {
+            DrawGroup group = {};
+            group.pMesh = entry.pMesh;
+            group.firstCommandIdx = static_cast<uint32_t>(m_indirectCommands.size());
+            group.commandsCount = 0;
+            group.indexType = entry.indexType;
+
+            m_groups.emplace_back(group);
+            prevKey = entry.key;
+        }
+
+        const uint32_t instanceCount = entry.indirectCommand.instanceCount;
+        const uint32_t sortedDrawDataIdx = static_cast<uint32_t>(m_sortedDrawData.size() / m_drawDataSize);
+
+        // Instances of a record are contiguous in the sorted draw data, so adjacent draws of the same range extend the last record
+        if (m_groups.back().commandsCount > 0 && IsSameIndexRange(m_indirectCommands.back(), entry.indirectCommand)) {
+            m_indirectCommands.back().instanceCount += instanceCount;
+        } else {
+            DrawElementsIndirectCommand& indirectCommand = m_indirectCommands.emplace_back(entry.indirectCommand);
+            indirectCommand.baseInstance = sortedDrawDataIdx;
+
+            ++m_groups.back().commandsCount;
+        }
+
+        const uint8_t* pDrawData = m_drawData.data() + uint64_t(entry.drawDataIdx) * m_drawDataSize;
+        m_sortedDrawData.insert(m_sortedDrawData.end(), pDrawData, pDrawData + uint64_t(instanceCount) * m_drawDataSize);
+    }
+
+    m_stats.drawsCount = static_cast<uint32_t>(m_draws.size());
+    m_stats.commandsCount = static_cast<uint32_t>(m_indirectCommands.size());
+    m_stats.multiDrawsCount = static_cast<uint32_t>(m_groups.size());
+
+    m_isBuilt = true;
+}
+
+
+void IndirectDrawBatch::Upload() noexcept
+{
+    ENG_ASSERT(IsValid(), "Indirect draw batch is invalid");
+    ENG_ASSERT(m_isBuilt, "Indirect draw batch must be built before upload");
+
+    if (m_indirectCommands.empty()) {
+        return;
+    }
+
+    const uint64_t drawDataSize = m_sortedDrawData.size();
+
+    if (drawDataSize > m_drawDataView.size) {
+        MemoryBufferManager& memBuffManager = MemoryBufferManager::GetInstance();
+
+        const uint64_t newSize = std::max(m_drawDataView.size * 2, drawDataSize);
+
+        memBuffManager.DeallocateView(m_drawDataView);
+        m_drawDataView = memBuffManager.AllocateView(MemoryBufferType::TYPE_UNORDERED_ACCESS_BUFFER, newSize);
+
+        if (!m_drawDataView.IsValid()) {
+            ENG_ASSERT_FAIL("Failed to grow indirect draw batch draw data view");
+            return;
+        }
+    }
+
+    m_indirectView.FillSubdata(0, m_indirectCommands.size() * sizeof(DrawElementsIndirectCommand), m_indirectCommands.data());
+    m_drawDataView.FillSubdata(0, drawDataSize, m_sortedDrawData.data());
+}
+
+
+void IndirectDrawBatch::Record(RenderCommandList& commandList) const noexcept
+{
+    ENG_ASSERT(m_isBuilt, "Indirect draw batch must be built before recording");
+
+    if (m_groups.empty()) {
+        return;
+    }
+
+    // baseInstance of records is relative to the whole draw data range
+    commandList.BindBufferRange(m_drawDataBinding, m_drawDataView.pBuffer, m_drawDataView.offset, m_sortedDrawData.size());
+
+    uint32_t boundVAORenderID = 0;
+
+    for (const DrawGroup& group : m_groups) {
+        if (group.pMesh->GetVAORenderID() != boundVAORenderID) {
+            commandList.BindMesh(group.pMesh);
+            boundVAORenderID = group.pMesh->GetVAORenderID();
+        }
+
+        commandList.DrawIndexedIndirect(group.indexType, m_indirectView.pBuffer,
+            m_indirectView.offset + uint64_t(group.firstCommandIdx) * sizeof(DrawElementsIndirectCommand), group.commandsCount);
+    }
+}
+
+
+void IndirectDrawBatch::Submit() noexcept
+{
+    Build();
+    Upload();
+
+    m_commandList.Reset();
+
+    Record(m_commandList);
+    m_commandList.Execute();
+}
+
+
+void IndirectDrawBatch::Clear() noexcept
+{
+    m_draws.clear();
+    m_drawData.clear();
+    m_indirectCommands.clear();
+    m_sortedDrawData.clear();
+    m_groups.clear();
+
+    m_stats = {};
+
+    m_isBuilt = true;
+}
+
+
+bool IndirectDrawBatch::IsValid() const noexcept
+{
+    return m_indirectView.IsValid() && m_drawDataView.IsValid();
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "render/command_list/command_list.h"
+#include "render/mem_manager/buffer_manager.h"
+
+#include "core.h"
+
+#include <vector>
+
+#include <cstdint>
+
+
+class MeshObj;
+
+
+// Matches the layout glMultiDrawElementsIndirect reads
+struct DrawElementsIndirectCommand
+{
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t  baseVertex;
+    uint32_t baseInstance;
+};
+
+static_assert(sizeof(DrawElementsIndirectCommand) == 5 * sizeof(uint32_t));
+
+
+struct IndirectDrawBatchCreateInfo
+{
+    uint32_t maxDrawsCount;
+    uint32_t drawDataSize;  // Size of a per draw data element, std430 array stride of the shader side struct
+    uint32_t drawDataBinding;
+};
+
+
+struct IndirectDrawCommand
+{
+    const MeshObj* pMesh = nullptr;
+    uint32_t       first = 0;   // Relative to the mesh first index
+    uint32_t       count = 0;
+    uint32_t       instanceCount = 1;
+    DrawIndexType  indexType = DrawIndexType::INDEX_TYPE_UINT32;
+};
+
+
+struct IndirectDrawBatchStats
+{
+    uint32_t drawsCount;
+    uint32_t commandsCount;     // Indirect records after repeated mesh ranges were merged
+    uint32_t multiDrawsCount;
+    uint32_t droppedDrawsCount; // Draws added after the batch was full
+};
+
+
+// Collects indexed draws of a frame and submits them with glMultiDrawElementsIndirect, one multi draw per (VAO, index type) group.
+// Build() sorts the draws and writes DrawElementsIndirectCommand records and per instance data into CPU arrays, it doesn't touch GL,
+// so batch construction can be done by jobs and profiled headless. Upload() copies both arrays into storage heap views.
+// Draws of the same mesh range are merged into one instanced record. Every record points baseInstance to its first element
+// of the per instance data, which is bound as one storage buffer range, shaders fetch it with gl_BaseInstance + gl_InstanceID
+class IndirectDrawBatch
+{
+public:
+    IndirectDrawBatch() = default;
+    ~IndirectDrawBatch() { Destroy(); }
+
+    IndirectDrawBatch(const IndirectDrawBatch& other) = delete;
+    IndirectDrawBatch& operator=(const IndirectDrawBatch& other) = delete;
+
+    bool Create(const IndirectDrawBatchCreateInfo& createInfo) noexcept;
+    void Destroy() noexcept;
+
+    // pDrawData must point to command.instanceCount elements of drawDataSize bytes, they are copied into the batch
+    void AddDraw(const IndirectDrawCommand& command, const void* pDrawData) noexcept;
+
+    void Build() noexcept;
+    void Upload() noexcept;
+
+    // Records mesh binds, draw data range binds and multi draws. Pipeline must be bound by the caller
+    void Record(RenderCommandList& commandList) const noexcept;
+
+    // Builds, uploads and executes the batch. Must be called on the render thread. The batch isn't cleared
+    void Submit() noexcept;
+
+    void Clear() noexcept;
+
+    const DrawElementsIndirectCommand* GetIndirectCommands() const noexcept { return m_indirectCommands.data(); }
+    const uint8_t* GetDrawData() const noexcept { return m_sortedDrawData.data(); }
+
+    const IndirectDrawBatchStats& GetStats() const noexcept { return m_stats; }
+    uint32_t GetDrawsCount() const noexcept { return static_cast<uint32_t>(m_draws.size()); }
+    uint32_t GetMaxDrawsCount() const noexcept { return m_maxDrawsCount; }
+
+    bool IsBuilt() const noexcept { return m_isBuilt; }
+    bool IsEmpty() const noexcept { return m_draws.empty(); }
+    bool IsValid() const noexcept;
+
+private:
+    struct DrawEntry
+    {
+        uint64_t                    key;    // VAO render ID | index type
+        const MeshObj*              pMesh;
+        DrawElementsIndirectCommand indirectCommand; // baseInstance is set by Build()
+        uint32_t                    drawDataIdx;
+        DrawIndexType               indexType;
+    };
+
+    // Consecutive indirect commands sharing a VAO and an index type
+    struct DrawGroup
+    {
+        const MeshObj* pMesh;
+        uint32_t       firstCommandIdx;
+        uint32_t       commandsCount;
+        DrawIndexType  indexType;
+    };
+
+private:
+    std::vector<DrawEntry> m_draws;
+    std::vector<uint8_t>   m_drawData;
+
+    std::vector<DrawElementsIndirectCommand> m_indirectCommands;
+    std::vector<uint8_t>                     m_sortedDrawData;
+    std::vector<DrawGroup>                   m_groups;
+
+    RenderCommandList m_commandList;
+
+    IndirectDrawBatchStats m_stats = {};
+
+    MemoryBufferView m_indirectView;
+    MemoryBufferView m_drawDataView;
+
+    uint32_t m_maxDrawsCount = 0;
+    uint32_t m_drawDataSize = 0;
+    uint32_t m_drawDataBinding = 0;
+
+    bool m_isBuilt = false;
+};
@@ -2,6 +2,7 @@
 #include "buffer_manager.h"
 
 #include "utils/debug/assertion.h"
+#include "utils/math/common_math.h"
 
 #include "render/platform/OpenGL/opengl_driver.h"
 
@@ -10,6 +11,11 @@ static std::unique_ptr<MemoryBufferManager> pMemoryBufferMngInst = nullptr;
 
 static constexpr size_t MAX_MEM_BUFFER_COUNT = 4096;
 
+static constexpr uint64_t MEM_BUFFER_HEAP_BLOCK_SIZE = 32 * 1024 * 1024;
+// Vertex, index and pixel pack buffer views don't have API alignment requirements, it just keeps views vec4 aligned
+static constexpr uint64_t MEM_BUFFER_HEAP_VERTEX_INDEX_ALIGNMENT = 16;
+static constexpr uint64_t MEM_BUFFER_HEAP_PIXEL_PACK_ALIGNMENT = 16;
+
 
 static GLbitfield GetMemoryBufferCreationFlagsGL(MemoryBufferCreationFlags flags) noexcept
 {
@@ -33,6 +39,7 @@ static GLenum TranslateMemoryBufferTypeToGL(MemoryBufferType type) noexcept
         case MemoryBufferType::TYPE_INDEX_BUFFER:            return GL_ELEMENT_ARRAY_BUFFER;
         case MemoryBufferType::TYPE_CONSTANT_BUFFER:         return GL_UNIFORM_BUFFER;
         case MemoryBufferType::TYPE_UNORDERED_ACCESS_BUFFER: return GL_SHADER_STORAGE_BUFFER;
+        case MemoryBufferType::TYPE_PIXEL_PACK_BUFFER:       return GL_PIXEL_PACK_BUFFER;
         default:
             ENG_ASSERT_FAIL("Invalid memory buffer type");
             return GL_NONE;
@@ -47,6 +54,7 @@ static bool IsBufferIndexedBindable(MemoryBufferType type) noexcept
         case MemoryBufferType::TYPE_INDEX_BUFFER:            return false;
         case MemoryBufferType::TYPE_CONSTANT_BUFFER:         return true;
         case MemoryBufferType::TYPE_UNORDERED_ACCESS_BUFFER: return true;
+        case MemoryBufferType::TYPE_PIXEL_PACK_BUFFER:       return false;
         default:
             ENG_ASSERT_FAIL("Invalid memory buffer type");
             return GL_NONE;
@@ -54,6 +62,36 @@ static bool IsBufferIndexedBindable(MemoryBufferType type) noexcept
 }
 
 
+static uint64_t GetMemoryBufferHeapAlignment(MemoryBufferType type) noexcept
+{
+    switch(type) {
+        case MemoryBufferType::TYPE_VERTEX_BUFFER:           return MEM_BUFFER_HEAP_VERTEX_INDEX_ALIGNMENT;
+        case MemoryBufferType::TYPE_INDEX_BUFFER:            return MEM_BUFFER_HEAP_VERTEX_INDEX_ALIGNMENT;
+        case MemoryBufferType::TYPE_CONSTANT_BUFFER:         return engGetOpenGLUniformBufferOffsetAlignment();
+        case MemoryBufferType::TYPE_UNORDERED_ACCESS_BUFFER: return engGetOpenGLShaderStorageBufferOffsetAlignment();
+        case MemoryBufferType::TYPE_PIXEL_PACK_BUFFER:       return MEM_BUFFER_HEAP_PIXEL_PACK_ALIGNMENT;
+        default:
+            ENG_ASSERT_FAIL("Invalid memory buffer type");
+            return 0;
+    }
+}
+
+
+static const char* GetMemoryBufferHeapBlockDebugName(MemoryBufferType type) noexcept
+{
+    switch(type) {
+        case MemoryBufferType::TYPE_VERTEX_BUFFER:           return "__VERTEX_BUFFER_HEAP_BLOCK__";
+        case MemoryBufferType::TYPE_INDEX_BUFFER:            return "__INDEX_BUFFER_HEAP_BLOCK__";
+        case MemoryBufferType::TYPE_CONSTANT_BUFFER:         return "__CONSTANT_BUFFER_HEAP_BLOCK__";
+        case MemoryBufferType::TYPE_UNORDERED_ACCESS_BUFFER: return "__UNORDERED_ACCESS_BUFFER_HEAP_BLOCK__";
+        case MemoryBufferType::TYPE_PIXEL_PACK_BUFFER:       return "__PIXEL_PACK_BUFFER_HEAP_BLOCK__";
+        default:
+            ENG_ASSERT_FAIL("Invalid memory buffer type");
+            return "__INVALID_HEAP_BLOCK__";
+    }
+}
+
+
 MemoryBuffer::MemoryBuffer(MemoryBuffer &&other) noexcept
 {
 #if defined(ENG_DEBUG)
@@ -126,6 +164,17 @@ void MemoryBuffer::BindIndexed(uint32_t index) noexcept
 }
 
 
+void MemoryBuffer::BindIndexedRange(uint32_t index, uint64_t offset, uint64_t size) noexcept
+{
+    ENG_ASSERT(IsValid(), "Memory buffer \'{}\' is invalid", m_dbgName.CStr());
+    ENG_ASSERT(IsBufferIndexedBindable(m_type), "Memory buffer \'{}\' is not indexed bindable", m_dbgName.CStr());
+    ENG_ASSERT(size > 0 && offset + size <= m_size, "Memory buffer \'{}\' bind range is out of bounds", m_dbgName.CStr());
+
+    const GLenum target = TranslateMemoryBufferTypeToGL(m_type);
+    glBindBufferRange(target, index, m_renderID, offset, size);
+}
+
+
 const void* MemoryBuffer::MapRead() noexcept
 {
     ENG_ASSERT(IsValid(), "Memory buffer \'{}\' is invalid", m_dbgName.CStr());
@@ -156,6 +205,17 @@ void* MemoryBuffer::MapReadWrite() noexcept
 }
 
 
+void* MemoryBuffer::MapPersistentWrite() noexcept
+{
+    ENG_ASSERT(IsValid(), "Memory buffer \'{}\' is invalid", m_dbgName.CStr());
+    ENG_ASSERT(IsWritable(), "Memory buffer \'{}\' was not created with BUFFER_CREATION_FLAG_WRITABLE flag", m_dbgName.CStr());
+    ENG_ASSERT(IsPersistent(), "Memory buffer \'{}\' was not created with BUFFER_CREATION_FLAG_PERSISTENT flag", m_dbgName.CStr());
+    ENG_ASSERT(IsCoherent(), "Memory buffer \'{}\' was not created with BUFFER_CREATION_FLAG_COHERENT flag", m_dbgName.CStr());
+
+    return glMapNamedBufferRange(m_renderID, 0, m_size, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+}
+
+
 bool MemoryBuffer::Unmap() const noexcept
 {
     ENG_ASSERT(IsValid(), "Memory buffer \'{}\' is invalid", m_dbgName.CStr());
@@ -243,6 +303,191 @@ void MemoryBuffer::Destroy() noexcept
 }
 
 
+void MemoryBufferView::FillSubdata(uint64_t offset, uint64_t size, const void* pData) const noexcept
+{
+    ENG_ASSERT(IsValid(), "Memory buffer view is invalid");
+    ENG_ASSERT(offset + size <= this->size, "Memory buffer view fill range is out of bounds");
+
+    pBuffer->FillSubdata(this->offset + offset, size, pData);
+}
+
+
+void MemoryBufferView::BindIndexed(uint32_t index) const noexcept
+{
+    ENG_ASSERT(IsValid(), "Memory buffer view is invalid");
+    pBuffer->BindIndexedRange(index, offset, size);
+}
+
+
+MemoryBufferView MemoryBufferHeap::Allocate(uint64_t size) noexcept
+{
+    ENG_ASSERT(m_pOwner, "Memory buffer heap is not initialized");
+    ENG_ASSERT(size > 0, "Memory buffer view size must be greater than 0");
+
+    const uint64_t granulesCount = amAlignUp(size, m_alignment) / m_alignment;
+
+    TLSFAllocation allocation = {};
+    uint32_t blockIdx = MemoryBufferView::INVALID_HEAP_BLOCK_IDX;
+
+    for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+        if (!m_blocks[i].pBuffer) {
+            continue;
+        }
+
+        allocation = m_blocks[i].allocator.Allocate(granulesCount);
+
+        if (allocation.IsValid()) {
+            blockIdx = i;
+            break;
+        }
+    }
+
+    if (!allocation.IsValid()) {
+        blockIdx = CreateBlock(std::max(amAlignUp(size, m_alignment), m_blockSize));
+
+        if (blockIdx == MemoryBufferView::INVALID_HEAP_BLOCK_IDX) {
+            return {};
+        }
+
+        allocation = m_blocks[blockIdx].allocator.Allocate(granulesCount);
+        ENG_ASSERT(allocation.IsValid(), "Failed to allocate memory buffer view from new heap block");
+    }
+
+    MemoryBufferView view = {};
+    view.pBuffer = m_blocks[blockIdx].pBuffer;
+    view.offset = allocation.offset * m_alignment;
+    view.size = size;
+    view.allocation = allocation;
+    view.heapBlockIdx = blockIdx;
+
+    return view;
+}
+
+
+void MemoryBufferHeap::Deallocate(MemoryBufferView& view) noexcept
+{
+    if (!view.IsValid()) {
+        return;
+    }
+
+    ENG_ASSERT(view.heapBlockIdx < m_blocks.size() && m_blocks[view.heapBlockIdx].pBuffer == view.pBuffer,
+        "Memory buffer view doesn't belong to the heap");
+
+    Block& block = m_blocks[view.heapBlockIdx];
+    block.allocator.Deallocate(view.allocation);
+
+    // Dedicated blocks of oversized views aren't reused
+    if (block.allocator.IsEmpty() && block.pBuffer->GetSize() > m_blockSize) {
+        DestroyBlock(view.heapBlockIdx);
+    }
+
+    view = {};
+}
+
+
+MemoryBufferHeapStats MemoryBufferHeap::GetStats() const noexcept
+{
+    MemoryBufferHeapStats stats = {};
+
+    for (const Block& block : m_blocks) {
+        if (!block.pBuffer) {
+            continue;
+        }
+
+        stats.totalSize += block.pBuffer->GetSize();
+        stats.usedSize += block.allocator.GetUsedSize() * m_alignment;
+        stats.viewsCount += block.allocator.GetAllocationsCount();
+        ++stats.blocksCount;
+    }
+
+    return stats;
+}
+
+
+bool MemoryBufferHeap::Init(MemoryBufferManager* pOwner, MemoryBufferType type, uint64_t blockSize, uint64_t alignment) noexcept
+{
+    ENG_ASSERT(pOwner, "Memory buffer heap owner is nullptr");
+    ENG_ASSERT(alignment > 0 && alignment <= UINT16_MAX, "Invalid memory buffer heap alignment: {}", alignment);
+    ENG_ASSERT(blockSize > 0 && blockSize % alignment == 0, "Memory buffer heap block size must be multiple of alignment");
+
+    m_pOwner = pOwner;
+    m_type = type;
+    m_blockSize = blockSize;
+    m_alignment = alignment;
+
+    return true;
+}
+
+
+void MemoryBufferHeap::Terminate() noexcept
+{
+    for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+        DestroyBlock(i);
+    }
+
+    m_blocks.clear();
+
+    m_pOwner = nullptr;
+    m_blockSize = 0;
+    m_alignment = 0;
+    m_type = MemoryBufferType::TYPE_INVALID;
+}
+
+
+uint32_t MemoryBufferHeap::CreateBlock(uint64_t size) noexcept
+{
+    MemoryBuffer* pBuffer = m_pOwner->RegisterBuffer();
+    ENG_ASSERT(pBuffer, "Failed to register memory buffer heap block");
+
+    MemoryBufferCreateInfo createInfo = {};
+    createInfo.type = m_type;
+    createInfo.dataSize = size;
+    createInfo.elementSize = static_cast<uint16_t>(m_alignment);
+    createInfo.creationFlags = BUFFER_CREATION_FLAG_DYNAMIC_STORAGE;
+    createInfo.pData = nullptr;
+
+    if (!pBuffer->Create(createInfo)) {
+        ENG_ASSERT_FAIL("Failed to create memory buffer heap block");
+        m_pOwner->UnregisterBuffer(pBuffer);
+        return MemoryBufferView::INVALID_HEAP_BLOCK_IDX;
+    }
+
+    pBuffer->SetDebugName(GetMemoryBufferHeapBlockDebugName(m_type));
+
+    auto freeSlotIt = std::find_if(m_blocks.begin(), m_blocks.end(), [](const Block& block) { return block.pBuffer == nullptr; });
+
+    if (freeSlotIt == m_blocks.end()) {
+        freeSlotIt = m_blocks.emplace(m_blocks.end());
+    }
+
+    freeSlotIt->pBuffer = pBuffer;
+    freeSlotIt->allocator.Create(size / m_alignment);
+
+    return static_cast<uint32_t>(std::distance(m_blocks.begin(), freeSlotIt));
+}
+
+
+void MemoryBufferHeap::DestroyBlock(uint32_t blockIdx) noexcept
+{
+    Block& block = m_blocks[blockIdx];
+
+    if (!block.pBuffer) {
+        return;
+    }
+
+    if (!block.allocator.IsEmpty()) {
+        ENG_LOG_WARN("Destruction of \'{}\' while it still has {} views. Prefer to deallocate views manually",
+            block.pBuffer->GetDebugName().CStr(), block.allocator.GetAllocationsCount());
+    }
+
+    block.pBuffer->Destroy();
+    m_pOwner->UnregisterBuffer(block.pBuffer);
+
+    block.pBuffer = nullptr;
+    block.allocator.Destroy();
+}
+
+
 MemoryBufferManager& MemoryBufferManager::GetInstance() noexcept
 {
     ENG_ASSERT(engIsMemoryBufferManagerInitialized(), "Memory buffer manager is not initialized");
@@ -259,9 +504,9 @@ MemoryBufferManager::~MemoryBufferManager()
 MemoryBuffer* MemoryBufferManager::RegisterBuffer() noexcept
 {
     const BufferID bufferID = m_IDPool.Allocate();
-    ENG_ASSERT(bufferID.Value() < m_buffersStorage.size(), "Memory buffer storage overflow");
+    ENG_ASSERT(bufferID.Index() < m_buffersStorage.size(), "Memory buffer storage overflow");
     
-    MemoryBuffer* pBuffer = &m_buffersStorage[bufferID.Value()];
+    MemoryBuffer* pBuffer = &m_buffersStorage[bufferID.Index()];
 
     ENG_ASSERT(!pBuffer->IsValid(), "Valid buffer was returned during registration");
 
@@ -286,6 +531,30 @@ void MemoryBufferManager::UnregisterBuffer(MemoryBuffer* pBuffer)
 }
 
 
+MemoryBufferView MemoryBufferManager::AllocateView(MemoryBufferType type, uint64_t size) noexcept
+{
+    ENG_ASSERT(type < MemoryBufferType::TYPE_COUNT, "Invalid memory buffer type");
+    return m_heaps[static_cast<size_t>(type)].Allocate(size);
+}
+
+
+void MemoryBufferManager::DeallocateView(MemoryBufferView& view) noexcept
+{
+    if (!view.IsValid()) {
+        return;
+    }
+
+    m_heaps[static_cast<size_t>(view.pBuffer->GetType())].Deallocate(view);
+}
+
+
+const MemoryBufferHeap& MemoryBufferManager::GetHeap(MemoryBufferType type) const noexcept
+{
+    ENG_ASSERT(type < MemoryBufferType::TYPE_COUNT, "Invalid memory buffer type");
+    return m_heaps[static_cast<size_t>(type)];
+}
+
+
 bool MemoryBufferManager::Init() noexcept
 {
     if (IsInitialized()) {
@@ -294,6 +563,16 @@ bool MemoryBufferManager::Init() noexcept
 
     m_buffersStorage.resize(MAX_MEM_BUFFER_COUNT);
     m_IDPool.Reset();
+
+    for (size_t i = 0; i < m_heaps.size(); ++i) {
+        const MemoryBufferType type = static_cast<MemoryBufferType>(i);
+        const uint64_t alignment = GetMemoryBufferHeapAlignment(type);
+
+        if (!m_heaps[i].Init(this, type, amAlignUp(MEM_BUFFER_HEAP_BLOCK_SIZE, alignment), alignment)) {
+            return false;
+        }
+    }
+
     m_isInitialized = true;
 
     return true;
@@ -302,6 +581,10 @@ bool MemoryBufferManager::Init() noexcept
 
 void MemoryBufferManager::Terminate() noexcept
 {
+    for (MemoryBufferHeap& heap : m_heaps) {
+        heap.Terminate();
+    }
+
     m_buffersStorage.clear();
     m_IDPool.Reset();
     m_isInitialized = false;
@@ -2,18 +2,23 @@
 
 #include "core.h"
 
-#include "utils/data_structures/base_id.h"
+#include "render/mem_manager/tlsf_allocator.h"
+
+#include "utils/data_structures/generational_id.h"
 #include "utils/data_structures/strid.h"
 
 #include <deque>
 
 
+class MemoryBufferManager;
+
 enum class MemoryBufferType : uint8_t
 {
     TYPE_VERTEX_BUFFER,
     TYPE_INDEX_BUFFER,
     TYPE_CONSTANT_BUFFER,
     TYPE_UNORDERED_ACCESS_BUFFER,
+    TYPE_PIXEL_PACK_BUFFER,
 
     TYPE_COUNT,
     TYPE_INVALID,
@@ -43,7 +48,7 @@ struct MemoryBufferCreateInfo
 };
 
 
-using BufferID = ds::BaseID<uint32_t>;
+using BufferID = ds::GenerationalID<uint32_t>;
 
 
 class MemoryBuffer
@@ -69,6 +74,8 @@ public:
 
     void Bind() noexcept;
     void BindIndexed(uint32_t index) noexcept;
+    // offset must be a multiple of the buffer type offset alignment
+    void BindIndexedRange(uint32_t index, uint64_t offset, uint64_t size) noexcept;
 
     const void* MapRead() noexcept;
     template <typename Type>
@@ -82,6 +89,10 @@ public:
     template <typename Type>
     Type* MapReadWrite() noexcept { return static_cast<Type*>(MapReadWrite()); }
 
+    // Maps the whole buffer for writing. The pointer stays valid while the GPU uses the buffer, until Unmap() is called.
+    // Buffer must be created with BUFFER_CREATION_FLAG_PERSISTENT, BUFFER_CREATION_FLAG_COHERENT and BUFFER_CREATION_FLAG_WRITABLE flags
+    void* MapPersistentWrite() noexcept;
+
     bool Unmap() const noexcept;
 
     bool IsValid() const noexcept;
@@ -100,6 +111,7 @@ public:
     bool IsIndexBuffer() const noexcept { return m_type == MemoryBufferType::TYPE_INDEX_BUFFER; }
     bool IsConstantBuffer() const noexcept { return m_type == MemoryBufferType::TYPE_CONSTANT_BUFFER; }
     bool IsUnorderedAccessBuffer() const noexcept { return m_type == MemoryBufferType::TYPE_UNORDERED_ACCESS_BUFFER; }
+    bool IsPixelPackBuffer() const noexcept { return m_type == MemoryBufferType::TYPE_PIXEL_PACK_BUFFER; }
 
     MemoryBufferCreationFlags GetCreationFlags() const noexcept { return m_creationFlags; }
     bool IsDynamicStorage() const noexcept { return m_creationFlags & BUFFER_CREATION_FLAG_DYNAMIC_STORAGE; }
@@ -123,6 +135,81 @@ private:
 };
 
 
+// Sub-allocated range of a heap block buffer
+struct MemoryBufferView
+{
+    static inline constexpr uint32_t INVALID_HEAP_BLOCK_IDX = UINT32_MAX;
+
+    MemoryBuffer*  pBuffer = nullptr;
+    uint64_t       offset = 0;
+    uint64_t       size = 0;
+
+    TLSFAllocation allocation;  // In heap granules, needed to release the view
+    uint32_t       heapBlockIdx = INVALID_HEAP_BLOCK_IDX;
+
+    // offset is relative to the view
+    void FillSubdata(uint64_t offset, uint64_t size, const void* pData) const noexcept;
+    void BindIndexed(uint32_t index) const noexcept;
+
+    bool IsValid() const noexcept { return pBuffer != nullptr; }
+};
+
+
+struct MemoryBufferHeapStats
+{
+    uint64_t totalSize;
+    uint64_t usedSize; // Including granularity padding
+    uint32_t blocksCount;
+    uint32_t viewsCount;
+};
+
+
+// Large buffers of a single type, sub-allocated by TLSF allocators, so many small resources share a few GL buffer objects.
+// Views are aligned to the type offset alignment. Requests larger than a block get a dedicated block which is released with the view
+class MemoryBufferHeap
+{
+    friend class MemoryBufferManager;
+
+public:
+    MemoryBufferHeap() = default;
+
+    MemoryBufferHeap(const MemoryBufferHeap& other) = delete;
+    MemoryBufferHeap& operator=(const MemoryBufferHeap& other) = delete;
+
+    MemoryBufferView Allocate(uint64_t size) noexcept;
+    void Deallocate(MemoryBufferView& view) noexcept;
+
+    MemoryBufferHeapStats GetStats() const noexcept;
+
+    MemoryBufferType GetType() const noexcept { return m_type; }
+    uint64_t GetBlockSize() const noexcept { return m_blockSize; }
+    uint64_t GetAlignment() const noexcept { return m_alignment; }
+
+private:
+    struct Block
+    {
+        MemoryBuffer* pBuffer;
+        TLSFAllocator allocator;
+    };
+
+    bool Init(MemoryBufferManager* pOwner, MemoryBufferType type, uint64_t blockSize, uint64_t alignment) noexcept;
+    void Terminate() noexcept;
+
+    uint32_t CreateBlock(uint64_t size) noexcept;
+    void DestroyBlock(uint32_t blockIdx) noexcept;
+
+private:
+    // Released blocks keep their slots, so block indices stored in views stay valid
+    std::vector<Block> m_blocks;
+
+    MemoryBufferManager* m_pOwner = nullptr;
+
+    uint64_t m_blockSize = 0;
+    uint64_t m_alignment = 0;
+    MemoryBufferType m_type = MemoryBufferType::TYPE_INVALID;
+};
+
+
 class MemoryBufferManager
 {
     friend bool engInitMemoryBufferManager() noexcept;
@@ -143,6 +230,12 @@ public:
     MemoryBuffer* RegisterBuffer() noexcept;
     void UnregisterBuffer(MemoryBuffer* pBuffer);
 
+    // Sub-allocates a view from the heap of the type instead of creating a dedicated GL buffer
+    MemoryBufferView AllocateView(MemoryBufferType type, uint64_t size) noexcept;
+    void DeallocateView(MemoryBufferView& view) noexcept;
+
+    const MemoryBufferHeap& GetHeap(MemoryBufferType type) const noexcept;
+
 private:
     MemoryBufferManager() = default;
 
@@ -154,9 +247,11 @@ private:
 private:
     std::vector<MemoryBuffer> m_buffersStorage;
 
-    using BufferIDPool = ds::BaseIDPool<BufferID>;
+    using BufferIDPool = ds::GenerationalIDPool<BufferID>;
     BufferIDPool m_IDPool;
 
+    std::array<MemoryBufferHeap, static_cast<size_t>(MemoryBufferType::TYPE_COUNT)> m_heaps;
+
     bool m_isInitialized = false;
 };
 
@@ -0,0 +1,213 @@
+#include "pch.h"
+#include "ring_buffer.h"
+
+#include "utils/debug/assertion.h"
+#include "utils/math/common_math.h"
+
+#include "render/platform/OpenGL/opengl_driver.h"
+
+
+static constexpr GLuint64 FENCE_WAIT_TIMEOUT_NS = 1'000'000;
+
+
+static uint64_t GetMemoryBufferOffsetAlignment(MemoryBufferType type) noexcept
+{
+    switch(type) {
+        case MemoryBufferType::TYPE_CONSTANT_BUFFER:         return engGetOpenGLUniformBufferOffsetAlignment();
+        case MemoryBufferType::TYPE_UNORDERED_ACCESS_BUFFER: return engGetOpenGLShaderStorageBufferOffsetAlignment();
+        default:
+            ENG_ASSERT_GRAPHICS_API_FAIL("Memory ring buffer supports only constant and unordered access buffers");
+            return 0;
+    }
+}
+
+
+// Returns true if the fence wasn't signaled yet and the call had to block
+static bool WaitFence(GLsync fence) noexcept
+{
+    // Poll first, most of the time the GPU is done with the frame already
+    GLenum waitResult = glClientWaitSync(fence, 0, 0);
+
+    if (waitResult == GL_ALREADY_SIGNALED || waitResult == GL_CONDITION_SATISFIED) {
+        return false;
+    }
+
+    while (waitResult == GL_TIMEOUT_EXPIRED) {
+        waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_TIMEOUT_NS);
+    }
+
+    ENG_ASSERT_GRAPHICS_API(waitResult != GL_WAIT_FAILED, "Memory ring buffer fence wait failed");
+
+    return true;
+}
+
+
+bool MemoryRingBuffer::Create(const MemoryRingBufferCreateInfo& createInfo) noexcept
+{
+    ENG_ASSERT_GRAPHICS_API(!IsValid(), "Attempt to create already valid memory ring buffer: {}", GetDebugName().CStr());
+    ENG_ASSERT_GRAPHICS_API(createInfo.frameSize > 0, "Invalid memory ring buffer frame size");
+
+    const uint64_t alignment = GetMemoryBufferOffsetAlignment(createInfo.type);
+
+    if (alignment == 0) {
+        return false;
+    }
+
+    m_pBuffer = MemoryBufferManager::GetInstance().RegisterBuffer();
+    ENG_ASSERT_GRAPHICS_API(m_pBuffer, "Failed to register memory ring buffer");
+
+    // Every region starts at aligned offset
+    const uint64_t frameSize = amAlignUp(createInfo.frameSize, alignment);
+
+    MemoryBufferCreateInfo bufferCreateInfo = {};
+    bufferCreateInfo.type = createInfo.type;
+    bufferCreateInfo.dataSize = frameSize * FRAMES_IN_FLIGHT_COUNT;
+    bufferCreateInfo.elementSize = static_cast<uint16_t>(alignment);
+    bufferCreateInfo.creationFlags = static_cast<MemoryBufferCreationFlags>(
+        BUFFER_CREATION_FLAG_WRITABLE | BUFFER_CREATION_FLAG_PERSISTENT | BUFFER_CREATION_FLAG_COHERENT);
+    bufferCreateInfo.pData = nullptr;
+
+    if (!m_pBuffer->Create(bufferCreateInfo)) {
+        ENG_ASSERT_GRAPHICS_API_FAIL("Failed to create memory ring buffer");
+        Destroy();
+        return false;
+    }
+
+    m_pMappedData = static_cast<uint8_t*>(m_pBuffer->MapPersistentWrite());
+
+    if (!m_pMappedData) {
+        ENG_ASSERT_GRAPHICS_API_FAIL("Failed to persistently map memory ring buffer");
+        Destroy();
+        return false;
+    }
+
+    m_frameSize = frameSize;
+    m_alignment = alignment;
+    m_frameOffset = 0;
+    m_frameIdx = 0;
+    m_stats = {};
+
+    return true;
+}
+
+
+void MemoryRingBuffer::Destroy() noexcept
+{
+    for (void*& pFence : m_frameFences) {
+        if (pFence) {
+            glDeleteSync(static_cast<GLsync>(pFence));
+            pFence = nullptr;
+        }
+    }
+
+    if (m_pBuffer) {
+        if (m_pMappedData) {
+            m_pBuffer->Unmap();
+        }
+
+        m_pBuffer->Destroy();
+        MemoryBufferManager::GetInstance().UnregisterBuffer(m_pBuffer);
+    }
+
+    m_pBuffer = nullptr;
+    m_pMappedData = nullptr;
+    m_frameSize = 0;
+    m_alignment = 0;
+    m_frameOffset = 0;
+    m_frameIdx = 0;
+    m_stats = {};
+}
+
+
+void MemoryRingBuffer::BeginFrame() noexcept
+{
+    ENG_ASSERT_GRAPHICS_API(IsValid(), "Memory ring buffer \'{}\' is invalid", GetDebugName().CStr());
+
+    m_stats = {};
+
+    void*& pFence = m_frameFences[m_frameIdx];
+
+    if (pFence) {
+        m_stats.fenceWaitsCount += WaitFence(static_cast<GLsync>(pFence)) ? 1 : 0;
+
+        glDeleteSync(static_cast<GLsync>(pFence));
+        pFence = nullptr;
+    }
+
+    m_frameOffset = 0;
+}
+
+
+void MemoryRingBuffer::EndFrame() noexcept
+{
+    ENG_ASSERT_GRAPHICS_API(IsValid(), "Memory ring buffer \'{}\' is invalid", GetDebugName().CStr());
+    ENG_ASSERT_GRAPHICS_API(!m_frameFences[m_frameIdx], "Memory ring buffer \'{}\' frame region is already fenced", GetDebugName().CStr());
+
+    m_frameFences[m_frameIdx] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_frameIdx = (m_frameIdx + 1) % FRAMES_IN_FLIGHT_COUNT;
+}
+
+
+MemoryRingBufferAllocation MemoryRingBuffer::Allocate(uint64_t size) noexcept
+{
+    ENG_ASSERT_GRAPHICS_API(IsValid(), "Memory ring buffer \'{}\' is invalid", GetDebugName().CStr());
+    ENG_ASSERT_GRAPHICS_API(size > 0, "Memory ring buffer \'{}\' allocation size is 0", GetDebugName().CStr());
+
+    const uint64_t alignedSize = amAlignUp(size, m_alignment);
+
+    if (m_frameOffset + alignedSize > m_frameSize) {
+        ENG_LOG_GRAPHICS_API_WARN("Memory ring buffer \'{}\' frame region overflow ({} of {} bytes are used, {} requested)",
+            GetDebugName().CStr(), m_frameOffset, m_frameSize, size);
+        ++m_stats.failedAllocationsCount;
+        return {};
+    }
+
+    const uint64_t offset = m_frameIdx * m_frameSize + m_frameOffset;
+
+    m_frameOffset += alignedSize;
+
+    m_stats.allocatedSize += alignedSize;
+    ++m_stats.allocationsCount;
+
+    MemoryRingBufferAllocation allocation = {};
+    allocation.pData = m_pMappedData + offset;
+    allocation.pBuffer = m_pBuffer;
+    allocation.offset = offset;
+    allocation.size = size;
+
+    return allocation;
+}
+
+
+MemoryRingBufferAllocation MemoryRingBuffer::Allocate(const void* pData, uint64_t size) noexcept
+{
+    ENG_ASSERT_GRAPHICS_API(pData, "pData is nullptr");
+
+    MemoryRingBufferAllocation allocation = Allocate(size);
+
+    if (allocation.IsValid()) {
+        memcpy(allocation.pData, pData, size);
+    }
+
+    return allocation;
+}
+
+
+void MemoryRingBuffer::SetDebugName(ds::StrID name) noexcept
+{
+    if (m_pBuffer) {
+        m_pBuffer->SetDebugName(name);
+    }
+}
+
+
+ds::StrID MemoryRingBuffer::GetDebugName() const noexcept
+{
+    return m_pBuffer ? m_pBuffer->GetDebugName() : "";
+}
+
+
+bool MemoryRingBuffer::IsValid() const noexcept
+{
+    return m_pBuffer && m_pBuffer->IsValid() && m_pMappedData;
+}
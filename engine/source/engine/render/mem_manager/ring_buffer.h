@@ -0,0 +1,94 @@
+#pragma once
+
+#include "render/mem_manager/buffer_manager.h"
+
+#include <array>
+
+
+struct MemoryRingBufferCreateInfo
+{
+    uint64_t         frameSize; // Capacity of a single frame region
+    MemoryBufferType type;      // TYPE_CONSTANT_BUFFER or TYPE_UNORDERED_ACCESS_BUFFER
+};
+
+
+struct MemoryRingBufferAllocation
+{
+    void*         pData = nullptr;   // Persistently mapped write only memory
+    MemoryBuffer* pBuffer = nullptr;
+    uint64_t      offset = 0;        // Offset in pBuffer to bind the allocation with BindIndexedRange()
+    uint64_t      size = 0;
+
+    template <typename Type>
+    Type* GetData() const noexcept { return static_cast<Type*>(pData); }
+
+    void BindIndexed(uint32_t index) const noexcept { pBuffer->BindIndexedRange(index, offset, size); }
+
+    bool IsValid() const noexcept { return pData != nullptr; }
+};
+
+
+struct MemoryRingBufferStats
+{
+    uint64_t allocatedSize;         // Including alignment padding
+    uint32_t allocationsCount;
+    uint32_t failedAllocationsCount;
+    uint32_t fenceWaitsCount;       // Frames which had to wait for the GPU to release their region
+};
+
+
+// Persistently mapped memory buffer split into FRAMES_IN_FLIGHT_COUNT regions. Each frame allocates linearly from its own region,
+// so CPU writes never touch memory the GPU may still read. EndFrame() fences the region, BeginFrame() of the frame which reuses it waits on the fence.
+// Allocations are aligned to the buffer type offset alignment and can be bound with BindIndexedRange() without any map/unmap
+class MemoryRingBuffer
+{
+public:
+    static inline constexpr uint32_t FRAMES_IN_FLIGHT_COUNT = 3;
+
+public:
+    MemoryRingBuffer() = default;
+    ~MemoryRingBuffer() { Destroy(); }
+
+    MemoryRingBuffer(const MemoryRingBuffer& other) = delete;
+    MemoryRingBuffer& operator=(const MemoryRingBuffer& other) = delete;
+
+    bool Create(const MemoryRingBufferCreateInfo& createInfo) noexcept;
+    void Destroy() noexcept;
+
+    // Switches to the next frame region. Blocks while the GPU still reads it
+    void BeginFrame() noexcept;
+    // Must be called after the last command which reads allocations of the frame was issued
+    void EndFrame() noexcept;
+
+    // Returns invalid allocation if the frame region is exhausted
+    MemoryRingBufferAllocation Allocate(uint64_t size) noexcept;
+    MemoryRingBufferAllocation Allocate(const void* pData, uint64_t size) noexcept;
+
+    template <typename Type>
+    MemoryRingBufferAllocation Allocate() noexcept { return Allocate(sizeof(Type)); }
+
+    void SetDebugName(ds::StrID name) noexcept;
+    ds::StrID GetDebugName() const noexcept;
+
+    const MemoryRingBufferStats& GetStats() const noexcept { return m_stats; }
+
+    uint64_t GetFrameSize() const noexcept { return m_frameSize; }
+    uint64_t GetAlignment() const noexcept { return m_alignment; }
+
+    bool IsValid() const noexcept;
+
+private:
+    // GLsync handles, kept opaque so GL headers don't leak from here
+    std::array<void*, FRAMES_IN_FLIGHT_COUNT> m_frameFences = {};
+
+    MemoryRingBufferStats m_stats = {};
+
+    MemoryBuffer* m_pBuffer = nullptr;
+    uint8_t*      m_pMappedData = nullptr;
+
+    uint64_t m_frameSize = 0;
+    uint64_t m_alignment = 0;
+    uint64_t m_frameOffset = 0; // Allocation offset in the current frame region
+
+    uint32_t m_frameIdx = 0;
+};
@@ -0,0 +1,387 @@
+#include "pch.h"
+#include "tlsf_allocator.h"
+
+#include "utils/debug/assertion.h"
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+
+static uint32_t FindMSB(uint64_t value) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanReverse64(&idx, value);
+    return static_cast<uint32_t>(idx);
+#else
+    return 63u - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+
+static uint32_t FindLSB(uint64_t value) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanForward64(&idx, value);
+    return static_cast<uint32_t>(idx);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+
+static uint32_t GetFreeListIndex(uint32_t firstLevel, uint32_t secondLevel) noexcept
+{
+    return firstLevel * TLSFAllocator::SECOND_LEVEL_COUNT + secondLevel;
+}
+
+
+void TLSFAllocator::MapSizeToLists(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) noexcept
+{
+    if (size < SECOND_LEVEL_COUNT) {
+        firstLevel = 0;
+        secondLevel = static_cast<uint32_t>(size);
+        return;
+    }
+
+    const uint32_t msb = FindMSB(size);
+
+    firstLevel = msb - SECOND_LEVEL_BITS + 1;
+    secondLevel = static_cast<uint32_t>(size >> (msb - SECOND_LEVEL_BITS)) ^ SECOND_LEVEL_COUNT;
+}
+
+
+bool TLSFAllocator::Create(uint64_t size, uint32_t nodesCountHint) noexcept
+{
+    ENG_ASSERT(!IsValid(), "Attempt to create already valid TLSF allocator");
+    ENG_ASSERT(size > 0, "TLSF allocator size must be greater than 0");
+
+    m_nodes.reserve(nodesCountHint);
+    m_unusedNodeIndices.reserve(nodesCountHint);
+
+    m_size = size;
+
+    Reset();
+
+    return true;
+}
+
+
+void TLSFAllocator::Destroy() noexcept
+{
+    m_nodes.clear();
+    m_unusedNodeIndices.clear();
+
+    m_freeListHeads.fill(INVALID_NODE_IDX);
+    m_secondLevelMasks.fill(0);
+    m_firstLevelMask = 0;
+
+    m_size = 0;
+    m_usedSize = 0;
+    m_allocationsCount = 0;
+}
+
+
+TLSFAllocation TLSFAllocator::Allocate(uint64_t size) noexcept
+{
+    ENG_ASSERT(IsValid(), "TLSF allocator is invalid");
+    ENG_ASSERT(size > 0, "TLSF allocation size must be greater than 0");
+
+    const uint32_t nodeIdx = FindFreeNode(size);
+
+    if (nodeIdx == INVALID_NODE_IDX) {
+        return {};
+    }
+
+    RemoveFreeNode(nodeIdx);
+
+    // Tail of the region returns to the free lists
+    if (m_nodes[nodeIdx].size > size) {
+        const uint32_t tailIdx = AllocateNode();
+
+        Node& node = m_nodes[nodeIdx];
+        Node& tail = m_nodes[tailIdx];
+
+        tail.offset = node.offset + size;
+        tail.size = node.size - size;
+        tail.prevPhysIdx = nodeIdx;
+        tail.nextPhysIdx = node.nextPhysIdx;
+
+        if (node.nextPhysIdx != INVALID_NODE_IDX) {
+            m_nodes[node.nextPhysIdx].prevPhysIdx = tailIdx;
+        }
+
+        node.nextPhysIdx = tailIdx;
+        node.size = size;
+
+        InsertFreeNode(tailIdx);
+    }
+
+    Node& node = m_nodes[nodeIdx];
+    node.isFree = false;
+
+    m_usedSize += node.size;
+    ++m_allocationsCount;
+
+    TLSFAllocation allocation = {};
+    allocation.offset = node.offset;
+    allocation.nodeIdx = nodeIdx;
+
+    return allocation;
+}
+
+
+void TLSFAllocator::Deallocate(const TLSFAllocation& allocation) noexcept
+{
+    ENG_ASSERT(IsValid(), "TLSF allocator is invalid");
+
+    if (!allocation.IsValid()) {
+        return;
+    }
+
+    ENG_ASSERT(allocation.nodeIdx < m_nodes.size(), "Invalid TLSF allocation node index");
+
+    uint32_t nodeIdx = allocation.nodeIdx;
+
+    ENG_ASSERT(!m_nodes[nodeIdx].isFree && m_nodes[nodeIdx].offset == allocation.offset, "TLSF allocation is already released");
+
+    m_usedSize -= m_nodes[nodeIdx].size;
+    --m_allocationsCount;
+
+    m_nodes[nodeIdx].isFree = true;
+
+    const uint32_t prevPhysIdx = m_nodes[nodeIdx].prevPhysIdx;
+
+    if (prevPhysIdx != INVALID_NODE_IDX && m_nodes[prevPhysIdx].isFree) {
+        RemoveFreeNode(prevPhysIdx);
+
+        Node& prev = m_nodes[prevPhysIdx];
+        const Node& node = m_nodes[nodeIdx];
+
+        prev.size += node.size;
+        prev.nextPhysIdx = node.nextPhysIdx;
+
+        if (node.nextPhysIdx != INVALID_NODE_IDX) {
+            m_nodes[node.nextPhysIdx].prevPhysIdx = prevPhysIdx;
+        }
+
+        ReleaseNode(nodeIdx);
+        nodeIdx = prevPhysIdx;
+    }
+
+    const uint32_t nextPhysIdx = m_nodes[nodeIdx].nextPhysIdx;
+
+    if (nextPhysIdx != INVALID_NODE_IDX && m_nodes[nextPhysIdx].isFree) {
+        RemoveFreeNode(nextPhysIdx);
+
+        Node& node = m_nodes[nodeIdx];
+        const Node& next = m_nodes[nextPhysIdx];
+
+        node.size += next.size;
+        node.nextPhysIdx = next.nextPhysIdx;
+
+        if (next.nextPhysIdx != INVALID_NODE_IDX) {
+            m_nodes[next.nextPhysIdx].prevPhysIdx = nodeIdx;
+        }
+
+        ReleaseNode(nextPhysIdx);
+    }
+
+    InsertFreeNode(nodeIdx);
+}
+
+
+void TLSFAllocator::Reset() noexcept
+{
+    ENG_ASSERT(IsValid(), "TLSF allocator is invalid");
+
+    m_nodes.clear();
+    m_unusedNodeIndices.clear();
+
+    m_freeListHeads.fill(INVALID_NODE_IDX);
+    m_secondLevelMasks.fill(0);
+    m_firstLevelMask = 0;
+
+    m_usedSize = 0;
+    m_allocationsCount = 0;
+
+    const uint32_t nodeIdx = AllocateNode();
+
+    Node& node = m_nodes[nodeIdx];
+    node.offset = 0;
+    node.size = m_size;
+
+    InsertFreeNode(nodeIdx);
+}
+
+
+uint64_t TLSFAllocator::GetAllocationSize(const TLSFAllocation& allocation) const noexcept
+{
+    ENG_ASSERT(allocation.IsValid() && allocation.nodeIdx < m_nodes.size(), "Invalid TLSF allocation");
+    return m_nodes[allocation.nodeIdx].size;
+}
+
+
+TLSFAllocatorStats TLSFAllocator::GetStats() const noexcept
+{
+    TLSFAllocatorStats stats = {};
+    stats.totalSize = m_size;
+    stats.usedSize = m_usedSize;
+    stats.allocationsCount = m_allocationsCount;
+
+    for (uint32_t headIdx : m_freeListHeads) {
+        for (uint32_t nodeIdx = headIdx; nodeIdx != INVALID_NODE_IDX; nodeIdx = m_nodes[nodeIdx].nextFreeIdx) {
+            stats.largestFreeRegionSize = std::max(stats.largestFreeRegionSize, m_nodes[nodeIdx].size);
+            ++stats.freeRegionsCount;
+        }
+    }
+
+    return stats;
+}
+
+
+uint32_t TLSFAllocator::AllocateNode() noexcept
+{
+    uint32_t nodeIdx = INVALID_NODE_IDX;
+
+    if (!m_unusedNodeIndices.empty()) {
+        nodeIdx = m_unusedNodeIndices.back();
+        m_unusedNodeIndices.pop_back();
+    } else {
+        ENG_ASSERT(m_nodes.size() < INVALID_NODE_IDX, "TLSF allocator nodes overflow");
+
+        nodeIdx = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+
+    Node& node = m_nodes[nodeIdx];
+    node.offset = 0;
+    node.size = 0;
+    node.prevPhysIdx = INVALID_NODE_IDX;
+    node.nextPhysIdx = INVALID_NODE_IDX;
+    node.prevFreeIdx = INVALID_NODE_IDX;
+    node.nextFreeIdx = INVALID_NODE_IDX;
+    node.isFree = true;
+
+    return nodeIdx;
+}
+
+
+void TLSFAllocator::ReleaseNode(uint32_t nodeIdx) noexcept
+{
+    m_nodes[nodeIdx].isFree = false;
+    m_nodes[nodeIdx].size = 0;
+
+    m_unusedNodeIndices.emplace_back(nodeIdx);
+}
+
+
+void TLSFAllocator::InsertFreeNode(uint32_t nodeIdx) noexcept
+{
+    Node& node = m_nodes[nodeIdx];
+    node.isFree = true;
+
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    MapSizeToLists(node.size, firstLevel, secondLevel);
+
+    uint32_t& headIdx = m_freeListHeads[GetFreeListIndex(firstLevel, secondLevel)];
+
+    node.prevFreeIdx = INVALID_NODE_IDX;
+    node.nextFreeIdx = headIdx;
+
+    if (headIdx != INVALID_NODE_IDX) {
+        m_nodes[headIdx].prevFreeIdx = nodeIdx;
+    }
+
+    headIdx = nodeIdx;
+
+    m_secondLevelMasks[firstLevel] |= static_cast<uint8_t>(1u << secondLevel);
+    m_firstLevelMask |= 1ull << firstLevel;
+}
+
+
+void TLSFAllocator::RemoveFreeNode(uint32_t nodeIdx) noexcept
+{
+    Node& node = m_nodes[nodeIdx];
+
+    if (node.prevFreeIdx != INVALID_NODE_IDX) {
+        m_nodes[node.prevFreeIdx].nextFreeIdx = node.nextFreeIdx;
+    }
+
+    if (node.nextFreeIdx != INVALID_NODE_IDX) {
+        m_nodes[node.nextFreeIdx].prevFreeIdx = node.prevFreeIdx;
+    }
+
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    MapSizeToLists(node.size, firstLevel, secondLevel);
+
+    uint32_t& headIdx = m_freeListHeads[GetFreeListIndex(firstLevel, secondLevel)];
+
+    if (headIdx == nodeIdx) {
+        headIdx = node.nextFreeIdx;
+
+        if (headIdx == INVALID_NODE_IDX) {
+            m_secondLevelMasks[firstLevel] &= static_cast<uint8_t>(~(1u << secondLevel));
+
+            if (m_secondLevelMasks[firstLevel] == 0) {
+                m_firstLevelMask &= ~(1ull << firstLevel);
+            }
+        }
+    }
+
+    node.prevFreeIdx = INVALID_NODE_IDX;
+    node.nextFreeIdx = INVALID_NODE_IDX;
+    node.isFree = false;
+}
+
+
+uint32_t TLSFAllocator::FindFreeNode(uint64_t size) const noexcept
+{
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+
+    // Round the size up to the next list boundary, so any region of the found list fits without walking the list
+    if (size >= SECOND_LEVEL_COUNT) {
+        const uint64_t roundUp = (1ull << (FindMSB(size) - SECOND_LEVEL_BITS)) - 1ull;
+
+        if (size <= UINT64_MAX - roundUp) {
+            MapSizeToLists(size + roundUp, firstLevel, secondLevel);
+        } else {
+            firstLevel = FIRST_LEVEL_COUNT;
+        }
+    } else {
+        MapSizeToLists(size, firstLevel, secondLevel);
+    }
+
+    if (firstLevel < FIRST_LEVEL_COUNT) {
+        uint32_t secondLevelMask = m_secondLevelMasks[firstLevel] & (~0u << secondLevel);
+
+        if (secondLevelMask == 0) {
+            const uint64_t firstLevelMask = firstLevel + 1 < FIRST_LEVEL_COUNT ? m_firstLevelMask & (~0ull << (firstLevel + 1)) : 0;
+
+            if (firstLevelMask != 0) {
+                firstLevel = FindLSB(firstLevelMask);
+                secondLevelMask = m_secondLevelMasks[firstLevel];
+            }
+        }
+
+        if (secondLevelMask != 0) {
+            return m_freeListHeads[GetFreeListIndex(firstLevel, FindLSB(secondLevelMask))];
+        }
+    }
+
+    // Rounding skips regions of the size own list which are large enough, e.g. the whole allocator range. Walk that list as a last resort
+    MapSizeToLists(size, firstLevel, secondLevel);
+
+    for (uint32_t nodeIdx = m_freeListHeads[GetFreeListIndex(firstLevel, secondLevel)]; nodeIdx != INVALID_NODE_IDX; nodeIdx = m_nodes[nodeIdx].nextFreeIdx) {
+        if (m_nodes[nodeIdx].size >= size) {
+            return nodeIdx;
+        }
+    }
+
+    return INVALID_NODE_IDX;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "core.h"
+
+#include <vector>
+#include <array>
+
+#include <cstdint>
+
+
+struct TLSFAllocation
+{
+    static inline constexpr uint32_t INVALID_NODE_IDX = UINT32_MAX;
+
+    uint64_t offset = 0;
+    uint32_t nodeIdx = INVALID_NODE_IDX; // Internal allocator node, needed to release the allocation
+
+    bool IsValid() const noexcept { return nodeIdx != INVALID_NODE_IDX; }
+};
+
+
+struct TLSFAllocatorStats
+{
+    uint64_t totalSize;
+    uint64_t usedSize;
+    uint64_t largestFreeRegionSize;
+    uint32_t allocationsCount;
+    uint32_t freeRegionsCount;
+};
+
+
+// Two-level segregated fit allocator of offsets in [0, size) range. It never touches the memory it manages,
+// so the same logic sub-allocates GPU buffers and can be exercised on CPU alone.
+// First level splits sizes by powers of two, second level splits every power of two range linearly into SECOND_LEVEL_COUNT lists.
+// Allocation and deallocation are O(1): free lists are found with bit scans over the level masks, neighbour free regions are merged on release.
+// Sizes and offsets are in abstract units, the owner decides what a unit is (bytes, aligned chunks, vertices)
+class TLSFAllocator
+{
+public:
+    static inline constexpr uint32_t SECOND_LEVEL_BITS = 3;
+    static inline constexpr uint32_t SECOND_LEVEL_COUNT = 1u << SECOND_LEVEL_BITS;
+    static inline constexpr uint32_t FIRST_LEVEL_COUNT = 64 - SECOND_LEVEL_BITS + 1;
+
+public:
+    // Returns indices of the free list which a free region of the size belongs to
+    static void MapSizeToLists(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) noexcept;
+
+public:
+    TLSFAllocator() = default;
+
+    TLSFAllocator(const TLSFAllocator& other) = delete;
+    TLSFAllocator& operator=(const TLSFAllocator& other) = delete;
+
+    TLSFAllocator(TLSFAllocator&& other) noexcept = default;
+    TLSFAllocator& operator=(TLSFAllocator&& other) noexcept = default;
+
+    // nodesCountHint reserves bookkeeping for that many allocations and free regions up front
+    bool Create(uint64_t size, uint32_t nodesCountHint = 0) noexcept;
+    void Destroy() noexcept;
+
+    // Returns invalid allocation if there is no free region large enough
+    TLSFAllocation Allocate(uint64_t size) noexcept;
+    void Deallocate(const TLSFAllocation& allocation) noexcept;
+
+    // Releases all allocations at once
+    void Reset() noexcept;
+
+    uint64_t GetAllocationSize(const TLSFAllocation& allocation) const noexcept;
+
+    // Walks all free regions, intended for debug output and profiling
+    TLSFAllocatorStats GetStats() const noexcept;
+
+    uint64_t GetSize() const noexcept { return m_size; }
+    uint64_t GetUsedSize() const noexcept { return m_usedSize; }
+    uint32_t GetAllocationsCount() const noexcept { return m_allocationsCount; }
+
+    bool IsEmpty() const noexcept { return m_allocationsCount == 0; }
+    bool IsValid() const noexcept { return m_size > 0; }
+
+private:
+    static inline constexpr uint32_t INVALID_NODE_IDX = TLSFAllocation::INVALID_NODE_IDX;
+
+    // Node describes a free region or an allocation. Physical links connect neighbour regions in address order,
+    // free links connect regions of the same free list
+    struct Node
+    {
+        uint64_t offset;
+        uint64_t size;
+
+        uint32_t prevPhysIdx;
+        uint32_t nextPhysIdx;
+        uint32_t prevFreeIdx;
+        uint32_t nextFreeIdx;
+
+        bool isFree;
+    };
+
+    uint32_t AllocateNode() noexcept;
+    void ReleaseNode(uint32_t nodeIdx) noexcept;
+
+    void InsertFreeNode(uint32_t nodeIdx) noexcept;
+    void RemoveFreeNode(uint32_t nodeIdx) noexcept;
+
+    uint32_t FindFreeNode(uint64_t size) const noexcept;
+
+private:
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_unusedNodeIndices;
+
+    std::array<uint32_t, FIRST_LEVEL_COUNT * SECOND_LEVEL_COUNT> m_freeListHeads = {};
+    std::array<uint8_t, FIRST_LEVEL_COUNT> m_secondLevelMasks = {};
+    uint64_t m_firstLevelMask = 0;
+
+    static_assert(SECOND_LEVEL_COUNT <= 8, "Second level mask doesn't fit into uint8_t");
+
+    uint64_t m_size = 0;
+    uint64_t m_usedSize = 0;
+    uint32_t m_allocationsCount = 0;
+};
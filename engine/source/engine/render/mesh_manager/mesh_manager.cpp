@@ -3,6 +3,8 @@
 
 #include "render/platform/OpenGL/opengl_driver.h"
 
+#include <numeric>
+
 static std::unique_ptr<MeshManager> pMeshMngInst = nullptr;
 static std::unique_ptr<MeshDataManager> pMeshDataMngInst = nullptr;
 
@@ -13,6 +15,7 @@ static constexpr uint64_t MAX_GPU_BUFF_DATA_COUNT = 8192;
 static constexpr uint64_t MAX_VERT_BUFF_LAYOUT_COUNT = 8192;
 
 
+
 static uint64_t amHash(const MeshVertexLayoutCreateInfo& layoutCreateInfo) noexcept
 {
     ds::HashBuilder builder;
@@ -67,6 +70,33 @@ static GLenum GetAttribDataGLType(MeshVertexAttribDataType type) noexcept
 }
 
 
+static uint32_t CreateVertexArray(const MeshVertexLayout& layout, const MemoryBuffer& vertexBuffer, uint64_t vertexSize, const MemoryBuffer& indexBuffer) noexcept
+{
+    uint32_t vaoRenderID = 0;
+    glCreateVertexArrays(1, &vaoRenderID);
+
+    for (uint32_t i = 0; i < layout.GetActiveAttribsCount(); ++i) {
+        const uint32_t index                    = layout.GetAttribIndex(i);
+        const MeshVertexAttribDataType dataType = layout.GetAttribDataType(i);
+        const uint32_t elementsCount            = layout.GetAttribElementCount(i);
+        const uint32_t offset                   = layout.GetAttribOffset(i);
+        const bool isNormalized                 = layout.IsAttribNormalized(i);
+
+        glVertexArrayAttribBinding(vaoRenderID, index, 0);
+
+        const GLenum type = GetAttribDataGLType(dataType);
+        glVertexArrayAttribFormat(vaoRenderID, index, elementsCount, type, isNormalized, offset);
+        
+        glEnableVertexArrayAttrib(vaoRenderID, index);
+    }
+
+    glVertexArrayVertexBuffer(vaoRenderID, 0, vertexBuffer.GetRenderID(), 0, vertexSize);
+    glVertexArrayElementBuffer(vaoRenderID, indexBuffer.GetRenderID());
+
+    return vaoRenderID;
+}
+
+
 
 bool MeshVertexLayout::IsValid() const noexcept
 {
@@ -161,6 +191,90 @@ void MeshVertexLayout::Destroy() noexcept
 }
 
 
+MeshVertexArena::~MeshVertexArena()
+{
+    Destroy();
+}
+
+
+bool MeshVertexArena::IsValid() const noexcept
+{
+    return m_pLayout && m_pLayout->IsValid() && m_vertexSize > 0;
+}
+
+
+bool MeshVertexArena::Create(const MeshVertexLayout* pLayout, uint64_t vertexSize) noexcept
+{
+    ENG_ASSERT(!IsValid(), "Attempt to create already valid mesh vertex arena");
+    ENG_ASSERT(pLayout && pLayout->IsValid(), "Mesh vertex arena layout is invalid");
+    ENG_ASSERT(vertexSize > 0 && vertexSize <= UINT16_MAX, "Invalid mesh vertex arena vertex size: {}", vertexSize);
+
+    m_pLayout = pLayout;
+    m_vertexSize = vertexSize;
+
+    return true;
+}
+
+
+void MeshVertexArena::Destroy() noexcept
+{
+    for (const VertexArray& vertexArray : m_vertexArrays) {
+        ENG_LOG_WARN("Destruction of mesh vertex arena while VAO {} still has {} meshes", vertexArray.vaoRenderID, vertexArray.meshesCount);
+        glDeleteVertexArrays(1, &vertexArray.vaoRenderID);
+    }
+
+    m_vertexArrays.clear();
+
+    m_pLayout = nullptr;
+    m_vertexSize = 0;
+}
+
+
+uint32_t MeshVertexArena::AcquireVertexArray(const MemoryBuffer& vertexBuffer, const MemoryBuffer& indexBuffer) noexcept
+{
+    ENG_ASSERT(IsValid(), "Mesh vertex arena is invalid");
+
+    for (VertexArray& vertexArray : m_vertexArrays) {
+        if (vertexArray.vertexBufferRenderID == vertexBuffer.GetRenderID() && vertexArray.indexBufferRenderID == indexBuffer.GetRenderID()) {
+            ++vertexArray.meshesCount;
+            return vertexArray.vaoRenderID;
+        }
+    }
+
+    VertexArray vertexArray = {};
+    vertexArray.vertexBufferRenderID = vertexBuffer.GetRenderID();
+    vertexArray.indexBufferRenderID = indexBuffer.GetRenderID();
+    vertexArray.vaoRenderID = CreateVertexArray(*m_pLayout, vertexBuffer, m_vertexSize, indexBuffer);
+    vertexArray.meshesCount = 1;
+
+    m_vertexArrays.emplace_back(vertexArray);
+
+    return vertexArray.vaoRenderID;
+}
+
+
+void MeshVertexArena::ReleaseVertexArray(uint32_t vaoRenderID) noexcept
+{
+    auto vertexArrayIt = std::find_if(m_vertexArrays.begin(), m_vertexArrays.end(), [vaoRenderID](const VertexArray& vertexArray) {
+        return vertexArray.vaoRenderID == vaoRenderID;
+    });
+
+    if (vertexArrayIt == m_vertexArrays.end()) {
+        ENG_ASSERT_FAIL("VAO {} doesn't belong to mesh vertex arena", vaoRenderID);
+        return;
+    }
+
+    if (--vertexArrayIt->meshesCount > 0) {
+        return;
+    }
+
+    glDeleteVertexArrays(1, &vertexArrayIt->vaoRenderID);
+
+    *vertexArrayIt = m_vertexArrays.back();
+    m_vertexArrays.pop_back();
+}
+
+
 MeshGPUBufferData::~MeshGPUBufferData()
 {
     Destroy();
@@ -170,26 +284,26 @@ MeshGPUBufferData::~MeshGPUBufferData()
 const MemoryBuffer& MeshGPUBufferData::GetVertexBuffer() const noexcept
 {
     ENG_ASSERT(IsVertexBufferValid(), "Mesh GPU vertex buffer is invalid");
-    return *m_pVertexGPUBuffer;
+    return *m_vertexView.pBuffer;
 }
 
 
 const MemoryBuffer& MeshGPUBufferData::GetIndexBuffer() const noexcept
 {
     ENG_ASSERT(IsIndexBufferValid(), "Mesh GPU index buffer is invalid");
-    return *m_pIndexGPUBuffer;
+    return *m_indexView.pBuffer;
 }
 
 
 bool MeshGPUBufferData::IsVertexBufferValid() const noexcept
 {
-    return m_pVertexGPUBuffer && m_pVertexGPUBuffer->IsValid();
+    return m_vertexView.IsValid() && m_vertexView.pBuffer->IsValid();
 }
 
 
 bool MeshGPUBufferData::IsIndexBufferValid() const noexcept
 {
-    return m_pIndexGPUBuffer && m_pIndexGPUBuffer->IsValid();
+    return m_indexView.IsValid() && m_indexView.pBuffer->IsValid();
 }
 
 
@@ -218,57 +332,114 @@ bool MeshGPUBufferData::Create(const MeshGPUBufferDataCreateInfo& createInfo) no
 
     ENG_ASSERT(!IsValid(), "Trying to recreate already valid mesh GPU buffer data \'{}\'", m_name.CStr());
 
-    char vertBufName[512] = { 0 };
-    sprintf_s(vertBufName, "%s_VERT_BUF", m_name.CStr());
+    if (createInfo.keepOccluderCopy) {
+        StoreOccluderCopy(createInfo);
+    }
 
-    m_pVertexGPUBuffer = pMemBuffMngInst->RegisterBuffer();
-    ENG_ASSERT(m_pVertexGPUBuffer, "Failed to register \'{}\' buffer", vertBufName);
-    
-    MemoryBufferCreateInfo vertBuffCreateInfo = {};
-    vertBuffCreateInfo.type          = MemoryBufferType::TYPE_VERTEX_BUFFER;
-    vertBuffCreateInfo.creationFlags = BUFFER_CREATION_FLAG_ZERO;
-    vertBuffCreateInfo.pData         = createInfo.pVertexData;
-    vertBuffCreateInfo.dataSize      = createInfo.vertexDataSize;
-    vertBuffCreateInfo.elementSize   = createInfo.vertexSize;
-    
-    m_pVertexGPUBuffer->Create(vertBuffCreateInfo);
-    ENG_ASSERT(m_pVertexGPUBuffer->IsValid(), "Failed to create \'{}\' buffer", vertBufName);
+    MeshVertexArena* pArena = MeshDataManager::GetInstance().GetVertexArena(createInfo.pVertexLayout, createInfo.vertexSize);
 
-    m_pVertexGPUBuffer->SetDebugName(vertBufName);
-    
-    char indexBufName[512] = { 0 };
-    sprintf_s(indexBufName, "%s_IDX_BUF", m_name.CStr());
+    if (!pArena) {
+        ENG_ASSERT_FAIL("Failed to get vertex arena of mesh GPU buffer data \'{}\'", m_name.CStr());
+        return false;
+    }
 
-    m_pIndexGPUBuffer = pMemBuffMngInst->RegisterBuffer();
-    ENG_ASSERT(m_pIndexGPUBuffer, "Failed to register \'{}\' buffer", indexBufName);
-        
-    MemoryBufferCreateInfo indexBuffCreateInfo = {};
-    indexBuffCreateInfo.type          = MemoryBufferType::TYPE_INDEX_BUFFER;
-    indexBuffCreateInfo.creationFlags = BUFFER_CREATION_FLAG_ZERO;
-    indexBuffCreateInfo.pData         = createInfo.pIndexData;
-    indexBuffCreateInfo.dataSize      = createInfo.indexDataSize;
-    indexBuffCreateInfo.elementSize   = createInfo.indexSize;
-        
-    m_pIndexGPUBuffer->Create(indexBuffCreateInfo);
-    ENG_ASSERT(m_pIndexGPUBuffer->IsValid(), "Failed to create \'{}\' buffer", indexBufName);
-    
-    m_pIndexGPUBuffer->SetDebugName(indexBufName);
+    const uint64_t vertexAlignment = pMemBuffMngInst->GetHeap(MemoryBufferType::TYPE_VERTEX_BUFFER).GetAlignment();
+    const uint64_t indexAlignment = pMemBuffMngInst->GetHeap(MemoryBufferType::TYPE_INDEX_BUFFER).GetAlignment();
+
+    ENG_ASSERT(indexAlignment % createInfo.indexSize == 0, "Mesh GPU buffer data \'{}\' index size {} is not supported by index heap", m_name.CStr(), createInfo.indexSize);
+
+    // Heap offsets are multiples of the heap alignment, the padding lets the data start at a whole vertex for any vertex size
+    const uint64_t vertexPadding = createInfo.vertexSize - std::gcd(createInfo.vertexSize, vertexAlignment);
+
+    m_vertexView = pMemBuffMngInst->AllocateView(MemoryBufferType::TYPE_VERTEX_BUFFER, createInfo.vertexDataSize + vertexPadding);
+
+    if (!m_vertexView.IsValid()) {
+        ENG_ASSERT_FAIL("Failed to allocate mesh GPU buffer data \'{}\' vertex view", m_name.CStr());
+        Destroy();
+        return false;
+    }
+
+    m_indexView = pMemBuffMngInst->AllocateView(MemoryBufferType::TYPE_INDEX_BUFFER, createInfo.indexDataSize);
+
+    if (!m_indexView.IsValid()) {
+        ENG_ASSERT_FAIL("Failed to allocate mesh GPU buffer data \'{}\' index view", m_name.CStr());
+        Destroy();
+        return false;
+    }
+
+    const uint64_t baseVertex = (m_vertexView.offset + createInfo.vertexSize - 1) / createInfo.vertexSize;
+
+    m_vertexView.FillSubdata(baseVertex * createInfo.vertexSize - m_vertexView.offset, createInfo.vertexDataSize, createInfo.pVertexData);
+    m_indexView.FillSubdata(0, createInfo.indexDataSize, createInfo.pIndexData);
+
+    m_pArena = pArena;
+    m_vaoRenderID = pArena->AcquireVertexArray(*m_vertexView.pBuffer, *m_indexView.pBuffer);
+
+    m_baseVertex = static_cast<uint32_t>(baseVertex);
+    m_firstIndex = static_cast<uint32_t>(m_indexView.offset / createInfo.indexSize);
 
     return true;
 }
 
 
+void MeshGPUBufferData::StoreOccluderCopy(const MeshGPUBufferDataCreateInfo& createInfo) noexcept
+{
+    ENG_ASSERT(createInfo.occluderPositionOffset + 3 * sizeof(float) <= createInfo.vertexSize, 
+        "Mesh GPU buffer data \'{}\' occluder position is out of vertex", m_name.CStr());
+    ENG_ASSERT(createInfo.indexSize == sizeof(uint8_t) || createInfo.indexSize == sizeof(uint16_t) || createInfo.indexSize == sizeof(uint32_t), 
+        "Mesh GPU buffer data \'{}\' has unsupported index size {}", m_name.CStr(), createInfo.indexSize);
+
+    const uint64_t verticesCount = createInfo.vertexDataSize / createInfo.vertexSize;
+    const uint64_t indicesCount = createInfo.indexDataSize / createInfo.indexSize;
+
+    const uint8_t* pVertexData = static_cast<const uint8_t*>(createInfo.pVertexData) + createInfo.occluderPositionOffset;
+
+    m_occluderPositions.resize(verticesCount);
+
+    for (uint64_t i = 0; i < verticesCount; ++i) {
+        memcpy(&m_occluderPositions[i], pVertexData + i * createInfo.vertexSize, sizeof(glm::vec3));
+    }
+
+    m_occluderIndices.resize(indicesCount);
+
+    for (uint64_t i = 0; i < indicesCount; ++i) {
+        switch (createInfo.indexSize) {
+            case sizeof(uint8_t):
+                m_occluderIndices[i] = static_cast<const uint8_t*>(createInfo.pIndexData)[i];
+                break;
+            case sizeof(uint16_t):
+                m_occluderIndices[i] = static_cast<const uint16_t*>(createInfo.pIndexData)[i];
+                break;
+            default:
+                m_occluderIndices[i] = static_cast<const uint32_t*>(createInfo.pIndexData)[i];
+                break;
+        }
+    }
+}
+
+
 void MeshGPUBufferData::Destroy() noexcept
 {
-    if (!IsValid()) {
+    m_occluderPositions.clear();
+    m_occluderIndices.clear();
+
+    if (!m_vertexView.IsValid() && !m_indexView.IsValid()) {
         return;
     }
 
-    m_pVertexGPUBuffer->Destroy();
-    m_pIndexGPUBuffer->Destroy();
-    
-    pMemBuffMngInst->UnregisterBuffer(m_pVertexGPUBuffer);
-    pMemBuffMngInst->UnregisterBuffer(m_pIndexGPUBuffer);
+    // The VAO goes first, heap blocks it references are released once their last view is
+    if (m_pArena && m_vaoRenderID != 0) {
+        m_pArena->ReleaseVertexArray(m_vaoRenderID);
+    }
+
+    m_pArena = nullptr;
+    m_vaoRenderID = 0;
+
+    pMemBuffMngInst->DeallocateView(m_vertexView);
+    pMemBuffMngInst->DeallocateView(m_indexView);
+
+    m_baseVertex = 0;
+    m_firstIndex = 0;
 }
 
 
@@ -395,8 +566,10 @@ bool MeshDataManager::Init() noexcept
 
 void MeshDataManager::Terminate() noexcept
 {
-    m_vertexLayoutStorage.clear();
+    // Meshes release their VAOs before arenas are gone
     m_GPUBufferDataStorage.clear();
+    m_vertexArenas.clear();
+    m_vertexLayoutStorage.clear();
 
     m_vertexLayoutHashToStorageIndexMap.clear();
     m_GPUBufferDataNameToStorageIndexMap.clear();
@@ -422,6 +595,24 @@ MeshGPUBufferData* MeshDataManager::GetGPUBufferDataByName(ds::StrID name) noexc
 }
 
 
+MeshVertexArena* MeshDataManager::GetVertexArena(const MeshVertexLayout* pLayout, uint64_t vertexSize) noexcept
+{
+    ENG_ASSERT(pLayout && pLayout->IsValid(), "Invalid mesh vertex arena layout");
+
+    const uint64_t arenaKey = (static_cast<uint64_t>(pLayout->GetID().Value()) << 32) | vertexSize;
+
+    auto [arenaIt, isInserted] = m_vertexArenas.try_emplace(arenaKey);
+    MeshVertexArena& arena = arenaIt->second;
+
+    if (isInserted && !arena.Create(pLayout, vertexSize)) {
+        m_vertexArenas.erase(arenaIt);
+        return nullptr;
+    }
+
+    return &arena;
+}
+
+
 bool engInitMeshDataManager() noexcept
 {
     if (engIsMeshDataManagerInitialized()) {
@@ -498,28 +689,10 @@ bool MeshObj::Create(MeshVertexLayout* pLayoutDesc, MeshGPUBufferData* pMeshData
     m_pVertexLayout = pLayoutDesc;
     m_pBufferData = pMeshData;
 
-    glCreateVertexArrays(1, &m_vaoRenderID);
+    ENG_ASSERT(m_pBufferData->GetArena()->GetLayout() == m_pVertexLayout, "Mesh object \'{}\' layout differs from its vertex arena layout", m_name.CStr());
 
-    for (uint32_t i = 0; i < m_pVertexLayout->GetActiveAttribsCount(); ++i) {
-        const uint32_t index                    = m_pVertexLayout->GetAttribIndex(i);
-        const MeshVertexAttribDataType dataType = m_pVertexLayout->GetAttribDataType(i);
-        const uint32_t elementsCount            = m_pVertexLayout->GetAttribElementCount(i);
-        const uint32_t offset                   = m_pVertexLayout->GetAttribOffset(i);
-        const bool isNormalized                 = m_pVertexLayout->IsAttribNormalized(i);
-
-        glVertexArrayAttribBinding(m_vaoRenderID, index, 0);
-
-        const GLenum type = GetAttribDataGLType(dataType);
-        glVertexArrayAttribFormat(m_vaoRenderID, index, elementsCount, type, isNormalized, offset);
-        
-        glEnableVertexArrayAttrib(m_vaoRenderID, index);
-    }
-
-    const MemoryBuffer& vertBuf = m_pBufferData->GetVertexBuffer();
-    glVertexArrayVertexBuffer(m_vaoRenderID, 0, vertBuf.GetRenderID(), 0, vertBuf.GetElementSize());
-
-    const MemoryBuffer& indexBuf = m_pBufferData->GetIndexBuffer();
-    glVertexArrayElementBuffer(m_vaoRenderID, indexBuf.GetRenderID());
+    // VAO is owned by the vertex arena
+    m_vaoRenderID = m_pBufferData->GetVAORenderID();
 
     return true;
 }
@@ -531,7 +704,6 @@ void MeshObj::Destroy() noexcept
         return; 
     }
 
-    glDeleteVertexArrays(1, &m_vaoRenderID);
     m_vaoRenderID = 0;
     
     m_name = "_INVALID_";
@@ -547,6 +719,20 @@ void MeshObj::Bind() const noexcept
 }
 
 
+uint32_t MeshObj::GetBaseVertex() const noexcept
+{
+    ENG_ASSERT(IsGPUBufferDataValid(), "Mesh object \'{}\' GPU buffer data is invalid", m_name.CStr());
+    return m_pBufferData->GetBaseVertex();
+}
+
+
+uint32_t MeshObj::GetFirstIndex() const noexcept
+{
+    ENG_ASSERT(IsGPUBufferDataValid(), "Mesh object \'{}\' GPU buffer data is invalid", m_name.CStr());
+    return m_pBufferData->GetFirstIndex();
+}
+
+
 bool MeshObj::IsVertexLayoutValid() const noexcept
 {
     return m_pVertexLayout && m_pVertexLayout->IsValid();
@@ -583,9 +769,9 @@ MeshObj* MeshManager::RegisterMeshObj(ds::StrID name) noexcept
     ENG_ASSERT(GetMeshObjByName(name) == nullptr, "Attempt to create already valid mesh object: {}", name.CStr());
 
     const MeshID meshID = m_IDPool.Allocate();
-    ENG_ASSERT(meshID.Value() < m_meshObjStorage.size(), "Mesh objects storage overflow");
+    ENG_ASSERT(meshID.Index() < m_meshObjStorage.size(), "Mesh objects storage overflow");
     
-    const uint64_t index = meshID.Value();
+    const uint64_t index = meshID.Index();
 
     MeshObj* pMeshObj = &m_meshObjStorage[index];
 
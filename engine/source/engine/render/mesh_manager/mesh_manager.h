@@ -3,6 +3,12 @@
 #include "render/mem_manager/buffer_manager.h"
 
 #include "utils/data_structures/strid.h"
+#include "utils/data_structures/base_id.h"
+#include "utils/data_structures/generational_id.h"
+
+#include "utils/math/common_math.h"
+
+#include <vector>
 
 
 enum class MeshVertexAttribDataType : uint8_t
@@ -113,6 +119,60 @@ struct MeshGPUBufferDataCreateInfo
     const void*                 pIndexData;
     uint64_t                    indexDataSize;
     uint64_t                    indexSize;
+
+    // Selects the vertex arena the data is placed into, must be the layout of mesh objects created from the data
+    const MeshVertexLayout*     pVertexLayout;
+
+    // If set, positions and indices are also kept on CPU to rasterize the mesh as a software occluder.
+    // Positions must be three floats at occluderPositionOffset of every vertex
+    bool                        keepOccluderCopy;
+    uint64_t                    occluderPositionOffset;
+};
+
+
+// Meshes of a vertex layout and vertex size. Mesh vertices and indices are views of the memory buffer manager vertex and index heaps.
+// Arena meshes whose views live in the same pair of heap blocks share a VAO, so their draws don't rebind it.
+// Vertex views start at whole vertices and are addressed with base vertex, index view offsets are aligned for any index type
+class MeshVertexArena
+{
+    friend class MeshDataManager;
+    friend class MeshGPUBufferData;
+
+public:
+    MeshVertexArena() = default;
+    ~MeshVertexArena();
+
+    MeshVertexArena(const MeshVertexArena& other) = delete;
+    MeshVertexArena& operator=(const MeshVertexArena& other) = delete;
+
+    const MeshVertexLayout* GetLayout() const noexcept { return m_pLayout; }
+    uint64_t GetVertexSize() const noexcept { return m_vertexSize; }
+    uint32_t GetVertexArraysCount() const noexcept { return static_cast<uint32_t>(m_vertexArrays.size()); }
+
+    bool IsValid() const noexcept;
+
+private:
+    bool Create(const MeshVertexLayout* pLayout, uint64_t vertexSize) noexcept;
+    void Destroy() noexcept;
+
+    // VAOs are reference counted by meshes, so a VAO is deleted before the heap block buffers it references can be released
+    uint32_t AcquireVertexArray(const MemoryBuffer& vertexBuffer, const MemoryBuffer& indexBuffer) noexcept;
+    void ReleaseVertexArray(uint32_t vaoRenderID) noexcept;
+
+private:
+    struct VertexArray
+    {
+        uint32_t vertexBufferRenderID;
+        uint32_t indexBufferRenderID;
+        uint32_t vaoRenderID;
+        uint32_t meshesCount;
+    };
+
+private:
+    std::vector<VertexArray> m_vertexArrays;
+
+    const MeshVertexLayout* m_pLayout = nullptr;
+    uint64_t m_vertexSize = 0;
 };
 
 
@@ -136,17 +196,40 @@ public:
     const MemoryBuffer& GetVertexBuffer() const noexcept;
     const MemoryBuffer& GetIndexBuffer() const noexcept;
 
+    uint32_t GetBaseVertex() const noexcept { return m_baseVertex; }
+    uint32_t GetFirstIndex() const noexcept { return m_firstIndex; }
+
+    const MeshVertexArena* GetArena() const noexcept { return m_pArena; }
+    uint32_t GetVAORenderID() const noexcept { return m_vaoRenderID; }
+
+    // Empty unless the data was created with keepOccluderCopy
+    const std::vector<glm::vec3>& GetOccluderPositions() const noexcept { return m_occluderPositions; }
+    const std::vector<uint32_t>& GetOccluderIndices() const noexcept { return m_occluderIndices; }
+    bool HasOccluderCopy() const noexcept { return !m_occluderIndices.empty(); }
+
     bool IsVertexBufferValid() const noexcept;
     bool IsIndexBufferValid() const noexcept;
 
     bool IsValid() const noexcept;
 
+private:
+    void StoreOccluderCopy(const MeshGPUBufferDataCreateInfo& createInfo) noexcept;
+
 private:
     ds::StrID           m_name = "_INVALID_";
     MeshGPUBufferDataID m_ID;
 
-    MemoryBuffer*       m_pVertexGPUBuffer = nullptr;
-    MemoryBuffer*       m_pIndexGPUBuffer = nullptr;
+    MemoryBufferView    m_vertexView;
+    MemoryBufferView    m_indexView;
+
+    MeshVertexArena*    m_pArena = nullptr;
+    uint32_t            m_vaoRenderID = 0;
+
+    std::vector<glm::vec3> m_occluderPositions;
+    std::vector<uint32_t>  m_occluderIndices;
+
+    uint32_t            m_baseVertex = 0;
+    uint32_t            m_firstIndex = 0;
 };
 
 
@@ -176,6 +259,9 @@ public:
 
     MeshGPUBufferData* GetGPUBufferDataByName(ds::StrID name) noexcept;
 
+    // Creates the arena of the layout and vertex size pair on first request
+    MeshVertexArena* GetVertexArena(const MeshVertexLayout* pLayout, uint64_t vertexSize) noexcept;
+
     bool IsInitialized() const noexcept { return m_isInitialized; }
 
 private:
@@ -193,6 +279,9 @@ private:
     std::unordered_map<uint64_t, uint64_t> m_vertexLayoutHashToStorageIndexMap;
     std::unordered_map<ds::StrID, uint64_t> m_GPUBufferDataNameToStorageIndexMap;
 
+    // Keyed by layout ID and vertex size. Map nodes are stable, so mesh data keeps plain pointers to arenas
+    std::unordered_map<uint64_t, MeshVertexArena> m_vertexArenas;
+
     using MeshVertexLayoutIDPool = ds::BaseIDPool<MeshVertexLayoutID>;
     using MeshGPUBufferDataIDPool = ds::BaseIDPool<MeshGPUBufferDataID>;
     
@@ -203,7 +292,7 @@ private:
 };
 
 
-using MeshID = ds::BaseID<uint32_t>;
+using MeshID = ds::GenerationalID<uint32_t>;
 
 
 class MeshObj
@@ -233,6 +322,12 @@ public:
     ds::StrID GetName() const noexcept { return m_name; }
     MeshID GetID() const noexcept { return m_ID; }
 
+    // Meshes of the same arena and heap blocks share VAO
+    uint32_t GetVAORenderID() const noexcept { return m_vaoRenderID; }
+
+    uint32_t GetBaseVertex() const noexcept;
+    uint32_t GetFirstIndex() const noexcept;
+
 private:
     uint32_t m_vaoRenderID = 0;
     MeshID m_ID;
@@ -279,7 +374,7 @@ private:
     std::vector<MeshObj> m_meshObjStorage;
     std::unordered_map<ds::StrID, uint64_t> m_meshNameToStorageIndexMap;
 
-    using MeshIDPool = ds::BaseIDPool<MeshID>;
+    using MeshIDPool = ds::GenerationalIDPool<MeshID>;
     MeshIDPool m_IDPool;
 
     bool m_isInitialized = false;
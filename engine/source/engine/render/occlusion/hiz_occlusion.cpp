@@ -0,0 +1,184 @@
+#include "pch.h"
+#include "hiz_occlusion.h"
+
+#include "render/mem_manager/buffer_manager.h"
+#include "render/texture_manager/texture_mng.h"
+
+#include "render/platform/OpenGL/opengl_driver.h"
+
+#include "utils/debug/assertion.h"
+
+
+bool HiZOcclusionCuller::Create() noexcept
+{
+    ENG_ASSERT_GRAPHICS_API(!IsValid(), "Attempt to create already valid HiZ occlusion culler");
+
+    MemoryBufferManager& memBuffManager = MemoryBufferManager::GetInstance();
+
+    // Buffers storage is created by the first readback, when the depth size is known
+    for (DepthReadback& readback : m_readbacks) {
+        readback = {};
+        readback.pBuffer = memBuffManager.RegisterBuffer();
+
+        if (!readback.pBuffer) {
+            ENG_ASSERT_GRAPHICS_API_FAIL("Failed to register HiZ depth readback buffer");
+            Destroy();
+            return false;
+        }
+    }
+
+    m_stats = {};
+    m_frameIdx = 0;
+    m_hiZFrameIdx = 0;
+    m_nextReadbackIdx = 0;
+
+    m_isCreated = true;
+
+    return true;
+}
+
+
+void HiZOcclusionCuller::Destroy() noexcept
+{
+    for (DepthReadback& readback : m_readbacks) {
+        ReleaseFence(readback);
+
+        if (readback.pBuffer) {
+            readback.pBuffer->Destroy();
+            MemoryBufferManager::GetInstance().UnregisterBuffer(readback.pBuffer);
+        }
+
+        readback = {};
+    }
+
+    m_hiZBuffer.Clear();
+
+    m_stats = {};
+    m_frameIdx = 0;
+    m_hiZFrameIdx = 0;
+    m_nextReadbackIdx = 0;
+
+    m_isCreated = false;
+}
+
+
+void HiZOcclusionCuller::Update() noexcept
+{
+    ENG_ASSERT_GRAPHICS_API(IsValid(), "HiZ occlusion culler is invalid");
+
+    ++m_frameIdx;
+    m_stats = {};
+
+    m_hiZBuffer.ResetTestStats();
+
+    DepthReadback* pNewestReadback = nullptr;
+
+    // From the oldest readback to the newest one, the GPU completes them in the same order
+    for (uint32_t i = 0; i < READBACKS_COUNT; ++i) {
+        DepthReadback& readback = m_readbacks[(m_nextReadbackIdx + i) % READBACKS_COUNT];
+
+        if (!readback.pFence) {
+            continue;
+        }
+
+        const GLenum waitResult = glClientWaitSync(static_cast<GLsync>(readback.pFence), GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+        if (waitResult == GL_TIMEOUT_EXPIRED) {
+            break;
+        }
+
+        ENG_ASSERT_GRAPHICS_API(waitResult != GL_WAIT_FAILED, "HiZ depth readback fence wait failed");
+
+        ReleaseFence(readback);
+        pNewestReadback = &readback;
+    }
+
+    if (pNewestReadback) {
+        const float* pDepth = static_cast<const float*>(pNewestReadback->pBuffer->MapRead());
+
+        if (pDepth) {
+            m_hiZBuffer.Build(pDepth, pNewestReadback->width, pNewestReadback->height, pNewestReadback->viewProjMatrix);
+            m_hiZFrameIdx = pNewestReadback->frameIdx;
+
+            pNewestReadback->pBuffer->Unmap();
+        } else {
+            ENG_LOG_GRAPHICS_API_WARN("Failed to map HiZ depth readback buffer");
+        }
+    }
+
+    m_stats.hiZFrameLatency = m_hiZBuffer.IsValid() ? static_cast<uint32_t>(m_frameIdx - m_hiZFrameIdx) : 0;
+}
+
+
+void HiZOcclusionCuller::RequestDepthReadback(const Texture* pDepthTexture, const glm::mat4x4& viewProjMatrix) noexcept
+{
+    ENG_ASSERT_GRAPHICS_API(IsValid(), "HiZ occlusion culler is invalid");
+    ENG_ASSERT_GRAPHICS_API(pDepthTexture && pDepthTexture->IsValid(), "Invalid HiZ depth texture");
+
+    DepthReadback& readback = m_readbacks[m_nextReadbackIdx];
+
+    // The oldest readback is still in flight, so all of them are
+    if (readback.pFence) {
+        ++m_stats.skippedReadbacksCount;
+        return;
+    }
+
+    const uint32_t width = pDepthTexture->GetWidth();
+    const uint32_t height = pDepthTexture->GetHeight();
+    const uint64_t depthSize = uint64_t(width) * height * sizeof(float);
+
+    MemoryBuffer* pBuffer = readback.pBuffer;
+
+    if (!pBuffer->IsValid() || pBuffer->GetSize() < depthSize) {
+        pBuffer->Destroy();
+
+        MemoryBufferCreateInfo createInfo = {};
+        createInfo.type = MemoryBufferType::TYPE_PIXEL_PACK_BUFFER;
+        createInfo.creationFlags = static_cast<MemoryBufferCreationFlags>(BUFFER_CREATION_FLAG_READABLE | BUFFER_CREATION_FLAG_CLIENT_STORAGE);
+        createInfo.pData = nullptr;
+        createInfo.dataSize = depthSize;
+        createInfo.elementSize = sizeof(float);
+
+        if (!pBuffer->Create(createInfo)) {
+            ENG_ASSERT_GRAPHICS_API_FAIL("Failed to create HiZ depth readback buffer");
+            return;
+        }
+
+        pBuffer->SetDebugName("__HIZ_DEPTH_READBACK_BUF__");
+    }
+
+    pBuffer->Bind();
+    glGetTextureImage(pDepthTexture->GetRenderID(), 0, GL_DEPTH_COMPONENT, GL_FLOAT, static_cast<GLsizei>(depthSize), nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback.pFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.viewProjMatrix = viewProjMatrix;
+    readback.frameIdx = m_frameIdx;
+    readback.width = width;
+    readback.height = height;
+
+    m_nextReadbackIdx = (m_nextReadbackIdx + 1) % READBACKS_COUNT;
+
+    ++m_stats.readbacksCount;
+}
+
+
+void HiZOcclusionCuller::CullSpheres(const BoundingSpheresSoA& spheres, std::vector<uint32_t>& inOutVisibleIndices) noexcept
+{
+    m_hiZBuffer.CullSpheres(spheres, inOutVisibleIndices);
+}
+
+
+void HiZOcclusionCuller::CullAABBs(const BoundingAABBsSoA& aabbs, std::vector<uint32_t>& inOutVisibleIndices) noexcept
+{
+    m_hiZBuffer.CullAABBs(aabbs, inOutVisibleIndices);
+}
+
+
+void HiZOcclusionCuller::ReleaseFence(DepthReadback& readback) noexcept
+{
+    if (readback.pFence) {
+        glDeleteSync(static_cast<GLsync>(readback.pFence));
+        readback.pFence = nullptr;
+    }
+}
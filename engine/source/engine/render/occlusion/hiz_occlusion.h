@@ -0,0 +1,82 @@
+#pragma once
+
+#include "core/culling/hiz_buffer.h"
+
+#include "utils/math/common_math.h"
+
+#include <array>
+
+#include <cstdint>
+
+
+class Texture;
+class MemoryBuffer;
+
+
+struct HiZOcclusionStats
+{
+    uint32_t readbacksCount;        // Depth readbacks issued this frame
+    uint32_t skippedReadbacksCount; // Readbacks dropped because all readback buffers were still in flight
+    uint32_t hiZFrameLatency;       // Frames between the depth the HiZ buffer was built from and the current frame
+};
+
+
+// Builds HiZBuffer from depth of previous frames. Depth is copied into pixel pack buffers with glGetTextureImage and fenced,
+// the HiZ buffer is rebuilt from the newest copy whose fence is signaled, so the render thread never waits for the GPU.
+// Bounds are tested with the view projection matrix of the frame the depth comes from
+class HiZOcclusionCuller
+{
+public:
+    HiZOcclusionCuller() = default;
+    ~HiZOcclusionCuller() { Destroy(); }
+
+    HiZOcclusionCuller(const HiZOcclusionCuller& other) = delete;
+    HiZOcclusionCuller& operator=(const HiZOcclusionCuller& other) = delete;
+
+    bool Create() noexcept;
+    void Destroy() noexcept;
+
+    // Rebuilds the HiZ buffer if a readback is complete. Must be called on the render thread at the beginning of a frame
+    void Update() noexcept;
+
+    // Copies the depth texture once the frame depth is final. Must be called on the render thread
+    void RequestDepthReadback(const Texture* pDepthTexture, const glm::mat4x4& viewProjMatrix) noexcept;
+
+    // Remove occluded volumes from inOutVisibleIndices. Nothing is culled until the first readback completes
+    void CullSpheres(const BoundingSpheresSoA& spheres, std::vector<uint32_t>& inOutVisibleIndices) noexcept;
+    void CullAABBs(const BoundingAABBsSoA& aabbs, std::vector<uint32_t>& inOutVisibleIndices) noexcept;
+
+    const HiZBuffer& GetHiZBuffer() const noexcept { return m_hiZBuffer; }
+    const HiZOcclusionStats& GetStats() const noexcept { return m_stats; }
+
+    bool IsValid() const noexcept { return m_isCreated; }
+
+private:
+    static inline constexpr uint32_t READBACKS_COUNT = 3;
+
+private:
+    struct DepthReadback
+    {
+        glm::mat4x4   viewProjMatrix;
+        MemoryBuffer* pBuffer;
+        void*         pFence;       // GLsync, set while the copy is in flight
+        uint64_t      frameIdx;
+        uint32_t      width;
+        uint32_t      height;
+    };
+
+    void ReleaseFence(DepthReadback& readback) noexcept;
+
+private:
+    std::array<DepthReadback, READBACKS_COUNT> m_readbacks = {};
+
+    HiZBuffer m_hiZBuffer;
+
+    HiZOcclusionStats m_stats = {};
+
+    uint64_t m_frameIdx = 0;
+    uint64_t m_hiZFrameIdx = 0;
+    uint32_t m_nextReadbackIdx = 0;
+
+    bool m_isCreated = false;
+};
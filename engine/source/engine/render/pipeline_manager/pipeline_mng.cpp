@@ -6,6 +6,8 @@
 
 #include "render/platform/OpenGL/opengl_driver.h"
 
+#include "core/window_system/window_system.h"
+
 
 static constexpr size_t ENG_MAX_PIPELINES_COUNT = 8192; // TODO: make it configurable
 
@@ -125,45 +127,49 @@ static constexpr bool IsBlendFactorConstant(GLenum factor) noexcept
 }
 
 
-static void EnablePolygonOffset(PolygonMode mode) noexcept
+// Issues the call only if the shadowed value differs from the new one
+template <typename T, typename SetFunc>
+static void SetState(std::optional<T>& shadowValue, const T& value, PipelineBindStats& stats, SetFunc&& setFunc) noexcept
 {
-    switch(mode) {
-        case PolygonMode::POLYGON_MODE_FILL:
-            glEnable(GL_POLYGON_OFFSET_FILL);
-            break;
-        case PolygonMode::POLYGON_MODE_LINE:
-            glEnable(GL_POLYGON_OFFSET_LINE);
-            break;
-        case PolygonMode::POLYGON_MODE_POINT:
-            glEnable(GL_POLYGON_OFFSET_POINT);
-            break;
-        default:
-            ENG_ASSERT_GRAPHICS_API_FAIL("Invalid polygon mode");
-            break;
+    if (shadowValue == value) {
+        ++stats.elidedCallsCount;
+        return;
     }
+
+    setFunc();
+
+    shadowValue = value;
+    ++stats.issuedCallsCount;
 }
 
 
-static void DisablePolygonOffset(PolygonMode mode) noexcept
+static void SetCapability(std::optional<bool>& shadowValue, GLenum capability, bool enabled, PipelineBindStats& stats) noexcept
+{
+    SetState(shadowValue, enabled, stats, [capability, enabled]() {
+        if (enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    });
+}
+
+
+static constexpr GLenum PolygonModeToPolygonOffsetCapability(PolygonMode mode) noexcept
 {
     switch(mode) {
-        case PolygonMode::POLYGON_MODE_FILL:
-            glDisable(GL_POLYGON_OFFSET_FILL);
-            break;
-        case PolygonMode::POLYGON_MODE_LINE:
-            glDisable(GL_POLYGON_OFFSET_LINE);
-            break;
-        case PolygonMode::POLYGON_MODE_POINT:
-            glDisable(GL_POLYGON_OFFSET_POINT);
-            break;
+        case PolygonMode::POLYGON_MODE_FILL: return GL_POLYGON_OFFSET_FILL;
+        case PolygonMode::POLYGON_MODE_LINE: return GL_POLYGON_OFFSET_LINE;
+        case PolygonMode::POLYGON_MODE_POINT: return GL_POLYGON_OFFSET_POINT;
         default:
             ENG_ASSERT_GRAPHICS_API_FAIL("Invalid polygon mode");
-            break;
+            return GL_NONE;
     }
 }
 
 
-static void SetupPolygonOffset(PolygonMode mode, float biasConstFactor, float biasSlopeFactor, float biasClamp, bool enabled) noexcept
+static void SetupPolygonOffset(RenderStateCache& cache, PipelineBindStats& stats, PolygonMode mode, 
+    float biasConstFactor, float biasSlopeFactor, float biasClamp, bool enabled) noexcept
 {
 #if defined(ENG_USE_INVERTED_Z)
     biasConstFactor = -biasConstFactor;
@@ -171,51 +177,64 @@ static void SetupPolygonOffset(PolygonMode mode, float biasConstFactor, float bi
     biasClamp       = -biasClamp;
 #endif
 
+    const GLenum capability = PolygonModeToPolygonOffsetCapability(mode);
+    SetCapability(cache.polygonOffsetEnable[static_cast<size_t>(mode)], capability, enabled, stats);
+
     if (enabled) {
-        EnablePolygonOffset(mode);
-        glPolygonOffsetClamp(biasConstFactor, biasSlopeFactor, biasClamp);
-    } else {
-        DisablePolygonOffset(mode);
+        const std::array<float, 3> polygonOffset = { biasConstFactor, biasSlopeFactor, biasClamp };
+
+        SetState(cache.polygonOffset, polygonOffset, stats, [&polygonOffset]() {
+            glPolygonOffsetClamp(polygonOffset[0], polygonOffset[1], polygonOffset[2]);
+        });
     }
 }
 
 
-static void SetupFaceStencilTesting(GLenum face, GLuint mask, uint32_t sfOp, uint32_t spdfOp, uint32_t spdpOp, bool enabled)
+static void SetupFaceStencilTesting(RenderStateCache::StencilFaceState& shadowState, PipelineBindStats& stats, 
+    GLenum face, GLuint mask, uint32_t sfOp, uint32_t spdfOp, uint32_t spdpOp, bool enabled) noexcept
 {
+    const GLuint writeMask = enabled ? mask : 0x00;
+    SetState(shadowState.writeMask, writeMask, stats, [face, writeMask]() { glStencilMaskSeparate(face, writeMask); });
+
     if (enabled) {
-        glStencilMaskSeparate(face, mask);
-
-        const GLenum frontFaceStencilFailOp = CompressedStencilOpToGLEnum(sfOp);
-        const GLenum frontFaceStencilPassDepthFailOp = CompressedStencilOpToGLEnum(spdfOp);
-        const GLenum frontFaceStencilPassDepthPassOp = CompressedStencilOpToGLEnum(spdpOp);
-        glStencilOpSeparate(face, frontFaceStencilFailOp, frontFaceStencilPassDepthFailOp, frontFaceStencilPassDepthPassOp);
-    } else {
-        glStencilMaskSeparate(face, 0x00);
+        const GLenum stencilFailOp = CompressedStencilOpToGLEnum(sfOp);
+        const GLenum stencilPassDepthFailOp = CompressedStencilOpToGLEnum(spdfOp);
+        const GLenum stencilPassDepthPassOp = CompressedStencilOpToGLEnum(spdpOp);
+        const std::array<uint32_t, 3> stencilOp = { stencilFailOp, stencilPassDepthFailOp, stencilPassDepthPassOp };
+
+        SetState(shadowState.op, stencilOp, stats, [face, &stencilOp]() {
+            glStencilOpSeparate(face, stencilOp[0], stencilOp[1], stencilOp[2]);
+        });
     }
 }
 
 
-static void SetupFaceCulling(CullMode mode) noexcept
+static void SetupFaceCulling(RenderStateCache& cache, PipelineBindStats& stats, CullMode mode) noexcept
 {
+    GLenum cullFace = GL_NONE;
+
     switch(mode) {
         case CullMode::CULL_MODE_NONE:
-            glDisable(GL_CULL_FACE);
             break;
         case CullMode::CULL_MODE_FRONT:
-            glEnable(GL_CULL_FACE);
-            glCullFace(GL_FRONT);
+            cullFace = GL_FRONT;
             break;
         case CullMode::CULL_MODE_BACK:
-            glEnable(GL_CULL_FACE);
-            glCullFace(GL_BACK);
+            cullFace = GL_BACK;
             break;
         case CullMode::CULL_MODE_FRONT_AND_BACK:
-            glEnable(GL_CULL_FACE);
-            glCullFace(GL_FRONT_AND_BACK);
+            cullFace = GL_FRONT_AND_BACK;
             break;
         default:
             ENG_ASSERT_GRAPHICS_API_FAIL("Invalid cull face mode");
-            break;
+            return;
+    }
+
+    const bool isCullingEnabled = mode != CullMode::CULL_MODE_NONE;
+    SetCapability(cache.cullFaceEnable, GL_CULL_FACE, isCullingEnabled, stats);
+
+    if (isCullingEnabled) {
+        SetState(cache.cullFace, cullFace, stats, [cullFace]() { glCullFace(cullFace); });
     }
 }
 
@@ -301,23 +320,20 @@ void Pipeline::Bind() noexcept
 {
     ENG_ASSERT(IsValid(), "Pipeline is invalid");
 
-    m_pFrameBuffer->Bind();
-    m_pShaderProgram->Bind();
+    PipelineManager& pipelineManager = PipelineManager::GetInstance();
 
-    SetupColorAttachments();
-    SetupDepthTesting();
-    SetupStencilTesting();
+    RenderStateCache& cache = pipelineManager.m_stateCache;
+    PipelineBindStats& stats = pipelineManager.m_bindStats;
 
-    const CompressedGlobalState& state = m_compressedGlobalState;
+    ++stats.bindsCount;
 
-    const GLenum frontFace = state.frontFace == uint64_t(FrontFace::FRONT_FACE_CLOCKWISE) ? GL_CW : GL_CCW;
-    glFrontFace(frontFace);
+    SetState(cache.frameBufferRenderID, m_pFrameBuffer->GetRenderID(), stats, [this]() { m_pFrameBuffer->Bind(); });
+    SetState(cache.programRenderID, m_pShaderProgram->GetRenderID(), stats, [this]() { m_pShaderProgram->Bind(); });
 
-    SetupFaceCulling(static_cast<CullMode>(state.cullMode));
-
-    if (state.polygonMode == uint64_t(PolygonMode::POLYGON_MODE_LINE)) {
-        glLineWidth(m_lineWidth);
-    }
+    SetupColorAttachments(cache, stats);
+    SetupDepthTesting(cache, stats);
+    SetupStencilTesting(cache, stats);
+    SetupRasterization(cache, stats);
 }
 
 
@@ -386,7 +402,7 @@ const ShaderProgram& Pipeline::GetShaderProgram() noexcept
 }
 
 
-void Pipeline::SetupColorAttachments() noexcept
+void Pipeline::SetupColorAttachments(RenderStateCache& cache, PipelineBindStats& stats) noexcept
 {
     bool isAnyBlendFactorConstant = false;
 
@@ -394,17 +410,29 @@ void Pipeline::SetupColorAttachments() noexcept
 
     for (uint32_t index = 0; index < realFBColorAttachementsCount; ++index) {
         const CompressedColorAttachmentBlendState& blendState = m_frameBufferColorAttachmentStates[index].blendState;
+        RenderStateCache::ColorAttachmentState& shadowState = cache.colorAttachments[index];
         
         const GLboolean rMask = (blendState.colorWriteMask & ColorComponentFlags::COLOR_COMPONENT_R_BIT) != 0 ? GL_TRUE : GL_FALSE;
         const GLboolean gMask = (blendState.colorWriteMask & ColorComponentFlags::COLOR_COMPONENT_G_BIT) != 0 ? GL_TRUE : GL_FALSE;
         const GLboolean bMask = (blendState.colorWriteMask & ColorComponentFlags::COLOR_COMPONENT_B_BIT) != 0 ? GL_TRUE : GL_FALSE;
         const GLboolean aMask = (blendState.colorWriteMask & ColorComponentFlags::COLOR_COMPONENT_A_BIT) != 0 ? GL_TRUE : GL_FALSE;
+        const std::array<uint32_t, 4> colorMask = { rMask, gMask, bMask, aMask };
+
+        SetState(shadowState.colorMask, colorMask, stats, [index, rMask, gMask, bMask, aMask]() {
+            glColorMaski(index, rMask, gMask, bMask, aMask);
+        });
 
-        glColorMaski(index, rMask, gMask, bMask, aMask);
+        const bool isBlendEnabled = blendState.blendEnable;
 
-        if (blendState.blendEnable) {
-            glEnablei(GL_BLEND, index);
+        SetState(shadowState.blendEnable, isBlendEnabled, stats, [index, isBlendEnabled]() {
+            if (isBlendEnabled) {
+                glEnablei(GL_BLEND, index);
+            } else {
+                glDisablei(GL_BLEND, index);
+            }
+        });
 
+        if (isBlendEnabled) {
             const GLenum srcRGBBlendFactor = CompressedBlendFactorToGLEnum(blendState.srcRGBBlendFactor);
             const GLenum dstRGBBlendFactor = CompressedBlendFactorToGLEnum(blendState.dstRGBBlendFactor);
             const GLenum srcAlphaBlendFactor = CompressedBlendFactorToGLEnum(blendState.srcAlphaBlendFactor);
@@ -413,74 +441,87 @@ void Pipeline::SetupColorAttachments() noexcept
             const GLenum rgbBlendOp = CompressedBlendOpToGLEnum(blendState.rgbBlendOp);
             const GLenum alphaBlendOp = CompressedBlendOpToGLEnum(blendState.alphaBlendOp);
 
-            glBlendEquationSeparatei(index, rgbBlendOp, alphaBlendOp);
-            glBlendFuncSeparatei(index, srcRGBBlendFactor, dstRGBBlendFactor, srcAlphaBlendFactor, dstAlphaBlendFactor);
+            const std::array<uint32_t, 2> blendEquation = { rgbBlendOp, alphaBlendOp };
+            const std::array<uint32_t, 4> blendFunc = { srcRGBBlendFactor, dstRGBBlendFactor, srcAlphaBlendFactor, dstAlphaBlendFactor };
+
+            SetState(shadowState.blendEquation, blendEquation, stats, [index, &blendEquation]() {
+                glBlendEquationSeparatei(index, blendEquation[0], blendEquation[1]);
+            });
+            
+            SetState(shadowState.blendFunc, blendFunc, stats, [index, &blendFunc]() {
+                glBlendFuncSeparatei(index, blendFunc[0], blendFunc[1], blendFunc[2], blendFunc[3]);
+            });
 
             isAnyBlendFactorConstant = isAnyBlendFactorConstant
                 || IsBlendFactorConstant(srcRGBBlendFactor)
                 || IsBlendFactorConstant(dstRGBBlendFactor)
                 || IsBlendFactorConstant(srcAlphaBlendFactor)
                 || IsBlendFactorConstant(dstAlphaBlendFactor);
-        } else {
-            glDisablei(GL_BLEND, index);
         }
     }
 
-    const float blendConstRed = m_blendConstants[0] * isAnyBlendFactorConstant;
-    const float blendConstGreen = m_blendConstants[1] * isAnyBlendFactorConstant;
-    const float blendConstBlue = m_blendConstants[2] * isAnyBlendFactorConstant;
-    const float blendConstAlpha = m_blendConstants[3] * isAnyBlendFactorConstant;
+    const std::array<float, 4> blendColor = {
+        m_blendConstants[0] * isAnyBlendFactorConstant,
+        m_blendConstants[1] * isAnyBlendFactorConstant,
+        m_blendConstants[2] * isAnyBlendFactorConstant,
+        m_blendConstants[3] * isAnyBlendFactorConstant,
+    };
 
-    glBlendColor(blendConstRed, blendConstGreen, blendConstBlue, blendConstAlpha);
+    SetState(cache.blendColor, blendColor, stats, [&blendColor]() {
+        glBlendColor(blendColor[0], blendColor[1], blendColor[2], blendColor[3]);
+    });
 
-    if (m_compressedGlobalState.colorBlendLogicOpEnable) {
-        glEnable(GL_COLOR_LOGIC_OP);
+    const bool isLogicOpEnabled = m_compressedGlobalState.colorBlendLogicOpEnable;
+    SetCapability(cache.logicOpEnable, GL_COLOR_LOGIC_OP, isLogicOpEnabled, stats);
 
+    if (isLogicOpEnabled) {
         const GLenum colorLogicOp = CompressedLogicOpToGLEnum(m_compressedGlobalState.colorBlendLogicOp);
-        glLogicOp(colorLogicOp);
-    } else {
-        glDisable(GL_COLOR_LOGIC_OP);
+        SetState(cache.logicOp, colorLogicOp, stats, [colorLogicOp]() { glLogicOp(colorLogicOp); });
     }
 
-    std::array<GLenum, FrameBuffer::GetMaxColorAttachmentsCount()> drawColorBuffers = { GL_NONE };
-    for (size_t i = 0; i < realFBColorAttachementsCount; ++i) {
-        drawColorBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
-    }
-    
-    glDrawBuffers(realFBColorAttachementsCount, drawColorBuffers.data());
+    SetState(cache.drawBuffersCounts[m_pFrameBuffer->GetRenderID()], realFBColorAttachementsCount, stats, [realFBColorAttachementsCount]() {
+        std::array<GLenum, FrameBuffer::GetMaxColorAttachmentsCount()> drawColorBuffers = { GL_NONE };
+        for (size_t i = 0; i < realFBColorAttachementsCount; ++i) {
+            drawColorBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+        }
+        
+        glDrawBuffers(realFBColorAttachementsCount, drawColorBuffers.data());
+    });
 }
 
 
-void Pipeline::SetupDepthTesting() noexcept
+void Pipeline::SetupDepthTesting(RenderStateCache& cache, PipelineBindStats& stats) noexcept
 {
     const CompressedGlobalState& state = m_compressedGlobalState;
 
-    if (state.depthTestEnable) {
-        glEnable(GL_DEPTH_TEST);
+    SetCapability(cache.depthTestEnable, GL_DEPTH_TEST, state.depthTestEnable, stats);
 
-        if (state.depthWriteEnable) {
-            glDepthMask(GL_TRUE);
+    if (state.depthTestEnable) {
+        const bool isDepthWriteEnabled = state.depthWriteEnable;
+        
+        SetState(cache.depthMask, isDepthWriteEnabled, stats, [isDepthWriteEnabled]() {
+            glDepthMask(isDepthWriteEnabled ? GL_TRUE : GL_FALSE);
+        });
 
+        if (isDepthWriteEnabled) {
             const PolygonMode polygonMode = static_cast<PolygonMode>(state.polygonMode);
-            SetupPolygonOffset(polygonMode, m_depthBiasConstantFactor, m_depthBiasSlopeFactor, m_depthBiasClamp, state.depthBiasEnabled);
+            SetupPolygonOffset(cache, stats, polygonMode, m_depthBiasConstantFactor, m_depthBiasSlopeFactor, m_depthBiasClamp, state.depthBiasEnabled);
 
             const GLenum depthCompareFunc = CompressedCompareFuncToGLEnum(state.depthCompareFunc);
-            glDepthFunc(depthCompareFunc);
-        } else {
-            glDepthMask(GL_FALSE);
+            SetState(cache.depthFunc, depthCompareFunc, stats, [depthCompareFunc]() { glDepthFunc(depthCompareFunc); });
         }
-    } else {
-        glDisable(GL_DEPTH_TEST);
     }
 }
 
 
-void Pipeline::SetupStencilTesting() noexcept
+void Pipeline::SetupStencilTesting(RenderStateCache& cache, PipelineBindStats& stats) noexcept
 {
-    if (m_compressedGlobalState.stencilTestEnable) {
-        glEnable(GL_STENCIL_TEST);
+    SetCapability(cache.stencilTestEnable, GL_STENCIL_TEST, m_compressedGlobalState.stencilTestEnable, stats);
 
+    if (m_compressedGlobalState.stencilTestEnable) {
         SetupFaceStencilTesting(
+            cache.stencilFaces[0],
+            stats,
             GL_FRONT, 
             m_stencilFrontMask, 
             m_compressedGlobalState.frontFaceStencilFailOp, 
@@ -489,21 +530,36 @@ void Pipeline::SetupStencilTesting() noexcept
             m_compressedGlobalState.stencilFrontWriteEnable);
 
         SetupFaceStencilTesting(
+            cache.stencilFaces[1],
+            stats,
             GL_BACK, 
             m_stencilBackMask, 
             m_compressedGlobalState.backFaceStencilFailOp, 
             m_compressedGlobalState.backFaceStencilPassDepthFailOp, 
             m_compressedGlobalState.backFaceStencilPassDepthPassOp, 
             m_compressedGlobalState.stencilBackWriteEnable);
-    } else {
-        glDisable(GL_STENCIL_TEST);
+    }
+}
+
+
+void Pipeline::SetupRasterization(RenderStateCache& cache, PipelineBindStats& stats) noexcept
+{
+    const CompressedGlobalState& state = m_compressedGlobalState;
+
+    const GLenum frontFace = state.frontFace == uint64_t(FrontFace::FRONT_FACE_CLOCKWISE) ? GL_CW : GL_CCW;
+    SetState(cache.frontFace, frontFace, stats, [frontFace]() { glFrontFace(frontFace); });
+
+    SetupFaceCulling(cache, stats, static_cast<CullMode>(state.cullMode));
+
+    if (state.polygonMode == uint64_t(PolygonMode::POLYGON_MODE_LINE)) {
+        SetState(cache.lineWidth, m_lineWidth, stats, [this]() { glLineWidth(m_lineWidth); });
     }
 }
 
 
 bool Pipeline::Create(const PipelineCreateInfo &createInfo) noexcept
 {
-    ENG_ASSERT(!IsValid(), "Attempt to create already valid pipeline (ID: {})", m_ID.Value());
+    ENG_ASSERT(!IsValid(), "Attempt to create already valid pipeline (ID: {})", m_ID.Index());
     ENG_ASSERT(m_ID.IsValid(), "Pipeline ID is invalid. You must initialize only pipelines which were returned by PipelineManager");
 
     ENG_ASSERT(createInfo.pInputAssemblyState,     "pInputAssemblyState is nullptr");
@@ -637,9 +693,9 @@ PipelineManager& PipelineManager::GetInstance() noexcept
 Pipeline* PipelineManager::RegisterPipeline() noexcept
 {
     const PipelineID pipelineID = m_IDPool.Allocate();
-    ENG_ASSERT(pipelineID.Value() < m_pipelineStorage.size(), "Pipeline storage overflow");
+    ENG_ASSERT(pipelineID.Index() < m_pipelineStorage.size(), "Pipeline storage overflow");
 
-    Pipeline* pPipeline = &m_pipelineStorage[pipelineID.Value()];
+    Pipeline* pPipeline = &m_pipelineStorage[pipelineID.Index()];
 
     ENG_ASSERT(!pPipeline->IsValid(), "Valid graphics pipeline was returned during registration");
 
@@ -656,7 +712,7 @@ void PipelineManager::UnregisterPipeline(Pipeline* pPipeline) noexcept
     }
 
     if (pPipeline->IsValid()) {
-        ENG_LOG_WARN("Unregistration of pipeline \'{}\' while it's steel valid. Prefer to destroy buffers manually", pPipeline->m_ID.Value());
+        ENG_LOG_WARN("Unregistration of pipeline \'{}\' while it's steel valid. Prefer to destroy buffers manually", pPipeline->m_ID.Index());
         pPipeline->Destroy();
     }
 
@@ -664,6 +720,18 @@ void PipelineManager::UnregisterPipeline(Pipeline* pPipeline) noexcept
 }
 
 
+void PipelineManager::InvalidateStateCache() noexcept
+{
+    m_stateCache = RenderStateCache();
+}
+
+
+void PipelineManager::ResetBindStats() noexcept
+{
+    m_bindStats = {};
+}
+
+
 bool PipelineManager::Init() noexcept
 {   
     if (IsInitialized()) {
@@ -676,6 +744,16 @@ bool PipelineManager::Init() noexcept
 #if defined(ENG_USE_INVERTED_Z)
     glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
 #endif
+
+    InvalidateStateCache();
+    ResetBindStats();
+
+    es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
+
+    // Render target frame buffers are recreated on resize. Their render IDs may be reused, while the GL binding falls back to the default frame buffer
+    m_frameBufferResizeEventListenerID = dispatcher.Subscribe<EventFramebufferResized>([this](const void*) {
+        InvalidateStateCache();
+    });
     
     m_isInitialized = true;
 
@@ -685,9 +763,14 @@ bool PipelineManager::Init() noexcept
 
 void PipelineManager::Terminate() noexcept
 {
+    es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
+    dispatcher.Unsubscribe(m_frameBufferResizeEventListenerID);
+
     m_pipelineStorage.clear();
     m_IDPool.Reset();
 
+    InvalidateStateCache();
+
     m_isInitialized = false;
 }
 
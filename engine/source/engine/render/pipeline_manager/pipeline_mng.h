@@ -4,9 +4,11 @@
 #include "render/shader_manager/shader_mng.h"
 
 #include "utils/data_structures/strid.h"
-#include "utils/data_structures/base_id.h"
+#include "utils/data_structures/generational_id.h"
 
 #include <vector>
+#include <array>
+#include <optional>
 #include <unordered_map>
 
 
@@ -253,7 +255,58 @@ struct PipelineCreateInfo
 };
 
 
-using PipelineID = ds::BaseID<uint32_t>;
+using PipelineID = ds::GenerationalID<uint32_t>;
+
+
+struct PipelineBindStats
+{
+    uint32_t bindsCount;
+    // GL calls issued by Pipeline::Bind() and calls elided since the shadowed GL state already had the same value
+    uint32_t issuedCallsCount;
+    uint32_t elidedCallsCount;
+};
+
+
+// Shadow copy of the GL state set by Pipeline::Bind(). Empty values are unknown and are always issued
+struct RenderStateCache
+{
+    struct ColorAttachmentState
+    {
+        std::optional<std::array<uint32_t, 4>> colorMask;
+        std::optional<std::array<uint32_t, 4>> blendFunc;     // src RGB, dst RGB, src alpha, dst alpha
+        std::optional<std::array<uint32_t, 2>> blendEquation; // RGB, alpha
+        std::optional<bool>                    blendEnable;
+    };
+
+    struct StencilFaceState
+    {
+        std::optional<std::array<uint32_t, 3>> op; // stencil fail, depth fail, depth pass
+        std::optional<uint32_t>                writeMask;
+    };
+
+    std::array<ColorAttachmentState, FrameBuffer::GetMaxColorAttachmentsCount()> colorAttachments;
+    std::array<StencilFaceState, 2> stencilFaces; // front, back
+    
+    // Draw buffers are a part of the frame buffer object state, so they are tracked per frame buffer render ID
+    std::unordered_map<uint32_t, std::optional<uint32_t>> drawBuffersCounts;
+
+    std::optional<std::array<float, 4>> blendColor;
+    std::optional<std::array<float, 3>> polygonOffset; // factor, units, clamp
+    std::array<std::optional<bool>, static_cast<size_t>(PolygonMode::POLYGON_MODE_COUNT)> polygonOffsetEnable;
+
+    std::optional<uint32_t> frameBufferRenderID;
+    std::optional<uint32_t> programRenderID;
+    std::optional<uint32_t> logicOp;
+    std::optional<uint32_t> depthFunc;
+    std::optional<uint32_t> cullFace;
+    std::optional<uint32_t> frontFace;
+    std::optional<float>    lineWidth;
+    std::optional<bool>     logicOpEnable;
+    std::optional<bool>     depthTestEnable;
+    std::optional<bool>     depthMask;
+    std::optional<bool>     stencilTestEnable;
+    std::optional<bool>     cullFaceEnable;
+};
 
 
 class Pipeline
@@ -283,11 +336,14 @@ public:
     const FrameBuffer& GetFrameBuffer() noexcept;
     const ShaderProgram& GetShaderProgram() noexcept;
 
+    PipelineID GetID() const noexcept { return m_ID; }
+
 private:
-    void SetupColorAttachments() noexcept;
+    void SetupColorAttachments(RenderStateCache& cache, PipelineBindStats& stats) noexcept;
 
-    void SetupDepthTesting() noexcept;
-    void SetupStencilTesting() noexcept;
+    void SetupDepthTesting(RenderStateCache& cache, PipelineBindStats& stats) noexcept;
+    void SetupStencilTesting(RenderStateCache& cache, PipelineBindStats& stats) noexcept;
+    void SetupRasterization(RenderStateCache& cache, PipelineBindStats& stats) noexcept;
 
 private:
     enum ColorAttachmentBlendStateBitsPerField : uint32_t
@@ -391,6 +447,8 @@ private:
 
 class PipelineManager
 {
+    friend class Pipeline;
+
     friend bool engInitPipelineManager() noexcept;
     friend void engTerminatePipelineManager() noexcept;
     friend bool engIsRenderPipelineInitialized() noexcept;
@@ -406,6 +464,12 @@ public:
 
     Pipeline* RegisterPipeline() noexcept;
     void UnregisterPipeline(Pipeline* pPipeline) noexcept;
+
+    // Forgets shadowed GL state, so the next Pipeline::Bind() issues all of it. Call it after the state was changed bypassing pipelines
+    void InvalidateStateCache() noexcept;
+
+    const PipelineBindStats& GetBindStats() const noexcept { return m_bindStats; }
+    void ResetBindStats() noexcept;
     
 private:
     PipelineManager() = default;
@@ -418,9 +482,14 @@ private:
 private:
     std::vector<Pipeline> m_pipelineStorage;
 
-    using PipelineIDPool = ds::BaseIDPool<PipelineID>;
+    using PipelineIDPool = ds::GenerationalIDPool<PipelineID>;
     PipelineIDPool m_IDPool;
 
+    RenderStateCache m_stateCache;
+    PipelineBindStats m_bindStats = {};
+
+    es::ListenerID m_frameBufferResizeEventListenerID;
+
     bool m_isInitialized = false;
 };
 
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "opengl_driver.h"
+#include "opengl_recording_backend.h"
 
 #include <GLFW/glfw3.h>
 
@@ -61,6 +62,8 @@ struct OpenGLGlobalInfo
     int32_t maxGeometryUniformComponentsCount;
     int32_t maxIntegerSamplesCount;
     int32_t minMapBufferAlignment;
+    int32_t uniformBufferOffsetAlignment;
+    int32_t shaderStorageBufferOffsetAlignment;
     int32_t maxRectangleTextureSize;
     int32_t maxRenderBufferSize;
     int32_t maxSampleMaskWordsCount;
@@ -157,23 +160,8 @@ static void GLAPIENTRY OpenGLMessageCallback(GLenum source, GLenum type, GLuint
 #endif
 
 
-bool engInitOpenGLDriver() noexcept
+static void QueryGlobalInfo() noexcept
 {
-    if (engIsOpenGLDriverInitialized()) {
-        ENG_LOG_GRAPHICS_API_WARN("OpenGL driver is already initialized!");
-        return true;
-    }
-
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        ENG_ASSERT_GRAPHICS_API_FAIL("Failed to initialize OpenGL driver");
-        return false;
-    }
-
-#if defined(ENG_DEBUG) && defined(ENG_LOGGING_ENABLED)
-    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-    glDebugMessageCallback(OpenGLMessageCallback, nullptr);
-#endif
-
     glGetIntegerv(GL_MINOR_VERSION, &g_globalInfo.minorVersion);
     glGetIntegerv(GL_MAJOR_VERSION, &g_globalInfo.majorVersion);
     glGetIntegerv(GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS, &g_globalInfo.maxComputeShaderStorageBlocksCount);
@@ -227,6 +215,8 @@ bool engInitOpenGLDriver() noexcept
     glGetIntegerv(GL_MAX_GEOMETRY_UNIFORM_COMPONENTS, &g_globalInfo.maxGeometryUniformComponentsCount);
     glGetIntegerv(GL_MAX_INTEGER_SAMPLES, &g_globalInfo.maxIntegerSamplesCount);
     glGetIntegerv(GL_MIN_MAP_BUFFER_ALIGNMENT, &g_globalInfo.minMapBufferAlignment);
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &g_globalInfo.uniformBufferOffsetAlignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &g_globalInfo.shaderStorageBufferOffsetAlignment);
     glGetIntegerv(GL_MAX_RECTANGLE_TEXTURE_SIZE, &g_globalInfo.maxRectangleTextureSize);
     glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &g_globalInfo.maxRenderBufferSize);
     glGetIntegerv(GL_MAX_SAMPLE_MASK_WORDS, &g_globalInfo.maxSampleMaskWordsCount);
@@ -276,7 +266,32 @@ bool engInitOpenGLDriver() noexcept
     g_globalInfo.pVendorName = (const char*)glGetString(GL_VENDOR);
     g_globalInfo.pRendererName = (const char*)glGetString(GL_RENDERER);
     g_globalInfo.pHardwareVersionName = (const char*)glGetString(GL_VERSION);
-    g_globalInfo.pShadingLanguageName = (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION);    
+    g_globalInfo.pShadingLanguageName = (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION);
+}
+
+
+bool engInitOpenGLDriver() noexcept
+{
+    if (engIsOpenGLDriverInitialized()) {
+        ENG_LOG_GRAPHICS_API_WARN("OpenGL driver is already initialized!");
+        return true;
+    }
+
+#if defined(ENG_GL_RECORDING_BACKEND)
+    engInstallOpenGLRecordingBackend();
+#else
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        ENG_ASSERT_GRAPHICS_API_FAIL("Failed to initialize OpenGL driver");
+        return false;
+    }
+#endif
+
+#if defined(ENG_DEBUG) && defined(ENG_LOGGING_ENABLED)
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(OpenGLMessageCallback, nullptr);
+#endif
+
+    QueryGlobalInfo();
 
     g_isInitialized = true;
 
@@ -660,6 +675,20 @@ uint32_t engGetOpenGLMinMapBufferAlignment() noexcept
 }
 
 
+uint32_t engGetOpenGLUniformBufferOffsetAlignment() noexcept
+{
+    CHECK_DRV_INIT();
+    return g_globalInfo.uniformBufferOffsetAlignment;
+}
+
+
+uint32_t engGetOpenGLShaderStorageBufferOffsetAlignment() noexcept
+{
+    CHECK_DRV_INIT();
+    return g_globalInfo.shaderStorageBufferOffsetAlignment;
+}
+
+
 uint32_t engGetOpenGLMaxRectangleTextureSize() noexcept
 {
     CHECK_DRV_INIT();
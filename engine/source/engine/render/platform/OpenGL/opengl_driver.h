@@ -162,6 +162,12 @@ uint32_t engGetOpenGLMaxIntegerSamplesCount() noexcept;
 // Returns the minimum alignment in basic machine units of pointers returned fromglMapBuffer and glMapBufferRange. This value must be a power of two and must be at least 64.
 uint32_t engGetOpenGLMinMapBufferAlignment() noexcept;
 
+// Returns the minimum required alignment for uniform buffer sizes and offset. This value must be a power of two (at most 256).
+uint32_t engGetOpenGLUniformBufferOffsetAlignment() noexcept;
+
+// Returns the minimum required alignment for shader storage buffer sizes and offset. This value must be a power of two (at most 256).
+uint32_t engGetOpenGLShaderStorageBufferOffsetAlignment() noexcept;
+
 // Returns a rough estimate of the largest rectangular texture that the GL can handle (at least 1024).
 uint32_t engGetOpenGLMaxRectangleTextureSize() noexcept;
 
@@ -0,0 +1,827 @@
+#include "pch.h"
+#include "opengl_recording_backend.h"
+
+#include "utils/debug/assertion.h"
+
+#include <glad/glad.h>
+
+
+using OpenGLStateValue = std::array<uint64_t, 4>;
+
+
+static std::vector<OpenGLRecordedCommand> g_commands;
+static OpenGLRecordingStats g_stats = {};
+
+// Last value set for every state slot, used to detect redundant state changes
+static std::unordered_map<uint64_t, OpenGLStateValue> g_shadowState;
+
+// Host memory backing of buffers, so that mapping and uploads work without a context
+static std::unordered_map<GLuint, std::vector<uint8_t>> g_bufferStorages;
+
+static GLuint g_nextObjectID = 1;
+static GLuint g_boundDrawFramebuffer = 0;
+
+static bool g_isInstalled = false;
+
+
+template <typename T>
+static uint64_t ArgToU64(T arg) noexcept
+{
+    if constexpr (std::is_pointer_v<T>) {
+        return reinterpret_cast<uintptr_t>(arg);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        uint64_t value = 0;
+        memcpy(&value, &arg, sizeof(arg));
+        return value;
+    } else {
+        return static_cast<uint64_t>(arg);
+    }
+}
+
+
+template <typename... Args>
+static void Record(OpenGLCommandType type, Args... args) noexcept
+{
+    OpenGLRecordedCommand command = {};
+    command.type = type;
+
+    if constexpr (sizeof...(Args) > 0) {
+        const uint64_t values[] = { ArgToU64(args)... };
+
+        for (size_t i = 0; i < std::min(command.args.size(), sizeof...(Args)); ++i) {
+            command.args[i] = values[i];
+        }
+    }
+
+    g_commands.emplace_back(command);
+
+    ++g_stats.commandCounts[static_cast<size_t>(type)];
+    ++g_stats.commandsCount;
+}
+
+
+template <typename... Args>
+static void RecordStateChange(OpenGLCommandType stateType, uint64_t slot, Args... values) noexcept
+{
+    static_assert(sizeof...(Args) <= std::tuple_size_v<OpenGLStateValue>, "Too many state values");
+
+    const OpenGLStateValue value = { ArgToU64(values)... };
+    const uint64_t key = (static_cast<uint64_t>(stateType) << 48ull) ^ slot;
+
+    ++g_stats.stateChangesCount;
+
+    auto stateIt = g_shadowState.find(key);
+
+    if (stateIt != g_shadowState.end() && stateIt->second == value) {
+        ++g_stats.redundantStateChangesCount;
+    } else {
+        g_shadowState[key] = value;
+    }
+}
+
+
+static void GenObjects(GLsizei n, GLuint* pObjects) noexcept
+{
+    for (GLsizei i = 0; i < n; ++i) {
+        pObjects[i] = g_nextObjectID++;
+    }
+}
+
+
+static void APIENTRY Rec_Enable(GLenum cap)
+{
+    Record(OpenGLCommandType::ENABLE, cap);
+    RecordStateChange(OpenGLCommandType::ENABLE, cap, GL_TRUE);
+}
+
+
+static void APIENTRY Rec_Disable(GLenum cap)
+{
+    Record(OpenGLCommandType::DISABLE, cap);
+    RecordStateChange(OpenGLCommandType::ENABLE, cap, GL_FALSE);
+}
+
+
+static void APIENTRY Rec_Enablei(GLenum target, GLuint index)
+{
+    Record(OpenGLCommandType::ENABLEI, target, index);
+    RecordStateChange(OpenGLCommandType::ENABLEI, (uint64_t(target) << 32ull) | index, GL_TRUE);
+}
+
+
+static void APIENTRY Rec_Disablei(GLenum target, GLuint index)
+{
+    Record(OpenGLCommandType::DISABLEI, target, index);
+    RecordStateChange(OpenGLCommandType::ENABLEI, (uint64_t(target) << 32ull) | index, GL_FALSE);
+}
+
+
+static void APIENTRY Rec_GetIntegerv(GLenum pname, GLint* pData)
+{
+    Record(OpenGLCommandType::GET_INTEGERV, pname);
+
+    switch (pname) {
+        case GL_MAJOR_VERSION: pData[0] = 4; break;
+        case GL_MINOR_VERSION: pData[0] = 6; break;
+        case GL_MAX_DRAW_BUFFERS: pData[0] = 8; break;
+        case GL_MAX_VERTEX_ATTRIBS: pData[0] = 16; break;
+        case GL_MIN_MAP_BUFFER_ALIGNMENT: pData[0] = 64; break;
+        case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: pData[0] = 256; break;
+        case GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT: pData[0] = 16; break;
+        case GL_NUM_COMPRESSED_TEXTURE_FORMATS: pData[0] = 0; break;
+        case GL_NUM_EXTENSIONS: pData[0] = 0; break;
+        case GL_MAX_VIEWPORT_DIMS:
+            pData[0] = 16384;
+            pData[1] = 16384;
+            break;
+        case GL_VIEWPORT_BOUNDS_RANGE:
+            pData[0] = -32768;
+            pData[1] = 32767;
+            break;
+        default:
+            pData[0] = 16384;
+            break;
+    }
+}
+
+
+static void APIENTRY Rec_GetIntegeri_v(GLenum target, GLuint index, GLint* pData)
+{
+    Record(OpenGLCommandType::GET_INTEGERI_V, target, index);
+    pData[0] = 1024;
+}
+
+
+static void APIENTRY Rec_GetFloatv(GLenum pname, GLfloat* pData)
+{
+    Record(OpenGLCommandType::GET_FLOATV, pname);
+    pData[0] = 16.f;
+}
+
+
+static const GLubyte* APIENTRY Rec_GetString(GLenum name)
+{
+    Record(OpenGLCommandType::GET_STRING, name);
+
+    switch (name) {
+        case GL_VERSION: return reinterpret_cast<const GLubyte*>("4.6 Recording");
+        case GL_SHADING_LANGUAGE_VERSION: return reinterpret_cast<const GLubyte*>("4.60");
+        default: return reinterpret_cast<const GLubyte*>("Recording");
+    }
+}
+
+
+static void APIENTRY Rec_DebugMessageCallback(GLDEBUGPROC callback, const void* pUserParam)
+{
+    Record(OpenGLCommandType::DEBUG_MESSAGE_CALLBACK);
+}
+
+
+static void APIENTRY Rec_ClipControl(GLenum origin, GLenum depth)
+{
+    Record(OpenGLCommandType::CLIP_CONTROL, origin, depth);
+    RecordStateChange(OpenGLCommandType::CLIP_CONTROL, 0, origin, depth);
+}
+
+
+static void APIENTRY Rec_Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    Record(OpenGLCommandType::VIEWPORT, x, y, width, height);
+    RecordStateChange(OpenGLCommandType::VIEWPORT, 0, x, y, width, height);
+}
+
+
+static void APIENTRY Rec_CullFace(GLenum mode)
+{
+    Record(OpenGLCommandType::CULL_FACE, mode);
+    RecordStateChange(OpenGLCommandType::CULL_FACE, 0, mode);
+}
+
+
+static void APIENTRY Rec_FrontFace(GLenum mode)
+{
+    Record(OpenGLCommandType::FRONT_FACE, mode);
+    RecordStateChange(OpenGLCommandType::FRONT_FACE, 0, mode);
+}
+
+
+static void APIENTRY Rec_LineWidth(GLfloat width)
+{
+    Record(OpenGLCommandType::LINE_WIDTH, width);
+    RecordStateChange(OpenGLCommandType::LINE_WIDTH, 0, width);
+}
+
+
+static void APIENTRY Rec_PolygonOffsetClamp(GLfloat factor, GLfloat units, GLfloat clamp)
+{
+    Record(OpenGLCommandType::POLYGON_OFFSET_CLAMP, factor, units, clamp);
+    RecordStateChange(OpenGLCommandType::POLYGON_OFFSET_CLAMP, 0, factor, units, clamp);
+}
+
+
+static void APIENTRY Rec_DepthMask(GLboolean flag)
+{
+    Record(OpenGLCommandType::DEPTH_MASK, flag);
+    RecordStateChange(OpenGLCommandType::DEPTH_MASK, 0, flag);
+}
+
+
+static void APIENTRY Rec_DepthFunc(GLenum func)
+{
+    Record(OpenGLCommandType::DEPTH_FUNC, func);
+    RecordStateChange(OpenGLCommandType::DEPTH_FUNC, 0, func);
+}
+
+
+static void APIENTRY Rec_StencilMaskSeparate(GLenum face, GLuint mask)
+{
+    Record(OpenGLCommandType::STENCIL_MASK_SEPARATE, face, mask);
+    RecordStateChange(OpenGLCommandType::STENCIL_MASK_SEPARATE, face, mask);
+}
+
+
+static void APIENTRY Rec_StencilOpSeparate(GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass)
+{
+    Record(OpenGLCommandType::STENCIL_OP_SEPARATE, face, sfail, dpfail, dppass);
+    RecordStateChange(OpenGLCommandType::STENCIL_OP_SEPARATE, face, sfail, dpfail, dppass);
+}
+
+
+static void APIENTRY Rec_LogicOp(GLenum opcode)
+{
+    Record(OpenGLCommandType::LOGIC_OP, opcode);
+    RecordStateChange(OpenGLCommandType::LOGIC_OP, 0, opcode);
+}
+
+
+static void APIENTRY Rec_BlendColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+    Record(OpenGLCommandType::BLEND_COLOR, red, green, blue, alpha);
+    RecordStateChange(OpenGLCommandType::BLEND_COLOR, 0, red, green, blue, alpha);
+}
+
+
+static void APIENTRY Rec_BlendEquationSeparatei(GLuint buf, GLenum modeRGB, GLenum modeAlpha)
+{
+    Record(OpenGLCommandType::BLEND_EQUATION_SEPARATEI, buf, modeRGB, modeAlpha);
+    RecordStateChange(OpenGLCommandType::BLEND_EQUATION_SEPARATEI, buf, modeRGB, modeAlpha);
+}
+
+
+static void APIENTRY Rec_BlendFuncSeparatei(GLuint buf, GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
+{
+    Record(OpenGLCommandType::BLEND_FUNC_SEPARATEI, buf, srcRGB, dstRGB, srcAlpha);
+    RecordStateChange(OpenGLCommandType::BLEND_FUNC_SEPARATEI, buf, srcRGB, dstRGB, srcAlpha, dstAlpha);
+}
+
+
+static void APIENTRY Rec_ColorMaski(GLuint index, GLboolean r, GLboolean g, GLboolean b, GLboolean a)
+{
+    Record(OpenGLCommandType::COLOR_MASKI, index, r, g, b);
+    RecordStateChange(OpenGLCommandType::COLOR_MASKI, index, r, g, b, a);
+}
+
+
+static void APIENTRY Rec_CreateBuffers(GLsizei n, GLuint* pBuffers)
+{
+    GenObjects(n, pBuffers);
+    Record(OpenGLCommandType::CREATE_BUFFERS, n);
+}
+
+
+static void APIENTRY Rec_DeleteBuffers(GLsizei n, const GLuint* pBuffers)
+{
+    Record(OpenGLCommandType::DELETE_BUFFERS, n);
+
+    for (GLsizei i = 0; i < n; ++i) {
+        g_bufferStorages.erase(pBuffers[i]);
+    }
+}
+
+
+static void APIENTRY Rec_NamedBufferStorage(GLuint buffer, GLsizeiptr size, const void* pData, GLbitfield flags)
+{
+    Record(OpenGLCommandType::NAMED_BUFFER_STORAGE, buffer, size, flags);
+
+    std::vector<uint8_t>& storage = g_bufferStorages[buffer];
+    storage.assign(static_cast<size_t>(size), 0);
+
+    if (pData) {
+        memcpy(storage.data(), pData, storage.size());
+    }
+}
+
+
+static void APIENTRY Rec_NamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* pData)
+{
+    Record(OpenGLCommandType::NAMED_BUFFER_SUB_DATA, buffer, offset, size);
+
+    auto storageIt = g_bufferStorages.find(buffer);
+
+    if (pData && storageIt != g_bufferStorages.end() && offset + size <= GLsizeiptr(storageIt->second.size())) {
+        memcpy(storageIt->second.data() + offset, pData, size);
+    }
+}
+
+
+static void APIENTRY Rec_ClearNamedBufferSubData(GLuint buffer, GLenum internalformat, GLintptr offset, GLsizeiptr size, GLenum format, GLenum type, const void* pData)
+{
+    Record(OpenGLCommandType::CLEAR_NAMED_BUFFER_SUB_DATA, buffer, offset, size);
+
+    // Only zero clears are emulated, clear values of other formats aren't decoded
+    auto storageIt = g_bufferStorages.find(buffer);
+
+    if (!pData && storageIt != g_bufferStorages.end() && offset + size <= GLsizeiptr(storageIt->second.size())) {
+        memset(storageIt->second.data() + offset, 0, size);
+    }
+}
+
+
+static void* APIENTRY Rec_MapNamedBuffer(GLuint buffer, GLenum access)
+{
+    Record(OpenGLCommandType::MAP_NAMED_BUFFER, buffer, access);
+
+    auto storageIt = g_bufferStorages.find(buffer);
+    return storageIt != g_bufferStorages.end() ? storageIt->second.data() : nullptr;
+}
+
+
+static void* APIENTRY Rec_MapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    Record(OpenGLCommandType::MAP_NAMED_BUFFER_RANGE, buffer, offset, length, access);
+
+    auto storageIt = g_bufferStorages.find(buffer);
+
+    if (storageIt == g_bufferStorages.end() || offset + length > GLsizeiptr(storageIt->second.size())) {
+        return nullptr;
+    }
+
+    return storageIt->second.data() + offset;
+}
+
+
+static GLboolean APIENTRY Rec_UnmapNamedBuffer(GLuint buffer)
+{
+    Record(OpenGLCommandType::UNMAP_NAMED_BUFFER, buffer);
+    return GL_TRUE;
+}
+
+
+static void APIENTRY Rec_BindBuffer(GLenum target, GLuint buffer)
+{
+    Record(OpenGLCommandType::BIND_BUFFER, target, buffer);
+    RecordStateChange(OpenGLCommandType::BIND_BUFFER, target, buffer);
+}
+
+
+static void APIENTRY Rec_BindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    Record(OpenGLCommandType::BIND_BUFFER_BASE, target, index, buffer);
+    RecordStateChange(OpenGLCommandType::BIND_BUFFER_BASE, (uint64_t(target) << 32ull) | index, buffer);
+}
+
+
+static void APIENTRY Rec_BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    Record(OpenGLCommandType::BIND_BUFFER_RANGE, target, index, buffer, offset);
+    RecordStateChange(OpenGLCommandType::BIND_BUFFER_BASE, (uint64_t(target) << 32ull) | index, buffer, offset, size);
+}
+
+
+// There is no GPU timeline, so fences are signaled right away. Fence handles are just unique non null values
+static GLsync APIENTRY Rec_FenceSync(GLenum condition, GLbitfield flags)
+{
+    Record(OpenGLCommandType::FENCE_SYNC, condition, flags);
+    return reinterpret_cast<GLsync>(static_cast<uintptr_t>(g_nextObjectID++));
+}
+
+
+static GLenum APIENTRY Rec_ClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+{
+    Record(OpenGLCommandType::CLIENT_WAIT_SYNC, sync, flags, timeout);
+    return GL_ALREADY_SIGNALED;
+}
+
+
+static void APIENTRY Rec_DeleteSync(GLsync sync)
+{
+    Record(OpenGLCommandType::DELETE_SYNC, sync);
+}
+
+
+static void APIENTRY Rec_CreateTextures(GLenum target, GLsizei n, GLuint* pTextures)
+{
+    GenObjects(n, pTextures);
+    Record(OpenGLCommandType::CREATE_TEXTURES, target, n);
+}
+
+
+static void APIENTRY Rec_DeleteTextures(GLsizei n, const GLuint* pTextures)
+{
+    Record(OpenGLCommandType::DELETE_TEXTURES, n);
+}
+
+
+static void APIENTRY Rec_TextureStorage2D(GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height)
+{
+    Record(OpenGLCommandType::TEXTURE_STORAGE_2D, texture, levels, internalformat, width);
+}
+
+
+static void APIENTRY Rec_TextureSubImage2D(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+    GLenum format, GLenum type, const void* pPixels)
+{
+    Record(OpenGLCommandType::TEXTURE_SUB_IMAGE_2D, texture, level, width, height);
+}
+
+
+static void APIENTRY Rec_GenerateTextureMipmap(GLuint texture)
+{
+    Record(OpenGLCommandType::GENERATE_TEXTURE_MIPMAP, texture);
+}
+
+
+static void APIENTRY Rec_GetTextureImage(GLuint texture, GLint level, GLenum format, GLenum type, GLsizei bufSize, void* pPixels)
+{
+    Record(OpenGLCommandType::GET_TEXTURE_IMAGE, texture, level, format, type);
+}
+
+
+static void APIENTRY Rec_BindTextureUnit(GLuint unit, GLuint texture)
+{
+    Record(OpenGLCommandType::BIND_TEXTURE_UNIT, unit, texture);
+    RecordStateChange(OpenGLCommandType::BIND_TEXTURE_UNIT, unit, texture);
+}
+
+
+static void APIENTRY Rec_CreateSamplers(GLsizei n, GLuint* pSamplers)
+{
+    GenObjects(n, pSamplers);
+    Record(OpenGLCommandType::CREATE_SAMPLERS, n);
+}
+
+
+static void APIENTRY Rec_DeleteSamplers(GLsizei n, const GLuint* pSamplers)
+{
+    Record(OpenGLCommandType::DELETE_SAMPLERS, n);
+}
+
+
+static void APIENTRY Rec_SamplerParameteri(GLuint sampler, GLenum pname, GLint param)
+{
+    Record(OpenGLCommandType::SAMPLER_PARAMETERI, sampler, pname, param);
+}
+
+
+static void APIENTRY Rec_BindSampler(GLuint unit, GLuint sampler)
+{
+    Record(OpenGLCommandType::BIND_SAMPLER, unit, sampler);
+    RecordStateChange(OpenGLCommandType::BIND_SAMPLER, unit, sampler);
+}
+
+
+static void APIENTRY Rec_CreateFramebuffers(GLsizei n, GLuint* pFramebuffers)
+{
+    GenObjects(n, pFramebuffers);
+    Record(OpenGLCommandType::CREATE_FRAMEBUFFERS, n);
+}
+
+
+static void APIENTRY Rec_DeleteFramebuffers(GLsizei n, const GLuint* pFramebuffers)
+{
+    Record(OpenGLCommandType::DELETE_FRAMEBUFFERS, n);
+}
+
+
+static void APIENTRY Rec_NamedFramebufferTexture(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level)
+{
+    Record(OpenGLCommandType::NAMED_FRAMEBUFFER_TEXTURE, framebuffer, attachment, texture, level);
+}
+
+
+static GLenum APIENTRY Rec_CheckNamedFramebufferStatus(GLuint framebuffer, GLenum target)
+{
+    Record(OpenGLCommandType::CHECK_NAMED_FRAMEBUFFER_STATUS, framebuffer, target);
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+
+static void APIENTRY Rec_BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    Record(OpenGLCommandType::BIND_FRAMEBUFFER, target, framebuffer);
+
+    if (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER) {
+        RecordStateChange(OpenGLCommandType::BIND_FRAMEBUFFER, GL_DRAW_FRAMEBUFFER, framebuffer);
+        g_boundDrawFramebuffer = framebuffer;
+    }
+
+    if (target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER) {
+        RecordStateChange(OpenGLCommandType::BIND_FRAMEBUFFER, GL_READ_FRAMEBUFFER, framebuffer);
+    }
+}
+
+
+static void APIENTRY Rec_DrawBuffers(GLsizei n, const GLenum* pBufs)
+{
+    Record(OpenGLCommandType::DRAW_BUFFERS, n);
+
+    // Draw buffers are the state of the bound draw framebuffer, two buffer enums are packed per value
+    OpenGLStateValue bufs = {};
+    for (GLsizei i = 0; i < std::min<GLsizei>(n, 2 * static_cast<GLsizei>(bufs.size())); ++i) {
+        bufs[i / 2] |= uint64_t(pBufs[i]) << (32ull * (i % 2));
+    }
+
+    RecordStateChange(OpenGLCommandType::DRAW_BUFFERS, g_boundDrawFramebuffer, bufs[0], bufs[1], bufs[2], bufs[3]);
+}
+
+
+static void APIENTRY Rec_ClearNamedFramebufferfv(GLuint framebuffer, GLenum buffer, GLint drawbuffer, const GLfloat* pValue)
+{
+    Record(OpenGLCommandType::CLEAR_NAMED_FRAMEBUFFERFV, framebuffer, buffer, drawbuffer);
+}
+
+
+static void APIENTRY Rec_ClearNamedFramebufferiv(GLuint framebuffer, GLenum buffer, GLint drawbuffer, const GLint* pValue)
+{
+    Record(OpenGLCommandType::CLEAR_NAMED_FRAMEBUFFERIV, framebuffer, buffer, drawbuffer);
+}
+
+
+static void APIENTRY Rec_ClearNamedFramebufferfi(GLuint framebuffer, GLenum buffer, GLint drawbuffer, GLfloat depth, GLint stencil)
+{
+    Record(OpenGLCommandType::CLEAR_NAMED_FRAMEBUFFERFI, framebuffer, buffer, drawbuffer, depth);
+}
+
+
+static void APIENTRY Rec_BlitNamedFramebuffer(GLuint readFramebuffer, GLuint drawFramebuffer, GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+    GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)
+{
+    Record(OpenGLCommandType::BLIT_NAMED_FRAMEBUFFER, readFramebuffer, drawFramebuffer, mask, filter);
+}
+
+
+static void APIENTRY Rec_CreateVertexArrays(GLsizei n, GLuint* pArrays)
+{
+    GenObjects(n, pArrays);
+    Record(OpenGLCommandType::CREATE_VERTEX_ARRAYS, n);
+}
+
+
+static void APIENTRY Rec_DeleteVertexArrays(GLsizei n, const GLuint* pArrays)
+{
+    Record(OpenGLCommandType::DELETE_VERTEX_ARRAYS, n);
+}
+
+
+static void APIENTRY Rec_VertexArrayVertexBuffer(GLuint vaobj, GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride)
+{
+    Record(OpenGLCommandType::VERTEX_ARRAY_VERTEX_BUFFER, vaobj, bindingindex, buffer, offset);
+}
+
+
+static void APIENTRY Rec_VertexArrayElementBuffer(GLuint vaobj, GLuint buffer)
+{
+    Record(OpenGLCommandType::VERTEX_ARRAY_ELEMENT_BUFFER, vaobj, buffer);
+}
+
+
+static void APIENTRY Rec_VertexArrayAttribFormat(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset)
+{
+    Record(OpenGLCommandType::VERTEX_ARRAY_ATTRIB_FORMAT, vaobj, attribindex, size, type);
+}
+
+
+static void APIENTRY Rec_VertexArrayAttribBinding(GLuint vaobj, GLuint attribindex, GLuint bindingindex)
+{
+    Record(OpenGLCommandType::VERTEX_ARRAY_ATTRIB_BINDING, vaobj, attribindex, bindingindex);
+}
+
+
+static void APIENTRY Rec_EnableVertexArrayAttrib(GLuint vaobj, GLuint index)
+{
+    Record(OpenGLCommandType::ENABLE_VERTEX_ARRAY_ATTRIB, vaobj, index);
+}
+
+
+static void APIENTRY Rec_BindVertexArray(GLuint array)
+{
+    Record(OpenGLCommandType::BIND_VERTEX_ARRAY, array);
+    RecordStateChange(OpenGLCommandType::BIND_VERTEX_ARRAY, 0, array);
+}
+
+
+static GLuint APIENTRY Rec_CreateShader(GLenum type)
+{
+    Record(OpenGLCommandType::CREATE_SHADER, type);
+    return g_nextObjectID++;
+}
+
+
+static void APIENTRY Rec_DeleteShader(GLuint shader)
+{
+    Record(OpenGLCommandType::DELETE_SHADER, shader);
+}
+
+
+static void APIENTRY Rec_ShaderSource(GLuint shader, GLsizei count, const GLchar* const* pString, const GLint* pLength)
+{
+    Record(OpenGLCommandType::SHADER_SOURCE, shader, count);
+}
+
+
+static void APIENTRY Rec_CompileShader(GLuint shader)
+{
+    Record(OpenGLCommandType::COMPILE_SHADER, shader);
+}
+
+
+static void APIENTRY Rec_GetShaderiv(GLuint shader, GLenum pname, GLint* pParams)
+{
+    Record(OpenGLCommandType::GET_SHADERIV, shader, pname);
+    pParams[0] = pname == GL_INFO_LOG_LENGTH ? 0 : GL_TRUE;
+}
+
+
+static void APIENTRY Rec_GetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* pLength, GLchar* pInfoLog)
+{
+    Record(OpenGLCommandType::GET_SHADER_INFO_LOG, shader);
+
+    if (pLength) {
+        *pLength = 0;
+    }
+
+    if (pInfoLog && bufSize > 0) {
+        pInfoLog[0] = '\0';
+    }
+}
+
+
+static GLuint APIENTRY Rec_CreateProgram()
+{
+    Record(OpenGLCommandType::CREATE_PROGRAM);
+    return g_nextObjectID++;
+}
+
+
+static void APIENTRY Rec_DeleteProgram(GLuint program)
+{
+    Record(OpenGLCommandType::DELETE_PROGRAM, program);
+}
+
+
+static void APIENTRY Rec_AttachShader(GLuint program, GLuint shader)
+{
+    Record(OpenGLCommandType::ATTACH_SHADER, program, shader);
+}
+
+
+static void APIENTRY Rec_LinkProgram(GLuint program)
+{
+    Record(OpenGLCommandType::LINK_PROGRAM, program);
+}
+
+
+static void APIENTRY Rec_ValidateProgram(GLuint program)
+{
+    Record(OpenGLCommandType::VALIDATE_PROGRAM, program);
+}
+
+
+static void APIENTRY Rec_GetProgramiv(GLuint program, GLenum pname, GLint* pParams)
+{
+    Record(OpenGLCommandType::GET_PROGRAMIV, program, pname);
+    pParams[0] = pname == GL_INFO_LOG_LENGTH ? 0 : GL_TRUE;
+}
+
+
+static void APIENTRY Rec_GetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* pLength, GLchar* pInfoLog)
+{
+    Record(OpenGLCommandType::GET_PROGRAM_INFO_LOG, program);
+
+    if (pLength) {
+        *pLength = 0;
+    }
+
+    if (pInfoLog && bufSize > 0) {
+        pInfoLog[0] = '\0';
+    }
+}
+
+
+static void APIENTRY Rec_UseProgram(GLuint program)
+{
+    Record(OpenGLCommandType::USE_PROGRAM, program);
+    RecordStateChange(OpenGLCommandType::USE_PROGRAM, 0, program);
+}
+
+
+static void APIENTRY Rec_ProgramUniform1i(GLuint program, GLint location, GLint v0)
+{
+    Record(OpenGLCommandType::PROGRAM_UNIFORM_1I, program, location, v0);
+}
+
+
+static void APIENTRY Rec_ProgramUniform1ui(GLuint program, GLint location, GLuint v0)
+{
+    Record(OpenGLCommandType::PROGRAM_UNIFORM_1UI, program, location, v0);
+}
+
+
+static void APIENTRY Rec_ProgramUniform1f(GLuint program, GLint location, GLfloat v0)
+{
+    Record(OpenGLCommandType::PROGRAM_UNIFORM_1F, program, location, v0);
+}
+
+
+static void APIENTRY Rec_ProgramUniform1d(GLuint program, GLint location, GLdouble v0)
+{
+    Record(OpenGLCommandType::PROGRAM_UNIFORM_1D, program, location, v0);
+}
+
+
+static void APIENTRY Rec_DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+{
+    Record(OpenGLCommandType::DRAW_ARRAYS_INSTANCED, mode, first, count, instancecount);
+    ++g_stats.drawCallsCount;
+}
+
+
+static void APIENTRY Rec_DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* pIndices, GLsizei instancecount)
+{
+    Record(OpenGLCommandType::DRAW_ELEMENTS_INSTANCED, mode, count, type, instancecount);
+    ++g_stats.drawCallsCount;
+}
+
+
+static void APIENTRY Rec_DrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* pIndices, GLsizei instancecount, GLint basevertex)
+{
+    Record(OpenGLCommandType::DRAW_ELEMENTS_INSTANCED_BASE_VERTEX, mode, count, type, instancecount, basevertex);
+    ++g_stats.drawCallsCount;
+}
+
+
+static void APIENTRY Rec_MultiDrawElementsIndirect(GLenum mode, GLenum type, const void* pIndirect, GLsizei drawcount, GLsizei stride)
+{
+    Record(OpenGLCommandType::MULTI_DRAW_ELEMENTS_INDIRECT, mode, type, drawcount, stride);
+    ++g_stats.drawCallsCount;
+}
+
+
+void engInstallOpenGLRecordingBackend() noexcept
+{
+    if (engIsOpenGLRecordingBackendInstalled()) {
+        ENG_LOG_GRAPHICS_API_WARN("OpenGL recording backend is already installed!");
+        return;
+    }
+
+#define ENG_GL_INSTALL_RECORDING_FUNC(type, func) glad_gl##func = &Rec_##func;
+    ENG_GL_RECORDED_COMMANDS_LIST(ENG_GL_INSTALL_RECORDING_FUNC)
+#undef ENG_GL_INSTALL_RECORDING_FUNC
+
+    g_shadowState.clear();
+    g_bufferStorages.clear();
+    g_nextObjectID = 1;
+    g_boundDrawFramebuffer = 0;
+
+    engResetOpenGLRecording();
+
+    g_isInstalled = true;
+}
+
+
+bool engIsOpenGLRecordingBackendInstalled() noexcept
+{
+    return g_isInstalled;
+}
+
+
+void engResetOpenGLRecording() noexcept
+{
+    g_commands.clear();
+    g_stats = {};
+}
+
+
+const std::vector<OpenGLRecordedCommand>& engGetOpenGLRecordedCommands() noexcept
+{
+    return g_commands;
+}
+
+
+const OpenGLRecordingStats& engGetOpenGLRecordingStats() noexcept
+{
+    return g_stats;
+}
+
+
+const char* engGetOpenGLCommandName(OpenGLCommandType type) noexcept
+{
+    switch (type) {
+    #define ENG_GL_COMMAND_NAME_CASE(type, func) case OpenGLCommandType::type: return "gl" #func;
+        ENG_GL_RECORDED_COMMANDS_LIST(ENG_GL_COMMAND_NAME_CASE)
+    #undef ENG_GL_COMMAND_NAME_CASE
+        default:
+            ENG_ASSERT_GRAPHICS_API_FAIL("Invalid OpenGL command type: {}", static_cast<uint32_t>(type));
+            return "UNKNOWN";
+    }
+}
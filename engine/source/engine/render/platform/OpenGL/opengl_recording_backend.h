@@ -0,0 +1,144 @@
+#pragma once
+
+#include <vector>
+#include <array>
+
+#include <cstdint>
+
+
+// Headless OpenGL backend. It replaces glad function pointers with stubs which record calls into a command log
+// and count state changes, so the render path can run and be profiled without a GL context.
+// Enabled by ENG_GL_RECORDING_BACKEND define, engInitOpenGLDriver() installs it instead of loading the real driver
+
+#define ENG_GL_RECORDED_COMMANDS_LIST(X)                            \
+    X(ENABLE, Enable)                                               \
+    X(DISABLE, Disable)                                             \
+    X(ENABLEI, Enablei)                                             \
+    X(DISABLEI, Disablei)                                           \
+    X(GET_INTEGERV, GetIntegerv)                                    \
+    X(GET_INTEGERI_V, GetIntegeri_v)                                \
+    X(GET_FLOATV, GetFloatv)                                        \
+    X(GET_STRING, GetString)                                        \
+    X(DEBUG_MESSAGE_CALLBACK, DebugMessageCallback)                 \
+    X(CLIP_CONTROL, ClipControl)                                    \
+    X(VIEWPORT, Viewport)                                           \
+    X(CULL_FACE, CullFace)                                          \
+    X(FRONT_FACE, FrontFace)                                        \
+    X(LINE_WIDTH, LineWidth)                                        \
+    X(POLYGON_OFFSET_CLAMP, PolygonOffsetClamp)                     \
+    X(DEPTH_MASK, DepthMask)                                        \
+    X(DEPTH_FUNC, DepthFunc)                                        \
+    X(STENCIL_MASK_SEPARATE, StencilMaskSeparate)                   \
+    X(STENCIL_OP_SEPARATE, StencilOpSeparate)                       \
+    X(LOGIC_OP, LogicOp)                                            \
+    X(BLEND_COLOR, BlendColor)                                      \
+    X(BLEND_EQUATION_SEPARATEI, BlendEquationSeparatei)             \
+    X(BLEND_FUNC_SEPARATEI, BlendFuncSeparatei)                     \
+    X(COLOR_MASKI, ColorMaski)                                      \
+    X(CREATE_BUFFERS, CreateBuffers)                                \
+    X(DELETE_BUFFERS, DeleteBuffers)                                \
+    X(NAMED_BUFFER_STORAGE, NamedBufferStorage)                     \
+    X(NAMED_BUFFER_SUB_DATA, NamedBufferSubData)                    \
+    X(CLEAR_NAMED_BUFFER_SUB_DATA, ClearNamedBufferSubData)         \
+    X(MAP_NAMED_BUFFER, MapNamedBuffer)                             \
+    X(MAP_NAMED_BUFFER_RANGE, MapNamedBufferRange)                  \
+    X(UNMAP_NAMED_BUFFER, UnmapNamedBuffer)                         \
+    X(BIND_BUFFER, BindBuffer)                                      \
+    X(BIND_BUFFER_BASE, BindBufferBase)                             \
+    X(BIND_BUFFER_RANGE, BindBufferRange)                           \
+    X(FENCE_SYNC, FenceSync)                                        \
+    X(CLIENT_WAIT_SYNC, ClientWaitSync)                             \
+    X(DELETE_SYNC, DeleteSync)                                      \
+    X(CREATE_TEXTURES, CreateTextures)                              \
+    X(DELETE_TEXTURES, DeleteTextures)                              \
+    X(TEXTURE_STORAGE_2D, TextureStorage2D)                         \
+    X(TEXTURE_SUB_IMAGE_2D, TextureSubImage2D)                      \
+    X(GENERATE_TEXTURE_MIPMAP, GenerateTextureMipmap)               \
+    X(GET_TEXTURE_IMAGE, GetTextureImage)                           \
+    X(BIND_TEXTURE_UNIT, BindTextureUnit)                           \
+    X(CREATE_SAMPLERS, CreateSamplers)                              \
+    X(DELETE_SAMPLERS, DeleteSamplers)                              \
+    X(SAMPLER_PARAMETERI, SamplerParameteri)                        \
+    X(BIND_SAMPLER, BindSampler)                                    \
+    X(CREATE_FRAMEBUFFERS, CreateFramebuffers)                      \
+    X(DELETE_FRAMEBUFFERS, DeleteFramebuffers)                      \
+    X(NAMED_FRAMEBUFFER_TEXTURE, NamedFramebufferTexture)           \
+    X(CHECK_NAMED_FRAMEBUFFER_STATUS, CheckNamedFramebufferStatus)  \
+    X(BIND_FRAMEBUFFER, BindFramebuffer)                            \
+    X(DRAW_BUFFERS, DrawBuffers)                                    \
+    X(CLEAR_NAMED_FRAMEBUFFERFV, ClearNamedFramebufferfv)           \
+    X(CLEAR_NAMED_FRAMEBUFFERIV, ClearNamedFramebufferiv)           \
+    X(CLEAR_NAMED_FRAMEBUFFERFI, ClearNamedFramebufferfi)           \
+    X(BLIT_NAMED_FRAMEBUFFER, BlitNamedFramebuffer)                 \
+    X(CREATE_VERTEX_ARRAYS, CreateVertexArrays)                     \
+    X(DELETE_VERTEX_ARRAYS, DeleteVertexArrays)                     \
+    X(VERTEX_ARRAY_VERTEX_BUFFER, VertexArrayVertexBuffer)          \
+    X(VERTEX_ARRAY_ELEMENT_BUFFER, VertexArrayElementBuffer)        \
+    X(VERTEX_ARRAY_ATTRIB_FORMAT, VertexArrayAttribFormat)          \
+    X(VERTEX_ARRAY_ATTRIB_BINDING, VertexArrayAttribBinding)        \
+    X(ENABLE_VERTEX_ARRAY_ATTRIB, EnableVertexArrayAttrib)          \
+    X(BIND_VERTEX_ARRAY, BindVertexArray)                           \
+    X(CREATE_SHADER, CreateShader)                                  \
+    X(DELETE_SHADER, DeleteShader)                                  \
+    X(SHADER_SOURCE, ShaderSource)                                  \
+    X(COMPILE_SHADER, CompileShader)                                \
+    X(GET_SHADERIV, GetShaderiv)                                    \
+    X(GET_SHADER_INFO_LOG, GetShaderInfoLog)                        \
+    X(CREATE_PROGRAM, CreateProgram)                                \
+    X(DELETE_PROGRAM, DeleteProgram)                                \
+    X(ATTACH_SHADER, AttachShader)                                  \
+    X(LINK_PROGRAM, LinkProgram)                                    \
+    X(VALIDATE_PROGRAM, ValidateProgram)                            \
+    X(GET_PROGRAMIV, GetProgramiv)                                  \
+    X(GET_PROGRAM_INFO_LOG, GetProgramInfoLog)                      \
+    X(USE_PROGRAM, UseProgram)                                      \
+    X(PROGRAM_UNIFORM_1I, ProgramUniform1i)                         \
+    X(PROGRAM_UNIFORM_1UI, ProgramUniform1ui)                       \
+    X(PROGRAM_UNIFORM_1F, ProgramUniform1f)                         \
+    X(PROGRAM_UNIFORM_1D, ProgramUniform1d)                         \
+    X(DRAW_ARRAYS_INSTANCED, DrawArraysInstanced)                   \
+    X(DRAW_ELEMENTS_INSTANCED, DrawElementsInstanced)               \
+    X(DRAW_ELEMENTS_INSTANCED_BASE_VERTEX, DrawElementsInstancedBaseVertex) \
+    X(MULTI_DRAW_ELEMENTS_INDIRECT, MultiDrawElementsIndirect)
+
+
+enum class OpenGLCommandType : uint16_t
+{
+#define ENG_GL_DECLARE_COMMAND_TYPE(type, func) type,
+    ENG_GL_RECORDED_COMMANDS_LIST(ENG_GL_DECLARE_COMMAND_TYPE)
+#undef ENG_GL_DECLARE_COMMAND_TYPE
+
+    COUNT
+};
+
+
+struct OpenGLRecordedCommand
+{
+    // Leading arguments of the call as raw 64 bit values (floats are bit casted), the rest are dropped
+    std::array<uint64_t, 4> args;
+    OpenGLCommandType type;
+};
+
+
+struct OpenGLRecordingStats
+{
+    std::array<uint32_t, static_cast<size_t>(OpenGLCommandType::COUNT)> commandCounts;
+
+    uint32_t commandsCount;
+    uint32_t drawCallsCount;
+    uint32_t stateChangesCount;
+    // State changes which set the same value which is already set
+    uint32_t redundantStateChangesCount;
+};
+
+
+void engInstallOpenGLRecordingBackend() noexcept;
+bool engIsOpenGLRecordingBackendInstalled() noexcept;
+
+// Clears command log and stats. Shadowed GL state and created objects are kept, so redundant state changes are tracked across frames
+void engResetOpenGLRecording() noexcept;
+
+const std::vector<OpenGLRecordedCommand>& engGetOpenGLRecordedCommands() noexcept;
+const OpenGLRecordingStats& engGetOpenGLRecordingStats() noexcept;
+
+const char* engGetOpenGLCommandName(OpenGLCommandType type) noexcept;
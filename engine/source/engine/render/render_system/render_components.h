@@ -0,0 +1,54 @@
+#pragma once
+
+#include "core/scene/scene_graph.h"
+#include "core/spatial/dynamic_bvh.h"
+
+#include "render/command_list/command_list.h"
+
+#include "utils/math/common_math.h"
+
+#include "core.h"
+
+#include <cstdint>
+
+
+class MeshObj;
+struct DrawMaterial;
+
+
+// ECS components of renderable entities
+
+
+// Copy of the scene node world matrix, synced after the scene graph update
+struct TransformComponent
+{
+    glm::mat4x4 worldMatrix = M3D_MAT4_IDENTITY;
+    SceneNodeID nodeID;
+};
+
+
+struct MeshRefComponent
+{
+    const MeshObj* pMesh = nullptr;
+    uint32_t       first = 0;
+    uint32_t       count = 0;
+    DrawIndexType  indexType = DrawIndexType::INDEX_TYPE_UINT32;
+};
+
+
+struct MaterialRefComponent
+{
+    const DrawMaterial* pMaterial = nullptr;
+};
+
+
+// Bounding sphere in local space and its world space version, synced together with the transform.
+// The world sphere AABB is a proxy of the scene BVH, created by the render system on the first sync
+struct BoundsComponent
+{
+    glm::vec3  localCenter = M3D_ZEROF3;
+    float      localRadius = 0.f;
+    glm::vec3  worldCenter = M3D_ZEROF3;
+    float      worldRadius = 0.f;
+    BVHProxyID bvhProxyID;
+};
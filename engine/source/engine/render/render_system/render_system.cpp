@@ -9,25 +9,50 @@
 #include "render/pipeline_manager/pipeline_mng.h"
 #include "render/mem_manager/buffer_manager.h"
 #include "render/mesh_manager/mesh_manager.h"
+#include "render/render_system/render_components.h"
 
 #include "core/camera/camera_manager.h"
 #include "core/window_system/window_system.h"
+#include "core/job_system/job_system.h"
 
 #include "utils/file/file.h"
+#include "utils/file/async_file_reader.h"
 #include "utils/debug/assertion.h"
 #include "utils/timer/timer.h"
 
 #include "render/platform/OpenGL/opengl_driver.h"
+#include "render/platform/OpenGL/opengl_recording_backend.h"
 
 #include "auto/auto_registers_common.h"
 
 
 static std::unique_ptr<RenderSystem> pRenderSysInst = nullptr;
 
+// Per frame budget for dynamic constants, enough for a few thousands of per object constant blocks
+static constexpr uint64_t CONST_RING_BUFFER_FRAME_SIZE = 1024 * 1024;
+// Enough for tens of thousands of instances of COMMON_DRAW_DATA
+static constexpr uint64_t STORAGE_RING_BUFFER_FRAME_SIZE = 4 * 1024 * 1024;
+
+static constexpr uint32_t GBUFFER_DRAW_BATCH_MAX_DRAWS_COUNT = 64 * 1024;
+
+static constexpr uint32_t SCENE_INITIAL_OBJECTS_COUNT = 1024;
+
 
 #define INIT_CALL(CALL, ...) if (!CALL(__VA_ARGS__)) { return false; } 
 
 
+// Main window is optional, there is none when the render system runs headless on the recording backend
+static Window* FindMainWindow() noexcept
+{
+    if (!engIsWindowSystemInitialized()) {
+        return nullptr;
+    }
+
+    Window* pWindow = WindowSystem::GetInstance().GetWindowByTag(WINDOW_TAG_MAIN);
+    return pWindow && pWindow->IsInitialized() ? pWindow : nullptr;
+}
+
+
 RenderSystem& RenderSystem::GetInstance() noexcept
 {
     ENG_ASSERT(engIsRenderSystemInitialized(), "Render system is not initialized");
@@ -37,18 +62,29 @@ RenderSystem& RenderSystem::GetInstance() noexcept
 
 void RenderSystem::BeginFrame() noexcept
 {
+    PipelineManager::GetInstance().ResetBindStats();
+
+    m_constRingBuffer.BeginFrame();
+    m_storageRingBuffer.BeginFrame();
+
+#if defined(ENG_GL_RECORDING_BACKEND)
+    // Command log and stats describe a single frame
+    engResetOpenGLRecording();
+#endif
 }
 
 
 void RenderSystem::EndFrame() noexcept
 {
-
+    m_constRingBuffer.EndFrame();
+    m_storageRingBuffer.EndFrame();
 }
 
 
 void RenderSystem::RunDepthPrepass() noexcept
 {
-
+    // There is no depth prepass geometry yet, previous frames depth feeds occlusion culling of this one
+    m_occlusionCuller.Update();
 }
 
 
@@ -63,24 +99,23 @@ void RenderSystem::RunColorPass() noexcept
     static Timer timer;
     timer.Tick();
 
-    static Window& window = engGetMainWindow();
-    static Input& input = window.GetInput();
-    static TextureManager& texManager = TextureManager::GetInstance();
-    static ShaderManager& shaderManager = ShaderManager::GetInstance();
-    static RenderTargetManager& rtManager = RenderTargetManager::GetInstance();
-    static PipelineManager& pipelineManager = PipelineManager::GetInstance();
-    static MemoryBufferManager& memBufferManager = MemoryBufferManager::GetInstance();
-    static MeshDataManager& meshDataManager = MeshDataManager::GetInstance();
-    static MeshManager& meshManager = MeshManager::GetInstance();
+    Window* pWindow = FindMainWindow();
+    // Render managers are recreated by Init(), so they can't be cached across a Terminate()
+    TextureManager& texManager = TextureManager::GetInstance();
+    ShaderManager& shaderManager = ShaderManager::GetInstance();
+    RenderTargetManager& rtManager = RenderTargetManager::GetInstance();
+    PipelineManager& pipelineManager = PipelineManager::GetInstance();
+    MeshDataManager& meshDataManager = MeshDataManager::GetInstance();
+    MeshManager& meshManager = MeshManager::GetInstance();
     static CameraManager& cameraManager = CameraManager::GetInstance();
 
-    static bool isInitialized = false;
     static ShaderProgram* pGBufferProgram = nullptr;
     static ShaderProgram* pPostProcProgram = nullptr;
 
     static Texture* pTestTexture = nullptr;
     static TextureSamplerState* pTestTextureSampler = nullptr;
 
+    static MeshGPUBufferData* pCubeBufferData = nullptr;
     static MeshObj* pCubeMeshObj = nullptr;
 
     static Texture* pGBufferAlbedoTex = nullptr;
@@ -95,12 +130,60 @@ void RenderSystem::RunColorPass() noexcept
     static Pipeline* pGBufferPipeline = nullptr;
     static Pipeline* pPostProcPipeline = nullptr;
 
-    static MemoryBuffer* pCommonConstBuffer = nullptr;
-    static MemoryBuffer* pCameraConstBuffer = nullptr;
-
     static Camera* pMainCam = nullptr;
 
-    if (!isInitialized) {
+    static DrawMaterial gBufferMaterial = {};
+    static DrawMaterial postProcMaterial = {};
+
+    if (!m_isSceneCreated) {
+        constexpr size_t texWidth = 256;
+        constexpr size_t texWidthDiv2 = texWidth / 2;
+        constexpr size_t texHeight = 256;
+        constexpr size_t texHeightDiv2 = texHeight / 2;
+        constexpr size_t texSizeInPixels = texWidth * texHeight;
+        constexpr size_t texComponentsCount = 4;
+        constexpr size_t texSizeInBytes = texSizeInPixels * texComponentsCount;
+        
+        static constexpr uint8_t texColors[4][4] = {
+            { 255,   0,   0, 255 },
+            {   0, 255,   0, 255 },
+            {   0,   0, 255, 255 },
+            {   255, 0, 255, 255 },
+        };
+
+        uint8_t pTexData[texSizeInBytes] = {};
+
+        // Shader sources are read on IO threads meanwhile
+        AsyncFileReader& fileReader = AsyncFileReader::GetInstance();
+
+        FileReadResult vsSourceCode;
+        FileReadResult psSourceCode;
+
+        fileReader.ReadAsync(ENG_ENGINE_DIR "/source/shaders/source/base/base.vs", [&vsSourceCode](FileReadResult& result) {
+            vsSourceCode = std::move(result);
+        }, FileReadPriority::HIGH);
+
+        fileReader.ReadAsync(ENG_ENGINE_DIR "/source/shaders/source/base/base.fs", [&psSourceCode](FileReadResult& result) {
+            psSourceCode = std::move(result);
+        }, FileReadPriority::HIGH);
+
+        // Test texture rows are filled by jobs while shaders are being created
+        JobSystem& jobSystem = JobSystem::GetInstance();
+        JobCounter texDataCounter;
+
+        jobSystem.ParallelFor(static_cast<uint32_t>(texHeight), 32, [pTexRows = &pTexData[0]](uint32_t y) {
+            for (size_t x = 0; x < texWidth; ++x) {
+                const size_t colorIdx = (y / (texHeightDiv2 - 1) + ((y / (texHeightDiv2 - 1)) % 2)) + x / texWidthDiv2;
+
+                const size_t pixelIdx = (y * texWidth + x);
+
+                pTexRows[texComponentsCount * pixelIdx + 0] = texColors[colorIdx][0];
+                pTexRows[texComponentsCount * pixelIdx + 1] = texColors[colorIdx][1];
+                pTexRows[texComponentsCount * pixelIdx + 2] = texColors[colorIdx][2];
+                pTexRows[texComponentsCount * pixelIdx + 3] = texColors[colorIdx][3];
+            }
+        }, texDataCounter);
+
         static constexpr const char* SHADER_INCLUDE_DIR = ENG_ENGINE_DIR "/source/shaders/include";
         static const char* GBUFFER_DEFINES[] = {
         #if defined(ENG_DEBUG)
@@ -109,13 +192,15 @@ void RenderSystem::RunColorPass() noexcept
             "PASS_GBUFFER"
         };
 
+        fileReader.WaitAll();
+        ENG_ASSERT(vsSourceCode.isSucceeded && psSourceCode.isSucceeded, "Failed to read base shader sources");
+
         ShaderStageCreateInfo vsStageCreateInfo = {};
 
         vsStageCreateInfo.type = ShaderStageType::VERTEX;
 
-        const std::vector<char> vsSourceCode = ReadTextFile(ENG_ENGINE_DIR "/source/shaders/source/base/base.vs");
-        vsStageCreateInfo.pSourceCode = vsSourceCode.data();
-        vsStageCreateInfo.codeSize = vsSourceCode.size();
+        vsStageCreateInfo.pSourceCode = reinterpret_cast<const char*>(vsSourceCode.pData.get());
+        vsStageCreateInfo.codeSize = vsSourceCode.dataSize;
 
         vsStageCreateInfo.pDefines = GBUFFER_DEFINES;
         vsStageCreateInfo.definesCount = _countof(GBUFFER_DEFINES);
@@ -127,9 +212,8 @@ void RenderSystem::RunColorPass() noexcept
 
         psStageCreateInfo.type = ShaderStageType::PIXEL;
 
-        const std::vector<char> psSourceCode = ReadTextFile(ENG_ENGINE_DIR "/source/shaders/source/base/base.fs");
-        psStageCreateInfo.pSourceCode = psSourceCode.data();
-        psStageCreateInfo.codeSize = psSourceCode.size();
+        psStageCreateInfo.pSourceCode = reinterpret_cast<const char*>(psSourceCode.pData.get());
+        psStageCreateInfo.codeSize = psSourceCode.dataSize;
 
         psStageCreateInfo.pDefines = GBUFFER_DEFINES;
         psStageCreateInfo.definesCount = _countof(GBUFFER_DEFINES);
@@ -175,34 +259,7 @@ void RenderSystem::RunColorPass() noexcept
         pPostProcProgram->SetDebugName("Pass_Post_Process");
 
 
-        constexpr size_t texWidth = 256;
-        constexpr size_t texWidthDiv2 = texWidth / 2;
-        constexpr size_t texHeight = 256;
-        constexpr size_t texHeightDiv2 = texHeight / 2;
-        constexpr size_t texSizeInPixels = texWidth * texHeight;
-        constexpr size_t texComponentsCount = 4;
-        constexpr size_t texSizeInBytes = texSizeInPixels * texComponentsCount;
-        
-        constexpr uint8_t texColors[4][4] = {
-            { 255,   0,   0, 255 },
-            {   0, 255,   0, 255 },
-            {   0,   0, 255, 255 },
-            {   255, 0, 255, 255 },
-        };
-
-        uint8_t pTexData[texSizeInBytes] = {};
-        for (size_t y = 0; y < texHeight; ++y) {
-            for (size_t x = 0; x < texWidth; ++x) {
-                const size_t colorIdx = (y / (texHeightDiv2 - 1) + ((y / (texHeightDiv2 - 1)) % 2)) + x / texWidthDiv2;
-
-                const size_t pixelIdx = (y * texWidth + x);
-
-                pTexData[texComponentsCount * pixelIdx + 0] = texColors[colorIdx][0];
-                pTexData[texComponentsCount * pixelIdx + 1] = texColors[colorIdx][1];
-                pTexData[texComponentsCount * pixelIdx + 2] = texColors[colorIdx][2];
-                pTexData[texComponentsCount * pixelIdx + 3] = texColors[colorIdx][3];
-            }
-        }
+        jobSystem.Wait(texDataCounter);
 
         Texture2DCreateInfo texCreateInfo = {};
         texCreateInfo.format = resGetTexResourceFormat(TEST_TEXTURE);
@@ -214,7 +271,7 @@ void RenderSystem::RunColorPass() noexcept
 
         texCreateInfo.inputData.pData = pTexData;
 
-        ds::StrID testTexName = "TEST_TEXTURE";
+        ds::StrID testTexName = "TEST_TEXTURE"_sid;
         pTestTexture = texManager.RegisterTexture2D(testTexName);
         ENG_ASSERT(pTestTexture, "Failed to register texture: {}", testTexName.CStr());
         pTestTexture->Create(texCreateInfo);
@@ -232,6 +289,25 @@ void RenderSystem::RunColorPass() noexcept
         pGBufferSpecSampler = texManager.GetSampler(resGetTexResourceSamplerIdx(GBUFFER_SPECULAR_TEX));
         pGBufferDepthSampler = texManager.GetSampler(resGetTexResourceSamplerIdx(COMMON_DEPTH_TEX));
 
+        gBufferMaterial.pTextures[0] = pTestTexture;
+        gBufferMaterial.pSamplers[0] = pTestTextureSampler;
+        gBufferMaterial.units[0] = resGetResourceBinding(TEST_TEXTURE).GetBinding();
+        gBufferMaterial.texturesCount = 1;
+
+        postProcMaterial.pTextures[0] = pGBufferAlbedoTex;
+        postProcMaterial.pSamplers[0] = pGBufferAlbedoSampler;
+        postProcMaterial.units[0] = resGetResourceBinding(GBUFFER_ALBEDO_TEX).GetBinding();
+        postProcMaterial.pTextures[1] = pGBufferNormalTex;
+        postProcMaterial.pSamplers[1] = pGBufferNormalSampler;
+        postProcMaterial.units[1] = resGetResourceBinding(GBUFFER_NORMAL_TEX).GetBinding();
+        postProcMaterial.pTextures[2] = pGBufferSpecTex;
+        postProcMaterial.pSamplers[2] = pGBufferSpecSampler;
+        postProcMaterial.units[2] = resGetResourceBinding(GBUFFER_SPECULAR_TEX).GetBinding();
+        postProcMaterial.pTextures[3] = pCommonDepthTex;
+        postProcMaterial.pSamplers[3] = pGBufferDepthSampler;
+        postProcMaterial.units[3] = resGetResourceBinding(COMMON_DEPTH_TEX).GetBinding();
+        postProcMaterial.texturesCount = 4;
+
 
         InputAssemblyStateCreateInfo gBufferInputAssemblyState = {};
         gBufferInputAssemblyState.topology = PrimitiveTopology::TOPOLOGY_TRIANGLES;
@@ -343,7 +419,7 @@ void RenderSystem::RunColorPass() noexcept
         MeshVertexLayout* pCubeVertexLayout = meshDataManager.RegisterVertexLayout(cubeVertexLayoutCreateInfo);
         ENG_ASSERT(pCubeVertexLayout && pCubeVertexLayout->IsValid(), "Failed to register cube mesh vertex layout");
 
-        MeshGPUBufferData* pCubeBufferData = meshDataManager.RegisterGPUBufferData("cube");
+        pCubeBufferData = meshDataManager.RegisterGPUBufferData("cube"_sid);
         ENG_ASSERT(pCubeBufferData, "Failed to register cube mesh GPU data");
 
         constexpr float CUBE_HALF_SIZE = 0.5f;
@@ -403,45 +479,36 @@ void RenderSystem::RunColorPass() noexcept
         cubeGPUDataCreateInfo.pIndexData = cubeIndices;
         cubeGPUDataCreateInfo.indexDataSize = sizeof(cubeIndices);
         cubeGPUDataCreateInfo.indexSize = sizeof(cubeIndices[0]);
+        cubeGPUDataCreateInfo.pVertexLayout = pCubeVertexLayout;
+        cubeGPUDataCreateInfo.keepOccluderCopy = true;
+        cubeGPUDataCreateInfo.occluderPositionOffset = 0;
 
         pCubeBufferData->Create(cubeGPUDataCreateInfo);
 
-        pCubeMeshObj = meshManager.RegisterMeshObj("cube");
+        pCubeMeshObj = meshManager.RegisterMeshObj("cube"_sid);
         ENG_ASSERT(pCubeMeshObj, "Failed to register cube mesh object");
         pCubeMeshObj->Create(pCubeVertexLayout, pCubeBufferData);
         ENG_ASSERT(pCubeMeshObj->IsValid(), "Failed to create cube mesh object");
 
+        TransformComponent cubeTransform = {};
+        cubeTransform.nodeID = m_sceneGraph.CreateNode();
+        ENG_ASSERT(cubeTransform.nodeID.IsValid(), "Failed to create cube scene node");
+
+        MeshRefComponent cubeMeshRef = {};
+        cubeMeshRef.pMesh = pCubeMeshObj;
+        cubeMeshRef.count = 36;
+        cubeMeshRef.indexType = DrawIndexType::INDEX_TYPE_UINT8;
+
+        MaterialRefComponent cubeMaterialRef = {};
+        cubeMaterialRef.pMaterial = &gBufferMaterial;
+
+        BoundsComponent cubeBounds = {};
+        cubeBounds.localRadius = CUBE_HALF_SIZE * glm::sqrt(3.f);
+
+        m_cubeEntityID = m_renderWorld.CreateEntity(cubeTransform, cubeMeshRef, cubeMaterialRef, cubeBounds);
+        ENG_ASSERT(m_cubeEntityID.IsValid(), "Failed to create cube entity");
+
 
-        MemoryBufferCreateInfo commonConstBufferCreateInfo = {};
-        commonConstBufferCreateInfo.type = MemoryBufferType::TYPE_CONSTANT_BUFFER;
-        commonConstBufferCreateInfo.dataSize = sizeof(COMMON_DYN_CB);
-        commonConstBufferCreateInfo.elementSize = sizeof(COMMON_DYN_CB);
-        commonConstBufferCreateInfo.creationFlags = static_cast<MemoryBufferCreationFlags>(
-            BUFFER_CREATION_FLAG_DYNAMIC_STORAGE | BUFFER_CREATION_FLAG_READABLE | BUFFER_CREATION_FLAG_WRITABLE);
-        commonConstBufferCreateInfo.pData = nullptr;
-
-        pCommonConstBuffer = memBufferManager.RegisterBuffer();
-        ENG_ASSERT(pCommonConstBuffer, "Failed to register common const buffer");
-        pCommonConstBuffer->Create(commonConstBufferCreateInfo);
-        ENG_ASSERT(pCommonConstBuffer->IsValid(), "Failed to create common const buffer");
-        pCommonConstBuffer->SetDebugName("__COMMON_DYN_CB__");
-
-        MemoryBufferCreateInfo cameraConstBufferCreateInfo = {};
-        cameraConstBufferCreateInfo.type = MemoryBufferType::TYPE_CONSTANT_BUFFER;
-        cameraConstBufferCreateInfo.dataSize = sizeof(COMMON_CAMERA_CB);
-        cameraConstBufferCreateInfo.elementSize = sizeof(COMMON_CAMERA_CB);
-        cameraConstBufferCreateInfo.creationFlags = static_cast<MemoryBufferCreationFlags>(
-            BUFFER_CREATION_FLAG_DYNAMIC_STORAGE | BUFFER_CREATION_FLAG_WRITABLE);
-        cameraConstBufferCreateInfo.pData = nullptr;
-
-        pCameraConstBuffer = MemoryBufferManager::GetInstance().RegisterBuffer();
-        ENG_ASSERT(pCameraConstBuffer, "Failed to register camera const buffer");
-        pCameraConstBuffer->Create(cameraConstBufferCreateInfo);
-        ENG_ASSERT(pCameraConstBuffer->IsValid(), "Failed to create camera const buffer");
-        pCameraConstBuffer->SetDebugName("__COMMON_CAMERA_CB__");
-        
-        pCameraConstBuffer->BindIndexed(resGetResourceBinding(COMMON_CAMERA_CB).GetBinding());
-        
         pMainCam = cameraManager.RegisterCamera();
         ENG_ASSERT(pMainCam && pMainCam->IsRegistered(), "Failed to register camera");
         
@@ -453,7 +520,9 @@ void RenderSystem::RunColorPass() noexcept
         pMainCam->SetPosition(glm::vec3(0.f, 0.f, 2.f));
         pMainCam->SetRotation(glm::quatLookAt(-M3D_AXIS_Z, M3D_AXIS_Y));
 
-        pMainCam->SetAspectRatio(window.GetFramebufferWidth(), window.GetFramebufferHeight());
+        if (m_framebufferWidth > 0 && m_framebufferHeight > 0) {
+            pMainCam->SetAspectRatio(m_framebufferWidth, m_framebufferHeight);
+        }
         pMainCam->SetFovDegress(90.f);
 
         cameraManager.SubscribeCamera<EventFramebufferResized>(*pMainCam, [](const void* pEvent) {
@@ -474,7 +543,7 @@ void RenderSystem::RunColorPass() noexcept
             }
         });
 
-        isInitialized = true;
+        m_isSceneCreated = true;
 
         return;
     }
@@ -488,30 +557,36 @@ void RenderSystem::RunColorPass() noexcept
     const float elapsedTime = timer.GetElapsedTimeInSec();
     const float deltaTime = timer.GetDeltaTimeInSec();
 
-    char title[256];
-    sprintf_s(title, "%.3f ms | %.1f FPS", deltaTime, 1.f / deltaTime);
-    window.SetTitle(title);
+    if (pWindow) {
+        char title[256];
+        sprintf_s(title, "%.3f ms | %.1f FPS", deltaTime, 1.f / deltaTime);
+        pWindow->SetTitle(title);
 
-    glm::vec3 offset(0.f);
-    
-    offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_W) * (-pMainCam->GetZDir());
-    offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_S) * (pMainCam->GetZDir());
-    offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_D) * (pMainCam->GetXDir());
-    offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_A) * (-pMainCam->GetXDir());
-    offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_E) * (pMainCam->GetYDir());
-    offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_Q) * (-pMainCam->GetYDir());
-
-    if (!amIsZero(offset)) {
-        pMainCam->Move(glm::normalize(offset) * deltaTime);
-    }
+        const Input& input = pWindow->GetInput();
 
-    const float fovDegrees = pMainCam->GetFovDegrees() - input.GetMouseWheelDy();
-    if (camIsFovDegreesValid(fovDegrees)) {
-        pMainCam->SetFovDegress(fovDegrees);
+        glm::vec3 offset(0.f);
+        
+        offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_W) * (-pMainCam->GetZDir());
+        offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_S) * (pMainCam->GetZDir());
+        offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_D) * (pMainCam->GetXDir());
+        offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_A) * (-pMainCam->GetXDir());
+        offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_E) * (pMainCam->GetYDir());
+        offset += (float)input.IsKeyPressedOrHold(KeyboardKey::KEY_Q) * (-pMainCam->GetYDir());
+
+        if (!amIsZero(offset)) {
+            pMainCam->Move(glm::normalize(offset) * deltaTime);
+        }
+
+        const float fovDegrees = pMainCam->GetFovDegrees() - input.GetMouseWheelDy();
+        if (camIsFovDegreesValid(fovDegrees)) {
+            pMainCam->SetFovDegress(fovDegrees);
+        }
     }
 
-    COMMON_CAMERA_CB* pCamConstBuff = pCameraConstBuffer->MapWrite<COMMON_CAMERA_CB>();
-    ENG_ASSERT(pCamConstBuff, "Failed to map camera const buffer");
+    const MemoryRingBufferAllocation cameraConstAllocation = m_constRingBuffer.Allocate<COMMON_CAMERA_CB>();
+    ENG_ASSERT(cameraConstAllocation.IsValid(), "Failed to allocate camera const buffer");
+
+    COMMON_CAMERA_CB* pCamConstBuff = cameraConstAllocation.GetData<COMMON_CAMERA_CB>();
 
     const glm::mat4x4 cameraViewMat = glm::transpose(pMainCam->GetViewMatrix());
     constexpr size_t commonViewMatSize = sizeof(pCamConstBuff->COMMON_VIEW_MATRIX);
@@ -534,60 +609,159 @@ void RenderSystem::RunColorPass() noexcept
     pCamConstBuff->COMMON_VIEW_Z_NEAR = camZNear;
     pCamConstBuff->COMMON_VIEW_Z_FAR = camZFar;
 
-    pCameraConstBuffer->Unmap();
+    cameraConstAllocation.BindIndexed(resGetResourceBinding(COMMON_CAMERA_CB).GetBinding());
+
+    glViewport(0, 0, m_framebufferWidth, m_framebufferHeight);
 
-    glViewport(0, 0, window.GetFramebufferWidth(), window.GetFramebufferHeight());
+    const MemoryRingBufferAllocation commonConstAllocation = m_constRingBuffer.Allocate<COMMON_DYN_CB>();
+    ENG_ASSERT(commonConstAllocation.IsValid(), "Failed to allocate common const buffer");
+
+    COMMON_DYN_CB* pCommonUBO = commonConstAllocation.GetData<COMMON_DYN_CB>();
+    
+    pCommonUBO->COMMON_ELAPSED_TIME  = elapsedTime;
+    pCommonUBO->COMMON_DELTA_TIME    = deltaTime;
+    pCommonUBO->COMMON_SCREEN_WIDTH  = (float)m_framebufferWidth;
+    pCommonUBO->COMMON_SCREEN_HEIGHT = (float)m_framebufferHeight;
+    
+    commonConstAllocation.BindIndexed(resGetResourceBinding(COMMON_DYN_CB).GetBinding());
+
+    pGBufferPipeline->ClearFrameBuffer();
+    pPostProcPipeline->ClearFrameBuffer();
 
     {
-        pGBufferPipeline->ClearFrameBuffer();
-        pGBufferPipeline->Bind();
+        m_gBufferCommandList.Reset();
 
-        COMMON_DYN_CB* pCommonUBO = static_cast<COMMON_DYN_CB*>(pCommonConstBuffer->MapWrite());
-        ENG_ASSERT(pCommonUBO, "pCommonUBO is nullptr");
-        
-        pCommonUBO->COMMON_ELAPSED_TIME  = elapsedTime;
-        pCommonUBO->COMMON_DELTA_TIME    = deltaTime;
-        pCommonUBO->COMMON_SCREEN_WIDTH  = (float)window.GetFramebufferWidth();
-        pCommonUBO->COMMON_SCREEN_HEIGHT = (float)window.GetFramebufferHeight();
-        
-        pCommonConstBuffer->Unmap();
+        m_gBufferCommandList.BindPipeline(pGBufferPipeline);
 
-        pCommonConstBuffer->BindIndexed(resGetResourceBinding(COMMON_DYN_CB).GetBinding());
+        for (uint32_t i = 0; i < gBufferMaterial.texturesCount; ++i) {
+            m_gBufferCommandList.BindTexture(gBufferMaterial.units[i], gBufferMaterial.pTextures[i], gBufferMaterial.pSamplers[i]);
+        }
 
-        pTestTexture->Bind(resGetResourceBinding(TEST_TEXTURE).GetBinding());
-        pTestTextureSampler->Bind(resGetResourceBinding(TEST_TEXTURE).GetBinding());
+        m_sceneGraph.Update();
 
-        pCubeMeshObj->Bind();
+        m_renderWorld.ParallelForEachChunk<TransformComponent, BoundsComponent>(
+            [this](const EntityID*, TransformComponent* pTransforms, BoundsComponent* pBounds, uint32_t count) {
+                for (uint32_t i = 0; i < count; ++i) {
+                    if (!m_sceneGraph.IsWorldMatrixChanged(pTransforms[i].nodeID)) {
+                        continue;
+                    }
 
-        glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, 0, 1);
-    }
+                    const glm::mat4x4& worldMat = m_sceneGraph.GetWorldMatrix(pTransforms[i].nodeID);
+                    pTransforms[i].worldMatrix = worldMat;
 
-    {
-        pPostProcPipeline->ClearFrameBuffer();
-        pPostProcPipeline->Bind();
+                    const glm::vec3 scale(glm::length(glm::vec3(worldMat[0])), glm::length(glm::vec3(worldMat[1])), glm::length(glm::vec3(worldMat[2])));
+                    const float maxScale = glm::max(scale.x, glm::max(scale.y, scale.z));
 
-        pGBufferAlbedoTex->Bind(resGetResourceBinding(GBUFFER_ALBEDO_TEX).GetBinding());
-        pGBufferAlbedoSampler->Bind(resGetResourceBinding(GBUFFER_ALBEDO_TEX).GetBinding());
-            
-        pGBufferNormalTex->Bind(resGetResourceBinding(GBUFFER_NORMAL_TEX).GetBinding());
-        pGBufferNormalSampler->Bind(resGetResourceBinding(GBUFFER_NORMAL_TEX).GetBinding());
-            
-        pGBufferSpecTex->Bind(resGetResourceBinding(GBUFFER_SPECULAR_TEX).GetBinding());
-        pGBufferSpecSampler->Bind(resGetResourceBinding(GBUFFER_SPECULAR_TEX).GetBinding());
-            
-        pCommonDepthTex->Bind(resGetResourceBinding(COMMON_DEPTH_TEX).GetBinding());
-        pGBufferDepthSampler->Bind(resGetResourceBinding(COMMON_DEPTH_TEX).GetBinding());
+                    pBounds[i].worldCenter = glm::vec3(worldMat * glm::vec4(pBounds[i].localCenter, 1.f));
+                    pBounds[i].worldRadius = pBounds[i].localRadius * maxScale;
+                }
+            });
+
+        // Bounds get a sphere slot and a BVH proxy on the first sync, later only changed ones move their proxies
+        uint32_t createdProxiesCount = 0;
+
+        m_renderWorld.ForEachChunk<const TransformComponent, BoundsComponent>(
+            [this, &createdProxiesCount](const EntityID* pIDs, const TransformComponent* pTransforms, BoundsComponent* pBounds, uint32_t count) {
+                for (uint32_t i = 0; i < count; ++i) {
+                    BoundsComponent& bounds = pBounds[i];
+                    const glm::vec3 extents(bounds.worldRadius);
+
+                    if (!m_sceneBVH.IsProxyValid(bounds.bvhProxyID)) {
+                        const uint32_t sphereIdx = m_sceneBoundingSpheres.Add(bounds.worldCenter, bounds.worldRadius);
+                        m_sceneEntityIDs.emplace_back(pIDs[i]);
 
-        pCommonConstBuffer->BindIndexed(resGetResourceBinding(COMMON_DYN_CB).GetBinding());
+                        bounds.bvhProxyID = m_sceneBVH.CreateProxy(bounds.worldCenter - extents, bounds.worldCenter + extents, sphereIdx);
+                        ++createdProxiesCount;
 
-        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, 1);
+                        continue;
+                    }
+
+                    if (!m_sceneGraph.IsWorldMatrixChanged(pTransforms[i].nodeID)) {
+                        continue;
+                    }
+
+                    m_sceneBoundingSpheres.Set(m_sceneBVH.GetProxyUserData(bounds.bvhProxyID), bounds.worldCenter, bounds.worldRadius);
+                    m_sceneBVH.UpdateProxy(bounds.bvhProxyID, bounds.worldCenter - extents, bounds.worldCenter + extents);
+                }
+            });
+
+        // Inserted proxies make a worse tree than the SAH build, so it's rebuilt when most of the scene is new
+        if (createdProxiesCount * 2 > m_sceneBVH.GetProxiesCount()) {
+            m_sceneBVH.Build();
+        } else {
+            m_sceneBVH.Refit();
+        }
+
+        // Any bound which contains an occluder has a nearest depth no farther than the depth the occluder rasterizes,
+        // so the cube doesn't occlude its own bounding sphere
+        const glm::mat4x4& cubeWorldMat = m_renderWorld.GetComponent<TransformComponent>(m_cubeEntityID)->worldMatrix;
+
+        m_occlusionRasterizer.BeginFrame(pMainCam->GetViewProjectionMatrix());
+        m_occlusionRasterizer.AddOccluder(pCubeBufferData->GetOccluderPositions().data(), static_cast<uint32_t>(pCubeBufferData->GetOccluderPositions().size()),
+            pCubeBufferData->GetOccluderIndices().data(), static_cast<uint32_t>(pCubeBufferData->GetOccluderIndices().size()), cubeWorldMat);
+        m_occlusionRasterizer.Rasterize();
+
+        m_sceneBVH.QueryFrustum(pMainCam->GetFrustum(), m_visibleObjectIndices);
+        m_occlusionRasterizer.CullSpheres(m_sceneBoundingSpheres, m_visibleObjectIndices);
+        m_occlusionCuller.CullSpheres(m_sceneBoundingSpheres, m_visibleObjectIndices);
+
+        for (uint32_t objectIdx : m_visibleObjectIndices) {
+            const EntityID entityID = m_sceneEntityIDs[objectIdx];
+
+            const TransformComponent* pTransform = m_renderWorld.GetComponent<TransformComponent>(entityID);
+            const MeshRefComponent* pMeshRef = m_renderWorld.GetComponent<MeshRefComponent>(entityID);
+            const MaterialRefComponent* pMaterialRef = m_renderWorld.GetComponent<MaterialRefComponent>(entityID);
+
+            if (!pTransform || !pMeshRef || !pMaterialRef) {
+                continue;
+            }
+
+            // The batch is recorded with the GBuffer material bound
+            ENG_ASSERT(pMaterialRef->pMaterial == &gBufferMaterial, "GBuffer batch supports the GBuffer material only");
+
+            COMMON_DRAW_DATA drawData = {};
+
+            const glm::mat4x4 worldMatTransposed = glm::transpose(pTransform->worldMatrix);
+            constexpr size_t worldMatSize = sizeof(drawData.COMMON_WORLD_MATRIX);
+            memcpy_s(drawData.COMMON_WORLD_MATRIX, worldMatSize, &worldMatTransposed, worldMatSize);
+
+            IndirectDrawCommand drawCommand = {};
+            drawCommand.pMesh = pMeshRef->pMesh;
+            drawCommand.first = pMeshRef->first;
+            drawCommand.count = pMeshRef->count;
+            drawCommand.indexType = pMeshRef->indexType;
+
+            m_gBufferDrawBatch.AddDraw(drawCommand, &drawData);
+        }
+
+        m_gBufferDrawBatch.Build();
+        m_gBufferDrawBatch.Upload();
+        m_gBufferDrawBatch.Record(m_gBufferCommandList);
+
+        m_gBufferCommandList.Execute();
+        m_gBufferDrawBatch.Clear();
+
+        m_occlusionCuller.RequestDepthReadback(pCommonDepthTex, pMainCam->GetViewProjectionMatrix());
+
+        DrawCommand postProcDrawCommand = {};
+        postProcDrawCommand.pPipeline = pPostProcPipeline;
+        postProcDrawCommand.pMaterial = &postProcMaterial;
+        postProcDrawCommand.count = 6;
+
+        m_drawBucket.AddDraw(DrawPass::PASS_POST_PROCESS, 0.f, postProcDrawCommand);
+
+        m_drawBucket.Submit();
+        m_drawBucket.Clear();
     }
 
     {
         const FrameBuffer* pPostProcFrameBuffer = rtManager.GetFrameBuffer(RTFrameBufferID::POST_PROCESS);
+
+        const uint32_t blitWidth = pWindow ? pWindow->GetWidth() : m_framebufferWidth;
+        const uint32_t blitHeight = pWindow ? pWindow->GetHeight() : m_framebufferHeight;
         
-        glBlitNamedFramebuffer(pPostProcFrameBuffer->GetRenderID(), 0, 0, 0, window.GetWidth(), window.GetHeight(),
-            0, 0, window.GetWidth(), window.GetHeight(), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBlitNamedFramebuffer(pPostProcFrameBuffer->GetRenderID(), 0, 0, 0, blitWidth, blitHeight,
+            0, 0, blitWidth, blitHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
     }
 }
 
@@ -618,6 +792,44 @@ bool RenderSystem::Init() noexcept
     INIT_CALL(engInitMemoryBufferManager);
     INIT_CALL(engInitMeshManager);
 
+    MemoryRingBufferCreateInfo constRingBufferCreateInfo = {};
+    constRingBufferCreateInfo.type = MemoryBufferType::TYPE_CONSTANT_BUFFER;
+    constRingBufferCreateInfo.frameSize = CONST_RING_BUFFER_FRAME_SIZE;
+
+    INIT_CALL(m_constRingBuffer.Create, constRingBufferCreateInfo);
+    m_constRingBuffer.SetDebugName("__CONST_RING_BUFFER__");
+
+    MemoryRingBufferCreateInfo storageRingBufferCreateInfo = {};
+    storageRingBufferCreateInfo.type = MemoryBufferType::TYPE_UNORDERED_ACCESS_BUFFER;
+    storageRingBufferCreateInfo.frameSize = STORAGE_RING_BUFFER_FRAME_SIZE;
+
+    INIT_CALL(m_storageRingBuffer.Create, storageRingBufferCreateInfo);
+    m_storageRingBuffer.SetDebugName("__STORAGE_RING_BUFFER__");
+
+    IndirectDrawBatchCreateInfo gBufferDrawBatchCreateInfo = {};
+    gBufferDrawBatchCreateInfo.maxDrawsCount = GBUFFER_DRAW_BATCH_MAX_DRAWS_COUNT;
+    gBufferDrawBatchCreateInfo.drawDataSize = sizeof(COMMON_DRAW_DATA);
+    gBufferDrawBatchCreateInfo.drawDataBinding = resGetResourceBinding(COMMON_DRAW_DATA_SB).GetBinding();
+
+    INIT_CALL(m_gBufferDrawBatch.Create, gBufferDrawBatchCreateInfo);
+    INIT_CALL(m_occlusionCuller.Create);
+
+    m_sceneGraph.Reserve(SCENE_INITIAL_OBJECTS_COUNT);
+    m_sceneEntityIDs.reserve(SCENE_INITIAL_OBJECTS_COUNT);
+    m_sceneBoundingSpheres.Reserve(SCENE_INITIAL_OBJECTS_COUNT);
+    m_sceneBVH.Reserve(SCENE_INITIAL_OBJECTS_COUNT);
+    m_visibleObjectIndices.reserve(SCENE_INITIAL_OBJECTS_COUNT);
+    m_occlusionRasterizer.SetResolution(OcclusionRasterizer::DEFAULT_WIDTH, OcclusionRasterizer::DEFAULT_HEIGHT);
+
+    m_frameBufferResizeEventListenerID = es::EventDispatcher::GetInstance().Subscribe<EventFramebufferResized>([this](const void* pEvent) {
+        const EventFramebufferResized& event = es::EventCast<EventFramebufferResized>(pEvent);
+
+        if (event.GetWidth() > 0 && event.GetHeight() > 0) {
+            m_framebufferWidth = static_cast<uint32_t>(event.GetWidth());
+            m_framebufferHeight = static_cast<uint32_t>(event.GetHeight());
+        }
+    });
+
     m_isInitialized = true;
 
     return true;
@@ -626,6 +838,27 @@ bool RenderSystem::Init() noexcept
     
 void RenderSystem::Terminate() noexcept
 {
+    // Scene components reference meshes and materials of the managers terminated below
+    m_visibleObjectIndices.clear();
+    m_sceneBVH.Clear();
+    m_sceneBoundingSpheres.Clear();
+    m_sceneEntityIDs.clear();
+    m_renderWorld.Clear();
+    m_sceneGraph.Clear();
+    m_cubeEntityID = EntityID();
+    m_gBufferCommandList.Reset();
+    m_drawBucket.Clear();
+    m_isSceneCreated = false;
+
+    if (m_isInitialized) {
+        es::EventDispatcher::GetInstance().Unsubscribe(m_frameBufferResizeEventListenerID);
+    }
+
+    m_occlusionCuller.Destroy();
+    m_gBufferDrawBatch.Destroy();
+    m_storageRingBuffer.Destroy();
+    m_constRingBuffer.Destroy();
+
     engTerminateMeshManager();
     engTerminateMemoryBufferManager();
     engTerminatePipelineManager();
@@ -650,10 +883,12 @@ bool engInitRenderSystem() noexcept
         return true;
     }
 
+#if !defined(ENG_GL_RECORDING_BACKEND)
     if (!engIsWindowSystemInitialized()) {
         ENG_ASSERT_GRAPHICS_API_FAIL("Window system must be initialized before render system");
         return false;
     }
+#endif
 
     pRenderSysInst = std::unique_ptr<RenderSystem>(new RenderSystem);
     if (!pRenderSysInst) {
@@ -1,5 +1,18 @@
 #pragma once
 
+#include "render/mem_manager/ring_buffer.h"
+#include "render/indirect_draw/indirect_draw_batch.h"
+#include "render/occlusion/hiz_occlusion.h"
+#include "render/draw_bucket/draw_bucket.h"
+#include "render/command_list/command_list.h"
+
+#include "core/scene/scene_graph.h"
+#include "core/ecs/ecs_world.h"
+#include "core/culling/frustum_culling.h"
+#include "core/culling/occlusion_rasterizer.h"
+#include "core/spatial/dynamic_bvh.h"
+#include "core/event_system/event_dispatcher.h"
+
 #include <memory>
 
 
@@ -28,6 +41,21 @@ public:
     void RunColorPass() noexcept;
     void RunPostprocessingPass() noexcept;
 
+    // Per frame constants are allocated from it and bound with BindIndexedRange(). Allocations are valid until EndFrame()
+    MemoryRingBuffer& GetConstantRingBuffer() noexcept { return m_constRingBuffer; }
+
+    // Per frame storage buffer data, e.g. instance data of instanced draws. Allocations are valid until EndFrame()
+    MemoryRingBuffer& GetStorageRingBuffer() noexcept { return m_storageRingBuffer; }
+
+    // GBuffer geometry is submitted through it with COMMON_DRAW_DATA per draw
+    IndirectDrawBatch& GetGBufferDrawBatch() noexcept { return m_gBufferDrawBatch; }
+
+    // Tests bounds against HiZ built from depth of previous frames, see GetStats() of it for occluded ratio and cost
+    HiZOcclusionCuller& GetOcclusionCuller() noexcept { return m_occlusionCuller; }
+
+    // Proxy user data of it is the index of the entity bounding sphere, the main camera frustum is culled with it
+    const DynamicBVH& GetSceneBVH() const noexcept { return m_sceneBVH; }
+
 private:
     RenderSystem() = default;
     
@@ -40,6 +68,31 @@ private:
     // GBuffer textures, framebuffer
     // ...
 
+    MemoryRingBuffer m_constRingBuffer;
+    MemoryRingBuffer m_storageRingBuffer;
+    IndirectDrawBatch m_gBufferDrawBatch;
+    HiZOcclusionCuller m_occlusionCuller;
+
+    DrawBucket m_drawBucket;
+    RenderCommandList m_gBufferCommandList;
+
+    SceneGraph m_sceneGraph;
+    EcsWorld m_renderWorld;
+    EntityID m_cubeEntityID;
+
+    // Entity of every scene bounding sphere, indexed by BVH proxy user data
+    std::vector<EntityID> m_sceneEntityIDs;
+    BoundingSpheresSoA m_sceneBoundingSpheres;
+    DynamicBVH m_sceneBVH;
+    OcclusionRasterizer m_occlusionRasterizer;
+    std::vector<uint32_t> m_visibleObjectIndices;
+
+    // Tracked from EventFramebufferResized, so passes don't depend on the main window which is absent in headless runs
+    es::ListenerID m_frameBufferResizeEventListenerID;
+    uint32_t m_framebufferWidth = 0;
+    uint32_t m_framebufferHeight = 0;
+
+    bool m_isSceneCreated = false;
     bool m_isInitialized = false;
 };
 
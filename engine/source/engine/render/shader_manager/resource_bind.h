@@ -13,6 +13,7 @@ enum class ShaderResourceType : uint32_t
 
     TYPE_SAMPLER_2D,
     TYPE_CONST_BUFFER,
+    TYPE_UNORDERED_ACCESS_BUFFER,
 };
 
 
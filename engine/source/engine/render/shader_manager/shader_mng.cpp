@@ -3,11 +3,14 @@
 
 #include "utils/data_structures/hash.h"
 #include "utils/file/file.h"
+#include "utils/file/mapped_file.h"
 
 #include "utils/debug/assertion.h"
 
 #include "render/platform/OpenGL/opengl_driver.h"
 
+#include "core/job_system/job_system.h"
+
 
 static constexpr size_t ENG_MAX_SHADER_PROGRAMS_COUNT = 4096; // TODO: make it configurable
 static constexpr size_t ENG_MAX_SHADER_INCLUDE_DEPTH = 128;   // TODO: make it configurable
@@ -46,7 +49,7 @@ static void Preprocessor_FillIncludes(std::stringstream& ss, const std::string_v
     ptrdiff_t currentIncludePos;
     ptrdiff_t prevIncludePos = 0;
 
-    std::vector<char> includeFileContent;
+    MappedFile includeFile;
 
     for (; includeIter != std::cregex_iterator(); ++includeIter) {
         const std::cmatch& mr = *includeIter;
@@ -61,13 +64,11 @@ static void Preprocessor_FillIncludes(std::stringstream& ss, const std::string_v
         
         curentSourceCode = sourceCode.substr(mr.position() + mr.length());
 
-        std::string_view includeFile(mr[1].first, mr[1].length());
-        const fs::path includeFilepath = includeDirPath / includeFile;
-
-        ReadTextFile(includeFilepath, includeFileContent);
+        std::string_view includeFilename(mr[1].first, mr[1].length());
+        const fs::path includeFilepath = includeDirPath / includeFilename;
 
-        if (!includeFileContent.empty()) {
-            Preprocessor_FillIncludes(ss, includeFileContent.data(), includeDirPath, includeDepth + 1);
+        if (includeFile.Open(includeFilepath) && !includeFile.IsEmpty()) {
+            Preprocessor_FillIncludes(ss, includeFile.GetText(), includeDirPath, includeDepth + 1);
         }
     }
 
@@ -89,12 +90,13 @@ public:
     ShaderStage(ShaderStage&& other) noexcept;
     ShaderStage& operator=(ShaderStage&& other) noexcept;
 
-    bool Init(const ShaderStageCreateInfo& createInfo) noexcept;
+    bool Init(ShaderStageType type, const std::string& preprocessedSourceCode) noexcept;
     void Destroy() noexcept;
 
     bool IsValid() const noexcept { return m_stageID != 0; }
 
 private:
+    // Doesn't touch GL, so it's safe to call from jobs
     static std::string PreprocessSourceCode(const ShaderStageCreateInfo& createInfo) noexcept;
 
 private:
@@ -120,7 +122,7 @@ ShaderStage &ShaderStage::operator=(ShaderStage &&other) noexcept
 }
 
 
-bool ShaderStage::Init(const ShaderStageCreateInfo &createInfo) noexcept
+bool ShaderStage::Init(ShaderStageType type, const std::string& preprocessedSourceCode) noexcept
 {
     const GLenum shaderStageGLType = [](ShaderStageType type) -> GLenum {
         switch (type) {
@@ -128,11 +130,10 @@ bool ShaderStage::Init(const ShaderStageCreateInfo &createInfo) noexcept
             case ShaderStageType::PIXEL:  return GL_FRAGMENT_SHADER;
             default: return GL_NONE;
         }
-    }(createInfo.type);
+    }(type);
     
-    ENG_ASSERT_GRAPHICS_API(shaderStageGLType != GL_NONE, "Invalid ShaderStageType value: {}", static_cast<uint32_t>(createInfo.type));
+    ENG_ASSERT_GRAPHICS_API(shaderStageGLType != GL_NONE, "Invalid ShaderStageType value: {}", static_cast<uint32_t>(type));
 
-    const std::string preprocessedSourceCode = PreprocessSourceCode(createInfo);
     if (preprocessedSourceCode.empty()) {
         ENG_LOG_WARN("Empty shader source code");
         return false;
@@ -173,7 +174,8 @@ std::string ShaderStage::PreprocessSourceCode(const ShaderStageCreateInfo& creat
 
     std::stringstream ss;
 
-    std::string_view sourceCode = createInfo.pSourceCode;
+    // Source code may come from a mapped file, so it isn't null terminated
+    std::string_view sourceCode(createInfo.pSourceCode, createInfo.codeSize);
     
     ptrdiff_t versionPatternBeginPos, versionPatternEndPos;
     Preprocessor_GetShaderVersionPosition(sourceCode, versionPatternBeginPos, versionPatternEndPos);
@@ -181,7 +183,7 @@ std::string ShaderStage::PreprocessSourceCode(const ShaderStageCreateInfo& creat
 
     ss.write(sourceCode.data() + versionPatternBeginPos, versionPatternSize);
 
-    sourceCode = sourceCode.data() + versionPatternBeginPos + versionPatternSize;
+    sourceCode = sourceCode.substr(std::min<size_t>(versionPatternBeginPos + versionPatternSize, sourceCode.size()));
 
     for (size_t i = 0; i < createInfo.definesCount; ++i) {
         const char* pDefineStr = createInfo.pDefines[i];
@@ -331,13 +333,33 @@ bool ShaderProgram::Create(const ShaderProgramCreateInfo &createInfo) noexcept
     ENG_ASSERT(createInfo.pStageCreateInfos && createInfo.stageCreateInfosCount > 0, 
         "Shader program create info '{}' has invalid stages parametres", m_dbgName.CStr());
 
-    std::array<ShaderStage, static_cast<size_t>(ShaderStageType::COUNT)> shaderStages = {};
+    constexpr size_t MAX_STAGES_COUNT = static_cast<size_t>(ShaderStageType::COUNT);
+    ENG_ASSERT(createInfo.stageCreateInfosCount <= MAX_STAGES_COUNT, "Shader program create info '{}' has too many stages", m_dbgName.CStr());
+
+    // Preprocessing reads include files and runs regexes, so stages are preprocessed in parallel.
+    // GL calls stay on the main thread
+    std::array<std::string, MAX_STAGES_COUNT> preprocessedSourceCodes = {};
+    
+    JobSystem& jobSystem = JobSystem::GetInstance();
+    JobCounter preprocessCounter;
+
     for (size_t i = 0; i < createInfo.stageCreateInfosCount; ++i) {
         const ShaderStageCreateInfo* pStageCreateInfo = createInfo.pStageCreateInfos[i];
         
         ENG_ASSERT(pStageCreateInfo, "pStageCreateInfo is nullptr");
+
+        std::string* pPreprocessedSourceCode = &preprocessedSourceCodes[i];
         
-        if (!shaderStages[i].Init(*pStageCreateInfo)) {
+        jobSystem.Submit([pStageCreateInfo, pPreprocessedSourceCode]() {
+            *pPreprocessedSourceCode = ShaderStage::PreprocessSourceCode(*pStageCreateInfo);
+        }, &preprocessCounter);
+    }
+
+    jobSystem.Wait(preprocessCounter);
+
+    std::array<ShaderStage, MAX_STAGES_COUNT> shaderStages = {};
+    for (size_t i = 0; i < createInfo.stageCreateInfosCount; ++i) {
+        if (!shaderStages[i].Init(createInfo.pStageCreateInfos[i]->type, preprocessedSourceCodes[i])) {
             return false;
         }
     }
@@ -417,9 +439,9 @@ ShaderManager::~ShaderManager()
 ShaderProgram* ShaderManager::RegisterShaderProgram() noexcept
 {
     const ProgramID programID = m_IDPool.Allocate();
-    ENG_ASSERT(programID.Value() < m_shaderProgramsStorage.size(), "Shader storage overflow");
+    ENG_ASSERT(programID.Index() < m_shaderProgramsStorage.size(), "Shader storage overflow");
     
-    ShaderProgram* pProgram = &m_shaderProgramsStorage[programID.Value()];
+    ShaderProgram* pProgram = &m_shaderProgramsStorage[programID.Index()];
 
     ENG_ASSERT(!pProgram->IsValid(), "Valid shader program was returned during registration");
 
@@ -2,7 +2,7 @@
 
 #include "utils/file/file.h"
 #include "utils/data_structures/strid.h"
-#include "utils/data_structures/base_id.h"
+#include "utils/data_structures/generational_id.h"
 
 #include "resource_bind.h"
 
@@ -40,7 +40,7 @@ struct ShaderProgramCreateInfo
 };
 
 
-using ProgramID = ds::BaseID<uint32_t>;
+using ProgramID = ds::GenerationalID<uint32_t>;
 
 
 class ShaderProgram
@@ -126,7 +126,7 @@ private:
 private:
     std::vector<ShaderProgram> m_shaderProgramsStorage;
     
-    using ProgramIDPool = ds::BaseIDPool<ProgramID>;
+    using ProgramIDPool = ds::GenerationalIDPool<ProgramID>;
     ProgramIDPool m_IDPool;
 
     bool m_isInitialized = false;
@@ -497,9 +497,9 @@ Texture* TextureManager::RegisterTexture2D(ds::StrID name) noexcept
     ENG_ASSERT(GetTextureByName(name) == nullptr, "Attempt to register already registered 2D texture: {}", name.CStr());
     
     const TextureID textureID = m_IDPool.Allocate();
-    ENG_ASSERT(textureID.Value() < m_texturesStorage.size(), "Texture storage overflow");
+    ENG_ASSERT(textureID.Index() < m_texturesStorage.size(), "Texture storage overflow");
     
-    const uint64_t index = textureID.Value();
+    const uint64_t index = textureID.Index();
 
     Texture* pTex = &m_texturesStorage[index];
 
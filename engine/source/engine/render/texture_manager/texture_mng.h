@@ -1,7 +1,7 @@
 #pragma once
 
 #include "utils/data_structures/strid.h"
-#include "utils/data_structures/base_id.h"
+#include "utils/data_structures/generational_id.h"
 
 #include "core.h"
 
@@ -92,7 +92,7 @@ struct Texture2DCreateInfo
 };
 
 
-using TextureID = ds::BaseID<uint32_t>;
+using TextureID = ds::GenerationalID<uint32_t>;
 
 
 class Texture
@@ -196,7 +196,7 @@ private:
 
     std::unordered_map<ds::StrID, uint64_t> m_textureNameToStorageIndexMap;
 
-    using TextureIDPool = ds::BaseIDPool<TextureID>;
+    using TextureIDPool = ds::GenerationalIDPool<TextureID>;
     TextureIDPool m_IDPool;
 
     bool m_isInitialized = false;
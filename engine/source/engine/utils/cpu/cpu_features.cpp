@@ -0,0 +1,98 @@
+#include "pch.h"
+#include "cpu_features.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+  #define CPU_X86
+#endif
+
+#if defined(CPU_X86) && defined(_MSC_VER)
+  #include <intrin.h>
+  #include <immintrin.h>
+#endif
+
+
+#if defined(CPU_X86)
+static bool DetectAVX() noexcept
+{
+#if defined(_MSC_VER)
+    int cpuInfo[4] = {};
+
+    __cpuid(cpuInfo, 1);
+    const bool isOSXSaveSupported = (cpuInfo[2] & (1 << 27)) != 0;
+    const bool isAVXSupported = (cpuInfo[2] & (1 << 28)) != 0;
+
+    if (!isOSXSaveSupported || !isAVXSupported) {
+        return false;
+    }
+
+    // OS must save YMM registers on context switch
+    return (_xgetbv(0) & 0x6) == 0x6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx");
+#endif
+}
+
+
+static bool DetectAVX2() noexcept
+{
+    if (!DetectAVX()) {
+        return false;
+    }
+
+#if defined(_MSC_VER)
+    int cpuInfo[4] = {};
+
+    __cpuid(cpuInfo, 0);
+    if (cpuInfo[0] < 7) {
+        return false;
+    }
+
+    __cpuidex(cpuInfo, 7, 0);
+    return (cpuInfo[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+
+bool IsCPUAVXSupported() noexcept
+{
+#if defined(CPU_X86)
+    static const bool isSupported = DetectAVX();
+    return isSupported;
+#else
+    return false;
+#endif
+}
+
+
+bool IsCPUAVX2Supported() noexcept
+{
+#if defined(CPU_X86)
+    static const bool isSupported = DetectAVX2();
+    return isSupported;
+#else
+    return false;
+#endif
+}
+
+
+
+CPUSIMDLevel GetCPUSIMDLevel() noexcept
+{
+    if (IsCPUAVX2Supported()) {
+        return CPUSIMDLevel::AVX2;
+    }
+
+    if (IsCPUAVXSupported()) {
+        return CPUSIMDLevel::AVX;
+    }
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return CPUSIMDLevel::SSE2;
+#else
+    return CPUSIMDLevel::SCALAR;
+#endif
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Runtime x86 SIMD support checks for code which selects kernels on start. AVX checks include OS support of YMM registers saving.
+// Results are cached after the first call. Always false on other architectures
+bool IsCPUAVXSupported() noexcept;
+bool IsCPUAVX2Supported() noexcept;
+
+
+// Instruction sets of runtime selected SIMD kernels, in ascending order
+enum class CPUSIMDLevel : uint8_t
+{
+    SCALAR,
+    SSE2,
+    AVX,
+    AVX2,
+};
+
+
+// Best level supported by both the CPU and the build
+CPUSIMDLevel GetCPUSIMDLevel() noexcept;
+
@@ -3,6 +3,7 @@
 #include "hash.h"
 
 #include <deque>
+#include <vector>
 
 #include <type_traits>
 #include <limits>
@@ -66,6 +67,7 @@ namespace ds
 
     private:
         std::deque<IDType> m_idFreeList;
+        std::vector<bool> m_allocationFlags;
         IDType m_nextAllocatedID = IDType{0};
     };
 }
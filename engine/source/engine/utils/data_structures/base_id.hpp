@@ -6,12 +6,16 @@ namespace ds
         if (m_idFreeList.empty()) {
             const IDType ID = m_nextAllocatedID;
             m_nextAllocatedID = IDType(m_nextAllocatedID.Value() + 1);
+            
+            m_allocationFlags.emplace_back(true);
     
             return ID;
         }
     
         const IDType ID = m_idFreeList.front();
         m_idFreeList.pop_front();
+
+        m_allocationFlags[ID.Value()] = true;
             
         return ID;
     }
@@ -20,7 +24,8 @@ namespace ds
     template <typename BaseIDType>
     inline void BaseIDPool<BaseIDType>::Deallocate(IDType& ID) noexcept
     {
-        if (ID < m_nextAllocatedID && std::find(m_idFreeList.cbegin(), m_idFreeList.cend(), ID) == m_idFreeList.cend()) {
+        if (IsAllocated(ID)) {
+            m_allocationFlags[ID.Value()] = false;
             m_idFreeList.emplace_back(ID);
         }
 
@@ -32,6 +37,7 @@ namespace ds
     inline void BaseIDPool<BaseIDType>::Reset() noexcept
     {
         m_idFreeList.clear();
+        m_allocationFlags.clear();
         m_nextAllocatedID.SetValue(0);
     }
 
@@ -46,6 +52,6 @@ namespace ds
     template <typename BaseIDType>
     inline bool BaseIDPool<BaseIDType>::IsAllocated(const IDType& ID) const noexcept
     {
-        return ID < m_nextAllocatedID && std::find(m_idFreeList.cbegin(), m_idFreeList.cend(), ID) == m_idFreeList.cend();
+        return ID < m_nextAllocatedID && m_allocationFlags[ID.Value()];
     }
 }
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "hash.h"
+
+#include "utils/debug/assertion.h"
+
+#include <deque>
+#include <vector>
+
+#include <type_traits>
+#include <limits>
+
+
+namespace ds
+{
+    // Handle which packs slot index and slot generation. When a slot is freed its generation is bumped,
+    // so handles which still point to it become stale and can be detected in O(1)
+    template <typename T, size_t INDEX_BITS_COUNT = sizeof(T) * 5ull>
+    class GenerationalID
+    {
+        static_assert(std::is_integral_v<T> && std::is_unsigned_v<T>, "T must be an unsigned integral type");
+        static_assert(INDEX_BITS_COUNT > 0 && INDEX_BITS_COUNT < sizeof(T) * 8ull, "Invalid index bits count");
+
+    public:
+        using StorageType = T;
+
+        static inline constexpr size_t INDEX_BITS = INDEX_BITS_COUNT;
+        static inline constexpr size_t GENERATION_BITS = sizeof(StorageType) * 8ull - INDEX_BITS;
+
+        static inline constexpr StorageType INDEX_MASK = (StorageType(1) << INDEX_BITS) - StorageType(1);
+        static inline constexpr StorageType GENERATION_MASK = (StorageType(1) << GENERATION_BITS) - StorageType(1);
+
+        // Max index value is reserved for invalid ID
+        static inline constexpr StorageType MAX_INDEX = INDEX_MASK - StorageType(1);
+
+    public:
+        GenerationalID() = default;
+        GenerationalID(StorageType index, StorageType generation)
+            : m_value(static_cast<StorageType>(((generation & GENERATION_MASK) << INDEX_BITS) | (index & INDEX_MASK))) {}
+
+        void Invalidate() noexcept { m_value = ID_INVALID; }
+        bool IsValid() const noexcept { return m_value != ID_INVALID; }
+
+        StorageType Index() const noexcept { return m_value & INDEX_MASK; }
+        StorageType Generation() const noexcept { return (m_value >> INDEX_BITS) & GENERATION_MASK; }
+
+        StorageType Value() const noexcept { return m_value; }
+
+        uint64_t Hash() const noexcept { return m_value; }
+
+        bool operator==(GenerationalID other) const noexcept { return m_value == other.m_value; }
+        bool operator!=(GenerationalID other) const noexcept { return m_value != other.m_value; }
+        bool operator>(GenerationalID other) const noexcept { return m_value > other.m_value; }
+        bool operator<(GenerationalID other) const noexcept { return m_value < other.m_value; }
+        bool operator<=(GenerationalID other) const noexcept { return m_value <= other.m_value; }
+        bool operator>=(GenerationalID other) const noexcept { return m_value >= other.m_value; }
+
+    private:
+        static inline constexpr StorageType ID_INVALID = std::numeric_limits<StorageType>::max();
+
+    private:
+        StorageType m_value = ID_INVALID;
+    };
+
+
+    // Slot map style ID allocator. Allocate, Deallocate and IsAllocated are O(1).
+    // Freed indices are reused in FIFO order to spread generation increments over all slots
+    template <typename GenerationalIDType>
+    class GenerationalIDPool
+    {
+    public:
+        using IDType = GenerationalIDType;
+        using StorageType = typename IDType::StorageType;
+
+    public:
+        IDType Allocate() noexcept;
+        void Deallocate(IDType& ID) noexcept;
+
+        void Reset() noexcept;
+
+        bool IsAnyAllocated() const noexcept { return m_allocatedCount > 0; }
+        bool IsAllocated(const IDType& ID) const noexcept;
+
+        size_t GetAllocatedCount() const noexcept { return m_allocatedCount; }
+
+    private:
+        struct Slot
+        {
+            StorageType generation;
+            bool isAllocated;
+        };
+
+        std::vector<Slot> m_slots;
+        std::deque<StorageType> m_freeIndices;
+        size_t m_allocatedCount = 0;
+    };
+}
+
+template <typename T, size_t INDEX_BITS_COUNT>
+inline uint64_t amHash(const ds::GenerationalID<T, INDEX_BITS_COUNT>& ID) noexcept
+{
+    return ID.Hash();
+}
+
+
+#include "generational_id.hpp"
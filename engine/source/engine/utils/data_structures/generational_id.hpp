@@ -0,0 +1,67 @@
+namespace ds
+{
+    template <typename GenerationalIDType>
+    inline typename GenerationalIDPool<GenerationalIDType>::IDType GenerationalIDPool<GenerationalIDType>::Allocate() noexcept
+    {
+        StorageType index = 0;
+
+        if (m_freeIndices.empty()) {
+            if (m_slots.size() > IDType::MAX_INDEX) {
+                ENG_ASSERT_FAIL("Generational ID pool overflow");
+                return IDType{};
+            }
+
+            index = static_cast<StorageType>(m_slots.size());
+            m_slots.emplace_back(Slot { 0, false });
+        } else {
+            index = m_freeIndices.front();
+            m_freeIndices.pop_front();
+        }
+
+        Slot& slot = m_slots[index];
+        slot.isAllocated = true;
+        
+        ++m_allocatedCount;
+
+        return IDType(index, slot.generation);
+    }
+
+
+    template <typename GenerationalIDType>
+    inline void GenerationalIDPool<GenerationalIDType>::Deallocate(IDType& ID) noexcept
+    {
+        if (IsAllocated(ID)) {
+            const StorageType index = ID.Index();
+            Slot& slot = m_slots[index];
+
+            slot.generation = (slot.generation + StorageType(1)) & IDType::GENERATION_MASK;
+            slot.isAllocated = false;
+
+            m_freeIndices.emplace_back(index);
+            --m_allocatedCount;
+        }
+
+        ID.Invalidate();
+    }
+
+
+    template <typename GenerationalIDType>
+    inline void GenerationalIDPool<GenerationalIDType>::Reset() noexcept
+    {
+        m_slots.clear();
+        m_freeIndices.clear();
+        m_allocatedCount = 0;
+    }
+
+
+    template <typename GenerationalIDType>
+    inline bool GenerationalIDPool<GenerationalIDType>::IsAllocated(const IDType& ID) const noexcept
+    {
+        if (!ID.IsValid() || ID.Index() >= m_slots.size()) {
+            return false;
+        }
+
+        const Slot& slot = m_slots[ID.Index()];
+        return slot.isAllocated && slot.generation == ID.Generation();
+    }
+}
@@ -0,0 +1,288 @@
+#include "pch.h"
+#include "hash.h"
+
+#include "utils/cpu/cpu_features.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+  #define AM_HASH_X86
+#endif
+
+#if defined(AM_HASH_X86)
+  #include <immintrin.h>
+#endif
+
+#if defined(AM_HASH_X86) && (defined(__GNUC__) || defined(__clang__))
+  #define AM_HASH_TARGET_SSE2 __attribute__((target("sse2")))
+  #define AM_HASH_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+  #define AM_HASH_TARGET_SSE2
+  #define AM_HASH_TARGET_AVX2
+#endif
+
+
+static constexpr uint64_t HASH_PRIME_0 = 0xa0761d6478bd642full;
+static constexpr uint64_t HASH_PRIME_1 = 0xe7037ed1a0b428dbull;
+static constexpr uint64_t HASH_PRIME_2 = 0x8ebc6af09c88c6e3ull;
+static constexpr uint64_t HASH_PRIME_3 = 0x589965cc75374cc3ull;
+static constexpr uint64_t HASH_PRIME32 = 0x9e3779b1ull;
+
+static constexpr size_t HASH_STRIPE_LANES_COUNT = 8;
+static constexpr size_t HASH_STRIPE_SIZE = HASH_STRIPE_LANES_COUNT * sizeof(uint64_t);
+static constexpr size_t HASH_STRIPES_PER_BLOCK = 16;
+
+// Inputs shorter than this are hashed by the wyhash style scalar path, where stripe setup doesn't pay off
+static constexpr size_t HASH_LONG_INPUT_SIZE = 128;
+
+// First half is mixed into the stripes, second half is used for the last (possibly overlapping) stripe
+alignas(32) static constexpr uint64_t HASH_SECRET[2 * HASH_STRIPE_LANES_COUNT] = {
+    0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull, 0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+    0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull, 0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull,
+    0xcb00c391bb52283cull, 0xa32e531b8b65d088ull, 0x4ef90da297486471ull, 0xd8acdea946ef1938ull,
+    0x3f349ce33f76faa8ull, 0x1d4f0bc7c7bbdcf9ull, 0x3159b4cd4be0518aull, 0x647378d9c97e9fc8ull,
+};
+
+
+using AccumulateStripesFunc = void(*)(uint64_t* pAcc, const uint8_t* pData, size_t stripesCount, const uint64_t* pSecret) noexcept;
+
+
+static inline uint64_t Read64(const uint8_t* p) noexcept
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+
+static inline uint64_t Read32(const uint8_t* p) noexcept
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+
+static inline uint64_t ReadSmall(const uint8_t* p, size_t size) noexcept
+{
+    return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[size >> 1]) << 8) | p[size - 1];
+}
+
+
+// 64x64 -> 128 bit multiplication folded to 64 bits
+static inline uint64_t Mix(uint64_t a, uint64_t b) noexcept
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    uint64_t high;
+    const uint64_t low = _umul128(a, b, &high);
+    return low ^ high;
+#elif defined(__SIZEOF_INT128__)
+    const __uint128_t product = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+    const uint64_t aLow = a & 0xFFFFFFFFull, aHigh = a >> 32;
+    const uint64_t bLow = b & 0xFFFFFFFFull, bHigh = b >> 32;
+
+    const uint64_t ll = aLow * bLow, lh = aLow * bHigh, hl = aHigh * bLow, hh = aHigh * bHigh;
+    const uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFull) + (hl & 0xFFFFFFFFull);
+
+    const uint64_t low = (mid << 32) | (ll & 0xFFFFFFFFull);
+    const uint64_t high = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+    return low ^ high;
+#endif
+}
+
+
+static inline uint64_t Avalanche(uint64_t hash) noexcept
+{
+    hash ^= hash >> 37;
+    hash *= 0x165667919e3779f9ull;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+
+// Per lane: acc[i] += lo32(data ^ secret) * hi32(data ^ secret), acc[i ^ 1] += data
+static void AccumulateStripesScalar(uint64_t* pAcc, const uint8_t* pData, size_t stripesCount, const uint64_t* pSecret) noexcept
+{
+    for (size_t stripe = 0; stripe < stripesCount; ++stripe) {
+        const uint8_t* pStripe = pData + stripe * HASH_STRIPE_SIZE;
+
+        for (size_t lane = 0; lane < HASH_STRIPE_LANES_COUNT; ++lane) {
+            const uint64_t data = Read64(pStripe + lane * sizeof(uint64_t));
+            const uint64_t dataKey = data ^ pSecret[lane];
+
+            pAcc[lane ^ 1] += data;
+            pAcc[lane] += (dataKey & 0xFFFFFFFFull) * (dataKey >> 32);
+        }
+    }
+}
+
+
+#if defined(AM_HASH_X86)
+AM_HASH_TARGET_SSE2 static void AccumulateStripesSSE2(uint64_t* pAcc, const uint8_t* pData, size_t stripesCount, const uint64_t* pSecret) noexcept
+{
+    __m128i acc[4];
+    __m128i secret[4];
+
+    for (size_t i = 0; i < 4; ++i) {
+        acc[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pAcc) + i);
+        secret[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSecret) + i);
+    }
+
+    for (size_t stripe = 0; stripe < stripesCount; ++stripe) {
+        const __m128i* pStripe = reinterpret_cast<const __m128i*>(pData + stripe * HASH_STRIPE_SIZE);
+
+        for (size_t i = 0; i < 4; ++i) {
+            const __m128i data = _mm_loadu_si128(pStripe + i);
+            const __m128i dataKey = _mm_xor_si128(data, secret[i]);
+            const __m128i product = _mm_mul_epu32(dataKey, _mm_srli_epi64(dataKey, 32));
+            const __m128i dataSwapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+
+            acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(product, dataSwapped));
+        }
+    }
+
+    for (size_t i = 0; i < 4; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pAcc) + i, acc[i]);
+    }
+}
+
+
+AM_HASH_TARGET_AVX2 static void AccumulateStripesAVX2(uint64_t* pAcc, const uint8_t* pData, size_t stripesCount, const uint64_t* pSecret) noexcept
+{
+    __m256i acc[2];
+    __m256i secret[2];
+
+    for (size_t i = 0; i < 2; ++i) {
+        acc[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pAcc) + i);
+        secret[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSecret) + i);
+    }
+
+    for (size_t stripe = 0; stripe < stripesCount; ++stripe) {
+        const __m256i* pStripe = reinterpret_cast<const __m256i*>(pData + stripe * HASH_STRIPE_SIZE);
+
+        for (size_t i = 0; i < 2; ++i) {
+            const __m256i data = _mm256_loadu_si256(pStripe + i);
+            const __m256i dataKey = _mm256_xor_si256(data, secret[i]);
+            const __m256i product = _mm256_mul_epu32(dataKey, _mm256_srli_epi64(dataKey, 32));
+            // Shuffles within 128 bit lanes, so lane pairs match the scalar path
+            const __m256i dataSwapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+
+            acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(product, dataSwapped));
+        }
+    }
+
+    for (size_t i = 0; i < 2; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pAcc) + i, acc[i]);
+    }
+}
+#endif
+
+
+static AccumulateStripesFunc SelectAccumulateStripesFunc() noexcept
+{
+#if defined(AM_HASH_X86)
+    if (IsCPUAVX2Supported()) {
+        return AccumulateStripesAVX2;
+    }
+
+    #if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        return AccumulateStripesSSE2;
+    #endif
+#endif
+
+    return AccumulateStripesScalar;
+}
+
+
+static void ScrambleAccumulators(uint64_t* pAcc) noexcept
+{
+    for (size_t lane = 0; lane < HASH_STRIPE_LANES_COUNT; ++lane) {
+        uint64_t acc = pAcc[lane];
+
+        acc ^= acc >> 47;
+        acc ^= HASH_SECRET[HASH_STRIPE_LANES_COUNT + lane];
+        acc *= HASH_PRIME32;
+
+        pAcc[lane] = acc;
+    }
+}
+
+
+static uint64_t HashShort(const uint8_t* p, size_t size) noexcept
+{
+    uint64_t seed = HASH_PRIME_0 ^ Mix(size ^ HASH_PRIME_0, HASH_PRIME_1);
+    uint64_t a = 0;
+    uint64_t b = 0;
+
+    if (size <= 16) {
+        if (size >= 4) {
+            const size_t offset = (size >> 3) << 2;
+
+            a = (Read32(p) << 32) | Read32(p + offset);
+            b = (Read32(p + size - 4) << 32) | Read32(p + size - 4 - offset);
+        } else if (size > 0) {
+            a = ReadSmall(p, size);
+        }
+    } else {
+        size_t remaining = size;
+
+        while (remaining > 16) {
+            seed = Mix(Read64(p) ^ HASH_PRIME_1, Read64(p + 8) ^ seed);
+
+            p += 16;
+            remaining -= 16;
+        }
+
+        // Last 16 bytes may overlap already processed ones
+        a = Read64(p + remaining - 16);
+        b = Read64(p + remaining - 8);
+    }
+
+    return Mix(HASH_PRIME_1 ^ size, Mix(a ^ HASH_PRIME_1, b ^ seed));
+}
+
+
+static uint64_t HashLong(const uint8_t* p, size_t size) noexcept
+{
+    static const AccumulateStripesFunc AccumulateStripes = SelectAccumulateStripesFunc();
+
+    alignas(32) uint64_t acc[HASH_STRIPE_LANES_COUNT] = {
+        HASH_PRIME32, HASH_PRIME_0, HASH_PRIME_1, HASH_PRIME_2,
+        HASH_PRIME_3, HASH_PRIME32 << 32, HASH_PRIME_0 >> 1, HASH_PRIME_1 >> 1,
+    };
+
+    const size_t fullStripesCount = (size - 1) / HASH_STRIPE_SIZE;
+    const size_t blocksCount = fullStripesCount / HASH_STRIPES_PER_BLOCK;
+
+    for (size_t block = 0; block < blocksCount; ++block) {
+        AccumulateStripes(acc, p + block * HASH_STRIPES_PER_BLOCK * HASH_STRIPE_SIZE, HASH_STRIPES_PER_BLOCK, HASH_SECRET);
+        ScrambleAccumulators(acc);
+    }
+
+    const size_t tailStripesCount = fullStripesCount - blocksCount * HASH_STRIPES_PER_BLOCK;
+    AccumulateStripes(acc, p + blocksCount * HASH_STRIPES_PER_BLOCK * HASH_STRIPE_SIZE, tailStripesCount, HASH_SECRET);
+
+    // Last stripe always ends at the end of the input, so it may overlap the previous one
+    AccumulateStripes(acc, p + size - HASH_STRIPE_SIZE, 1, HASH_SECRET + HASH_STRIPE_LANES_COUNT);
+
+    uint64_t hash = size * HASH_PRIME_0;
+
+    for (size_t lane = 0; lane < HASH_STRIPE_LANES_COUNT; lane += 2) {
+        hash += Mix(acc[lane] ^ HASH_SECRET[lane], acc[lane + 1] ^ HASH_SECRET[lane + 1]);
+    }
+
+    return Avalanche(hash);
+}
+
+
+uint64_t amHashMem(const void* data, size_t size) noexcept
+{
+    if (!data || size == 0) {
+        return 0;
+    }
+
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+
+    return size < HASH_LONG_INPUT_SIZE ? HashShort(p, size) : HashLong(p, size);
+}
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <type_traits>
+#include <string_view>
 
 
 template <typename T>
@@ -14,37 +15,41 @@ inline uint64_t amHash(const T& value) noexcept
 }
 
 
-inline uint64_t amHashMem(const void* data, size_t size) noexcept
+// FNV-1a 64 bit. Unlike std::hash it can be evaluated at compile time and gives the same values across builds and platforms
+// (as long as the size of ElemT matches), so the results can be serialized
+template <typename ElemT>
+inline constexpr uint64_t amHashStr(const ElemT* str, size_t length) noexcept
 {
-    if (!data || size == 0) {
-        return 0;
-    }
+    constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+    constexpr uint64_t FNV_PRIME = 1099511628211ull;
 
-    const uint64_t* ptr = reinterpret_cast<const uint64_t*>(data);
-
-    uint64_t hash = 0;
-    int64_t remaining = size / sizeof(uint64_t);
-    
-    while (remaining > 0) {
-        hash ^= *ptr++;
-        hash *= 1103515245ull;
-        hash ^= *ptr++;
-        hash *= 1103515245ull;
-        remaining -= (int64_t)sizeof(uint64_t);
-    }
+    uint64_t hash = FNV_OFFSET_BASIS;
 
-    const uint8_t* tail = reinterpret_cast<const uint8_t*>(ptr);
-    const size_t tailLength = size % sizeof(uint64_t);
+    for (size_t i = 0; i < length; ++i) {
+        const uint64_t elem = static_cast<std::make_unsigned_t<ElemT>>(str[i]);
 
-    for (size_t i = 0; i < tailLength; ++i) {
-        hash ^= static_cast<uint64_t>(tail[i]) << (i * 8);
-        hash *= 1103515245ull;
+        for (size_t byte = 0; byte < sizeof(ElemT); ++byte) {
+            hash ^= (elem >> (byte * 8ull)) & 0xFFull;
+            hash *= FNV_PRIME;
+        }
     }
 
     return hash;
 }
 
 
+template <typename ElemT>
+inline constexpr uint64_t amHashStr(std::basic_string_view<ElemT> str) noexcept
+{
+    return amHashStr(str.data(), str.length());
+}
+
+
+// wyhash/xxh3 style memory hash. Long inputs are processed in 64 byte stripes with SSE2/AVX2 paths selected at runtime,
+// every path produces the same value
+uint64_t amHashMem(const void* data, size_t size) noexcept;
+
+
 namespace ds
 {
     class HashBuilder
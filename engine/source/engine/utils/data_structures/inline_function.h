@@ -0,0 +1,75 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cstddef>
+#include <cstring>
+
+#include "utils/debug/assertion.h"
+
+
+namespace ds
+{
+    template <typename Signature, size_t CAPACITY = 32ull>
+    class InlineFunction;
+
+
+    // std::function replacement which keeps the callable in fixed inline storage. There is no heap fallback:
+    // callables which don't fit in CAPACITY bytes are rejected at compile time.
+    // Trivially copyable callables (e.g. lambdas capturing 'this' or PODs) are copied with memcpy and need no destructor call
+    template <typename R, typename... Args, size_t CAPACITY>
+    class InlineFunction<R(Args...), CAPACITY>
+    {
+    public:
+        InlineFunction() = default;
+        InlineFunction(std::nullptr_t) noexcept {}
+
+        template <typename FuncT, typename = std::enable_if_t<!std::is_same_v<std::decay_t<FuncT>, InlineFunction>>>
+        InlineFunction(FuncT&& func) noexcept;
+
+        InlineFunction(const InlineFunction& other) noexcept;
+        InlineFunction& operator=(const InlineFunction& other) noexcept;
+
+        InlineFunction(InlineFunction&& other) noexcept;
+        InlineFunction& operator=(InlineFunction&& other) noexcept;
+
+        ~InlineFunction() { Reset(); }
+
+        R operator()(Args... args) const;
+
+        void Reset() noexcept;
+
+        explicit operator bool() const noexcept { return m_pInvoke != nullptr; }
+
+    private:
+        enum class ManageOp : uint8_t
+        {
+            COPY,
+            MOVE,
+            DESTROY,
+        };
+
+        using InvokeFunc = R(*)(void* pStorage, Args&&... args);
+        using ManageFunc = void(*)(ManageOp op, void* pDstStorage, void* pSrcStorage) noexcept;
+
+        template <typename FuncT>
+        static R Invoke(void* pStorage, Args&&... args);
+
+        template <typename FuncT>
+        static void Manage(ManageOp op, void* pDstStorage, void* pSrcStorage) noexcept;
+
+        void CopyFrom(const InlineFunction& other) noexcept;
+        void MoveFrom(InlineFunction& other) noexcept;
+
+    private:
+        alignas(std::max_align_t) std::byte m_storage[CAPACITY];
+
+        InvokeFunc m_pInvoke = nullptr;
+        // nullptr for trivially copyable callables
+        ManageFunc m_pManage = nullptr;
+    };
+}
+
+
+#include "inline_function.hpp"
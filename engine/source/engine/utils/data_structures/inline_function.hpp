@@ -0,0 +1,140 @@
+namespace ds
+{
+    template <typename R, typename... Args, size_t CAPACITY>
+    template <typename FuncT, typename>
+    inline InlineFunction<R(Args...), CAPACITY>::InlineFunction(FuncT&& func) noexcept
+    {
+        using CallableType = std::decay_t<FuncT>;
+
+        static_assert(sizeof(CallableType) <= CAPACITY, "Callable doesn't fit in InlineFunction storage, increase CAPACITY");
+        static_assert(alignof(CallableType) <= alignof(std::max_align_t), "Callable is overaligned for InlineFunction storage");
+        static_assert(std::is_invocable_r_v<R, CallableType&, Args...>, "Callable signature mismatch");
+        static_assert(std::is_nothrow_move_constructible_v<CallableType>, "Callable must be nothrow move constructible");
+
+        new (m_storage) CallableType(std::forward<FuncT>(func));
+        
+        m_pInvoke = &Invoke<CallableType>;
+        m_pManage = std::is_trivially_copyable_v<CallableType> ? nullptr : &Manage<CallableType>;
+    }
+
+
+    template <typename R, typename... Args, size_t CAPACITY>
+    inline InlineFunction<R(Args...), CAPACITY>::InlineFunction(const InlineFunction& other) noexcept
+    {
+        CopyFrom(other);
+    }
+
+
+    template <typename R, typename... Args, size_t CAPACITY>
+    inline InlineFunction<R(Args...), CAPACITY>& InlineFunction<R(Args...), CAPACITY>::operator=(const InlineFunction& other) noexcept
+    {
+        if (this != &other) {
+            Reset();
+            CopyFrom(other);
+        }
+
+        return *this;
+    }
+
+
+    template <typename R, typename... Args, size_t CAPACITY>
+    inline InlineFunction<R(Args...), CAPACITY>::InlineFunction(InlineFunction&& other) noexcept
+    {
+        MoveFrom(other);
+    }
+
+
+    template <typename R, typename... Args, size_t CAPACITY>
+    inline InlineFunction<R(Args...), CAPACITY>& InlineFunction<R(Args...), CAPACITY>::operator=(InlineFunction&& other) noexcept
+    {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+
+        return *this;
+    }
+
+
+    template <typename R, typename... Args, size_t CAPACITY>
+    inline R InlineFunction<R(Args...), CAPACITY>::operator()(Args... args) const
+    {
+        ENG_ASSERT(m_pInvoke, "Attempt to call empty InlineFunction");
+        return m_pInvoke(const_cast<std::byte*>(m_storage), std::forward<Args>(args)...);
+    }
+
+
+    template <typename R, typename... Args, size_t CAPACITY>
+    inline void InlineFunction<R(Args...), CAPACITY>::Reset() noexcept
+    {
+        if (m_pManage) {
+            m_pManage(ManageOp::DESTROY, m_storage, nullptr);
+        }
+
+        m_pInvoke = nullptr;
+        m_pManage = nullptr;
+    }
+
+
+    template <typename R, typename... Args, size_t CAPACITY>
+    template <typename FuncT>
+    inline R InlineFunction<R(Args...), CAPACITY>::Invoke(void* pStorage, Args&&... args)
+    {
+        return (*static_cast<FuncT*>(pStorage))(std::forward<Args>(args)...);
+    }
+
+
+    template <typename R, typename... Args, size_t CAPACITY>
+    template <typename FuncT>
+    inline void InlineFunction<R(Args...), CAPACITY>::Manage(ManageOp op, void* pDstStorage, void* pSrcStorage) noexcept
+    {
+        switch (op) {
+            case ManageOp::COPY:
+                // Move only callables are accepted as long as the InlineFunction holding them is never copied
+                if constexpr (std::is_copy_constructible_v<FuncT>) {
+                    new (pDstStorage) FuncT(*static_cast<const FuncT*>(pSrcStorage));
+                } else {
+                    ENG_ASSERT_FAIL("Attempt to copy InlineFunction holding move only callable");
+                }
+                break;
+            case ManageOp::MOVE:
+                new (pDstStorage) FuncT(std::move(*static_cast<FuncT*>(pSrcStorage)));
+                static_cast<FuncT*>(pSrcStorage)->~FuncT();
+                break;
+            case ManageOp::DESTROY:
+                static_cast<FuncT*>(pDstStorage)->~FuncT();
+                break;
+        }
+    }
+
+
+    template <typename R, typename... Args, size_t CAPACITY>
+    inline void InlineFunction<R(Args...), CAPACITY>::CopyFrom(const InlineFunction& other) noexcept
+    {
+        if (other.m_pManage) {
+            other.m_pManage(ManageOp::COPY, m_storage, const_cast<std::byte*>(other.m_storage));
+        } else if (other.m_pInvoke) {
+            memcpy(m_storage, other.m_storage, CAPACITY);
+        }
+
+        m_pInvoke = other.m_pInvoke;
+        m_pManage = other.m_pManage;
+    }
+
+
+    template <typename R, typename... Args, size_t CAPACITY>
+    inline void InlineFunction<R(Args...), CAPACITY>::MoveFrom(InlineFunction& other) noexcept
+    {
+        if (other.m_pManage) {
+            other.m_pManage(ManageOp::MOVE, m_storage, other.m_storage);
+        } else if (other.m_pInvoke) {
+            memcpy(m_storage, other.m_storage, CAPACITY);
+        }
+
+        m_pInvoke = other.m_pInvoke;
+        m_pManage = other.m_pManage;
+
+        other.m_pInvoke = nullptr;
+        other.m_pManage = nullptr;
+    }
+}
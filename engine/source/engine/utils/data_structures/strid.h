@@ -1,8 +1,14 @@
 #pragma once
 
-#include <unordered_map>
 #include <string_view>
 #include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <limits>
+#include <algorithm>
 
 #include <cstdint>
 
@@ -14,6 +20,10 @@
 
 namespace ds
 {
+    // Thread safe string interner. Strings are distributed across shards by their hash. Each shard owns an open addressing
+    // table which is read without locks and a mutex which serializes inserts into the shard only.
+    // Strings are placed into chunked arenas which are never reallocated, so pointers returned by Load stay valid for the whole
+    // lifetime of the storage
     template <typename ElemT>
     class StrIDDataStorage
     {
@@ -26,47 +36,103 @@ namespace ds
         using StringType = std::basic_string<ElementType, std::char_traits<ElementType>, std::allocator<ElementType>>;
 
     public:
-        uint64_t Store(const StringViewType& str) noexcept;
-        uint64_t Store(const ElementType* str)    noexcept { return Store(StringViewType(str)); }
+        uint64_t Store(const StringViewType& str) noexcept { return str.data() ? Store(str, amHashStr(str)) : INVALID_ID_HASH; }
+        uint64_t Store(const ElementType* str)    noexcept { return str ? Store(StringViewType(str)) : INVALID_ID_HASH; }
         uint64_t Store(const StringType& str)     noexcept { return Store(StringViewType(str)); }
 
+        // Stores string with hash precomputed by amHashStr. Used by StrIDLiteralImpl to skip hashing at runtime
+        uint64_t Store(const StringViewType& str, uint64_t id) noexcept;
+
         const ElementType* Load(uint64_t id) const noexcept;
 
-        bool IsExist(uint64_t id) const noexcept { return m_strBufLocations.find(id) != m_strBufLocations.cend(); } 
+        bool IsExist(uint64_t id) const noexcept { return Load(id) != nullptr; } 
 
-        uint64_t GetCapacity() const noexcept { return m_storage.capacity(); }
-        uint64_t GetSize() const noexcept { return m_size; }
+        uint64_t GetCapacity() const noexcept { return m_capacity.load(std::memory_order_relaxed); }
+        uint64_t GetSize() const noexcept { return m_size.load(std::memory_order_relaxed); }
 
     private:
-        StrIDDataStorage();    
+        StrIDDataStorage();
     
     private:
-
         static inline constexpr uint64_t INVALID_ID_HASH = std::numeric_limits<uint64_t>::max();
         static inline constexpr size_t PREALLOCATED_IDS_COUNT = 8192ull;
         
         static inline constexpr size_t AVERAGE_STR_SIZE = 32ull;
         static inline constexpr size_t PREALLOCATED_STORAGE_SIZE = PREALLOCATED_IDS_COUNT * AVERAGE_STR_SIZE;
 
+        static inline constexpr uint64_t SHARDS_COUNT_LOG2 = 5ull;
+        static inline constexpr uint64_t SHARDS_COUNT = 1ull << SHARDS_COUNT_LOG2;
+
+        static inline constexpr size_t SHARD_ARENA_CHUNK_SIZE = PREALLOCATED_STORAGE_SIZE / SHARDS_COUNT;
+        static inline constexpr size_t SHARD_TABLE_INITIAL_CAPACITY = 2ull * PREALLOCATED_IDS_COUNT / SHARDS_COUNT;
+
     private:
-        // We generate a unique hash in the Store method, and we don't want to hash the already unique value again, 
-        // so we use a proxy hasher
-        struct StringIdHasher
+        struct Slot
         {
-            inline constexpr uint64_t operator()(uint64_t id) const noexcept { return id; }
+            std::atomic<uint64_t> id;
+            std::atomic<const ElementType*> pStr;
         };
 
-        struct StringBufLocation
+        struct Table
         {
-            uint32_t offset;
-            uint32_t length;
+            std::unique_ptr<Slot[]> pSlots;
+            uint64_t capacity;
         };
 
-        std::unordered_map<uint64_t, StringBufLocation, StringIdHasher> m_strBufLocations;
-        std::vector<ElementType> m_storage;
-        
-        uint64_t m_size = 0;
-        uint64_t m_lastAllocatedID = INVALID_ID_HASH;
+        struct alignas(64) Shard
+        {
+            // Published table. Readers only ever see fully built tables, replaced ones are retired but kept alive
+            // since lock free readers may still probe them
+            std::atomic<const Table*> pTable = nullptr;
+
+            std::mutex mutex;
+            std::vector<std::unique_ptr<Table>> tables;
+            std::vector<std::unique_ptr<ElementType[]>> arenaChunks;
+            size_t arenaChunkOffset = 0;
+            size_t arenaChunkSize = 0;
+            uint64_t count = 0;
+        };
+
+    private:
+        Shard& GetShard(uint64_t id) noexcept { return m_shards[id >> (64ull - SHARDS_COUNT_LOG2)]; }
+        const Shard& GetShard(uint64_t id) const noexcept { return m_shards[id >> (64ull - SHARDS_COUNT_LOG2)]; }
+
+        static std::unique_ptr<Table> CreateTable(uint64_t capacity) noexcept;
+        static const ElementType* FindInTable(const Table* pTable, uint64_t id) noexcept;
+        static void InsertIntoTable(const Table* pTable, uint64_t id, const ElementType* pStr) noexcept;
+
+        const Table* GrowTable(Shard& shard) noexcept;
+        const ElementType* AllocateString(Shard& shard, const StringViewType& str) noexcept;
+
+    private:
+        std::array<Shard, SHARDS_COUNT> m_shards;
+
+        std::atomic<uint64_t> m_size = 0;
+        std::atomic<uint64_t> m_capacity = 0;
+    };
+
+
+    // Compile time string ID. Created with _sid literal: "cube"_sid.
+    // Its hash is a constant expression, so it can be used as switch case or template argument: case "cube"_sid.Hash():
+    template <typename ElemT>
+    class StrIDLiteralImpl
+    {
+    public:
+        using ElementType = ElemT;
+        using StringViewType = std::basic_string_view<ElementType>;
+
+    public:
+        constexpr StrIDLiteralImpl(const ElementType* str, size_t length) noexcept
+            : m_str(str, length), m_id(amHashStr(str, length))
+        {}
+
+        constexpr StringViewType GetStr() const noexcept { return m_str; }
+        constexpr uint64_t GetId() const noexcept { return m_id; }
+        constexpr uint64_t Hash() const noexcept { return m_id; }
+
+    private:
+        StringViewType m_str;
+        uint64_t m_id;
     };
 
 
@@ -90,10 +156,11 @@ namespace ds
         StrIDImpl(const ElementType* str);
         StrIDImpl(const StringType& str);
         StrIDImpl(const StringViewType& str);
+        StrIDImpl(const StrIDLiteralImpl<ElementType>& str);
 
         StrIDImpl& operator=(const ElementType* str)    noexcept;
         StrIDImpl& operator=(const StringType& str)     noexcept { return operator=(str.c_str()); }
-        StrIDImpl& operator=(const StringViewType& str) noexcept { return operator=(str.data()); }
+        StrIDImpl& operator=(const StringViewType& str) noexcept;
 
         const ElementType* CStr() const noexcept;
 
@@ -123,6 +190,21 @@ namespace ds
 
     using StrID = StrIDImpl<char>;
     using WStrID = StrIDImpl<wchar_t>;
+
+    using StrIDLiteral = StrIDLiteralImpl<char>;
+    using WStrIDLiteral = StrIDLiteralImpl<wchar_t>;
+}
+
+
+inline constexpr ds::StrIDLiteral operator""_sid(const char* str, size_t length) noexcept
+{
+    return ds::StrIDLiteral(str, length);
+}
+
+
+inline constexpr ds::WStrIDLiteral operator""_sid(const wchar_t* str, size_t length) noexcept
+{
+    return ds::WStrIDLiteral(str, length);
 }
 
 namespace std {
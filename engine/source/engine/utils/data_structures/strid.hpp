@@ -3,54 +3,162 @@ namespace ds
     template <typename ElemT>
     inline StrIDDataStorage<ElemT>::StrIDDataStorage()
     {
-        m_strBufLocations.reserve(PREALLOCATED_IDS_COUNT);
-        m_storage.resize(PREALLOCATED_STORAGE_SIZE);
+        for (Shard& shard : m_shards) {
+            std::unique_ptr<Table> pTable = CreateTable(SHARD_TABLE_INITIAL_CAPACITY);
+            shard.pTable.store(pTable.get(), std::memory_order_release);
+            shard.tables.emplace_back(std::move(pTable));
+        }
+    }
+
+
+    template <typename ElemT>
+    inline uint64_t StrIDDataStorage<ElemT>::Store(const StrIDDataStorage<ElemT>::StringViewType &str, uint64_t id) noexcept
+    {
+        ENG_ASSERT(id != INVALID_ID_HASH, "StrID hash collides with invalid ID hash");
+
+        Shard& shard = GetShard(id);
+
+        // Fast path: most of the StrIDs are constructed from already stored strings, so we try to avoid locking
+        if (FindInTable(shard.pTable.load(std::memory_order_acquire), id)) {
+            return id;
+        }
+
+        std::scoped_lock lock(shard.mutex);
+
+        const Table* pTable = shard.pTable.load(std::memory_order_relaxed);
+
+        if (FindInTable(pTable, id)) {
+            return id;
+        }
+
+        // Keep load factor below 0.5 to have short probe sequences
+        if ((shard.count + 1ull) * 2ull > pTable->capacity) {
+            pTable = GrowTable(shard);
+        }
+
+        InsertIntoTable(pTable, id, AllocateString(shard, str));
+        ++shard.count;
+
+        return id;
+    }
+
+
+    template <typename ElemT>
+    inline const typename StrIDDataStorage<ElemT>::ElementType* StrIDDataStorage<ElemT>::Load(uint64_t id) const noexcept
+    {
+        if (id == INVALID_ID_HASH) {
+            return nullptr;
+        }
+
+        return FindInTable(GetShard(id).pTable.load(std::memory_order_acquire), id);
     }
 
 
     template <typename ElemT>
-    inline uint64_t StrIDDataStorage<ElemT>::Store(const StrIDDataStorage<ElemT>::StringViewType &str) noexcept
+    inline std::unique_ptr<typename StrIDDataStorage<ElemT>::Table> StrIDDataStorage<ElemT>::CreateTable(uint64_t capacity) noexcept
     {
-        if (!str.data()) {
-            return INVALID_ID_HASH;
+        ENG_ASSERT((capacity & (capacity - 1ull)) == 0, "StrID table capacity must be power of 2");
+
+        std::unique_ptr<Table> pTable = std::make_unique<Table>();
+        pTable->pSlots = std::make_unique<Slot[]>(capacity);
+        pTable->capacity = capacity;
+
+        for (uint64_t i = 0; i < capacity; ++i) {
+            pTable->pSlots[i].id.store(INVALID_ID_HASH, std::memory_order_relaxed);
+            pTable->pSlots[i].pStr.store(nullptr, std::memory_order_relaxed);
         }
 
-        const uint64_t id = amHash(str);
+        return pTable;
+    }
 
-        if (!IsExist(id)) {
-            StringBufLocation& newStrBufLocation = m_strBufLocations[id];
-            
-            newStrBufLocation.length = str.length() + 1; // including null terminator
 
-            if (m_lastAllocatedID != INVALID_ID_HASH) {
-                const StringBufLocation& lastStrBufLocation = m_strBufLocations[m_lastAllocatedID];
+    template <typename ElemT>
+    inline const typename StrIDDataStorage<ElemT>::ElementType* StrIDDataStorage<ElemT>::FindInTable(const Table* pTable, uint64_t id) noexcept
+    {
+        const uint64_t mask = pTable->capacity - 1ull;
+
+        // Table always has free slots, so the probing is bounded
+        for (uint64_t i = id & mask; ; i = (i + 1ull) & mask) {
+            const Slot& slot = pTable->pSlots[i];
+            const uint64_t slotID = slot.id.load(std::memory_order_acquire);
+
+            if (slotID == id) {
+                return slot.pStr.load(std::memory_order_relaxed);
+            }
 
-                newStrBufLocation.offset = lastStrBufLocation.offset + lastStrBufLocation.length;
+            if (slotID == INVALID_ID_HASH) {
+                return nullptr;
             }
+        }
+    }
+
+
+    template <typename ElemT>
+    inline void StrIDDataStorage<ElemT>::InsertIntoTable(const Table* pTable, uint64_t id, const ElementType* pStr) noexcept
+    {
+        const uint64_t mask = pTable->capacity - 1ull;
+
+        for (uint64_t i = id & mask; ; i = (i + 1ull) & mask) {
+            Slot& slot = pTable->pSlots[i];
 
-            const uint64_t newSize = newStrBufLocation.offset + newStrBufLocation.length;
-            
-            if (newSize > m_storage.size()) {
-                ENG_ASSERT_FAIL("StrID storage overflow, think about increasing the size of the storage buffer");
-                m_storage.resize(newSize * 2ull);
+            if (slot.id.load(std::memory_order_relaxed) == INVALID_ID_HASH) {
+                // String pointer must be visible before the readers are able to match the ID
+                slot.pStr.store(pStr, std::memory_order_relaxed);
+                slot.id.store(id, std::memory_order_release);
+                return;
             }
+        }
+    }
 
-            std::copy_n(str.begin(), newStrBufLocation.length - 1, m_storage.begin() + newStrBufLocation.offset);
 
-            m_size = newSize;
-            m_lastAllocatedID = id;
+    template <typename ElemT>
+    inline const typename StrIDDataStorage<ElemT>::Table* StrIDDataStorage<ElemT>::GrowTable(Shard& shard) noexcept
+    {
+        const Table* pOldTable = shard.pTable.load(std::memory_order_relaxed);
+        std::unique_ptr<Table> pNewTable = CreateTable(pOldTable->capacity * 2ull);
+
+        for (uint64_t i = 0; i < pOldTable->capacity; ++i) {
+            const Slot& slot = pOldTable->pSlots[i];
+            const uint64_t slotID = slot.id.load(std::memory_order_relaxed);
+
+            if (slotID != INVALID_ID_HASH) {
+                InsertIntoTable(pNewTable.get(), slotID, slot.pStr.load(std::memory_order_relaxed));
+            }
         }
 
-        return id;
+        const Table* pTable = pNewTable.get();
+        shard.tables.emplace_back(std::move(pNewTable));
+        shard.pTable.store(pTable, std::memory_order_release);
+
+        return pTable;
     }
 
 
     template <typename ElemT>
-    inline const typename StrIDDataStorage<ElemT>::ElementType* StrIDDataStorage<ElemT>::Load(uint64_t id) const noexcept
+    inline const typename StrIDDataStorage<ElemT>::ElementType* StrIDDataStorage<ElemT>::AllocateString(Shard& shard, const StringViewType& str) noexcept
     {
-        const auto strBufLocationIt = m_strBufLocations.find(id);
+        const size_t length = str.length() + 1; // including null terminator
+
+        if (shard.arenaChunkOffset + length > shard.arenaChunkSize) {
+            // Chunks are never reallocated, so already returned pointers stay valid
+            const size_t chunkSize = std::max(SHARD_ARENA_CHUNK_SIZE, length);
+
+            shard.arenaChunks.emplace_back(std::make_unique<ElementType[]>(chunkSize));
+            shard.arenaChunkOffset = 0;
+            shard.arenaChunkSize = chunkSize;
+
+            m_capacity.fetch_add(chunkSize, std::memory_order_relaxed);
+        }
+
+        ElementType* pStr = shard.arenaChunks.back().get() + shard.arenaChunkOffset;
+        
+        std::copy_n(str.begin(), length - 1, pStr);
+        pStr[length - 1] = ElementType(0);
+
+        shard.arenaChunkOffset += length;
+        m_size.fetch_add(length, std::memory_order_relaxed);
 
-        return strBufLocationIt == m_strBufLocations.cend() ? nullptr : m_storage.data() + strBufLocationIt->second.offset;
+        return pStr;
     }
 
 
@@ -84,6 +192,16 @@ namespace ds
     }
 
 
+    template <typename ElemT>
+    inline StrIDImpl<ElemT>::StrIDImpl(const StrIDLiteralImpl<ElementType> &str)
+        : m_id(s_storage.Store(str.GetStr(), str.GetId()))
+    {
+    #if defined(ENG_DEBUG)
+        m_pStr = s_storage.Load(m_id);
+    #endif
+    }
+
+
     template <typename ElemT>
     inline StrIDImpl<ElemT>& StrIDImpl<ElemT>::operator=(const typename StrIDImpl<ElemT>::ElementType *str) noexcept
     {
@@ -96,6 +214,18 @@ namespace ds
     }
     
     
+    template <typename ElemT>
+    inline StrIDImpl<ElemT>& StrIDImpl<ElemT>::operator=(const typename StrIDImpl<ElemT>::StringViewType &str) noexcept
+    {
+        m_id = s_storage.Store(str);
+    #if defined(ENG_DEBUG)
+        m_pStr = s_storage.Load(m_id);
+    #endif
+
+        return *this;
+    }
+    
+    
     template <typename ElemT>
     inline const ElemT* StrIDImpl<ElemT>::CStr() const noexcept
     {
@@ -0,0 +1,667 @@
+#include "pch.h"
+
+#include "async_file_reader.h"
+
+#include "utils/debug/assertion.h"
+
+#if defined(__linux__)
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+
+    #include <cerrno>
+#endif
+
+
+static std::unique_ptr<AsyncFileReader> pAsyncFileReaderInst = nullptr;
+
+
+#define ASSERT_ASYNC_FILE_READER_INIT_STATUS() ENG_ASSERT(engIsAsyncFileReaderInitialized(), "Async file reader is not initialized")
+
+
+static void ReadFileBlocking(FileReadResult& result) noexcept
+{
+    std::ifstream file(result.filepath, std::ios_base::ate | std::ios_base::binary);
+    if (!file.is_open()) {
+        ENG_LOG_WARN("Async file reading error. Failed to open {} file.", result.filepath.string().c_str());
+        return;
+    }
+
+    const std::streamoff fileSize = file.tellg();
+    if (fileSize < 0) {
+        ENG_LOG_WARN("Async file reading error. Failed to get {} file size.", result.filepath.string().c_str());
+        return;
+    }
+
+    result.dataSize = static_cast<size_t>(fileSize);
+
+    if (result.dataSize > 0) {
+        result.pData = std::unique_ptr<uint8_t[]>(new uint8_t[result.dataSize]);
+
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(result.pData.get()), fileSize);
+
+        if (!file) {
+            ENG_LOG_WARN("Async file reading error. Failed to read {} file.", result.filepath.string().c_str());
+            
+            result.pData = nullptr;
+            result.dataSize = 0;
+            return;
+        }
+    }
+
+    result.isSucceeded = true;
+}
+
+
+#if defined(__linux__)
+static constexpr uint32_t IO_URING_ENTRIES_COUNT = 64;
+
+// Large files are split into chunks, so that several reads of one file are in flight at once
+static constexpr uint32_t IO_URING_READ_CHUNK_SIZE = 1024 * 1024;
+
+
+// Minimal io_uring queue on top of raw syscalls, so the engine doesn't depend on liburing.
+// Owned by a single IO thread which both submits reads and reaps their completions
+class IOURingQueue
+{
+public:
+    IOURingQueue() = default;
+    ~IOURingQueue() { Destroy(); }
+
+    IOURingQueue(const IOURingQueue& other) = delete;
+    IOURingQueue& operator=(const IOURingQueue& other) = delete;
+
+    bool Init(uint32_t entriesCount) noexcept
+    {
+        io_uring_params params = {};
+
+        const int ringFD = static_cast<int>(syscall(__NR_io_uring_setup, entriesCount, &params));
+        if (ringFD < 0) {
+            return false;
+        }
+
+        m_ringFD = ringFD;
+
+        m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        const bool isSingleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (isSingleMmap) {
+            m_sqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+            m_cqRingSize = m_sqRingSize;
+        }
+
+        m_pSQRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFD, IORING_OFF_SQ_RING);
+        if (m_pSQRing == MAP_FAILED) {
+            Destroy();
+            return false;
+        }
+
+        m_pCQRing = isSingleMmap ? m_pSQRing : mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFD, IORING_OFF_CQ_RING);
+        if (m_pCQRing == MAP_FAILED) {
+            Destroy();
+            return false;
+        }
+
+        m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+        void* pSQEs = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFD, IORING_OFF_SQES);
+        if (pSQEs == MAP_FAILED) {
+            Destroy();
+            return false;
+        }
+
+        m_pSQEs = static_cast<io_uring_sqe*>(pSQEs);
+
+        uint8_t* pSQRing = static_cast<uint8_t*>(m_pSQRing);
+        m_pSQHead = reinterpret_cast<uint32_t*>(pSQRing + params.sq_off.head);
+        m_pSQTail = reinterpret_cast<uint32_t*>(pSQRing + params.sq_off.tail);
+        m_pSQArray = reinterpret_cast<uint32_t*>(pSQRing + params.sq_off.array);
+        m_sqMask = *reinterpret_cast<uint32_t*>(pSQRing + params.sq_off.ring_mask);
+
+        uint8_t* pCQRing = static_cast<uint8_t*>(m_pCQRing);
+        m_pCQHead = reinterpret_cast<uint32_t*>(pCQRing + params.cq_off.head);
+        m_pCQTail = reinterpret_cast<uint32_t*>(pCQRing + params.cq_off.tail);
+        m_pCQEs = reinterpret_cast<io_uring_cqe*>(pCQRing + params.cq_off.cqes);
+        m_cqMask = *reinterpret_cast<uint32_t*>(pCQRing + params.cq_off.ring_mask);
+
+        // Completion queue is at least as large as the submission one, limiting in flight reads by it means completions never overflow
+        m_maxInFlightCount = params.sq_entries;
+
+        return true;
+    }
+
+
+    void Destroy() noexcept
+    {
+        if (m_pSQEs) {
+            munmap(m_pSQEs, m_sqesSize);
+        }
+
+        if (m_pCQRing != MAP_FAILED && m_pCQRing != m_pSQRing) {
+            munmap(m_pCQRing, m_cqRingSize);
+        }
+
+        if (m_pSQRing != MAP_FAILED) {
+            munmap(m_pSQRing, m_sqRingSize);
+        }
+
+        if (m_ringFD >= 0) {
+            close(m_ringFD);
+        }
+
+        m_pSQRing = MAP_FAILED;
+        m_pCQRing = MAP_FAILED;
+        m_pSQEs = nullptr;
+        m_ringFD = -1;
+        m_inFlightCount = 0;
+        m_unsubmittedCount = 0;
+    }
+
+
+    // Returns false if too many reads are already in flight
+    bool PushRead(int fd, void* pBuffer, uint32_t size, uint64_t offset, uint64_t userData) noexcept
+    {
+        if (m_inFlightCount >= m_maxInFlightCount) {
+            return false;
+        }
+
+        // Only this thread writes the tail, the kernel moves the head
+        const uint32_t tail = *m_pSQTail;
+        const uint32_t sqeIdx = tail & m_sqMask;
+
+        io_uring_sqe& sqe = m_pSQEs[sqeIdx];
+        memset(&sqe, 0, sizeof(sqe));
+
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(pBuffer);
+        sqe.len = size;
+        sqe.off = offset;
+        sqe.user_data = userData;
+
+        m_pSQArray[sqeIdx] = sqeIdx;
+        __atomic_store_n(m_pSQTail, tail + 1, __ATOMIC_RELEASE);
+
+        ++m_inFlightCount;
+        ++m_unsubmittedCount;
+
+        return true;
+    }
+
+
+    // Submits pushed reads and blocks until at least one completion is available
+    bool SubmitAndWait() noexcept
+    {
+        ENG_ASSERT(m_inFlightCount > 0, "Waiting on io_uring without reads in flight would never return");
+
+        while (true) {
+            const int result = static_cast<int>(syscall(__NR_io_uring_enter, m_ringFD, m_unsubmittedCount, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+
+            if (result >= 0) {
+                m_unsubmittedCount -= static_cast<uint32_t>(result);
+                return true;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            // Kernel is out of resources for new submissions, the reads in flight have to complete first
+            if (errno == EAGAIN || errno == EBUSY) {
+                return true;
+            }
+
+            return false;
+        }
+    }
+
+
+    // Calls func(userData, result) for every available completion. Result is the number of read bytes or negative errno
+    template <typename Func>
+    void ReapCompletions(Func&& func) noexcept
+    {
+        uint32_t head = *m_pCQHead;
+        const uint32_t tail = __atomic_load_n(m_pCQTail, __ATOMIC_ACQUIRE);
+
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = m_pCQEs[head & m_cqMask];
+            --m_inFlightCount;
+
+            func(cqe.user_data, cqe.res);
+        }
+
+        __atomic_store_n(m_pCQHead, head, __ATOMIC_RELEASE);
+    }
+
+
+    uint32_t GetInFlightCount() const noexcept { return m_inFlightCount; }
+
+    bool IsValid() const noexcept { return m_ringFD >= 0; }
+
+private:
+    void* m_pSQRing = MAP_FAILED;
+    void* m_pCQRing = MAP_FAILED;
+    io_uring_sqe* m_pSQEs = nullptr;
+
+    size_t m_sqRingSize = 0;
+    size_t m_cqRingSize = 0;
+    size_t m_sqesSize = 0;
+
+    uint32_t* m_pSQHead = nullptr;
+    uint32_t* m_pSQTail = nullptr;
+    uint32_t* m_pSQArray = nullptr;
+    uint32_t m_sqMask = 0;
+
+    uint32_t* m_pCQHead = nullptr;
+    uint32_t* m_pCQTail = nullptr;
+    io_uring_cqe* m_pCQEs = nullptr;
+    uint32_t m_cqMask = 0;
+
+    uint32_t m_maxInFlightCount = 0;
+    uint32_t m_inFlightCount = 0;
+    uint32_t m_unsubmittedCount = 0;
+
+    int m_ringFD = -1;
+};
+
+
+// Reads all files of the batch through the ring and calls onComplete(resultIdx) as soon as a file is done, so small files
+// don't wait for large ones. Returns false if the ring broke, reads that were still in flight then have their buffers leaked,
+// since the kernel may write into them after the results are returned
+template <typename Func>
+static bool ReadFilesIOURing(IOURingQueue& ring, FileReadResult* const* ppResults, uint32_t resultsCount, Func&& onComplete) noexcept
+{
+    struct FileReadState
+    {
+        int fd = -1;
+        uint32_t pendingReadsCount = 0;
+        bool isFailed = false;
+    };
+
+    struct ChunkRead
+    {
+        uint64_t offset;
+        uint32_t size;
+        uint32_t resultIdx;
+    };
+
+    std::vector<FileReadState> states(resultsCount);
+    std::vector<ChunkRead> reads;
+
+    auto FinishFile = [&](uint32_t resultIdx) {
+        FileReadState& state = states[resultIdx];
+        FileReadResult& result = *ppResults[resultIdx];
+
+        if (state.fd >= 0) {
+            close(state.fd);
+            state.fd = -1;
+        }
+
+        if (state.isFailed) {
+            ENG_LOG_WARN("Async file reading error. Failed to read {} file.", result.filepath.string().c_str());
+
+            result.pData = nullptr;
+            result.dataSize = 0;
+        } else {
+            result.isSucceeded = true;
+        }
+
+        onComplete(resultIdx);
+    };
+
+    for (uint32_t i = 0; i < resultsCount; ++i) {
+        FileReadState& state = states[i];
+        FileReadResult& result = *ppResults[i];
+
+        state.fd = open(result.filepath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (state.fd < 0) {
+            ENG_LOG_WARN("Async file reading error. Failed to open {} file.", result.filepath.string().c_str());
+            onComplete(i);
+            continue;
+        }
+
+        struct stat fileStat = {};
+        if (fstat(state.fd, &fileStat) != 0) {
+            ENG_LOG_WARN("Async file reading error. Failed to get {} file size.", result.filepath.string().c_str());
+            
+            close(state.fd);
+            state.fd = -1;
+            
+            onComplete(i);
+            continue;
+        }
+
+        result.dataSize = static_cast<size_t>(fileStat.st_size);
+
+        if (result.dataSize == 0) {
+            FinishFile(i);
+            continue;
+        }
+
+        result.pData = std::unique_ptr<uint8_t[]>(new uint8_t[result.dataSize]);
+
+        for (uint64_t offset = 0; offset < result.dataSize; offset += IO_URING_READ_CHUNK_SIZE) {
+            const uint32_t size = static_cast<uint32_t>(std::min<uint64_t>(IO_URING_READ_CHUNK_SIZE, result.dataSize - offset));
+            reads.emplace_back(ChunkRead { offset, size, i });
+            ++state.pendingReadsCount;
+        }
+    }
+
+    // Short reads are continued from where they stopped, such chunks go before the ones which weren't submitted yet
+    std::vector<uint32_t> continuedReads;
+    size_t nextReadIdx = 0;
+
+    auto PushChunkRead = [&](uint32_t readIdx) -> bool {
+        const ChunkRead& read = reads[readIdx];
+        FileReadState& state = states[read.resultIdx];
+
+        if (state.isFailed) {
+            if (--state.pendingReadsCount == 0) {
+                FinishFile(read.resultIdx);
+            }
+
+            return true;
+        }
+
+        uint8_t* pBuffer = ppResults[read.resultIdx]->pData.get() + read.offset;
+        return ring.PushRead(state.fd, pBuffer, read.size, read.offset, readIdx);
+    };
+
+    while (nextReadIdx < reads.size() || !continuedReads.empty() || ring.GetInFlightCount() > 0) {
+        while (!continuedReads.empty() && PushChunkRead(continuedReads.back())) {
+            continuedReads.pop_back();
+        }
+
+        while (continuedReads.empty() && nextReadIdx < reads.size() && PushChunkRead(static_cast<uint32_t>(nextReadIdx))) {
+            ++nextReadIdx;
+        }
+
+        if (ring.GetInFlightCount() == 0) {
+            continue;
+        }
+
+        if (!ring.SubmitAndWait()) {
+            for (uint32_t i = 0; i < resultsCount; ++i) {
+                FileReadState& state = states[i];
+
+                if (state.pendingReadsCount == 0) {
+                    continue;
+                }
+
+                ppResults[i]->pData.release();
+                state.isFailed = true;
+
+                FinishFile(i);
+            }
+
+            return false;
+        }
+
+        ring.ReapCompletions([&](uint64_t userData, int32_t readResult) {
+            const uint32_t readIdx = static_cast<uint32_t>(userData);
+            ChunkRead& read = reads[readIdx];
+            FileReadState& state = states[read.resultIdx];
+
+            // Zero means the file got shorter after fstat
+            if (readResult <= 0) {
+                state.isFailed = true;
+            } else if (static_cast<uint32_t>(readResult) < read.size) {
+                read.offset += static_cast<uint64_t>(readResult);
+                read.size -= static_cast<uint32_t>(readResult);
+                
+                continuedReads.emplace_back(readIdx);
+                return;
+            }
+
+            if (--state.pendingReadsCount == 0) {
+                FinishFile(read.resultIdx);
+            }
+        });
+    }
+
+    return true;
+}
+#endif
+
+
+AsyncFileReader& AsyncFileReader::GetInstance() noexcept
+{
+    ASSERT_ASYNC_FILE_READER_INIT_STATUS();
+    return *pAsyncFileReaderInst;
+}
+
+
+AsyncFileReader::~AsyncFileReader()
+{
+    Terminate();
+}
+
+
+void AsyncFileReader::ReadAsync(const fs::path& filepath, const FileReadCallback& callback, FileReadPriority priority) noexcept
+{
+    ENG_ASSERT(priority < FileReadPriority::COUNT, "Invalid file read priority");
+    ENG_ASSERT(callback, "Invalid file read callback");
+
+    Request request = {};
+    request.result.filepath = filepath;
+    request.callback = callback;
+
+    m_pendingRequestsCount.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::scoped_lock lock(m_requestsMutex);
+        m_requestQueues[static_cast<size_t>(priority)].emplace_back(std::move(request));
+    }
+
+    m_requestCondition.notify_one();
+}
+
+
+void AsyncFileReader::DispatchCompletions() noexcept
+{
+    {
+        std::scoped_lock lock(m_completionsMutex);
+        std::swap(m_completedRequests, m_dispatchedRequests);
+    }
+
+    for (Request& request : m_dispatchedRequests) {
+        request.callback(request.result);
+    }
+
+    m_pendingRequestsCount.fetch_sub(static_cast<uint32_t>(m_dispatchedRequests.size()), std::memory_order_relaxed);
+    m_dispatchedRequests.clear();
+}
+
+
+void AsyncFileReader::WaitAll() noexcept
+{
+    while (GetPendingRequestsCount() > 0) {
+        {
+            std::unique_lock lock(m_completionsMutex);
+            m_completionCondition.wait(lock, [this]() { return !m_completedRequests.empty(); });
+        }
+
+        DispatchCompletions();
+    }
+}
+
+
+bool AsyncFileReader::Init() noexcept
+{
+    if (IsInitialized()) {
+        return true;
+    }
+
+    m_isStopping = false;
+
+    m_ioThreads.reserve(IO_THREADS_COUNT);
+    for (uint32_t i = 0; i < IO_THREADS_COUNT; ++i) {
+        m_ioThreads.emplace_back([this]() { WorkerLoop(); });
+    }
+
+    m_isInitialized = true;
+
+    return true;
+}
+
+
+void AsyncFileReader::Terminate() noexcept
+{
+    {
+        std::scoped_lock lock(m_requestsMutex);
+        m_isStopping = true;
+    }
+    m_requestCondition.notify_all();
+
+    for (std::thread& thread : m_ioThreads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    m_ioThreads.clear();
+
+    const uint32_t droppedRequestsCount = GetPendingRequestsCount();
+    if (droppedRequestsCount > 0) {
+        ENG_LOG_WARN("Async file reader: {} requests were dropped during termination", droppedRequestsCount);
+    }
+
+    for (std::deque<Request>& queue : m_requestQueues) {
+        queue.clear();
+    }
+    m_completedRequests.clear();
+    m_dispatchedRequests.clear();
+
+    m_pendingRequestsCount.store(0, std::memory_order_relaxed);
+
+    m_isInitialized = false;
+}
+
+
+void AsyncFileReader::CompleteRequest(Request& request) noexcept
+{
+    {
+        std::scoped_lock lock(m_completionsMutex);
+        m_completedRequests.emplace_back(std::move(request));
+    }
+
+    m_completionCondition.notify_one();
+}
+
+
+void AsyncFileReader::WorkerLoop() noexcept
+{
+#if defined(__linux__)
+    IOURingQueue ring;
+    
+    if (!ring.Init(IO_URING_ENTRIES_COUNT)) {
+        ENG_LOG_WARN("Async file reader: io_uring is unavailable, files are read with blocking calls");
+    }
+
+    std::vector<FileReadResult*> batchResults;
+    batchResults.reserve(IO_URING_BATCH_MAX_REQUESTS_COUNT);
+#endif
+
+    std::vector<Request> batch;
+
+    while (true) {
+    #if defined(__linux__)
+        const size_t batchMaxSize = ring.IsValid() ? IO_URING_BATCH_MAX_REQUESTS_COUNT : 1;
+    #else
+        const size_t batchMaxSize = 1;
+    #endif
+
+        {
+            std::unique_lock lock(m_requestsMutex);
+
+            m_requestCondition.wait(lock, [this]() {
+                for (const std::deque<Request>& queue : m_requestQueues) {
+                    if (!queue.empty()) {
+                        return true;
+                    }
+                }
+
+                return m_isStopping;
+            });
+
+            if (m_isStopping) {
+                return;
+            }
+
+            // Higher priority requests are taken first, lower ones fill the rest of the batch
+            for (std::deque<Request>& queue : m_requestQueues) {
+                while (!queue.empty() && batch.size() < batchMaxSize) {
+                    batch.emplace_back(std::move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+        }
+
+    #if defined(__linux__)
+        if (ring.IsValid()) {
+            batchResults.clear();
+            
+            for (Request& request : batch) {
+                batchResults.emplace_back(&request.result);
+            }
+
+            const bool isRingValid = ReadFilesIOURing(ring, batchResults.data(), static_cast<uint32_t>(batchResults.size()), 
+                [this, &batch](uint32_t requestIdx) { CompleteRequest(batch[requestIdx]); });
+
+            if (!isRingValid) {
+                ENG_LOG_WARN("Async file reader: io_uring failed, files are read with blocking calls from now on");
+                ring.Destroy();
+            }
+
+            batch.clear();
+            continue;
+        }
+    #endif
+
+        for (Request& request : batch) {
+            ReadFileBlocking(request.result);
+            CompleteRequest(request);
+        }
+
+        batch.clear();
+    }
+}
+
+
+bool engInitAsyncFileReader() noexcept
+{
+    if (engIsAsyncFileReaderInitialized()) {
+        ENG_LOG_WARN("Async file reader is already initialized!");
+        return true;
+    }
+
+    pAsyncFileReaderInst = std::unique_ptr<AsyncFileReader>(new AsyncFileReader);
+
+    if (!pAsyncFileReaderInst) {
+        ENG_ASSERT_FAIL("Failed to allocate memory for async file reader");
+        return false;
+    }
+
+    if (!pAsyncFileReaderInst->Init()) {
+        ENG_ASSERT_FAIL("Failed to initialized async file reader");
+        return false;
+    }
+
+    return true;
+}
+
+
+void engTerminateAsyncFileReader() noexcept
+{
+    pAsyncFileReaderInst = nullptr;
+}
+
+
+bool engIsAsyncFileReaderInitialized() noexcept
+{
+    return pAsyncFileReaderInst && pAsyncFileReaderInst->IsInitialized();
+}
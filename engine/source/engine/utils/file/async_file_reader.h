@@ -0,0 +1,121 @@
+#pragma once
+
+#include "utils/data_structures/inline_function.h"
+
+#include <filesystem>
+#include <deque>
+#include <vector>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <cstdint>
+
+namespace fs = std::filesystem;
+
+
+enum class FileReadPriority : uint8_t
+{
+    HIGH,
+    NORMAL,
+    LOW,
+
+    COUNT
+};
+
+
+struct FileReadResult
+{
+    fs::path filepath;
+    
+    // Left uninitialized before reading, the callback may take the ownership
+    std::unique_ptr<uint8_t[]> pData;
+    size_t dataSize = 0;
+    
+    bool isSucceeded = false;
+};
+
+
+using FileReadCallback = ds::InlineFunction<void(FileReadResult&), 48>;
+
+
+// Reads whole files on dedicated IO threads so that loading doesn't stall frames. 
+// On Linux every IO thread owns an io_uring queue: it takes a batch of requests and keeps reads of all of them in flight,
+// large files are read by several chunks at once. Without io_uring files are read one by one with blocking calls.
+// Completion callbacks are invoked on the main thread from DispatchCompletions()
+class AsyncFileReader
+{
+    friend bool engInitAsyncFileReader() noexcept;
+    friend void engTerminateAsyncFileReader() noexcept;
+    friend bool engIsAsyncFileReaderInitialized() noexcept;
+
+public:
+    static AsyncFileReader& GetInstance() noexcept;
+
+public:
+    AsyncFileReader(const AsyncFileReader& other) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader& other) = delete;
+    AsyncFileReader(AsyncFileReader&& other) noexcept = delete;
+    AsyncFileReader& operator=(AsyncFileReader&& other) noexcept = delete;
+
+    ~AsyncFileReader();
+
+    void ReadAsync(const fs::path& filepath, const FileReadCallback& callback, FileReadPriority priority = FileReadPriority::NORMAL) noexcept;
+
+    // Invokes callbacks of all completed requests. Must be called from the main thread
+    void DispatchCompletions() noexcept;
+
+    // Blocks until all submitted requests are completed and dispatched
+    void WaitAll() noexcept;
+
+    uint32_t GetPendingRequestsCount() const noexcept { return m_pendingRequestsCount.load(std::memory_order_relaxed); }
+
+    bool IsInitialized() const noexcept { return m_isInitialized; }
+
+private:
+    AsyncFileReader() = default;
+
+    bool Init() noexcept;
+    void Terminate() noexcept;
+
+    void WorkerLoop() noexcept;
+
+private:
+    static inline constexpr uint32_t IO_THREADS_COUNT = 2;
+    static inline constexpr uint32_t IO_URING_BATCH_MAX_REQUESTS_COUNT = 32;
+
+private:
+    struct Request
+    {
+        FileReadResult result;
+        FileReadCallback callback;
+    };
+
+private:
+    void CompleteRequest(Request& request) noexcept;
+
+private:
+    std::array<std::deque<Request>, static_cast<size_t>(FileReadPriority::COUNT)> m_requestQueues;
+    std::vector<Request> m_completedRequests;
+    std::vector<Request> m_dispatchedRequests;
+
+    std::vector<std::thread> m_ioThreads;
+
+    std::mutex m_requestsMutex;
+    std::condition_variable m_requestCondition;
+    std::mutex m_completionsMutex;
+    std::condition_variable m_completionCondition;
+
+    std::atomic<uint32_t> m_pendingRequestsCount = 0;
+    bool m_isStopping = false;
+
+    bool m_isInitialized = false;
+};
+
+
+bool engInitAsyncFileReader() noexcept;
+void engTerminateAsyncFileReader() noexcept;
+bool engIsAsyncFileReaderInitialized() noexcept;
@@ -0,0 +1,158 @@
+#include "pch.h"
+
+#include "mapped_file.h"
+
+#include "utils/debug/assertion.h"
+
+#if defined(ENG_OS_WINDOWS)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    std::swap(m_pData, other.m_pData);
+    std::swap(m_size, other.m_size);
+    std::swap(m_isOpened, other.m_isOpened);
+}
+
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    Close();
+
+    std::swap(m_pData, other.m_pData);
+    std::swap(m_size, other.m_size);
+    std::swap(m_isOpened, other.m_isOpened);
+
+    return *this;
+}
+
+
+#if defined(ENG_OS_WINDOWS)
+bool MappedFile::Open(const fs::path& filepath) noexcept
+{
+    Close();
+
+    HANDLE fileHandle = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, 
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        ENG_LOG_WARN("File mapping error. Failed to open {} file.", filepath.string().c_str());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        ENG_LOG_WARN("File mapping error. Failed to get {} file size.", filepath.string().c_str());
+        CloseHandle(fileHandle);
+        return false;
+    }
+
+    // Zero sized files can't be mapped
+    if (fileSize.QuadPart == 0) {
+        CloseHandle(fileHandle);
+        m_isOpened = true;
+        return true;
+    }
+
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    
+    // The view keeps the mapping alive, so both handles can be closed right away
+    CloseHandle(fileHandle);
+
+    if (!mappingHandle) {
+        ENG_LOG_WARN("File mapping error. Failed to create {} file mapping.", filepath.string().c_str());
+        return false;
+    }
+
+    const void* pView = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mappingHandle);
+
+    if (!pView) {
+        ENG_LOG_WARN("File mapping error. Failed to map {} file view.", filepath.string().c_str());
+        return false;
+    }
+
+    m_pData = static_cast<const uint8_t*>(pView);
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    m_isOpened = true;
+
+    return true;
+}
+
+
+void MappedFile::Close() noexcept
+{
+    if (m_pData) {
+        UnmapViewOfFile(m_pData);
+    }
+
+    m_pData = nullptr;
+    m_size = 0;
+    m_isOpened = false;
+}
+#else
+bool MappedFile::Open(const fs::path& filepath) noexcept
+{
+    Close();
+
+    const int fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        ENG_LOG_WARN("File mapping error. Failed to open {} file.", filepath.string().c_str());
+        return false;
+    }
+
+    struct stat fileStat = {};
+    if (fstat(fd, &fileStat) != 0) {
+        ENG_LOG_WARN("File mapping error. Failed to get {} file size.", filepath.string().c_str());
+        close(fd);
+        return false;
+    }
+
+    // Zero sized files can't be mapped
+    if (fileStat.st_size == 0) {
+        close(fd);
+        m_isOpened = true;
+        return true;
+    }
+
+    void* pView = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+
+    if (pView == MAP_FAILED) {
+        ENG_LOG_WARN("File mapping error. Failed to map {} file.", filepath.string().c_str());
+        return false;
+    }
+
+    madvise(pView, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+
+    m_pData = static_cast<const uint8_t*>(pView);
+    m_size = static_cast<size_t>(fileStat.st_size);
+    m_isOpened = true;
+
+    return true;
+}
+
+
+void MappedFile::Close() noexcept
+{
+    if (m_pData) {
+        munmap(const_cast<uint8_t*>(m_pData), m_size);
+    }
+
+    m_pData = nullptr;
+    m_size = 0;
+    m_isOpened = false;
+}
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+#include <cstdint>
+
+namespace fs = std::filesystem;
+
+
+// Read-only memory mapped view of a whole file. Data is paged in by the OS on access, nothing is copied or zero-filled.
+// Mapped data isn't null terminated
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool Open(const fs::path& filepath) noexcept;
+    void Close() noexcept;
+
+    const uint8_t* GetData() const noexcept { return m_pData; }
+    size_t GetSize() const noexcept { return m_size; }
+
+    template <typename Type>
+    const Type* GetDataAs() const noexcept { return reinterpret_cast<const Type*>(m_pData); }
+
+    std::string_view GetText() const noexcept { return std::string_view(GetDataAs<char>(), m_size); }
+
+    const uint8_t* begin() const noexcept { return m_pData; }
+    const uint8_t* end() const noexcept { return m_pData + m_size; }
+
+    bool IsEmpty() const noexcept { return m_size == 0; }
+    
+    // Empty files are opened successfully but have no mapping
+    bool IsOpened() const noexcept { return m_isOpened; }
+
+private:
+    const uint8_t* m_pData = nullptr;
+    size_t m_size = 0;
+
+    bool m_isOpened = false;
+};
@@ -76,4 +76,14 @@ constexpr inline bool amAreEqual(const T& left, const T& right) noexcept
 constexpr inline bool amAreEqual(float left, float right) noexcept
 {
     return glm::abs(left - right) < M3D_EPS;
-}
\ No newline at end of file
+}
+
+// Rounds value up to the multiple of alignment, alignment doesn't have to be a power of two
+template <typename T, typename U>
+constexpr inline T amAlignUp(T value, U alignment) noexcept
+{
+    static_assert(std::is_integral_v<T> && std::is_integral_v<U>, "amAlignUp supports integral types only");
+
+    const T alignmentT = static_cast<T>(alignment);
+    return (value + alignmentT - 1) / alignmentT * alignmentT;
+}
@@ -37,4 +37,17 @@ DECLARE_CBV(COMMON_CAMERA_CB, 1)
     vec2  _PAD1;
 };
 
+
+DECLARE_STRUCT(COMMON_DRAW_DATA)
+{
+    vec4 COMMON_WORLD_MATRIX[3];
+};
+
+
+// Indexed by gl_BaseInstance + gl_InstanceID. Indirect records point baseInstance to their first element, instanced draws start from 0
+DECLARE_UAV(COMMON_DRAW_DATA_SB, 0)
+{
+    readonly COMMON_DRAW_DATA COMMON_DRAW_DATA_ARR[];
+};
+
 #endif
\ No newline at end of file
@@ -18,6 +18,14 @@
     layout(std140, binding = BINDING) uniform NAME
 
 
+#define DECLARE_UAV(NAME, BINDING) \
+    layout(std430, binding = BINDING) buffer NAME
+
+
+#define DECLARE_STRUCT(NAME) \
+    struct NAME
+
+
 #define REFLECT_INCLUDE(NAME)
 
 
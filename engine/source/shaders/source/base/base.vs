@@ -48,10 +48,12 @@ struct Vertex
 void main()
 {
 #if defined(PASS_GBUFFER)
-    vs_out_normal    = normalize(vs_in_normal);
+    const COMMON_DRAW_DATA drawData = COMMON_DRAW_DATA_ARR[gl_BaseInstance + gl_InstanceID];
+
+    vs_out_normal    = normalize(TransformVec3(vec4(vs_in_normal, 0.0f), drawData.COMMON_WORLD_MATRIX));
     vs_out_texCoords = vs_in_texCoords;
 
-    const vec4 wpos = vec4(vs_in_position, 1.0f);
+    const vec4 wpos = vec4(TransformVec3(vec4(vs_in_position, 1.0f), drawData.COMMON_WORLD_MATRIX), 1.0f);
     gl_Position = TransformVec4(wpos, COMMON_VIEW_PROJ_MATRIX);
 #else
     vs_out_texCoords = vertices[gl_VertexID].texCoords;
@@ -0,0 +1,138 @@
+#include "pch.h"
+
+#include "core/culling/frustum_culling.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+
+static constexpr uint32_t BENCH_VOLUMES_COUNT = 1'000'000;
+
+
+static Frustum MakeBenchFrustum() noexcept
+{
+#if defined(ENG_USE_INVERTED_Z)
+    const glm::mat4x4 projection = glm::perspectiveRH_ZO(glm::radians(70.f), 16.f / 9.f, 500.f, 0.1f);
+#else
+    const glm::mat4x4 projection = glm::perspectiveRH_ZO(glm::radians(70.f), 16.f / 9.f, 0.1f, 500.f);
+#endif
+
+    Frustum frustum;
+    frustum.ExtractPlanes(projection);
+
+    return frustum;
+}
+
+
+// Volumes are spread around the camera, so roughly a sixth of them is visible
+static const BoundingAABBsSoA& GetBenchAABBs() noexcept
+{
+    static const BoundingAABBsSoA aabbs = [] {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> positionDist(-500.f, 500.f);
+        std::uniform_real_distribution<float> extentDist(0.1f, 4.f);
+
+        BoundingAABBsSoA result;
+        result.Reserve(BENCH_VOLUMES_COUNT);
+
+        for (uint32_t i = 0; i < BENCH_VOLUMES_COUNT; ++i) {
+            const glm::vec3 center(positionDist(rng), positionDist(rng), positionDist(rng));
+            const glm::vec3 extents(extentDist(rng), extentDist(rng), extentDist(rng));
+
+            result.Add(center - extents, center + extents);
+        }
+
+        return result;
+    }();
+
+    return aabbs;
+}
+
+
+static const BoundingSpheresSoA& GetBenchSpheres() noexcept
+{
+    static const BoundingSpheresSoA spheres = [] {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> positionDist(-500.f, 500.f);
+        std::uniform_real_distribution<float> radiusDist(0.1f, 4.f);
+
+        BoundingSpheresSoA result;
+        result.Reserve(BENCH_VOLUMES_COUNT);
+
+        for (uint32_t i = 0; i < BENCH_VOLUMES_COUNT; ++i) {
+            result.Add(glm::vec3(positionDist(rng), positionDist(rng), positionDist(rng)), radiusDist(rng));
+        }
+
+        return result;
+    }();
+
+    return spheres;
+}
+
+
+// Args: SIMD level, batch size. Batch size equal to the volumes count culls everything on the calling thread
+template <typename CullFunc>
+static void RunCullBenchmark(benchmark::State& state, CullFunc cullFunc) noexcept
+{
+    const CPUSIMDLevel level = static_cast<CPUSIMDLevel>(state.range(0));
+
+    if (level > GetCPUSIMDLevel()) {
+        state.SkipWithError("SIMD level isn't supported by the CPU");
+        return;
+    }
+
+    const Frustum frustum = MakeBenchFrustum();
+
+    FrustumCuller culler;
+    culler.SetMaxSIMDLevel(level);
+    culler.SetBatchSize(static_cast<uint32_t>(state.range(1)));
+
+    std::vector<uint32_t> visibleIndices;
+
+    for (auto _ : state) {
+        cullFunc(culler, frustum, visibleIndices);
+        benchmark::DoNotOptimize(visibleIndices.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_VOLUMES_COUNT);
+    state.counters["visible"] = float(culler.GetStats().visibleCount);
+    state.counters["batches"] = float(culler.GetStats().batchesCount);
+}
+
+
+static void BM_FrustumCullAABBs(benchmark::State& state)
+{
+    const BoundingAABBsSoA& aabbs = GetBenchAABBs();
+
+    RunCullBenchmark(state, [&aabbs](FrustumCuller& culler, const Frustum& frustum, std::vector<uint32_t>& visibleIndices) {
+        culler.CullAABBs(frustum, aabbs, visibleIndices);
+    });
+}
+
+
+static void BM_FrustumCullSpheres(benchmark::State& state)
+{
+    const BoundingSpheresSoA& spheres = GetBenchSpheres();
+
+    RunCullBenchmark(state, [&spheres](FrustumCuller& culler, const Frustum& frustum, std::vector<uint32_t>& visibleIndices) {
+        culler.CullSpheres(frustum, spheres, visibleIndices);
+    });
+}
+
+
+static void CullBenchmarkArgs(benchmark::internal::Benchmark* pBenchmark)
+{
+    pBenchmark->ArgNames({ "simd", "batch" });
+
+    for (CPUSIMDLevel level : { CPUSIMDLevel::SCALAR, CPUSIMDLevel::SSE2, CPUSIMDLevel::AVX }) {
+        pBenchmark->Args({ int64_t(level), int64_t(BENCH_VOLUMES_COUNT) });
+        pBenchmark->Args({ int64_t(level), int64_t(FrustumCuller::DEFAULT_BATCH_SIZE) });
+    }
+
+    pBenchmark->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+
+BENCHMARK(BM_FrustumCullAABBs)->Apply(CullBenchmarkArgs);
+BENCHMARK(BM_FrustumCullSpheres)->Apply(CullBenchmarkArgs);
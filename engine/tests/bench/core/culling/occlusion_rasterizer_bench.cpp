@@ -0,0 +1,178 @@
+#include "pch.h"
+
+#include "core/culling/occlusion_rasterizer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+
+static constexpr uint32_t BENCH_OBJECTS_COUNT = 100'000;
+
+static constexpr float BENCH_BLOCK_SIZE = 24.f;
+static constexpr float BENCH_STREET_WIDTH = 8.f;
+
+
+// Unit cube, every building is the cube scaled and moved by its world matrix
+static constexpr glm::vec3 BENCH_BOX_POSITIONS[] = {
+    { -0.5f, 0.f, -0.5f }, { 0.5f, 0.f, -0.5f }, { 0.5f, 1.f, -0.5f }, { -0.5f, 1.f, -0.5f },
+    { -0.5f, 0.f,  0.5f }, { 0.5f, 0.f,  0.5f }, { 0.5f, 1.f,  0.5f }, { -0.5f, 1.f,  0.5f },
+};
+
+static constexpr uint32_t BENCH_BOX_INDICES[] = {
+    0, 2, 1, 0, 3, 2,   4, 5, 6, 4, 6, 7,
+    0, 4, 7, 0, 7, 3,   1, 2, 6, 1, 6, 5,
+    3, 7, 6, 3, 6, 2,   0, 1, 5, 0, 5, 4,
+};
+
+
+// City blocks on a grid in front of the camera, the camera stands in a street at eye level looking down the grid.
+// Near buildings hide most of the objects scattered over the streets and roofs behind them
+struct BenchOcclusionScene
+{
+    std::vector<glm::mat4x4> buildingMatrices;
+    BoundingAABBsSoA objects;
+    glm::mat4x4 viewProjMatrix;
+};
+
+
+static BenchOcclusionScene GenerateBenchScene(uint32_t buildingsCount) noexcept
+{
+    BenchOcclusionScene scene;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> footprintDist(0.6f, 1.f);
+    std::uniform_real_distribution<float> heightDist(8.f, 60.f);
+
+    const uint32_t blocksCountX = static_cast<uint32_t>(std::ceil(std::sqrt(float(buildingsCount))));
+    const float cityWidth = blocksCountX * BENCH_BLOCK_SIZE;
+
+    scene.buildingMatrices.reserve(buildingsCount);
+
+    for (uint32_t i = 0; i < buildingsCount; ++i) {
+        const uint32_t blockX = i % blocksCountX;
+        const uint32_t blockZ = i / blocksCountX;
+
+        // The camera street runs along -Z through the middle of the city
+        const glm::vec3 center((blockX + 0.5f) * BENCH_BLOCK_SIZE - cityWidth * 0.5f, 0.f, -(blockZ + 0.5f) * BENCH_BLOCK_SIZE);
+        const float footprint = (BENCH_BLOCK_SIZE - BENCH_STREET_WIDTH) * footprintDist(rng);
+
+        const glm::mat4x4 translation = glm::translate(M3D_MAT4_IDENTITY, center);
+        scene.buildingMatrices.emplace_back(glm::scale(translation, glm::vec3(footprint, heightDist(rng), footprint)));
+    }
+
+    const float cityDepth = std::ceil(float(buildingsCount) / blocksCountX) * BENCH_BLOCK_SIZE;
+
+    std::uniform_real_distribution<float> objectXDist(-cityWidth * 0.5f, cityWidth * 0.5f);
+    std::uniform_real_distribution<float> objectZDist(-cityDepth, 0.f);
+    std::uniform_real_distribution<float> objectYDist(0.f, 20.f);
+    std::uniform_real_distribution<float> objectExtentDist(0.25f, 2.f);
+
+    scene.objects.Reserve(BENCH_OBJECTS_COUNT);
+
+    for (uint32_t i = 0; i < BENCH_OBJECTS_COUNT; ++i) {
+        const glm::vec3 center(objectXDist(rng), objectYDist(rng), objectZDist(rng));
+        const glm::vec3 extents(objectExtentDist(rng));
+
+        scene.objects.Add(center - extents, center + extents);
+    }
+
+#if defined(ENG_USE_INVERTED_Z)
+    const glm::mat4x4 projection = glm::perspective(glm::radians(70.f), 16.f / 9.f, 2000.f, 0.1f);
+#else
+    const glm::mat4x4 projection = glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 2000.f);
+#endif
+
+    const glm::vec3 eyePosition(0.f, 1.8f, 0.f);
+    scene.viewProjMatrix = projection * glm::lookAt(eyePosition, eyePosition + glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+
+    return scene;
+}
+
+
+static void RasterizeBenchScene(OcclusionRasterizer& rasterizer, const BenchOcclusionScene& scene) noexcept
+{
+    rasterizer.BeginFrame(scene.viewProjMatrix);
+
+    for (const glm::mat4x4& worldMatrix : scene.buildingMatrices) {
+        rasterizer.AddOccluder(BENCH_BOX_POSITIONS, static_cast<uint32_t>(std::size(BENCH_BOX_POSITIONS)),
+            BENCH_BOX_INDICES, static_cast<uint32_t>(std::size(BENCH_BOX_INDICES)), worldMatrix);
+    }
+
+    rasterizer.Rasterize();
+}
+
+
+// Args: SIMD level, buildings count. Includes setup, binning, tile rasterization and HiZ build
+static void BM_OcclusionRasterize(benchmark::State& state)
+{
+    const CPUSIMDLevel level = static_cast<CPUSIMDLevel>(state.range(0));
+
+    if (level > GetCPUSIMDLevel()) {
+        state.SkipWithError("SIMD level isn't supported by the CPU");
+        return;
+    }
+
+    const BenchOcclusionScene scene = GenerateBenchScene(static_cast<uint32_t>(state.range(1)));
+
+    OcclusionRasterizer rasterizer;
+    rasterizer.SetMaxSIMDLevel(level);
+
+    for (auto _ : state) {
+        RasterizeBenchScene(rasterizer, scene);
+        benchmark::DoNotOptimize(rasterizer.GetDepth());
+    }
+
+    const OcclusionRasterizerStats& stats = rasterizer.GetStats();
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * stats.trianglesCount);
+    state.counters["setup_tris"] = float(stats.setupTrianglesCount);
+    state.counters["binned_tris"] = float(stats.binnedTrianglesCount);
+}
+
+
+// Args: buildings count. Tests of the scattered objects against the rasterized depth
+static void BM_OcclusionCullAABBs(benchmark::State& state)
+{
+    const BenchOcclusionScene scene = GenerateBenchScene(static_cast<uint32_t>(state.range(0)));
+
+    OcclusionRasterizer rasterizer;
+    RasterizeBenchScene(rasterizer, scene);
+
+    std::vector<uint32_t> visibleIndices;
+
+    for (auto _ : state) {
+        visibleIndices.resize(BENCH_OBJECTS_COUNT);
+        std::iota(visibleIndices.begin(), visibleIndices.end(), 0);
+
+        rasterizer.CullAABBs(scene.objects, visibleIndices);
+        benchmark::DoNotOptimize(visibleIndices.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_OBJECTS_COUNT);
+    state.counters["visible"] = float(visibleIndices.size());
+}
+
+
+static void RasterizeBenchmarkArgs(benchmark::internal::Benchmark* pBenchmark)
+{
+    pBenchmark->ArgNames({ "simd", "buildings" });
+
+    for (CPUSIMDLevel level : { CPUSIMDLevel::SCALAR, CPUSIMDLevel::SSE2, CPUSIMDLevel::AVX }) {
+        for (int64_t buildingsCount : { 64, 512, 4096 }) {
+            pBenchmark->Args({ int64_t(level), buildingsCount });
+        }
+    }
+
+    pBenchmark->Unit(benchmark::kMicrosecond)->UseRealTime();
+}
+
+
+static void CullBenchmarkArgs(benchmark::internal::Benchmark* pBenchmark)
+{
+    pBenchmark->ArgName("buildings")->Arg(64)->Arg(512)->Arg(4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+
+BENCHMARK(BM_OcclusionRasterize)->Apply(RasterizeBenchmarkArgs);
+BENCHMARK(BM_OcclusionCullAABBs)->Apply(CullBenchmarkArgs);
@@ -0,0 +1,326 @@
+#include "pch.h"
+
+#include "core/ecs/ecs_world.h"
+
+#include "utils/data_structures/strid.h"
+#include "utils/math/common_math.h"
+
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+
+
+static constexpr uint32_t BENCH_ENTITIES_COUNT = 100'000;
+
+
+struct BenchTransformComponent
+{
+    glm::mat4x4 worldMatrix;
+    glm::vec3   position;
+};
+
+
+struct BenchBoundsComponent
+{
+    glm::vec3 localCenter;
+    float     localRadius;
+    glm::vec3 worldCenter;
+    float     worldRadius;
+};
+
+
+struct BenchMeshComponent
+{
+    const void* pMesh;
+    uint32_t    first;
+    uint32_t    count;
+};
+
+
+struct BenchSelectedComponent
+{
+    uint32_t selectionIdx;
+};
+
+
+// Reference storage the way render managers keep objects: one struct per object with every optional part inline,
+// a vector of them and a name to index map. Removal swaps the last object into the hole
+struct BenchManagerObject
+{
+    BenchTransformComponent transform;
+    BenchBoundsComponent    bounds;
+    BenchMeshComponent      mesh;
+    BenchSelectedComponent  selected;
+    ds::StrID               name;
+    bool                    isSelected;
+};
+
+
+class BenchObjectManager
+{
+public:
+    void Reserve(size_t count) noexcept
+    {
+        m_objects.reserve(count);
+        m_nameToIdx.reserve(count);
+    }
+
+    BenchManagerObject& Register(ds::StrID name) noexcept
+    {
+        m_nameToIdx[name] = m_objects.size();
+        BenchManagerObject& object = m_objects.emplace_back();
+        object.name = name;
+
+        return object;
+    }
+
+    void Unregister(ds::StrID name) noexcept
+    {
+        const auto idxIt = m_nameToIdx.find(name);
+        const size_t idx = idxIt->second;
+
+        m_nameToIdx.erase(idxIt);
+
+        if (idx + 1 != m_objects.size()) {
+            m_objects[idx] = m_objects.back();
+            m_nameToIdx[m_objects[idx].name] = idx;
+        }
+
+        m_objects.pop_back();
+    }
+
+    BenchManagerObject* Find(ds::StrID name) noexcept
+    {
+        const auto idxIt = m_nameToIdx.find(name);
+        return idxIt != m_nameToIdx.end() ? &m_objects[idxIt->second] : nullptr;
+    }
+
+    std::vector<BenchManagerObject>& GetObjects() noexcept { return m_objects; }
+
+private:
+    std::vector<BenchManagerObject> m_objects;
+    std::unordered_map<ds::StrID, size_t> m_nameToIdx;
+};
+
+
+static const std::vector<ds::StrID>& GetBenchNames() noexcept
+{
+    static const std::vector<ds::StrID> names = [] {
+        std::vector<ds::StrID> result;
+        result.reserve(BENCH_ENTITIES_COUNT);
+
+        for (uint32_t i = 0; i < BENCH_ENTITIES_COUNT; ++i) {
+            result.emplace_back(std::string("_BENCH_OBJECT_") + std::to_string(i));
+        }
+
+        return result;
+    }();
+
+    return names;
+}
+
+
+static BenchBoundsComponent MakeBenchBounds(uint32_t idx) noexcept
+{
+    BenchBoundsComponent bounds = {};
+    bounds.localCenter = glm::vec3(float(idx % 100), 0.f, float(idx / 100));
+    bounds.localRadius = 1.f;
+
+    return bounds;
+}
+
+
+static void UpdateBounds(const BenchTransformComponent& transform, BenchBoundsComponent& bounds) noexcept
+{
+    bounds.worldCenter = glm::vec3(transform.worldMatrix * glm::vec4(bounds.localCenter, 1.f));
+    bounds.worldRadius = bounds.localRadius * glm::length(glm::vec3(transform.worldMatrix[0]));
+}
+
+
+// The world also has entities without bounds, so queries skip an archetype the way the render world does
+static void FillBenchWorld(EcsWorld& world, std::vector<EntityID>& entityIDs) noexcept
+{
+    entityIDs.resize(BENCH_ENTITIES_COUNT);
+
+    for (uint32_t i = 0; i < BENCH_ENTITIES_COUNT; ++i) {
+        const BenchTransformComponent transform = { glm::identity<glm::mat4x4>(), glm::vec3(0.f) };
+        const BenchMeshComponent mesh = { nullptr, 0, 36 };
+
+        entityIDs[i] = i % 8 == 7
+            ? world.CreateEntity(transform, mesh)
+            : world.CreateEntity(transform, MakeBenchBounds(i), mesh);
+    }
+}
+
+
+static void FillBenchManager(BenchObjectManager& manager) noexcept
+{
+    const std::vector<ds::StrID>& names = GetBenchNames();
+
+    manager.Reserve(BENCH_ENTITIES_COUNT);
+
+    for (uint32_t i = 0; i < BENCH_ENTITIES_COUNT; ++i) {
+        BenchManagerObject& object = manager.Register(names[i]);
+        object.transform = { glm::identity<glm::mat4x4>(), glm::vec3(0.f) };
+        object.bounds = MakeBenchBounds(i);
+        object.mesh = { nullptr, 0, 36 };
+    }
+}
+
+
+static void BM_EcsIterate(benchmark::State& state)
+{
+    EcsWorld world;
+    std::vector<EntityID> entityIDs;
+    FillBenchWorld(world, entityIDs);
+
+    for (auto _ : state) {
+        world.ForEachChunk<const BenchTransformComponent, BenchBoundsComponent>(
+            [](const EntityID*, const BenchTransformComponent* pTransforms, BenchBoundsComponent* pBounds, uint32_t count) {
+                for (uint32_t i = 0; i < count; ++i) {
+                    UpdateBounds(pTransforms[i], pBounds[i]);
+                }
+            });
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_ENTITIES_COUNT);
+}
+
+
+static void BM_EcsParallelIterate(benchmark::State& state)
+{
+    EcsWorld world;
+    std::vector<EntityID> entityIDs;
+    FillBenchWorld(world, entityIDs);
+
+    for (auto _ : state) {
+        world.ParallelForEachChunk<const BenchTransformComponent, BenchBoundsComponent>(
+            [](const EntityID*, const BenchTransformComponent* pTransforms, BenchBoundsComponent* pBounds, uint32_t count) {
+                for (uint32_t i = 0; i < count; ++i) {
+                    UpdateBounds(pTransforms[i], pBounds[i]);
+                }
+            });
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_ENTITIES_COUNT);
+}
+
+
+static void BM_ManagerIterate(benchmark::State& state)
+{
+    BenchObjectManager manager;
+    FillBenchManager(manager);
+
+    for (auto _ : state) {
+        for (BenchManagerObject& object : manager.GetObjects()) {
+            UpdateBounds(object.transform, object.bounds);
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_ENTITIES_COUNT);
+}
+
+
+// Creates all entities and destroys them in a shuffled order
+static void BM_EcsCreateDestroy(benchmark::State& state)
+{
+    EcsWorld world;
+    std::vector<EntityID> entityIDs;
+
+    std::vector<uint32_t> destroyOrder(BENCH_ENTITIES_COUNT);
+    std::iota(destroyOrder.begin(), destroyOrder.end(), 0);
+    std::shuffle(destroyOrder.begin(), destroyOrder.end(), std::mt19937(42));
+
+    for (auto _ : state) {
+        FillBenchWorld(world, entityIDs);
+
+        for (uint32_t idx : destroyOrder) {
+            world.DestroyEntity(entityIDs[idx]);
+        }
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_ENTITIES_COUNT);
+}
+
+
+static void BM_ManagerCreateDestroy(benchmark::State& state)
+{
+    const std::vector<ds::StrID>& names = GetBenchNames();
+
+    std::vector<uint32_t> destroyOrder(BENCH_ENTITIES_COUNT);
+    std::iota(destroyOrder.begin(), destroyOrder.end(), 0);
+    std::shuffle(destroyOrder.begin(), destroyOrder.end(), std::mt19937(42));
+
+    for (auto _ : state) {
+        BenchObjectManager manager;
+        FillBenchManager(manager);
+
+        for (uint32_t idx : destroyOrder) {
+            manager.Unregister(names[idx]);
+        }
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_ENTITIES_COUNT);
+}
+
+
+// Every 10th entity gets a component and loses it again, each change moves the entity between archetypes
+static void BM_EcsAddRemoveComponent(benchmark::State& state)
+{
+    EcsWorld world;
+    std::vector<EntityID> entityIDs;
+    FillBenchWorld(world, entityIDs);
+
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < BENCH_ENTITIES_COUNT; i += 10) {
+            world.AddComponent(entityIDs[i], BenchSelectedComponent { i });
+        }
+
+        for (uint32_t i = 0; i < BENCH_ENTITIES_COUNT; i += 10) {
+            world.RemoveComponent<BenchSelectedComponent>(entityIDs[i]);
+        }
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_ENTITIES_COUNT / 10);
+}
+
+
+// Manager objects have every optional part inline, so adding one is a lookup and a flag
+static void BM_ManagerAddRemoveComponent(benchmark::State& state)
+{
+    const std::vector<ds::StrID>& names = GetBenchNames();
+
+    BenchObjectManager manager;
+    FillBenchManager(manager);
+
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < BENCH_ENTITIES_COUNT; i += 10) {
+            BenchManagerObject* pObject = manager.Find(names[i]);
+            pObject->selected.selectionIdx = i;
+            pObject->isSelected = true;
+        }
+
+        for (uint32_t i = 0; i < BENCH_ENTITIES_COUNT; i += 10) {
+            manager.Find(names[i])->isSelected = false;
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_ENTITIES_COUNT / 10);
+}
+
+
+BENCHMARK(BM_EcsIterate)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_EcsParallelIterate)->Unit(benchmark::kMicrosecond)->UseRealTime();
+BENCHMARK(BM_ManagerIterate)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_EcsCreateDestroy)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ManagerCreateDestroy)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_EcsAddRemoveComponent)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ManagerAddRemoveComponent)->Unit(benchmark::kMillisecond);
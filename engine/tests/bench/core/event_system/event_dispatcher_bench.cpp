@@ -0,0 +1,124 @@
+#include "pch.h"
+
+#include "core/event_system/event_dispatcher.h"
+
+#include <benchmark/benchmark.h>
+
+#include <functional>
+
+
+static constexpr uint32_t BENCH_LISTENERS_COUNT = 1000;
+// 10K notifications fan out to 1K listeners each, 10M listener calls in total
+static constexpr uint32_t BENCH_NOTIFICATIONS_COUNT = 10'000;
+
+
+struct BenchEvent
+{
+    explicit BenchEvent(uint32_t value) : value(value) {}
+
+    uint32_t value;
+};
+
+
+struct BenchPostedEvent
+{
+    explicit BenchPostedEvent(uint32_t value) : value(value) {}
+
+    uint32_t value;
+};
+
+
+static void BM_EventNotify(benchmark::State& state)
+{
+    es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
+
+    uint64_t sum = 0;
+    std::vector<es::ListenerID> listenerIDs;
+
+    for (uint32_t i = 0; i < BENCH_LISTENERS_COUNT; ++i) {
+        listenerIDs.emplace_back(dispatcher.Subscribe<BenchEvent>([pSum = &sum](const void* pEvent) {
+            *pSum += es::EventCast<BenchEvent>(pEvent).value;
+        }));
+    }
+
+    uint32_t value = 0;
+
+    for (auto _ : state) {
+        dispatcher.Notify<BenchEvent>(value++);
+    }
+
+    benchmark::DoNotOptimize(sum);
+
+    for (es::ListenerID& listenerID : listenerIDs) {
+        dispatcher.Unsubscribe(listenerID);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_LISTENERS_COUNT);
+}
+
+
+// Listener storage as it was before inline callbacks: std::function per listener
+static void BM_StdFunctionNotify(benchmark::State& state)
+{
+    uint64_t sum = 0;
+    std::vector<std::function<void(const void*)>> callbacks;
+
+    for (uint32_t i = 0; i < BENCH_LISTENERS_COUNT; ++i) {
+        callbacks.emplace_back([pSum = &sum](const void* pEvent) {
+            *pSum += es::EventCast<BenchEvent>(pEvent).value;
+        });
+    }
+
+    uint32_t value = 0;
+
+    for (auto _ : state) {
+        const BenchEvent event(value++);
+
+        for (const std::function<void(const void*)>& callback : callbacks) {
+            callback(&event);
+        }
+    }
+
+    benchmark::DoNotOptimize(sum);
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_LISTENERS_COUNT);
+}
+
+
+// Post() into the queue and DispatchQueuedEvents() once per "frame" of 1K events, each fanned out to 1K listeners
+static void BM_EventPostAndDispatch(benchmark::State& state)
+{
+    constexpr uint32_t EVENTS_PER_FRAME_COUNT = 1000;
+
+    es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
+
+    uint64_t sum = 0;
+    std::vector<es::ListenerID> listenerIDs;
+
+    for (uint32_t i = 0; i < BENCH_LISTENERS_COUNT; ++i) {
+        listenerIDs.emplace_back(dispatcher.Subscribe<BenchPostedEvent>([pSum = &sum](const void* pEvent) {
+            *pSum += es::EventCast<BenchPostedEvent>(pEvent).value;
+        }));
+    }
+
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < EVENTS_PER_FRAME_COUNT; ++i) {
+            dispatcher.Post<BenchPostedEvent>(i);
+        }
+
+        dispatcher.DispatchQueuedEvents();
+    }
+
+    benchmark::DoNotOptimize(sum);
+
+    for (es::ListenerID& listenerID : listenerIDs) {
+        dispatcher.Unsubscribe(listenerID);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * EVENTS_PER_FRAME_COUNT * BENCH_LISTENERS_COUNT);
+}
+
+
+BENCHMARK(BM_EventNotify)->Iterations(BENCH_NOTIFICATIONS_COUNT);
+BENCHMARK(BM_StdFunctionNotify)->Iterations(BENCH_NOTIFICATIONS_COUNT);
+BENCHMARK(BM_EventPostAndDispatch)->Iterations(BENCH_NOTIFICATIONS_COUNT / 1000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,76 @@
+#include "pch.h"
+
+#include "core/job_system/job_system.h"
+
+#include <benchmark/benchmark.h>
+
+
+static constexpr uint32_t BENCH_ITEMS_COUNT = 64 * 1024;
+
+
+// Per job cost of Submit() + Wait() with empty jobs, i.e. pure scheduling overhead
+static void BM_JobSubmitWait(benchmark::State& state)
+{
+    JobSystem& jobSystem = JobSystem::GetInstance();
+    const uint32_t jobsCount = static_cast<uint32_t>(state.range(0));
+
+    for (auto _ : state) {
+        JobCounter counter;
+
+        for (uint32_t i = 0; i < jobsCount; ++i) {
+            jobSystem.Submit([]() {}, &counter);
+        }
+
+        jobSystem.Wait(counter);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * jobsCount);
+    state.counters["workers"] = float(jobSystem.GetWorkersCount());
+}
+
+
+static void BM_ParallelFor(benchmark::State& state)
+{
+    JobSystem& jobSystem = JobSystem::GetInstance();
+    const uint32_t batchSize = static_cast<uint32_t>(state.range(0));
+
+    std::vector<uint32_t> values(BENCH_ITEMS_COUNT, 1);
+    uint32_t* pValues = values.data();
+
+    for (auto _ : state) {
+        JobCounter counter;
+
+        jobSystem.ParallelFor(BENCH_ITEMS_COUNT, batchSize, [pValues](uint32_t i) {
+            pValues[i] = pValues[i] * 1664525u + 1013904223u;
+        }, counter);
+
+        jobSystem.Wait(counter);
+        benchmark::DoNotOptimize(pValues);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_ITEMS_COUNT);
+    state.counters["jobs"] = float((BENCH_ITEMS_COUNT + batchSize - 1) / batchSize);
+}
+
+
+// Same work as BM_ParallelFor on the calling thread, the baseline the batched versions have to beat
+static void BM_SerialFor(benchmark::State& state)
+{
+    std::vector<uint32_t> values(BENCH_ITEMS_COUNT, 1);
+    uint32_t* pValues = values.data();
+
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < BENCH_ITEMS_COUNT; ++i) {
+            pValues[i] = pValues[i] * 1664525u + 1013904223u;
+        }
+
+        benchmark::DoNotOptimize(pValues);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_ITEMS_COUNT);
+}
+
+
+BENCHMARK(BM_JobSubmitWait)->ArgName("jobs")->Arg(1)->Arg(64)->Arg(1024)->UseRealTime();
+BENCHMARK(BM_ParallelFor)->ArgName("batch")->Arg(64)->Arg(1024)->Arg(16 * 1024)->UseRealTime();
+BENCHMARK(BM_SerialFor)->UseRealTime();
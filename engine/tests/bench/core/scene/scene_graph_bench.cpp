@@ -0,0 +1,164 @@
+#include "pch.h"
+
+#include "core/scene/scene_graph.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+
+static constexpr uint32_t BENCH_ROOTS_COUNT = 256;
+static constexpr uint32_t BENCH_FANOUT = 4;
+
+
+// Roots first, then every node is a child of an earlier one with BENCH_FANOUT children per parent.
+// The hierarchy is 6-9 levels deep for 100K-1M nodes
+static uint32_t GetBenchParentIdx(uint32_t nodeIdx) noexcept
+{
+    return (nodeIdx - BENCH_ROOTS_COUNT) / BENCH_FANOUT;
+}
+
+
+static void BuildBenchSceneGraph(SceneGraph& graph, std::vector<SceneNodeID>& nodeIDs, uint32_t nodesCount) noexcept
+{
+    graph.Reserve(nodesCount);
+    nodeIDs.resize(nodesCount);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> positionDist(-10.f, 10.f);
+
+    for (uint32_t i = 0; i < nodesCount; ++i) {
+        const SceneNodeID parentID = i < BENCH_ROOTS_COUNT ? SceneNodeID() : nodeIDs[GetBenchParentIdx(i)];
+
+        nodeIDs[i] = graph.CreateNode(parentID);
+        graph.SetLocalPosition(nodeIDs[i], glm::vec3(positionDist(rng), positionDist(rng), positionDist(rng)));
+    }
+
+    graph.Update();
+}
+
+
+// Args: nodes count, percent of nodes moved per frame. Moved nodes also update their whole subtrees
+static void BM_SceneGraphUpdate(benchmark::State& state)
+{
+    const uint32_t nodesCount = static_cast<uint32_t>(state.range(0));
+    const uint32_t movedCount = static_cast<uint32_t>(int64_t(nodesCount) * state.range(1) / 100);
+
+    SceneGraph graph;
+    std::vector<SceneNodeID> nodeIDs;
+    BuildBenchSceneGraph(graph, nodeIDs, nodesCount);
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> nodeDist(0, nodesCount - 1);
+
+    std::vector<SceneNodeID> movedIDs(movedCount);
+    for (SceneNodeID& ID : movedIDs) {
+        ID = nodeIDs[nodeDist(rng)];
+    }
+
+    float offset = 0.f;
+
+    for (auto _ : state) {
+        offset += 0.01f;
+
+        for (SceneNodeID ID : movedIDs) {
+            graph.SetLocalPosition(ID, glm::vec3(offset, 0.f, 0.f));
+        }
+
+        graph.Update();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * nodesCount);
+    state.counters["updated"] = float(graph.GetStats().updatedNodesCount);
+    state.counters["levels"] = float(graph.GetStats().levelsCount);
+}
+
+
+// Reparenting a node marks the hierarchy dirty, the update reorders all nodes before recomputing matrices
+static void BM_SceneGraphReparentAndUpdate(benchmark::State& state)
+{
+    const uint32_t nodesCount = static_cast<uint32_t>(state.range(0));
+
+    SceneGraph graph;
+    std::vector<SceneNodeID> nodeIDs;
+    BuildBenchSceneGraph(graph, nodeIDs, nodesCount);
+
+    // Leaves are moved between roots, so the levels count doesn't change
+    const SceneNodeID leafID = nodeIDs.back();
+    uint32_t rootIdx = 0;
+
+    for (auto _ : state) {
+        rootIdx = (rootIdx + 1) % BENCH_ROOTS_COUNT;
+
+        graph.SetParent(leafID, nodeIDs[rootIdx]);
+        graph.Update();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * nodesCount);
+}
+
+
+// Reference: pointer based nodes with children lists, world matrices recomputed recursively for the whole tree each frame
+struct NaiveSceneNode
+{
+    glm::vec3   localPosition = glm::vec3(0.f);
+    glm::quat   localRotation = glm::identity<glm::quat>();
+    glm::vec3   localScale = glm::vec3(1.f);
+    glm::mat4x4 worldMatrix = glm::identity<glm::mat4x4>();
+
+    std::vector<NaiveSceneNode*> children;
+};
+
+
+static void UpdateNaiveNode(NaiveSceneNode& node, const glm::mat4x4& parentMatrix) noexcept
+{
+    const glm::mat4x4 localMatrix = glm::translate(glm::identity<glm::mat4x4>(), node.localPosition)
+        * glm::mat4_cast(node.localRotation) * glm::scale(glm::identity<glm::mat4x4>(), node.localScale);
+
+    node.worldMatrix = parentMatrix * localMatrix;
+
+    for (NaiveSceneNode* pChild : node.children) {
+        UpdateNaiveNode(*pChild, node.worldMatrix);
+    }
+}
+
+
+static void BM_NaiveSceneTreeUpdate(benchmark::State& state)
+{
+    const uint32_t nodesCount = static_cast<uint32_t>(state.range(0));
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> positionDist(-10.f, 10.f);
+
+    // Separate allocations, the same as nodes created one by one in a pointer based scene
+    std::vector<std::unique_ptr<NaiveSceneNode>> nodes(nodesCount);
+
+    for (uint32_t i = 0; i < nodesCount; ++i) {
+        nodes[i] = std::make_unique<NaiveSceneNode>();
+        nodes[i]->localPosition = glm::vec3(positionDist(rng), positionDist(rng), positionDist(rng));
+
+        if (i >= BENCH_ROOTS_COUNT) {
+            nodes[GetBenchParentIdx(i)]->children.emplace_back(nodes[i].get());
+        }
+    }
+
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < BENCH_ROOTS_COUNT; ++i) {
+            UpdateNaiveNode(*nodes[i], glm::identity<glm::mat4x4>());
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * nodesCount);
+}
+
+
+BENCHMARK(BM_SceneGraphUpdate)
+    ->ArgNames({ "nodes", "moved_pct" })
+    ->ArgsProduct({ { 100'000, 1'000'000 }, { 0, 1, 100 } })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_SceneGraphReparentAndUpdate)->ArgName("nodes")->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_NaiveSceneTreeUpdate)->ArgName("nodes")->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond);
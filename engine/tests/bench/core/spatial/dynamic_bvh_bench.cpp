@@ -0,0 +1,258 @@
+#include "pch.h"
+
+#include "core/spatial/dynamic_bvh.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+
+static constexpr uint32_t BENCH_RAYS_COUNT = 1024;
+
+
+static Frustum MakeBenchFrustum() noexcept
+{
+#if defined(ENG_USE_INVERTED_Z)
+    const glm::mat4x4 projection = glm::perspectiveRH_ZO(glm::radians(70.f), 16.f / 9.f, 500.f, 0.1f);
+#else
+    const glm::mat4x4 projection = glm::perspectiveRH_ZO(glm::radians(70.f), 16.f / 9.f, 0.1f, 500.f);
+#endif
+
+    Frustum frustum;
+    frustum.ExtractPlanes(projection);
+
+    return frustum;
+}
+
+
+// The same distribution as the frustum culling benchmark: boxes around the camera, roughly a sixth of them is visible
+static BoundingAABBsSoA GenerateBenchAABBs(uint32_t count) noexcept
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> positionDist(-500.f, 500.f);
+    std::uniform_real_distribution<float> extentDist(0.1f, 4.f);
+
+    BoundingAABBsSoA aabbs;
+    aabbs.Reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const glm::vec3 center(positionDist(rng), positionDist(rng), positionDist(rng));
+        const glm::vec3 extents(extentDist(rng), extentDist(rng), extentDist(rng));
+
+        aabbs.Add(center - extents, center + extents);
+    }
+
+    return aabbs;
+}
+
+
+static glm::vec3 GetBenchAABBCenter(const BoundingAABBsSoA& aabbs, uint32_t idx) noexcept
+{
+    return glm::vec3(aabbs.GetCentersX()[idx], aabbs.GetCentersY()[idx], aabbs.GetCentersZ()[idx]);
+}
+
+
+static glm::vec3 GetBenchAABBExtents(const BoundingAABBsSoA& aabbs, uint32_t idx) noexcept
+{
+    return glm::vec3(aabbs.GetExtentsX()[idx], aabbs.GetExtentsY()[idx], aabbs.GetExtentsZ()[idx]);
+}
+
+
+static void CreateBenchProxies(DynamicBVH& bvh, const BoundingAABBsSoA& aabbs, std::vector<BVHProxyID>* pOutIDs = nullptr) noexcept
+{
+    bvh.Reserve(aabbs.GetCount());
+
+    for (uint32_t i = 0; i < aabbs.GetCount(); ++i) {
+        const glm::vec3 center = GetBenchAABBCenter(aabbs, i);
+        const glm::vec3 extents = GetBenchAABBExtents(aabbs, i);
+
+        const BVHProxyID ID = bvh.CreateProxy(center - extents, center + extents, i);
+
+        if (pOutIDs) {
+            pOutIDs->emplace_back(ID);
+        }
+    }
+}
+
+
+// Args: proxies count. Proxies inserted one by one into an empty tree, the "sah" counter compares with BM_DynamicBVHBuild
+static void BM_DynamicBVHInsert(benchmark::State& state)
+{
+    const BoundingAABBsSoA aabbs = GenerateBenchAABBs(static_cast<uint32_t>(state.range(0)));
+
+    float sahCost = 0.f;
+
+    for (auto _ : state) {
+        DynamicBVH bvh;
+        CreateBenchProxies(bvh, aabbs);
+
+        state.PauseTiming();
+        sahCost = bvh.ComputeSAHCost();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * aabbs.GetCount());
+    state.counters["sah"] = sahCost;
+}
+
+
+// Args: proxies count. Full binned SAH rebuild of all proxies
+static void BM_DynamicBVHBuild(benchmark::State& state)
+{
+    const BoundingAABBsSoA aabbs = GenerateBenchAABBs(static_cast<uint32_t>(state.range(0)));
+
+    DynamicBVH bvh;
+    CreateBenchProxies(bvh, aabbs);
+
+    for (auto _ : state) {
+        bvh.Build();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * aabbs.GetCount());
+    state.counters["sah"] = bvh.ComputeSAHCost();
+    state.counters["nodes"] = float(bvh.GetNodesCount());
+}
+
+
+// Args: proxies count. Compare with BM_FrustumCullLinear over the same boxes
+static void BM_DynamicBVHQueryFrustum(benchmark::State& state)
+{
+    const BoundingAABBsSoA aabbs = GenerateBenchAABBs(static_cast<uint32_t>(state.range(0)));
+    const Frustum frustum = MakeBenchFrustum();
+
+    DynamicBVH bvh;
+    CreateBenchProxies(bvh, aabbs);
+    bvh.Build();
+
+    std::vector<uint32_t> visibleUserData;
+
+    for (auto _ : state) {
+        bvh.QueryFrustum(frustum, visibleUserData);
+        benchmark::DoNotOptimize(visibleUserData.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * aabbs.GetCount());
+    state.counters["visible"] = float(visibleUserData.size());
+}
+
+
+// Args: proxies count. Every box is tested by the SIMD culler on the calling thread
+static void BM_FrustumCullLinear(benchmark::State& state)
+{
+    const BoundingAABBsSoA aabbs = GenerateBenchAABBs(static_cast<uint32_t>(state.range(0)));
+    const Frustum frustum = MakeBenchFrustum();
+
+    FrustumCuller culler;
+    culler.SetBatchSize(aabbs.GetCount());
+
+    std::vector<uint32_t> visibleIndices;
+
+    for (auto _ : state) {
+        culler.CullAABBs(frustum, aabbs, visibleIndices);
+        benchmark::DoNotOptimize(visibleIndices.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * aabbs.GetCount());
+    state.counters["visible"] = float(visibleIndices.size());
+}
+
+
+// Args: proxies count, moved percent. Moves a random subset of proxies by a small offset and refits, like animated objects do every frame.
+// The "sah" counter shows how far the tree drifts from the built one over the run
+static void BM_DynamicBVHRefit(benchmark::State& state)
+{
+    const BoundingAABBsSoA aabbs = GenerateBenchAABBs(static_cast<uint32_t>(state.range(0)));
+    const uint32_t movedCount = static_cast<uint32_t>(aabbs.GetCount() * state.range(1) / 100);
+
+    DynamicBVH bvh;
+    std::vector<BVHProxyID> IDs;
+
+    CreateBenchProxies(bvh, aabbs, &IDs);
+    bvh.Build();
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> proxyDist(0, aabbs.GetCount() - 1);
+    std::uniform_real_distribution<float> offsetDist(-2.f, 2.f);
+
+    uint64_t rotationsCount = 0;
+
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < movedCount; ++i) {
+            const BVHProxyID ID = IDs[proxyDist(rng)];
+            const glm::vec3 offset(offsetDist(rng), offsetDist(rng), offsetDist(rng));
+
+            bvh.UpdateProxy(ID, bvh.GetProxyMin(ID) + offset, bvh.GetProxyMax(ID) + offset);
+        }
+
+        bvh.Refit();
+        rotationsCount += bvh.GetStats().rotationsCount;
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * movedCount);
+    state.counters["rotations"] = benchmark::Counter(float(rotationsCount), benchmark::Counter::kAvgIterations);
+    state.counters["sah"] = bvh.ComputeSAHCost();
+}
+
+
+// Args: proxies count. Nearest hits of random rays from the scene center
+static void BM_DynamicBVHRayCast(benchmark::State& state)
+{
+    const BoundingAABBsSoA aabbs = GenerateBenchAABBs(static_cast<uint32_t>(state.range(0)));
+
+    DynamicBVH bvh;
+    CreateBenchProxies(bvh, aabbs);
+    bvh.Build();
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dirDist(-1.f, 1.f);
+
+    std::vector<glm::vec3> directions(BENCH_RAYS_COUNT);
+
+    for (glm::vec3& direction : directions) {
+        direction = glm::normalize(glm::vec3(dirDist(rng), dirDist(rng), dirDist(rng)));
+    }
+
+    uint32_t hitsCount = 0;
+
+    for (auto _ : state) {
+        hitsCount = 0;
+
+        for (const glm::vec3& direction : directions) {
+            BVHRayHit hit = {};
+            hitsCount += bvh.RayCast(M3D_ZEROF3, direction, 1000.f, hit) ? 1 : 0;
+        }
+
+        benchmark::DoNotOptimize(hitsCount);
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_RAYS_COUNT);
+    state.counters["hits"] = float(hitsCount);
+}
+
+
+static void ProxiesCountArgs(benchmark::internal::Benchmark* pBenchmark)
+{
+    pBenchmark->ArgName("proxies")->Arg(10'000)->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+
+static void RefitArgs(benchmark::internal::Benchmark* pBenchmark)
+{
+    pBenchmark->ArgNames({ "proxies", "moved_pct" });
+
+    for (int64_t proxiesCount : { 100'000, 1'000'000 }) {
+        for (int64_t movedPercent : { 1, 10 }) {
+            pBenchmark->Args({ proxiesCount, movedPercent });
+        }
+    }
+
+    pBenchmark->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+
+BENCHMARK(BM_DynamicBVHInsert)->Apply(ProxiesCountArgs);
+BENCHMARK(BM_DynamicBVHBuild)->Apply(ProxiesCountArgs);
+BENCHMARK(BM_DynamicBVHQueryFrustum)->Apply(ProxiesCountArgs);
+BENCHMARK(BM_FrustumCullLinear)->Apply(ProxiesCountArgs);
+BENCHMARK(BM_DynamicBVHRefit)->Apply(RefitArgs);
+BENCHMARK(BM_DynamicBVHRayCast)->Apply(ProxiesCountArgs);
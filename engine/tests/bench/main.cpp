@@ -0,0 +1,35 @@
+#include "pch.h"
+
+#include "core/job_system/job_system.h"
+
+#include "utils/debug/eng_log_sys.h"
+
+#include "render/headless_render_resources.h"
+
+#include <benchmark/benchmark.h>
+
+
+// Benchmarks run with the job system up, the same as the engine does in a frame
+int main(int argc, char** argv)
+{
+    engInitLogSystem();
+    engInitJobSystem();
+
+    ::benchmark::Initialize(&argc, argv);
+
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::benchmark::Shutdown();
+
+#if defined(ENG_GL_RECORDING_BACKEND)
+    DestroyHeadlessRenderResources();
+#endif
+
+    engTerminateJobSystem();
+    engTerminateLogSystem();
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include "pch.h"
+
+#if defined(ENG_GL_RECORDING_BACKEND)
+
+#include "render/headless_render_resources.h"
+
+#include "render/draw_bucket/draw_bucket.h"
+#include "render/platform/OpenGL/opengl_recording_backend.h"
+
+#include <benchmark/benchmark.h>
+
+
+static constexpr uint32_t BENCH_MAX_DRAWS_COUNT = 100'000;
+
+
+struct BenchDraw
+{
+    DrawCommand command;
+    float depth;
+};
+
+
+// Draws pick pipeline, mesh and material at random, so the submission order is the worst case for state switches
+static const std::vector<BenchDraw>& GetBenchDraws() noexcept
+{
+    static const std::vector<BenchDraw> draws = [] {
+        const HeadlessRenderResources& resources = GetHeadlessRenderResources();
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<size_t> pipelineDist(0, resources.pipelines.size() - 1);
+        std::uniform_int_distribution<size_t> meshDist(0, resources.meshes.size() - 1);
+        std::uniform_int_distribution<size_t> materialDist(0, resources.materials.size() - 1);
+        std::uniform_real_distribution<float> depthDist(0.f, 1.f);
+
+        std::vector<BenchDraw> result(BENCH_MAX_DRAWS_COUNT);
+
+        for (BenchDraw& draw : result) {
+            draw.command.pPipeline = resources.pipelines[pipelineDist(rng)];
+            draw.command.pMesh = resources.meshes[meshDist(rng)];
+            draw.command.pMaterial = &resources.materials[materialDist(rng)];
+            draw.command.count = 6;
+            draw.command.indexType = DrawIndexType::INDEX_TYPE_UINT16;
+            draw.depth = depthDist(rng);
+        }
+
+        return result;
+    }();
+
+    return draws;
+}
+
+
+static void FillBucket(DrawBucket& bucket, const std::vector<BenchDraw>& draws, uint32_t drawsCount) noexcept
+{
+    bucket.Clear();
+
+    for (uint32_t i = 0; i < drawsCount; ++i) {
+        bucket.AddDraw(DrawPass::PASS_GBUFFER, draws[i].depth, draws[i].command);
+    }
+}
+
+
+static void BM_DrawBucketAddAndSort(benchmark::State& state)
+{
+    const std::vector<BenchDraw>& draws = GetBenchDraws();
+    const uint32_t drawsCount = static_cast<uint32_t>(state.range(0));
+
+    DrawBucket bucket;
+    bucket.Reserve(drawsCount);
+
+    for (auto _ : state) {
+        FillBucket(bucket, draws, drawsCount);
+        bucket.Sort();
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * drawsCount);
+}
+
+
+// Baseline for the radix sort: the same keys sorted with std::sort
+static void BM_StdSortDrawKeys(benchmark::State& state)
+{
+    const std::vector<BenchDraw>& draws = GetBenchDraws();
+    const uint32_t drawsCount = static_cast<uint32_t>(state.range(0));
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys(drawsCount);
+
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < drawsCount; ++i) {
+            keys[i] = { DrawBucket::EncodeSortKey(DrawPass::PASS_GBUFFER, draws[i].command, draws[i].depth), i };
+        }
+
+        std::sort(keys.begin(), keys.end());
+
+        benchmark::DoNotOptimize(keys.data());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * drawsCount);
+}
+
+
+// Sort, record and replay into the recording backend, so the time includes the GL call overhead of the engine side
+static void BM_DrawBucketSubmit(benchmark::State& state)
+{
+    const std::vector<BenchDraw>& draws = GetBenchDraws();
+    const uint32_t drawsCount = static_cast<uint32_t>(state.range(0));
+
+    DrawBucket bucket;
+    bucket.Reserve(drawsCount);
+
+    for (auto _ : state) {
+        FillBucket(bucket, draws, drawsCount);
+        bucket.Submit();
+
+        // Command log would grow across iterations otherwise
+        state.PauseTiming();
+        engResetOpenGLRecording();
+        state.ResumeTiming();
+    }
+
+    const DrawBucketStats& stats = bucket.GetStats();
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * drawsCount);
+    state.counters["pipeline_binds"] = float(stats.pipelineBindsCount);
+    state.counters["mesh_binds"] = float(stats.meshBindsCount);
+    state.counters["texture_binds"] = float(stats.textureBindsCount);
+}
+
+
+// Unsorted submission of the same draws shows what the sort saves in binds
+static void BM_UnsortedSubmit(benchmark::State& state)
+{
+    const std::vector<BenchDraw>& draws = GetBenchDraws();
+    const uint32_t drawsCount = static_cast<uint32_t>(state.range(0));
+
+    RenderCommandList commandList;
+
+    for (auto _ : state) {
+        commandList.Reset();
+
+        for (uint32_t i = 0; i < drawsCount; ++i) {
+            const DrawCommand& command = draws[i].command;
+            const DrawMaterial& material = *command.pMaterial;
+
+            commandList.BindPipeline(command.pPipeline);
+            commandList.BindMesh(command.pMesh);
+            commandList.BindTexture(material.units[0], material.pTextures[0], material.pSamplers[0]);
+            commandList.DrawIndexed(command.indexType, command.pMesh->GetFirstIndex(), command.count, 1, command.pMesh->GetBaseVertex());
+        }
+
+        commandList.Execute();
+
+        state.PauseTiming();
+        engResetOpenGLRecording();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * drawsCount);
+}
+
+
+static void DrawBucketBenchmarkArgs(benchmark::internal::Benchmark* pBenchmark)
+{
+    pBenchmark->ArgName("draws")->Arg(10'000)->Arg(BENCH_MAX_DRAWS_COUNT)->Unit(benchmark::kMillisecond);
+}
+
+
+BENCHMARK(BM_DrawBucketAddAndSort)->Apply(DrawBucketBenchmarkArgs);
+BENCHMARK(BM_StdSortDrawKeys)->Apply(DrawBucketBenchmarkArgs);
+BENCHMARK(BM_DrawBucketSubmit)->Apply(DrawBucketBenchmarkArgs);
+BENCHMARK(BM_UnsortedSubmit)->Apply(DrawBucketBenchmarkArgs);
+
+#endif
@@ -0,0 +1,244 @@
+#include "pch.h"
+#include "headless_render_resources.h"
+
+#if defined(ENG_GL_RECORDING_BACKEND)
+
+#include "render/render_system/render_system.h"
+#include "render/pipeline_manager/pipeline_mng.h"
+#include "render/shader_manager/shader_mng.h"
+#include "render/texture_manager/texture_mng.h"
+#include "render/rt_manager/rt_manager.h"
+#include "render/mesh_manager/mesh_manager.h"
+
+#include "core/window_system/window_system_events.h"
+
+#include "utils/debug/assertion.h"
+
+#include "auto/auto_registers_common.h"
+
+#include <string>
+
+
+static constexpr uint32_t BENCH_PIPELINES_COUNT = 64;
+static constexpr uint32_t BENCH_MESHES_COUNT = 1024;
+static constexpr uint32_t BENCH_MATERIALS_COUNT = 256;
+
+static constexpr int32_t BENCH_FRAMEBUFFER_WIDTH = 1280;
+static constexpr int32_t BENCH_FRAMEBUFFER_HEIGHT = 720;
+
+// Recording backend accepts any source, it only has to pass the preprocessor
+static constexpr char BENCH_SHADER_SOURCE[] = "#version 460 core\nvoid main() {}\n";
+
+
+static std::unique_ptr<HeadlessRenderResources> pResourcesInst = nullptr;
+
+
+static ShaderProgram* CreateBenchShaderProgram() noexcept
+{
+    ShaderStageCreateInfo vsStageCreateInfo = {};
+    vsStageCreateInfo.type = ShaderStageType::VERTEX;
+    vsStageCreateInfo.pSourceCode = BENCH_SHADER_SOURCE;
+    vsStageCreateInfo.codeSize = sizeof(BENCH_SHADER_SOURCE) - 1;
+    vsStageCreateInfo.pIncludeParentPath = "";
+
+    ShaderStageCreateInfo psStageCreateInfo = vsStageCreateInfo;
+    psStageCreateInfo.type = ShaderStageType::PIXEL;
+
+    const ShaderStageCreateInfo* pStages[] = { &vsStageCreateInfo, &psStageCreateInfo };
+
+    ShaderProgramCreateInfo programCreateInfo = {};
+    programCreateInfo.pStageCreateInfos = pStages;
+    programCreateInfo.stageCreateInfosCount = std::size(pStages);
+
+    ShaderProgram* pProgram = ShaderManager::GetInstance().RegisterShaderProgram();
+    ENG_ASSERT(pProgram, "Failed to register bench shader program");
+    pProgram->Create(programCreateInfo);
+
+    return pProgram;
+}
+
+
+// Pipelines alternate cull mode and depth write, so binding them changes GL state the way different materials would
+static void CreateBenchPipelines(ShaderProgram* pProgram, std::vector<Pipeline*>& pipelines) noexcept
+{
+    PipelineManager& pipelineManager = PipelineManager::GetInstance();
+
+    InputAssemblyStateCreateInfo inputAssemblyState = {};
+    inputAssemblyState.topology = PrimitiveTopology::TOPOLOGY_TRIANGLES;
+
+    ColorBlendAttachmentState blendAttachmentState = {};
+    blendAttachmentState.colorWriteMask.value = ColorComponentFlags::MASK_ALL;
+
+    ColorBlendAttachmentState blendAttachmentStates[] = { blendAttachmentState, blendAttachmentState, blendAttachmentState };
+
+    ColorBlendStateCreateInfo colorBlendState = {};
+    colorBlendState.pAttachmentStates = blendAttachmentStates;
+    colorBlendState.attachmentCount = std::size(blendAttachmentStates);
+
+    const FrameBufferColorAttachmentClearColor clearColors[] = {
+        { 0.f, 0.f, 0.f, 0.f },
+        { 0.f, 0.f, 0.f, 0.f },
+        { 0.f, 0.f, 0.f, 0.f }
+    };
+
+    FrameBufferClearValues clearValues = {};
+    clearValues.pColorAttachmentClearColors = clearColors;
+    clearValues.colorAttachmentsCount = std::size(clearColors);
+    clearValues.depthClearValue = 0.f;
+
+    pipelines.reserve(BENCH_PIPELINES_COUNT);
+
+    for (uint32_t i = 0; i < BENCH_PIPELINES_COUNT; ++i) {
+        RasterizationStateCreateInfo rasterizationState = {};
+        rasterizationState.cullMode = i % 2 ? CullMode::CULL_MODE_FRONT : CullMode::CULL_MODE_BACK;
+        rasterizationState.frontFace = FrontFace::FRONT_FACE_COUNTER_CLOCKWISE;
+        rasterizationState.polygonMode = PolygonMode::POLYGON_MODE_FILL;
+
+        DepthStencilStateCreateInfo depthStencilState = {};
+        depthStencilState.depthTestEnable = true;
+        depthStencilState.depthWriteEnable = i % 3 != 0;
+        depthStencilState.depthCompareFunc = CompareFunc::FUNC_GREATER;
+
+        PipelineCreateInfo pipelineCreateInfo = {};
+        pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
+        pipelineCreateInfo.pRasterizationState = &rasterizationState;
+        pipelineCreateInfo.pDepthStencilState = &depthStencilState;
+        pipelineCreateInfo.pColorBlendState = &colorBlendState;
+        pipelineCreateInfo.pFrameBufferClearValues = &clearValues;
+        pipelineCreateInfo.pFrameBuffer = RenderTargetManager::GetInstance().GetFrameBuffer(RTFrameBufferID::GBUFFER);
+        pipelineCreateInfo.pShaderProgram = pProgram;
+
+        Pipeline* pPipeline = pipelineManager.RegisterPipeline();
+        ENG_ASSERT(pPipeline, "Failed to register bench pipeline");
+        pPipeline->Create(pipelineCreateInfo);
+        ENG_ASSERT(pPipeline->IsValid(), "Failed to create bench pipeline");
+
+        pipelines.emplace_back(pPipeline);
+    }
+}
+
+
+static void CreateBenchMeshes(std::vector<MeshObj*>& meshes) noexcept
+{
+    MeshDataManager& meshDataManager = MeshDataManager::GetInstance();
+    MeshManager& meshManager = MeshManager::GetInstance();
+
+    const MeshVertexAttribDesc vertexAttribDescs[] = {
+        MeshVertexAttribDesc { 0, MeshVertexAttribDataType::TYPE_FLOAT, 0, 3, false },
+    };
+
+    MeshVertexLayoutCreateInfo vertexLayoutCreateInfo = {};
+    vertexLayoutCreateInfo.pVertexAttribDescs = vertexAttribDescs;
+    vertexLayoutCreateInfo.vertexAttribDescsCount = std::size(vertexAttribDescs);
+
+    MeshVertexLayout* pVertexLayout = meshDataManager.RegisterVertexLayout(vertexLayoutCreateInfo);
+    ENG_ASSERT(pVertexLayout && pVertexLayout->IsValid(), "Failed to register bench vertex layout");
+
+    const float quadVertices[] = {
+        -0.5f, -0.5f, 0.f,
+         0.5f, -0.5f, 0.f,
+         0.5f,  0.5f, 0.f,
+        -0.5f,  0.5f, 0.f,
+    };
+
+    const uint16_t quadIndices[] = { 0, 1, 2, 0, 2, 3 };
+
+    MeshGPUBufferDataCreateInfo gpuDataCreateInfo = {};
+    gpuDataCreateInfo.pVertexData = quadVertices;
+    gpuDataCreateInfo.vertexDataSize = sizeof(quadVertices);
+    gpuDataCreateInfo.vertexSize = 3 * sizeof(float);
+    gpuDataCreateInfo.pIndexData = quadIndices;
+    gpuDataCreateInfo.indexDataSize = sizeof(quadIndices);
+    gpuDataCreateInfo.indexSize = sizeof(quadIndices[0]);
+    gpuDataCreateInfo.pVertexLayout = pVertexLayout;
+
+    meshes.reserve(BENCH_MESHES_COUNT);
+
+    for (uint32_t i = 0; i < BENCH_MESHES_COUNT; ++i) {
+        const ds::StrID meshName = std::string("_BENCH_MESH_") + std::to_string(i);
+
+        MeshGPUBufferData* pGPUData = meshDataManager.RegisterGPUBufferData(meshName);
+        ENG_ASSERT(pGPUData, "Failed to register bench mesh GPU data");
+        pGPUData->Create(gpuDataCreateInfo);
+
+        MeshObj* pMesh = meshManager.RegisterMeshObj(meshName);
+        ENG_ASSERT(pMesh, "Failed to register bench mesh");
+        pMesh->Create(pVertexLayout, pGPUData);
+        ENG_ASSERT(pMesh->IsValid(), "Failed to create bench mesh");
+
+        meshes.emplace_back(pMesh);
+    }
+}
+
+
+static void CreateBenchMaterials(std::vector<DrawMaterial>& materials) noexcept
+{
+    TextureManager& texManager = TextureManager::GetInstance();
+
+    constexpr uint32_t texSize = 4;
+    const std::array<uint8_t, texSize * texSize * 4> texData = {};
+
+    Texture2DCreateInfo texCreateInfo = {};
+    texCreateInfo.format = resGetTexResourceFormat(TEST_TEXTURE);
+    texCreateInfo.width = texSize;
+    texCreateInfo.height = texSize;
+    texCreateInfo.inputData.format = TextureInputDataFormat::INPUT_FORMAT_RGBA;
+    texCreateInfo.inputData.dataType = TextureInputDataType::INPUT_TYPE_UNSIGNED_BYTE;
+    texCreateInfo.inputData.pData = texData.data();
+
+    TextureSamplerState* pSampler = texManager.GetSampler(resGetTexResourceSamplerIdx(TEST_TEXTURE));
+    const uint32_t unit = resGetResourceBinding(TEST_TEXTURE).GetBinding();
+
+    materials.resize(BENCH_MATERIALS_COUNT);
+
+    for (uint32_t i = 0; i < BENCH_MATERIALS_COUNT; ++i) {
+        const ds::StrID texName = std::string("_BENCH_TEXTURE_") + std::to_string(i);
+
+        Texture* pTexture = texManager.RegisterTexture2D(texName);
+        ENG_ASSERT(pTexture, "Failed to register bench texture");
+        pTexture->Create(texCreateInfo);
+        ENG_ASSERT(pTexture->IsValid(), "Failed to create bench texture");
+
+        DrawMaterial& material = materials[i];
+        material.pTextures[0] = pTexture;
+        material.pSamplers[0] = pSampler;
+        material.units[0] = unit;
+        material.texturesCount = 1;
+    }
+}
+
+
+const HeadlessRenderResources& GetHeadlessRenderResources() noexcept
+{
+    if (pResourcesInst) {
+        return *pResourcesInst;
+    }
+
+    const bool isRenderSystemInitialized = engInitRenderSystem();
+    ENG_ASSERT(isRenderSystemInitialized, "Failed to initialize headless render system");
+
+    // Render targets, so pipeline framebuffers, are created on the first resize
+    es::EventDispatcher::GetInstance().Notify<EventFramebufferResized>(BENCH_FRAMEBUFFER_WIDTH, BENCH_FRAMEBUFFER_HEIGHT);
+
+    pResourcesInst = std::make_unique<HeadlessRenderResources>();
+
+    CreateBenchPipelines(CreateBenchShaderProgram(), pResourcesInst->pipelines);
+    CreateBenchMeshes(pResourcesInst->meshes);
+    CreateBenchMaterials(pResourcesInst->materials);
+
+    return *pResourcesInst;
+}
+
+
+void DestroyHeadlessRenderResources() noexcept
+{
+    if (!pResourcesInst) {
+        return;
+    }
+
+    // Render objects are owned by the managers, which are terminated with the render system
+    pResourcesInst = nullptr;
+    engTerminateRenderSystem();
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+// Render objects are created through the real managers, which needs GL. Draw submission benchmarks are built only with the headless backend
+#if defined(ENG_GL_RECORDING_BACKEND)
+
+#include "render/draw_bucket/draw_bucket.h"
+
+#include <vector>
+
+
+// Pipelines, meshes and materials registered in the render managers, so draws built from them have real IDs and pass validation.
+// Meshes are indexed quads in one vertex arena, every material has a single texture
+struct HeadlessRenderResources
+{
+    std::vector<Pipeline*>    pipelines;
+    std::vector<MeshObj*>     meshes;
+    std::vector<DrawMaterial> materials;
+};
+
+
+// Initializes the render system on the recording backend and creates the resources on first call
+const HeadlessRenderResources& GetHeadlessRenderResources() noexcept;
+
+// Called by bench main after all benchmarks are run. Terminates the render system if the resources were created
+void DestroyHeadlessRenderResources() noexcept;
+
+#endif
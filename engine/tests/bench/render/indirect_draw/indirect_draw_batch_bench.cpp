@@ -0,0 +1,135 @@
+#include "pch.h"
+
+#if defined(ENG_GL_RECORDING_BACKEND)
+
+#include "render/headless_render_resources.h"
+
+#include "render/indirect_draw/indirect_draw_batch.h"
+#include "render/platform/OpenGL/opengl_recording_backend.h"
+
+#include <benchmark/benchmark.h>
+
+
+static constexpr uint32_t BENCH_MAX_DRAWS_COUNT = 100'000;
+
+
+// Same size as COMMON_DRAW_DATA, which holds a world matrix
+struct BenchDrawData
+{
+    float worldMatrix[16];
+};
+
+
+// Args: draws count, distinct meshes count. Fewer meshes means more draws of the same range are merged into instanced records
+static std::vector<IndirectDrawCommand> MakeBenchDraws(uint32_t drawsCount, uint32_t meshesCount) noexcept
+{
+    const HeadlessRenderResources& resources = GetHeadlessRenderResources();
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> meshDist(0, std::min<uint32_t>(meshesCount, static_cast<uint32_t>(resources.meshes.size())) - 1);
+
+    std::vector<IndirectDrawCommand> draws(drawsCount);
+
+    for (IndirectDrawCommand& draw : draws) {
+        draw.pMesh = resources.meshes[meshDist(rng)];
+        draw.count = 6;
+        draw.indexType = DrawIndexType::INDEX_TYPE_UINT16;
+    }
+
+    return draws;
+}
+
+
+static bool CreateBenchBatch(IndirectDrawBatch& batch) noexcept
+{
+    GetHeadlessRenderResources();
+
+    IndirectDrawBatchCreateInfo createInfo = {};
+    createInfo.maxDrawsCount = BENCH_MAX_DRAWS_COUNT;
+    createInfo.drawDataSize = sizeof(BenchDrawData);
+    createInfo.drawDataBinding = 0;
+
+    return batch.Create(createInfo);
+}
+
+
+static void BM_IndirectBatchAddAndBuild(benchmark::State& state)
+{
+    const std::vector<IndirectDrawCommand> draws = MakeBenchDraws(static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1)));
+    const BenchDrawData drawData = {};
+
+    IndirectDrawBatch batch;
+
+    if (!CreateBenchBatch(batch)) {
+        state.SkipWithError("Failed to create indirect draw batch");
+        return;
+    }
+
+    for (auto _ : state) {
+        batch.Clear();
+
+        for (const IndirectDrawCommand& draw : draws) {
+            batch.AddDraw(draw, &drawData);
+        }
+
+        batch.Build();
+
+        benchmark::DoNotOptimize(batch.GetIndirectCommands());
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(draws.size()));
+    state.counters["commands"] = float(batch.GetStats().commandsCount);
+    state.counters["multi_draws"] = float(batch.GetStats().multiDrawsCount);
+}
+
+
+// Build, upload into the mapped heap views and replay into the recording backend
+static void BM_IndirectBatchSubmit(benchmark::State& state)
+{
+    const std::vector<IndirectDrawCommand> draws = MakeBenchDraws(static_cast<uint32_t>(state.range(0)), static_cast<uint32_t>(state.range(1)));
+    const BenchDrawData drawData = {};
+
+    IndirectDrawBatch batch;
+
+    if (!CreateBenchBatch(batch)) {
+        state.SkipWithError("Failed to create indirect draw batch");
+        return;
+    }
+
+    for (auto _ : state) {
+        batch.Clear();
+
+        for (const IndirectDrawCommand& draw : draws) {
+            batch.AddDraw(draw, &drawData);
+        }
+
+        batch.Submit();
+
+        state.PauseTiming();
+        engResetOpenGLRecording();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(draws.size()));
+    state.counters["commands"] = float(batch.GetStats().commandsCount);
+    state.counters["multi_draws"] = float(batch.GetStats().multiDrawsCount);
+}
+
+
+static void IndirectBatchBenchmarkArgs(benchmark::internal::Benchmark* pBenchmark)
+{
+    pBenchmark->ArgNames({ "draws", "meshes" });
+
+    for (int64_t drawsCount : { int64_t(10'000), int64_t(BENCH_MAX_DRAWS_COUNT) }) {
+        pBenchmark->Args({ drawsCount, 16 });
+        pBenchmark->Args({ drawsCount, 1024 });
+    }
+
+    pBenchmark->Unit(benchmark::kMillisecond);
+}
+
+
+BENCHMARK(BM_IndirectBatchAddAndBuild)->Apply(IndirectBatchBenchmarkArgs);
+BENCHMARK(BM_IndirectBatchSubmit)->Apply(IndirectBatchBenchmarkArgs);
+
+#endif
@@ -0,0 +1,117 @@
+#include "pch.h"
+
+#include "render/mem_manager/tlsf_allocator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+
+static constexpr uint64_t BENCH_ALLOCATOR_SIZE = 256ull * 1024 * 1024;
+static constexpr uint32_t BENCH_SIZES_COUNT = 64 * 1024;
+
+
+// Mesh and buffer like sizes: mostly a few KB, sometimes up to a few MB
+static std::vector<uint64_t> GenerateBenchSizes(uint32_t count, uint64_t maxSize) noexcept
+{
+    std::mt19937 rng(42);
+    std::lognormal_distribution<double> sizeDist(8.0, 1.5);
+
+    std::vector<uint64_t> sizes(count);
+
+    for (uint64_t& size : sizes) {
+        size = std::clamp<uint64_t>(static_cast<uint64_t>(sizeDist(rng)), 1, maxSize);
+    }
+
+    return sizes;
+}
+
+
+// Steady state churn: every iteration frees a random live allocation and allocates a new one in its place
+static void BM_TLSFAllocFree(benchmark::State& state)
+{
+    const uint32_t liveAllocationsCount = static_cast<uint32_t>(state.range(0));
+    const std::vector<uint64_t> sizes = GenerateBenchSizes(BENCH_SIZES_COUNT, 4 * 1024 * 1024);
+
+    TLSFAllocator allocator;
+    allocator.Create(BENCH_ALLOCATOR_SIZE, 2 * liveAllocationsCount);
+
+    std::vector<TLSFAllocation> allocations(liveAllocationsCount);
+
+    for (uint32_t i = 0; i < liveAllocationsCount; ++i) {
+        allocations[i] = allocator.Allocate(sizes[i % BENCH_SIZES_COUNT]);
+    }
+
+    std::mt19937 rng(7);
+    uint32_t sizeIdx = 0;
+    int64_t failedAllocationsCount = 0;
+
+    for (auto _ : state) {
+        TLSFAllocation& allocation = allocations[rng() % liveAllocationsCount];
+
+        allocator.Deallocate(allocation);
+        allocation = allocator.Allocate(sizes[sizeIdx++ % BENCH_SIZES_COUNT]);
+
+        failedAllocationsCount += allocation.IsValid() ? 0 : 1;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["failed"] = float(failedAllocationsCount);
+}
+
+
+// Fills the allocator, then churns it with random frees and allocations and reports how fragmented the free space ends up.
+// frag = 1 - largest free region / free size, 0 means all free space is one region
+static void BM_TLSFFragmentation(benchmark::State& state)
+{
+    const uint32_t operationsCount = static_cast<uint32_t>(state.range(0));
+    const std::vector<uint64_t> sizes = GenerateBenchSizes(BENCH_SIZES_COUNT, 4 * 1024 * 1024);
+
+    TLSFAllocatorStats stats = {};
+    int64_t failedAllocationsCount = 0;
+
+    for (auto _ : state) {
+        TLSFAllocator allocator;
+        allocator.Create(BENCH_ALLOCATOR_SIZE);
+
+        std::vector<TLSFAllocation> allocations;
+        std::mt19937 rng(7);
+        uint32_t sizeIdx = 0;
+
+        failedAllocationsCount = 0;
+
+        // Fill to ~90% so the churn below has to reuse freed regions
+        while (allocator.GetUsedSize() < BENCH_ALLOCATOR_SIZE / 10 * 9) {
+            const TLSFAllocation allocation = allocator.Allocate(sizes[sizeIdx++ % BENCH_SIZES_COUNT]);
+
+            if (!allocation.IsValid()) {
+                break;
+            }
+
+            allocations.emplace_back(allocation);
+        }
+
+        for (uint32_t op = 0; op < operationsCount; ++op) {
+            const size_t idx = rng() % allocations.size();
+
+            allocator.Deallocate(allocations[idx]);
+            allocations[idx] = allocator.Allocate(sizes[sizeIdx++ % BENCH_SIZES_COUNT]);
+
+            failedAllocationsCount += allocations[idx].IsValid() ? 0 : 1;
+        }
+
+        stats = allocator.GetStats();
+    }
+
+    const uint64_t freeSize = stats.totalSize - stats.usedSize;
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * operationsCount);
+    state.counters["frag"] = freeSize > 0 ? 1.f - float(stats.largestFreeRegionSize) / float(freeSize) : 0.f;
+    state.counters["freeRegions"] = float(stats.freeRegionsCount);
+    state.counters["used"] = float(stats.usedSize) / float(stats.totalSize);
+    state.counters["failed"] = float(failedAllocationsCount);
+}
+
+
+BENCHMARK(BM_TLSFAllocFree)->ArgName("live")->Arg(1024)->Arg(16 * 1024);
+BENCHMARK(BM_TLSFFragmentation)->ArgName("ops")->Arg(100'000)->Arg(1'000'000)->Unit(benchmark::kMillisecond);
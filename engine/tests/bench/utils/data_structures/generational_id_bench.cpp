@@ -0,0 +1,82 @@
+#include "pch.h"
+
+#include "utils/data_structures/generational_id.h"
+#include "utils/data_structures/base_id.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+
+using BenchGenerationalID = ds::GenerationalID<uint32_t>;
+using BenchBaseID = ds::BaseID<uint32_t>;
+
+static constexpr uint32_t BENCH_HANDLES_COUNT = 1'000'000;
+
+
+// Every iteration frees a random live handle, checks that it became stale and allocates a new one in its place
+template <typename PoolType, typename IDType>
+static void RunHandleChurnBenchmark(benchmark::State& state) noexcept
+{
+    PoolType pool;
+    std::vector<IDType> handles(BENCH_HANDLES_COUNT);
+
+    for (IDType& handle : handles) {
+        handle = pool.Allocate();
+    }
+
+    std::mt19937 rng(42);
+    int64_t staleHandlesCount = 0;
+
+    for (auto _ : state) {
+        IDType& handle = handles[rng() % BENCH_HANDLES_COUNT];
+        const IDType oldHandle = handle;
+
+        pool.Deallocate(handle);
+        staleHandlesCount += pool.IsAllocated(oldHandle) ? 0 : 1;
+
+        handle = pool.Allocate();
+    }
+
+    benchmark::DoNotOptimize(staleHandlesCount);
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+static void BM_GenerationalIDPoolChurn(benchmark::State& state)
+{
+    RunHandleChurnBenchmark<ds::GenerationalIDPool<BenchGenerationalID>, BenchGenerationalID>(state);
+}
+
+
+// Allocates and frees all 1M handles, the cost of loading and unloading a whole resource set
+static void BM_GenerationalIDPoolFillAndDrain(benchmark::State& state)
+{
+    ds::GenerationalIDPool<BenchGenerationalID> pool;
+    std::vector<BenchGenerationalID> handles(BENCH_HANDLES_COUNT);
+
+    for (auto _ : state) {
+        for (BenchGenerationalID& handle : handles) {
+            handle = pool.Allocate();
+        }
+
+        for (BenchGenerationalID& handle : handles) {
+            pool.Deallocate(handle);
+        }
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * BENCH_HANDLES_COUNT);
+}
+
+
+// Plain pool of non generational IDs for comparison, freed IDs aren't detected once they are reused
+static void BM_BaseIDPoolChurn(benchmark::State& state)
+{
+    RunHandleChurnBenchmark<ds::BaseIDPool<BenchBaseID>, BenchBaseID>(state);
+}
+
+
+BENCHMARK(BM_GenerationalIDPoolChurn);
+BENCHMARK(BM_GenerationalIDPoolFillAndDrain)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BaseIDPoolChurn);
@@ -0,0 +1,44 @@
+#include "pch.h"
+
+#include "utils/data_structures/hash.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+
+static void BM_HashMem(benchmark::State& state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+
+    std::vector<uint8_t> data(size);
+    std::mt19937 rng(42);
+
+    for (uint8_t& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(amHashMem(data.data(), size));
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(size));
+}
+
+
+// StrID hash, for comparison on the same sizes
+static void BM_HashStr(benchmark::State& state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    const std::string str(size, 'x');
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(amHashStr(str.data(), size));
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(size));
+}
+
+
+BENCHMARK(BM_HashMem)->ArgName("size")->RangeMultiplier(4)->Range(8, 256 * 1024);
+BENCHMARK(BM_HashStr)->ArgName("size")->RangeMultiplier(4)->Range(8, 4 * 1024);
@@ -0,0 +1,153 @@
+#include "pch.h"
+
+#include "utils/data_structures/strid.h"
+
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+
+
+static constexpr uint32_t BENCH_HOT_STRINGS_COUNT = 1024;
+
+
+static const std::vector<std::string>& GetHotStrings() noexcept
+{
+    static const std::vector<std::string> strings = [] {
+        std::vector<std::string> result;
+        result.reserve(BENCH_HOT_STRINGS_COUNT);
+
+        for (uint32_t i = 0; i < BENCH_HOT_STRINGS_COUNT; ++i) {
+            result.emplace_back("bench_hot_resource_" + std::to_string(i));
+        }
+
+        return result;
+    }();
+
+    return strings;
+}
+
+
+// Interning as it was before the sharded storage: one unordered_map of offsets into one growing buffer.
+// It isn't thread safe, so sharing it between threads needs a global mutex, which is what it's benchmarked with
+class LegacyStrIDStorage
+{
+public:
+    uint64_t Store(std::string_view str) noexcept
+    {
+        const uint64_t id = amHashStr(str);
+
+        std::scoped_lock lock(m_mutex);
+
+        if (m_offsets.find(id) == m_offsets.end()) {
+            const size_t offset = m_storage.size();
+
+            m_storage.insert(m_storage.end(), str.begin(), str.end());
+            m_storage.emplace_back('\0');
+
+            m_offsets.emplace(id, offset);
+        }
+
+        return id;
+    }
+
+private:
+    std::unordered_map<uint64_t, size_t> m_offsets;
+    std::vector<char> m_storage;
+    std::mutex m_mutex;
+};
+
+
+static LegacyStrIDStorage& GetLegacyStorage() noexcept
+{
+    static LegacyStrIDStorage storage;
+    return storage;
+}
+
+
+// All threads intern the same already stored strings, the lock free lookup path under contention
+static void BM_StrIDInternExisting(benchmark::State& state)
+{
+    const std::vector<std::string>& strings = GetHotStrings();
+
+    if (state.thread_index() == 0) {
+        for (const std::string& str : strings) {
+            benchmark::DoNotOptimize(ds::StrID(str));
+        }
+    }
+
+    uint32_t strIdx = static_cast<uint32_t>(state.thread_index()) * 97;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ds::StrID(strings[strIdx++ % BENCH_HOT_STRINGS_COUNT]).GetId());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+// Every iteration stores a string nobody has stored before, threads contend on shard mutexes and table growth
+static void BM_StrIDInternNew(benchmark::State& state)
+{
+    static std::atomic<uint32_t> runIdx = 0;
+
+    const uint32_t threadRunIdx = runIdx.fetch_add(1, std::memory_order_relaxed);
+    const std::string prefix = "bench_new_" + std::to_string(threadRunIdx) + "_";
+
+    char buffer[64];
+    uint32_t strIdx = 0;
+
+    for (auto _ : state) {
+        const int length = snprintf(buffer, sizeof(buffer), "%s%u", prefix.c_str(), strIdx++);
+        benchmark::DoNotOptimize(ds::StrID(std::string_view(buffer, size_t(length))).GetId());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+static void BM_LegacyStrIDInternExisting(benchmark::State& state)
+{
+    const std::vector<std::string>& strings = GetHotStrings();
+    LegacyStrIDStorage& storage = GetLegacyStorage();
+
+    if (state.thread_index() == 0) {
+        for (const std::string& str : strings) {
+            benchmark::DoNotOptimize(storage.Store(str));
+        }
+    }
+
+    uint32_t strIdx = static_cast<uint32_t>(state.thread_index()) * 97;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(storage.Store(strings[strIdx++ % BENCH_HOT_STRINGS_COUNT]));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+static void BM_LegacyStrIDInternNew(benchmark::State& state)
+{
+    static std::atomic<uint32_t> runIdx = 0;
+
+    LegacyStrIDStorage& storage = GetLegacyStorage();
+
+    const uint32_t threadRunIdx = runIdx.fetch_add(1, std::memory_order_relaxed);
+    const std::string prefix = "bench_legacy_new_" + std::to_string(threadRunIdx) + "_";
+
+    char buffer[64];
+    uint32_t strIdx = 0;
+
+    for (auto _ : state) {
+        const int length = snprintf(buffer, sizeof(buffer), "%s%u", prefix.c_str(), strIdx++);
+        benchmark::DoNotOptimize(storage.Store(std::string_view(buffer, size_t(length))));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+BENCHMARK(BM_StrIDInternExisting)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_StrIDInternNew)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_LegacyStrIDInternExisting)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_LegacyStrIDInternNew)->ThreadRange(1, 8)->UseRealTime();
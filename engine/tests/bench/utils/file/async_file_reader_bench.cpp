@@ -0,0 +1,113 @@
+#include "pch.h"
+
+#include "utils/file/file.h"
+#include "utils/file/async_file_reader.h"
+
+#include <benchmark/benchmark.h>
+
+
+// Files are generated once into the temp directory and reused by later runs
+static std::vector<fs::path> GetBenchFiles(uint32_t filesCount, size_t fileSize) noexcept
+{
+    const fs::path dirPath = fs::temp_directory_path() / "engine_bench_files" / ("async_" + std::to_string(fileSize));
+
+    std::error_code error;
+    fs::create_directories(dirPath, error);
+
+    std::vector<char> data(fileSize);
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>(i * 31);
+    }
+
+    std::vector<fs::path> filepaths;
+    filepaths.reserve(filesCount);
+
+    for (uint32_t i = 0; i < filesCount; ++i) {
+        fs::path filepath = dirPath / ("file_" + std::to_string(i) + ".bin");
+
+        if (!fs::exists(filepath, error) || fs::file_size(filepath, error) != fileSize) {
+            std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+
+        filepaths.emplace_back(std::move(filepath));
+    }
+
+    return filepaths;
+}
+
+
+// Sequential blocking reads on the calling thread, which is what loaders did before the async reader
+static void BM_ReadBinaryFiles(benchmark::State& state)
+{
+    const uint32_t filesCount = static_cast<uint32_t>(state.range(0));
+    const size_t fileSize = static_cast<size_t>(state.range(1));
+    const std::vector<fs::path> filepaths = GetBenchFiles(filesCount, fileSize);
+
+    for (auto _ : state) {
+        for (const fs::path& filepath : filepaths) {
+            const std::vector<uint8_t> data = ReadBinaryFile(filepath);
+            benchmark::DoNotOptimize(data.data());
+        }
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * filesCount);
+    state.SetBytesProcessed(int64_t(state.iterations()) * filesCount * int64_t(fileSize));
+}
+
+
+// All files are requested at once and waited for, the time includes dispatching completions on this thread
+static void BM_AsyncFileReader(benchmark::State& state)
+{
+    const uint32_t filesCount = static_cast<uint32_t>(state.range(0));
+    const size_t fileSize = static_cast<size_t>(state.range(1));
+    const std::vector<fs::path> filepaths = GetBenchFiles(filesCount, fileSize);
+
+    if (!engInitAsyncFileReader()) {
+        state.SkipWithError("Failed to initialize async file reader");
+        return;
+    }
+
+    AsyncFileReader& reader = AsyncFileReader::GetInstance();
+
+    uint32_t failedReadsCount = 0;
+
+    for (auto _ : state) {
+        for (const fs::path& filepath : filepaths) {
+            reader.ReadAsync(filepath, [&failedReadsCount](FileReadResult& result) {
+                failedReadsCount += result.isSucceeded ? 0 : 1;
+                benchmark::DoNotOptimize(result.pData.get());
+            });
+        }
+
+        reader.WaitAll();
+    }
+
+    engTerminateAsyncFileReader();
+
+    if (failedReadsCount > 0) {
+        state.SkipWithError("Some files failed to read");
+        return;
+    }
+
+    state.SetItemsProcessed(int64_t(state.iterations()) * filesCount);
+    state.SetBytesProcessed(int64_t(state.iterations()) * filesCount * int64_t(fileSize));
+}
+
+
+// Many small files stress per request overhead, a few large ones the throughput of chunked reads. Both sets are 64 MB.
+// Files stay in the OS cache between iterations, so this measures the read path, not the disk
+static void FilesCountAndSizeArgs(benchmark::internal::Benchmark* pBenchmark)
+{
+    pBenchmark->ArgNames({ "files", "size" });
+    pBenchmark->Args({ 16 * 1024, 4 * 1024 });
+    pBenchmark->Args({ 1024, 64 * 1024 });
+    pBenchmark->Args({ 4, 16 * 1024 * 1024 });
+    pBenchmark->Unit(benchmark::kMillisecond);
+    pBenchmark->UseRealTime();
+}
+
+
+BENCHMARK(BM_ReadBinaryFiles)->Apply(FilesCountAndSizeArgs);
+BENCHMARK(BM_AsyncFileReader)->Apply(FilesCountAndSizeArgs);
@@ -0,0 +1,100 @@
+#include "pch.h"
+
+#include "utils/file/file.h"
+#include "utils/file/mapped_file.h"
+
+#include <benchmark/benchmark.h>
+
+
+static constexpr size_t BENCH_PAGE_SIZE = 4096;
+
+
+// Files are generated once into the temp directory and reused by later runs
+static fs::path GetBenchFile(size_t size) noexcept
+{
+    const fs::path dirPath = fs::temp_directory_path() / "engine_bench_files";
+    const fs::path filepath = dirPath / ("file_" + std::to_string(size) + ".bin");
+
+    std::error_code error;
+
+    if (fs::exists(filepath, error) && fs::file_size(filepath, error) == size) {
+        return filepath;
+    }
+
+    fs::create_directories(dirPath, error);
+
+    std::vector<char> chunk(16 * 1024 * 1024);
+
+    for (size_t i = 0; i < chunk.size(); ++i) {
+        chunk[i] = static_cast<char>(i * 31);
+    }
+
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+
+    for (size_t written = 0; written < size; written += chunk.size()) {
+        file.write(chunk.data(), static_cast<std::streamsize>(std::min(chunk.size(), size - written)));
+    }
+
+    return filepath;
+}
+
+
+// Both paths touch every page, so the mapped file pays for its page faults too
+static uint64_t TouchPages(const uint8_t* pData, size_t size) noexcept
+{
+    uint64_t sum = 0;
+
+    for (size_t offset = 0; offset < size; offset += BENCH_PAGE_SIZE) {
+        sum += pData[offset];
+    }
+
+    return sum;
+}
+
+
+static void BM_ReadBinaryFile(benchmark::State& state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    const fs::path filepath = GetBenchFile(size);
+
+    for (auto _ : state) {
+        const std::vector<uint8_t> data = ReadBinaryFile(filepath);
+        benchmark::DoNotOptimize(TouchPages(data.data(), data.size()));
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(size));
+}
+
+
+static void BM_MappedFile(benchmark::State& state)
+{
+    const size_t size = static_cast<size_t>(state.range(0));
+    const fs::path filepath = GetBenchFile(size);
+
+    for (auto _ : state) {
+        MappedFile file;
+        file.Open(filepath);
+
+        benchmark::DoNotOptimize(TouchPages(file.GetData(), file.GetSize()));
+    }
+
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(size));
+}
+
+
+// 4 KB to 1 GB. Files stay in the OS cache between iterations, so this measures copy, zero-fill and mapping costs, not the disk
+static void FileSizeArgs(benchmark::internal::Benchmark* pBenchmark)
+{
+    pBenchmark->ArgName("size");
+
+    for (int64_t size = 4 * 1024; size <= 1024 * 1024 * 1024; size *= 16) {
+        pBenchmark->Arg(size);
+    }
+
+    pBenchmark->Arg(1024 * 1024 * 1024);
+    pBenchmark->UseRealTime();
+}
+
+
+BENCHMARK(BM_ReadBinaryFile)->Apply(FileSizeArgs);
+BENCHMARK(BM_MappedFile)->Apply(FileSizeArgs);
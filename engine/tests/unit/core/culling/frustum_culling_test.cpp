@@ -0,0 +1,346 @@
+#include "pch.h"
+
+#include "core/culling/frustum_culling.h"
+#include "core/job_system/job_system.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+
+static constexpr float TEST_Z_NEAR = 0.1f;
+static constexpr float TEST_Z_FAR = 100.f;
+
+// Volumes closer to a plane than this are skipped by randomized tests: kernels sum plane distance terms
+// in different order, so results may legitimately differ right on a plane
+static constexpr float TEST_PLANE_MARGIN = 1e-3f;
+
+
+static float GetPlaneDistance(const glm::vec4& plane, const glm::vec3& point) noexcept
+{
+    return glm::dot(glm::vec3(plane), point) + plane.w;
+}
+
+
+// Camera at the origin looking down -Z, the same view the engine camera has with identity rotation
+static glm::mat4x4 MakeViewProjection(bool isInvertedZ) noexcept
+{
+    const float zNear = isInvertedZ ? TEST_Z_FAR : TEST_Z_NEAR;
+    const float zFar = isInvertedZ ? TEST_Z_NEAR : TEST_Z_FAR;
+
+    return glm::perspectiveRH_ZO(glm::radians(90.f), 1.f, zNear, zFar);
+}
+
+
+static bool IsSphereVisibleRef(const Frustum& frustum, const glm::vec3& center, float radius, float& outMinMargin) noexcept
+{
+    bool isVisible = true;
+    outMinMargin = std::numeric_limits<float>::max();
+
+    for (const glm::vec4& plane : frustum.planes) {
+        const float margin = GetPlaneDistance(plane, center) + radius;
+
+        isVisible &= margin >= 0.f;
+        outMinMargin = std::min(outMinMargin, std::abs(margin));
+    }
+
+    return isVisible;
+}
+
+
+static bool IsAABBVisibleRef(const Frustum& frustum, const glm::vec3& min, const glm::vec3& max, float& outMinMargin) noexcept
+{
+    bool isVisible = true;
+    outMinMargin = std::numeric_limits<float>::max();
+
+    for (const glm::vec4& plane : frustum.planes) {
+        // The corner farthest along the plane normal
+        const glm::vec3 corner(plane.x >= 0.f ? max.x : min.x, plane.y >= 0.f ? max.y : min.y, plane.z >= 0.f ? max.z : min.z);
+        const float margin = GetPlaneDistance(plane, corner);
+
+        isVisible &= margin >= 0.f;
+        outMinMargin = std::min(outMinMargin, std::abs(margin));
+    }
+
+    return isVisible;
+}
+
+
+static void ExpectDepthPlanes(const Frustum& frustum, FrustumPlane nearPlane, FrustumPlane farPlane) noexcept
+{
+    // Both planes are perpendicular to the view direction, near one faces away from the camera
+    EXPECT_NEAR(frustum.planes[nearPlane].z, -1.f, 1e-4f);
+    EXPECT_NEAR(frustum.planes[farPlane].z, 1.f, 1e-4f);
+
+    EXPECT_NEAR(GetPlaneDistance(frustum.planes[nearPlane], glm::vec3(0.f, 0.f, -TEST_Z_NEAR)), 0.f, 1e-3f);
+    EXPECT_NEAR(GetPlaneDistance(frustum.planes[farPlane], glm::vec3(0.f, 0.f, -TEST_Z_FAR)), 0.f, 1e-2f);
+}
+
+
+static void ExpectViewVolume(const Frustum& frustum) noexcept
+{
+    for (const glm::vec4& plane : frustum.planes) {
+        EXPECT_NEAR(glm::length(glm::vec3(plane)), 1.f, 1e-5f);
+    }
+
+    float margin = 0.f;
+
+    EXPECT_TRUE(IsSphereVisibleRef(frustum, glm::vec3(0.f, 0.f, -5.f), 0.f, margin));
+    EXPECT_TRUE(IsSphereVisibleRef(frustum, glm::vec3(4.f, -4.f, -5.f), 0.f, margin));
+
+    EXPECT_FALSE(IsSphereVisibleRef(frustum, glm::vec3(0.f, 0.f, 5.f), 0.f, margin));
+    EXPECT_FALSE(IsSphereVisibleRef(frustum, glm::vec3(0.f, 0.f, -0.05f), 0.f, margin));
+    EXPECT_FALSE(IsSphereVisibleRef(frustum, glm::vec3(0.f, 0.f, -150.f), 0.f, margin));
+    EXPECT_FALSE(IsSphereVisibleRef(frustum, glm::vec3(6.f, 0.f, -5.f), 0.f, margin));
+    EXPECT_FALSE(IsSphereVisibleRef(frustum, glm::vec3(0.f, -6.f, -5.f), 0.f, margin));
+}
+
+
+TEST(Frustum, ExtractPlanesInvertedZ)
+{
+    Frustum frustum;
+    frustum.ExtractPlanes(MakeViewProjection(true));
+
+    ExpectViewVolume(frustum);
+
+#if defined(ENG_USE_INVERTED_Z)
+    ExpectDepthPlanes(frustum, FRUSTUM_PLANE_NEAR, FRUSTUM_PLANE_FAR);
+#else
+    ExpectDepthPlanes(frustum, FRUSTUM_PLANE_FAR, FRUSTUM_PLANE_NEAR);
+#endif
+}
+
+
+TEST(Frustum, ExtractPlanesZeroToOne)
+{
+    Frustum frustum;
+    frustum.ExtractPlanes(MakeViewProjection(false));
+
+    ExpectViewVolume(frustum);
+
+    // Depth plane names follow ENG_USE_INVERTED_Z, the bounded volume doesn't depend on it
+#if defined(ENG_USE_INVERTED_Z)
+    ExpectDepthPlanes(frustum, FRUSTUM_PLANE_FAR, FRUSTUM_PLANE_NEAR);
+#else
+    ExpectDepthPlanes(frustum, FRUSTUM_PLANE_NEAR, FRUSTUM_PLANE_FAR);
+#endif
+}
+
+
+TEST(Frustum, ExtractPlanesKeepsDegeneratePlanes)
+{
+    Frustum frustum;
+    frustum.ExtractPlanes(glm::mat4x4(0.f));
+
+    for (const glm::vec4& plane : frustum.planes) {
+        EXPECT_EQ(plane.x, 0.f);
+        EXPECT_EQ(plane.y, 0.f);
+        EXPECT_EQ(plane.z, 0.f);
+        EXPECT_EQ(plane.w, 0.f);
+    }
+}
+
+
+TEST(BoundingVolumesSoA, PadsToSIMDWidth)
+{
+    BoundingSpheresSoA spheres;
+    BoundingAABBsSoA aabbs;
+
+    for (uint32_t i = 0; i < 13; ++i) {
+        EXPECT_EQ(spheres.Add(glm::vec3(float(i)), 1.f), i);
+        EXPECT_EQ(aabbs.Add(glm::vec3(float(i)), glm::vec3(float(i) + 1.f)), i);
+    }
+
+    EXPECT_EQ(spheres.GetCount(), 13u);
+    EXPECT_EQ(spheres.GetPaddedCount(), 16u);
+    EXPECT_EQ(aabbs.GetCount(), 13u);
+    EXPECT_EQ(aabbs.GetPaddedCount(), 16u);
+
+    EXPECT_FLOAT_EQ(aabbs.GetCentersX()[12], 12.5f);
+    EXPECT_FLOAT_EQ(aabbs.GetExtentsX()[12], 0.5f);
+
+    // Padding volumes have negative size
+    for (uint32_t i = 13; i < 16; ++i) {
+        EXPECT_LT(spheres.GetRadii()[i], 0.f);
+        EXPECT_LT(aabbs.GetExtentsX()[i], 0.f);
+    }
+
+    spheres.Resize(3);
+    EXPECT_EQ(spheres.GetCount(), 3u);
+    EXPECT_EQ(spheres.GetPaddedCount(), CULLING_SIMD_WIDTH);
+    EXPECT_LT(spheres.GetRadii()[3], 0.f);
+
+    spheres.Clear();
+    EXPECT_TRUE(spheres.IsEmpty());
+    EXPECT_EQ(spheres.GetPaddedCount(), 0u);
+}
+
+
+// Runs every test for each kernel the CPU supports, the scalar one is always there
+class FrustumCullerTest : public ::testing::TestWithParam<CPUSIMDLevel>
+{
+protected:
+    void SetUp() override
+    {
+        if (GetParam() > GetCPUSIMDLevel()) {
+            GTEST_SKIP() << "SIMD level isn't supported by the CPU";
+        }
+
+        m_culler.SetMaxSIMDLevel(GetParam());
+        m_frustum.ExtractPlanes(MakeViewProjection(true));
+    }
+
+    // Random volumes around the frustum, the ones which lie on a plane within TEST_PLANE_MARGIN are dropped
+    void GenerateVolumes(uint32_t count, uint32_t seed) noexcept
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> positionDist(-120.f, 120.f);
+        std::uniform_real_distribution<float> sizeDist(0.f, 5.f);
+
+        m_spheres.Clear();
+        m_aabbs.Clear();
+        m_refVisibleSpheres.clear();
+        m_refVisibleAABBs.clear();
+
+        while (m_spheres.GetCount() < count) {
+            const glm::vec3 center(positionDist(rng), positionDist(rng), positionDist(rng) - 60.f);
+            const glm::vec3 extents(sizeDist(rng), sizeDist(rng), sizeDist(rng));
+            const float radius = sizeDist(rng);
+
+            float sphereMargin = 0.f;
+            float aabbMargin = 0.f;
+
+            const bool isSphereVisible = IsSphereVisibleRef(m_frustum, center, radius, sphereMargin);
+            const bool isAABBVisible = IsAABBVisibleRef(m_frustum, center - extents, center + extents, aabbMargin);
+
+            if (sphereMargin < TEST_PLANE_MARGIN || aabbMargin < TEST_PLANE_MARGIN) {
+                continue;
+            }
+
+            const uint32_t idx = m_spheres.Add(center, radius);
+            m_aabbs.Add(center - extents, center + extents);
+
+            if (isSphereVisible) {
+                m_refVisibleSpheres.emplace_back(idx);
+            }
+
+            if (isAABBVisible) {
+                m_refVisibleAABBs.emplace_back(idx);
+            }
+        }
+    }
+
+protected:
+    FrustumCuller m_culler;
+    Frustum m_frustum;
+
+    BoundingSpheresSoA m_spheres;
+    BoundingAABBsSoA m_aabbs;
+
+    std::vector<uint32_t> m_refVisibleSpheres;
+    std::vector<uint32_t> m_refVisibleAABBs;
+
+    std::vector<uint32_t> m_visibleIndices;
+};
+
+
+TEST_P(FrustumCullerTest, MatchesScalarReference)
+{
+    // Not a multiple of the SIMD width, so the last group has padding lanes
+    GenerateVolumes(10'003, 1);
+
+    ASSERT_FALSE(m_refVisibleSpheres.empty());
+    ASSERT_FALSE(m_refVisibleAABBs.empty());
+
+    m_culler.CullSpheres(m_frustum, m_spheres, m_visibleIndices);
+    EXPECT_EQ(m_visibleIndices, m_refVisibleSpheres);
+
+    m_culler.CullAABBs(m_frustum, m_aabbs, m_visibleIndices);
+    EXPECT_EQ(m_visibleIndices, m_refVisibleAABBs);
+
+    EXPECT_EQ(m_culler.GetStats().testedCount, 10'003u);
+    EXPECT_EQ(m_culler.GetStats().visibleCount, m_refVisibleAABBs.size());
+    EXPECT_EQ(m_culler.GetStats().batchesCount, 1u);
+}
+
+
+TEST_P(FrustumCullerTest, CompactsSmallBatches)
+{
+    GenerateVolumes(10'003, 2);
+
+    // Many batches with different visible counts, each is moved down to the end of the previous one
+    m_culler.SetBatchSize(5);
+    EXPECT_EQ(m_culler.GetBatchSize(), CULLING_SIMD_WIDTH);
+
+    m_culler.CullSpheres(m_frustum, m_spheres, m_visibleIndices);
+    EXPECT_EQ(m_visibleIndices, m_refVisibleSpheres);
+
+    m_culler.CullAABBs(m_frustum, m_aabbs, m_visibleIndices);
+    EXPECT_EQ(m_visibleIndices, m_refVisibleAABBs);
+
+    EXPECT_EQ(m_culler.GetStats().batchesCount, m_aabbs.GetPaddedCount() / CULLING_SIMD_WIDTH);
+}
+
+
+TEST_P(FrustumCullerTest, MatchesScalarReferenceOnJobs)
+{
+    ASSERT_TRUE(engInitJobSystem());
+
+    GenerateVolumes(100'001, 3);
+    m_culler.SetBatchSize(1000);
+
+    m_culler.CullSpheres(m_frustum, m_spheres, m_visibleIndices);
+    EXPECT_EQ(m_visibleIndices, m_refVisibleSpheres);
+
+    m_culler.CullAABBs(m_frustum, m_aabbs, m_visibleIndices);
+    EXPECT_EQ(m_visibleIndices, m_refVisibleAABBs);
+
+    engTerminateJobSystem();
+}
+
+
+TEST_P(FrustumCullerTest, SkipsPaddingVolumes)
+{
+    // Padding volumes are centered at the origin, put it in the middle of the frustum
+    m_frustum.ExtractPlanes(MakeViewProjection(true) * glm::translate(M3D_MAT4_IDENTITY, glm::vec3(0.f, 0.f, -10.f)));
+
+    for (uint32_t i = 0; i < 13; ++i) {
+        m_spheres.Add(M3D_ZEROF3, 1.f);
+        m_aabbs.Add(-M3D_ONEF3, M3D_ONEF3);
+    }
+
+    const std::vector<uint32_t> allIndices = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+
+    m_culler.CullSpheres(m_frustum, m_spheres, m_visibleIndices);
+    EXPECT_EQ(m_visibleIndices, allIndices);
+
+    m_culler.CullAABBs(m_frustum, m_aabbs, m_visibleIndices);
+    EXPECT_EQ(m_visibleIndices, allIndices);
+}
+
+
+TEST_P(FrustumCullerTest, ClearsOutputOfEmptyVolumes)
+{
+    m_visibleIndices = { 1, 2, 3 };
+
+    m_culler.CullSpheres(m_frustum, m_spheres, m_visibleIndices);
+    EXPECT_TRUE(m_visibleIndices.empty());
+
+    m_visibleIndices = { 1, 2, 3 };
+
+    m_culler.CullAABBs(m_frustum, m_aabbs, m_visibleIndices);
+    EXPECT_TRUE(m_visibleIndices.empty());
+
+    EXPECT_EQ(m_culler.GetStats().testedCount, 0u);
+}
+
+
+INSTANTIATE_TEST_SUITE_P(SIMDLevels, FrustumCullerTest,
+    ::testing::Values(CPUSIMDLevel::SCALAR, CPUSIMDLevel::SSE2, CPUSIMDLevel::AVX),
+    [](const ::testing::TestParamInfo<CPUSIMDLevel>& info) -> std::string {
+        switch (info.param) {
+            case CPUSIMDLevel::SCALAR: return "Scalar";
+            case CPUSIMDLevel::SSE2: return "SSE2";
+            default: return "AVX";
+        }
+    });
@@ -0,0 +1,321 @@
+#include "pch.h"
+
+#include "core/culling/hiz_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <random>
+
+
+static constexpr float TEST_Z_NEAR = 0.1f;
+static constexpr float TEST_Z_FAR = 100.f;
+
+static constexpr uint32_t TEST_DEPTH_WIDTH = 256;
+static constexpr uint32_t TEST_DEPTH_HEIGHT = 128;
+
+
+// Camera at the origin looking down -Z with the projection the engine camera builds, inverted Z swaps near and far
+static glm::mat4x4 MakeViewProjection() noexcept
+{
+    const float aspect = float(TEST_DEPTH_WIDTH) / TEST_DEPTH_HEIGHT;
+
+#if defined(ENG_USE_INVERTED_Z)
+    return glm::perspective(glm::radians(90.f), aspect, TEST_Z_FAR, TEST_Z_NEAR);
+#else
+    return glm::perspective(glm::radians(90.f), aspect, TEST_Z_NEAR, TEST_Z_FAR);
+#endif
+}
+
+
+// Window space depth of a surface facing the camera at the distance, the value a rasterized depth buffer would hold
+static float GetWindowDepth(const glm::mat4x4& viewProjMatrix, float distance) noexcept
+{
+    const glm::vec4 clip = viewProjMatrix * glm::vec4(0.f, 0.f, -distance, 1.f);
+
+#if defined(GLM_FORCE_DEPTH_ZERO_TO_ONE)
+    return clip.z / clip.w;
+#else
+    return clip.z / clip.w * 0.5f + 0.5f;
+#endif
+}
+
+
+static float GetFartherDepthRef(float left, float right) noexcept
+{
+#if defined(ENG_USE_INVERTED_Z)
+    return std::min(left, right);
+#else
+    return std::max(left, right);
+#endif
+}
+
+
+static float GetNearerDepthRef(float left, float right) noexcept
+{
+#if defined(ENG_USE_INVERTED_Z)
+    return std::max(left, right);
+#else
+    return std::min(left, right);
+#endif
+}
+
+
+// Depth buffer cleared to the far plane, surfaces are filled as pixel rects with rows bottom to top
+class SyntheticDepth
+{
+public:
+    SyntheticDepth()
+        : m_viewProjMatrix(MakeViewProjection()), m_depth(TEST_DEPTH_WIDTH * TEST_DEPTH_HEIGHT, GetWindowDepth(m_viewProjMatrix, TEST_Z_FAR))
+    {
+    }
+
+    void FillRect(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, float distance) noexcept
+    {
+        const float depth = GetWindowDepth(m_viewProjMatrix, distance);
+
+        for (uint32_t y = y0; y < y1; ++y) {
+            std::fill_n(m_depth.begin() + y * TEST_DEPTH_WIDTH + x0, x1 - x0, depth);
+        }
+    }
+
+    void FillScreen(float distance) noexcept
+    {
+        FillRect(0, 0, TEST_DEPTH_WIDTH, TEST_DEPTH_HEIGHT, distance);
+    }
+
+    void Build(HiZBuffer& hiZBuffer) const noexcept
+    {
+        hiZBuffer.Build(m_depth.data(), TEST_DEPTH_WIDTH, TEST_DEPTH_HEIGHT, m_viewProjMatrix);
+    }
+
+    const glm::mat4x4& GetViewProjectionMatrix() const noexcept { return m_viewProjMatrix; }
+
+private:
+    glm::mat4x4 m_viewProjMatrix;
+    std::vector<float> m_depth;
+};
+
+
+TEST(HiZBuffer, LevelsKeepFarthestAndNearestDepthOfCoveredPixels)
+{
+    // Odd sizes clamp the last texels of rows and columns, the width is large enough for SIMD reduction of the first levels
+    constexpr uint32_t width = 203;
+    constexpr uint32_t height = 77;
+
+    std::vector<float> depth(width * height);
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> depthDist(0.f, 1.f);
+
+    for (float& value : depth) {
+        value = depthDist(rng);
+    }
+
+    HiZBuffer hiZBuffer;
+    hiZBuffer.Build(depth.data(), width, height, MakeViewProjection());
+
+    ASSERT_TRUE(hiZBuffer.IsValid());
+    EXPECT_EQ(hiZBuffer.GetDepthWidth(), width);
+    EXPECT_EQ(hiZBuffer.GetDepthHeight(), height);
+
+    uint32_t levelWidth = width;
+    uint32_t levelHeight = height;
+
+    for (uint32_t level = 0; level < hiZBuffer.GetLevelsCount(); ++level) {
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+
+        ASSERT_EQ(hiZBuffer.GetLevelWidth(level), levelWidth);
+        ASSERT_EQ(hiZBuffer.GetLevelHeight(level), levelHeight);
+
+        const uint32_t texelSize = 2u << level;
+
+        for (uint32_t y = 0; y < levelHeight; ++y) {
+            for (uint32_t x = 0; x < levelWidth; ++x) {
+                float farthest = depth[uint64_t(y) * texelSize * width + uint64_t(x) * texelSize];
+                float nearest = farthest;
+
+                for (uint32_t pixelY = y * texelSize; pixelY < std::min((y + 1) * texelSize, height); ++pixelY) {
+                    for (uint32_t pixelX = x * texelSize; pixelX < std::min((x + 1) * texelSize, width); ++pixelX) {
+                        farthest = GetFartherDepthRef(farthest, depth[uint64_t(pixelY) * width + pixelX]);
+                        nearest = GetNearerDepthRef(nearest, depth[uint64_t(pixelY) * width + pixelX]);
+                    }
+                }
+
+                ASSERT_EQ(hiZBuffer.GetFarthestDepth(level, x, y), farthest) << "level: " << level << " texel: " << x << ", " << y;
+                ASSERT_EQ(hiZBuffer.GetNearestDepth(level, x, y), nearest) << "level: " << level << " texel: " << x << ", " << y;
+            }
+        }
+    }
+
+    EXPECT_EQ(levelWidth, 1u);
+    EXPECT_EQ(levelHeight, 1u);
+}
+
+
+TEST(HiZBuffer, FollowsInvertedZ)
+{
+    const glm::mat4x4 viewProjMatrix = MakeViewProjection();
+    const float nearDepth = GetWindowDepth(viewProjMatrix, TEST_Z_NEAR);
+    const float farDepth = GetWindowDepth(viewProjMatrix, TEST_Z_FAR);
+
+#if defined(ENG_USE_INVERTED_Z)
+    EXPECT_NEAR(nearDepth, 1.f, 1e-5f);
+    EXPECT_NEAR(farDepth, 0.f, 1e-5f);
+#else
+    EXPECT_NEAR(nearDepth, 0.f, 1e-5f);
+    EXPECT_NEAR(farDepth, 1.f, 1e-5f);
+#endif
+
+    // Left half is a wall, the right half keeps the clear value
+    SyntheticDepth depth;
+    depth.FillRect(0, 0, TEST_DEPTH_WIDTH / 2, TEST_DEPTH_HEIGHT, 10.f);
+
+    HiZBuffer hiZBuffer;
+    depth.Build(hiZBuffer);
+
+    const uint32_t topLevel = hiZBuffer.GetLevelsCount() - 1;
+
+    EXPECT_EQ(hiZBuffer.GetFarthestDepth(topLevel, 0, 0), farDepth);
+    EXPECT_EQ(hiZBuffer.GetNearestDepth(topLevel, 0, 0), GetWindowDepth(viewProjMatrix, 10.f));
+
+    // Nothing is behind the cleared half, the wall half occludes what is behind it
+    EXPECT_FALSE(hiZBuffer.IsAABBOccluded(glm::vec3(20.f, 0.f, -50.f), glm::vec3(1.f)));
+    EXPECT_TRUE(hiZBuffer.IsAABBOccluded(glm::vec3(-20.f, 0.f, -50.f), glm::vec3(1.f)));
+}
+
+
+TEST(HiZBuffer, OccludesOnlyBoundsBehindWall)
+{
+    SyntheticDepth depth;
+    depth.FillScreen(10.f);
+
+    HiZBuffer hiZBuffer;
+    depth.Build(hiZBuffer);
+
+    EXPECT_TRUE(hiZBuffer.IsAABBOccluded(glm::vec3(0.f, 0.f, -20.f), glm::vec3(1.f)));
+    EXPECT_TRUE(hiZBuffer.IsAABBOccluded(glm::vec3(5.f, -3.f, -30.f), glm::vec3(2.f, 1.f, 4.f)));
+
+    // In front of the wall and intersecting it
+    EXPECT_FALSE(hiZBuffer.IsAABBOccluded(glm::vec3(0.f, 0.f, -5.f), glm::vec3(1.f)));
+    EXPECT_FALSE(hiZBuffer.IsAABBOccluded(glm::vec3(0.f, 0.f, -10.f), glm::vec3(1.f)));
+
+    // Off screen bounds are left to frustum culling
+    EXPECT_FALSE(hiZBuffer.IsAABBOccluded(glm::vec3(100.f, 0.f, -20.f), glm::vec3(1.f)));
+}
+
+
+TEST(HiZBuffer, KeepsBoundsVisibleThroughHole)
+{
+    // Wall with a hole in the middle of the screen
+    SyntheticDepth depth;
+    depth.FillRect(0, 0, TEST_DEPTH_WIDTH, 32, 10.f);
+    depth.FillRect(0, 96, TEST_DEPTH_WIDTH, TEST_DEPTH_HEIGHT, 10.f);
+    depth.FillRect(0, 32, 96, 96, 10.f);
+    depth.FillRect(160, 32, TEST_DEPTH_WIDTH, 96, 10.f);
+
+    HiZBuffer hiZBuffer;
+    depth.Build(hiZBuffer);
+
+    EXPECT_FALSE(hiZBuffer.IsAABBOccluded(glm::vec3(0.f, 0.f, -20.f), glm::vec3(1.f)));
+    EXPECT_TRUE(hiZBuffer.IsAABBOccluded(glm::vec3(-15.f, 0.f, -20.f), glm::vec3(1.f)));
+
+    // Partially behind the hole edge
+    EXPECT_FALSE(hiZBuffer.IsAABBOccluded(glm::vec3(-10.f, 0.f, -20.f), glm::vec3(1.5f)));
+}
+
+
+TEST(HiZBuffer, NeverOccludesBoundsCrossingNearPlane)
+{
+    SyntheticDepth depth;
+    depth.FillScreen(1.f);
+
+    HiZBuffer hiZBuffer;
+    depth.Build(hiZBuffer);
+
+    ASSERT_TRUE(hiZBuffer.IsAABBOccluded(glm::vec3(0.f, 0.f, -20.f), glm::vec3(1.f)));
+
+    // The camera is inside, and the bounds stretching from behind the camera to far behind the wall
+    EXPECT_FALSE(hiZBuffer.IsAABBOccluded(glm::vec3(0.f), glm::vec3(0.5f)));
+    EXPECT_FALSE(hiZBuffer.IsAABBOccluded(glm::vec3(0.f, 0.f, -20.f), glm::vec3(1.f, 1.f, 21.f)));
+    EXPECT_FALSE(hiZBuffer.IsAABBOccluded(glm::vec3(0.f, 0.f, 5.f), glm::vec3(1.f)));
+
+    std::vector<uint32_t> visibleIndices = { 0 };
+
+    BoundingSpheresSoA spheres;
+    spheres.Add(glm::vec3(0.f, 0.f, -0.05f), 0.2f);
+
+    hiZBuffer.CullSpheres(spheres, visibleIndices);
+    EXPECT_EQ(visibleIndices.size(), 1u);
+}
+
+
+TEST(HiZBuffer, CullKeepsOrderOfVisibleIndicesAcrossBatches)
+{
+    SyntheticDepth depth;
+    depth.FillScreen(10.f);
+
+    HiZBuffer hiZBuffer;
+    depth.Build(hiZBuffer);
+
+    // More volumes than a single cull batch holds, every odd one is in front of the wall
+    constexpr uint32_t count = 10'000;
+
+    BoundingAABBsSoA aabbs;
+    BoundingSpheresSoA spheres;
+    std::vector<uint32_t> expectedIndices;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const float distance = i % 2 ? 5.f : 20.f;
+        const glm::vec3 center(float(i % 7) - 3.f, float(i % 5) - 2.f, -distance);
+
+        aabbs.Add(center - 0.5f, center + 0.5f);
+        spheres.Add(center, 0.5f);
+
+        if (i % 2) {
+            expectedIndices.emplace_back(i);
+        }
+    }
+
+    std::vector<uint32_t> visibleIndices(count);
+    std::iota(visibleIndices.begin(), visibleIndices.end(), 0);
+
+    hiZBuffer.CullAABBs(aabbs, visibleIndices);
+    EXPECT_EQ(visibleIndices, expectedIndices);
+
+    visibleIndices.resize(count);
+    std::iota(visibleIndices.begin(), visibleIndices.end(), 0);
+
+    hiZBuffer.CullSpheres(spheres, visibleIndices);
+    EXPECT_EQ(visibleIndices, expectedIndices);
+
+    EXPECT_EQ(hiZBuffer.GetStats().testedCount, 2 * count);
+    EXPECT_EQ(hiZBuffer.GetStats().occludedCount, count);
+    EXPECT_FLOAT_EQ(hiZBuffer.GetOccludedRatio(), 0.5f);
+
+    hiZBuffer.ResetTestStats();
+    EXPECT_EQ(hiZBuffer.GetStats().testedCount, 0u);
+}
+
+
+TEST(HiZBuffer, ClearedBufferCullsNothing)
+{
+    SyntheticDepth depth;
+    depth.FillScreen(10.f);
+
+    HiZBuffer hiZBuffer;
+    depth.Build(hiZBuffer);
+    hiZBuffer.Clear();
+
+    ASSERT_FALSE(hiZBuffer.IsValid());
+    EXPECT_FALSE(hiZBuffer.IsAABBOccluded(glm::vec3(0.f, 0.f, -20.f), glm::vec3(1.f)));
+
+    BoundingAABBsSoA aabbs;
+    aabbs.Add(glm::vec3(-1.f, -1.f, -21.f), glm::vec3(1.f, 1.f, -19.f));
+
+    std::vector<uint32_t> visibleIndices = { 0 };
+    hiZBuffer.CullAABBs(aabbs, visibleIndices);
+
+    EXPECT_EQ(visibleIndices.size(), 1u);
+    EXPECT_EQ(hiZBuffer.GetStats().testedCount, 0u);
+}
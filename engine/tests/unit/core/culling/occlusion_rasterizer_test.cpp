@@ -0,0 +1,263 @@
+#include "pch.h"
+
+#include "core/culling/occlusion_rasterizer.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+
+static constexpr uint32_t TEST_WIDTH = 4 * OcclusionRasterizer::TILE_WIDTH;
+static constexpr uint32_t TEST_HEIGHT = 4 * OcclusionRasterizer::TILE_HEIGHT;
+
+static constexpr float TEST_Z_NEAR = 1.f;
+static constexpr float TEST_Z_FAR = 100.f;
+
+
+// World x and y are screen pixels, so triangle vertices can be put exactly on tile edges and pixel centers
+static glm::mat4x4 MakePixelProjection() noexcept
+{
+#if defined(ENG_USE_INVERTED_Z)
+    return glm::ortho(0.f, float(TEST_WIDTH), 0.f, float(TEST_HEIGHT), TEST_Z_FAR, TEST_Z_NEAR);
+#else
+    return glm::ortho(0.f, float(TEST_WIDTH), 0.f, float(TEST_HEIGHT), TEST_Z_NEAR, TEST_Z_FAR);
+#endif
+}
+
+
+static float GetClearDepth() noexcept
+{
+#if defined(ENG_USE_INVERTED_Z)
+    return 0.f;
+#else
+    return 1.f;
+#endif
+}
+
+
+// Triangles are kept as a single occluder with an identity world matrix
+struct TestOccluder
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+
+    void AddTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) noexcept
+    {
+        for (const glm::vec3& vertex : { v0, v1, v2 }) {
+            indices.emplace_back(static_cast<uint32_t>(positions.size()));
+            positions.emplace_back(vertex);
+        }
+    }
+
+    void AddQuad(float minX, float minY, float maxX, float maxY, float distance) noexcept
+    {
+        AddTriangle(glm::vec3(minX, minY, -distance), glm::vec3(maxX, minY, -distance), glm::vec3(maxX, maxY, -distance));
+        AddTriangle(glm::vec3(minX, minY, -distance), glm::vec3(maxX, maxY, -distance), glm::vec3(minX, maxY, -distance));
+    }
+};
+
+
+static void RasterizeTestOccluder(OcclusionRasterizer& rasterizer, const TestOccluder& occluder) noexcept
+{
+    rasterizer.SetResolution(TEST_WIDTH, TEST_HEIGHT);
+    rasterizer.BeginFrame(MakePixelProjection());
+    rasterizer.AddOccluder(occluder.positions.data(), static_cast<uint32_t>(occluder.positions.size()),
+        occluder.indices.data(), static_cast<uint32_t>(occluder.indices.size()), M3D_MAT4_IDENTITY);
+    rasterizer.Rasterize();
+}
+
+
+// Runs every test for each kernel the CPU supports, results must be equal to the scalar kernel bit for bit
+class OcclusionRasterizerTest : public ::testing::TestWithParam<CPUSIMDLevel>
+{
+protected:
+    void SetUp() override
+    {
+        if (GetParam() > GetCPUSIMDLevel()) {
+            GTEST_SKIP() << "SIMD level isn't supported by the CPU";
+        }
+
+        m_rasterizer.SetMaxSIMDLevel(GetParam());
+        m_refRasterizer.SetMaxSIMDLevel(CPUSIMDLevel::SCALAR);
+    }
+
+    void ExpectDepthEqualToScalar(const TestOccluder& occluder) noexcept
+    {
+        RasterizeTestOccluder(m_rasterizer, occluder);
+        RasterizeTestOccluder(m_refRasterizer, occluder);
+
+        ASSERT_EQ(m_rasterizer.GetStats().setupTrianglesCount, m_refRasterizer.GetStats().setupTrianglesCount);
+
+        const float* pDepth = m_rasterizer.GetDepth();
+        const float* pRefDepth = m_refRasterizer.GetDepth();
+
+        for (uint32_t y = 0; y < TEST_HEIGHT; ++y) {
+            for (uint32_t x = 0; x < TEST_WIDTH; ++x) {
+                ASSERT_EQ(pDepth[y * TEST_WIDTH + x], pRefDepth[y * TEST_WIDTH + x]) << "pixel: " << x << ", " << y;
+            }
+        }
+    }
+
+protected:
+    OcclusionRasterizer m_rasterizer;
+    OcclusionRasterizer m_refRasterizer;
+};
+
+
+TEST_P(OcclusionRasterizerTest, CoversPixelCentersOfTileAlignedQuad)
+{
+    constexpr uint32_t minX = OcclusionRasterizer::TILE_WIDTH;
+    constexpr uint32_t minY = OcclusionRasterizer::TILE_HEIGHT;
+    constexpr uint32_t maxX = 2 * OcclusionRasterizer::TILE_WIDTH;
+    constexpr uint32_t maxY = 3 * OcclusionRasterizer::TILE_HEIGHT;
+
+    TestOccluder occluder;
+    occluder.AddQuad(float(minX), float(minY), float(maxX), float(maxY), 10.f);
+
+    RasterizeTestOccluder(m_rasterizer, occluder);
+
+    const float* pDepth = m_rasterizer.GetDepth();
+    const float quadDepth = pDepth[minY * TEST_WIDTH + minX];
+
+    ASSERT_NE(quadDepth, GetClearDepth());
+
+    // Pixel centers on the quad edges go to the quad, the pixels right before the edges keep the clear depth
+    for (uint32_t y = 0; y < TEST_HEIGHT; ++y) {
+        for (uint32_t x = 0; x < TEST_WIDTH; ++x) {
+            const bool isInside = x >= minX && x < maxX && y >= minY && y < maxY;
+            ASSERT_EQ(pDepth[y * TEST_WIDTH + x], isInside ? quadDepth : GetClearDepth()) << "pixel: " << x << ", " << y;
+        }
+    }
+}
+
+
+TEST_P(OcclusionRasterizerTest, MatchesScalarOnTileEdges)
+{
+    // Vertices within a few pixels of tile corners, so spans start at every lane offset and cross tiles in both directions
+    constexpr float EDGE_OFFSETS[] = { -2.5f, -1.f, -0.5f, -0.25f, 0.f, 0.25f, 0.5f, 1.f, 1.5f, 3.75f };
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> offsetDist(0, static_cast<uint32_t>(std::size(EDGE_OFFSETS) - 1));
+    std::uniform_real_distribution<float> distanceDist(2.f, 90.f);
+
+    TestOccluder occluder;
+
+    for (uint32_t tileY = 1; tileY < TEST_HEIGHT / OcclusionRasterizer::TILE_HEIGHT; ++tileY) {
+        for (uint32_t tileX = 1; tileX < TEST_WIDTH / OcclusionRasterizer::TILE_WIDTH; ++tileX) {
+            const float edgeX = float(tileX * OcclusionRasterizer::TILE_WIDTH);
+            const float edgeY = float(tileY * OcclusionRasterizer::TILE_HEIGHT);
+
+            for (uint32_t i = 0; i < 16; ++i) {
+                glm::vec3 vertices[3];
+
+                // One vertex on each side of the corner, the third one anywhere near it
+                vertices[0] = glm::vec3(edgeX - EDGE_OFFSETS[offsetDist(rng)] - 4.f, edgeY + EDGE_OFFSETS[offsetDist(rng)], -distanceDist(rng));
+                vertices[1] = glm::vec3(edgeX + EDGE_OFFSETS[offsetDist(rng)] + 4.f, edgeY - EDGE_OFFSETS[offsetDist(rng)] - 3.f, -distanceDist(rng));
+                vertices[2] = glm::vec3(edgeX + EDGE_OFFSETS[offsetDist(rng)], edgeY + EDGE_OFFSETS[offsetDist(rng)] + 3.f, -distanceDist(rng));
+
+                // Both windings
+                if (i % 2) {
+                    std::swap(vertices[1], vertices[2]);
+                }
+
+                occluder.AddTriangle(vertices[0], vertices[1], vertices[2]);
+            }
+        }
+    }
+
+    ExpectDepthEqualToScalar(occluder);
+}
+
+
+TEST_P(OcclusionRasterizerTest, MatchesScalarOnNarrowSpans)
+{
+    // Slivers one to a few pixels wide at every lane offset, lanes outside the triangle bounds must keep the old depth
+    TestOccluder occluder;
+
+    for (uint32_t x = 0; x < 2 * OcclusionRasterizer::TILE_WIDTH; ++x) {
+        const float minX = float(x) + 0.25f;
+        const float maxX = minX + 1.f + float(x % 4);
+        const float baseY = float(x % 3) * OcclusionRasterizer::TILE_HEIGHT - 2.f;
+
+        occluder.AddTriangle(glm::vec3(minX, baseY, -20.f), glm::vec3(maxX, baseY + 1.f, -40.f), glm::vec3(minX + 0.5f, baseY + 30.f, -5.f));
+    }
+
+    ExpectDepthEqualToScalar(occluder);
+}
+
+
+TEST_P(OcclusionRasterizerTest, MatchesScalarOnRandomOccluders)
+{
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> xDist(-20.f, TEST_WIDTH + 20.f);
+    std::uniform_real_distribution<float> yDist(-20.f, TEST_HEIGHT + 20.f);
+    std::uniform_real_distribution<float> distanceDist(2.f, 90.f);
+
+    TestOccluder occluder;
+
+    for (uint32_t i = 0; i < 500; ++i) {
+        occluder.AddTriangle(
+            glm::vec3(xDist(rng), yDist(rng), -distanceDist(rng)),
+            glm::vec3(xDist(rng), yDist(rng), -distanceDist(rng)),
+            glm::vec3(xDist(rng), yDist(rng), -distanceDist(rng)));
+    }
+
+    ExpectDepthEqualToScalar(occluder);
+}
+
+
+INSTANTIATE_TEST_SUITE_P(SIMDLevels, OcclusionRasterizerTest,
+    ::testing::Values(CPUSIMDLevel::SCALAR, CPUSIMDLevel::SSE2, CPUSIMDLevel::AVX),
+    [](const ::testing::TestParamInfo<CPUSIMDLevel>& info) -> std::string {
+        switch (info.param) {
+            case CPUSIMDLevel::SCALAR: return "Scalar";
+            case CPUSIMDLevel::SSE2: return "SSE2";
+            default: return "AVX";
+        }
+    });
+
+
+TEST(OcclusionRasterizer, SetMaxSIMDLevelIsClampedToCPU)
+{
+    OcclusionRasterizer rasterizer;
+    EXPECT_EQ(rasterizer.GetSIMDLevel(), GetCPUSIMDLevel());
+
+    rasterizer.SetMaxSIMDLevel(CPUSIMDLevel::SCALAR);
+    EXPECT_EQ(rasterizer.GetSIMDLevel(), CPUSIMDLevel::SCALAR);
+
+    rasterizer.SetMaxSIMDLevel(CPUSIMDLevel::AVX2);
+    EXPECT_EQ(rasterizer.GetSIMDLevel(), GetCPUSIMDLevel());
+}
+
+
+TEST(OcclusionRasterizer, OccludesBoundsBehindWall)
+{
+    const glm::mat4x4 viewProjMatrix =
+#if defined(ENG_USE_INVERTED_Z)
+        glm::perspective(glm::radians(90.f), 16.f / 9.f, TEST_Z_FAR, TEST_Z_NEAR);
+#else
+        glm::perspective(glm::radians(90.f), 16.f / 9.f, TEST_Z_NEAR, TEST_Z_FAR);
+#endif
+
+    // 20x20 wall 10 units in front of the camera
+    TestOccluder wall;
+    wall.AddQuad(-10.f, -10.f, 10.f, 10.f, 10.f);
+
+    OcclusionRasterizer rasterizer;
+
+    // Nothing is occluded before the first rasterization
+    EXPECT_TRUE(rasterizer.IsVisible(glm::vec3(-1.f, -1.f, -21.f), glm::vec3(1.f, 1.f, -19.f)));
+
+    rasterizer.BeginFrame(viewProjMatrix);
+    rasterizer.AddOccluder(wall.positions.data(), static_cast<uint32_t>(wall.positions.size()),
+        wall.indices.data(), static_cast<uint32_t>(wall.indices.size()), M3D_MAT4_IDENTITY);
+    rasterizer.Rasterize();
+
+    EXPECT_EQ(rasterizer.GetStats().setupTrianglesCount, 2u);
+
+    EXPECT_FALSE(rasterizer.IsVisible(glm::vec3(-1.f, -1.f, -21.f), glm::vec3(1.f, 1.f, -19.f)));
+    EXPECT_TRUE(rasterizer.IsVisible(glm::vec3(-1.f, -1.f, -6.f), glm::vec3(1.f, 1.f, -4.f)));
+
+    // Behind the wall, but sticking out of its silhouette
+    EXPECT_TRUE(rasterizer.IsVisible(glm::vec3(15.f, -1.f, -21.f), glm::vec3(25.f, 1.f, -19.f)));
+}
@@ -0,0 +1,145 @@
+#include "pch.h"
+
+#include "core/event_system/event_dispatcher.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <atomic>
+
+
+struct TestProducerEvent
+{
+    TestProducerEvent(uint32_t producerIdx, uint32_t sequenceIdx)
+        : producerIdx(producerIdx), sequenceIdx(sequenceIdx) {}
+
+    uint32_t producerIdx;
+    uint32_t sequenceIdx;
+};
+
+
+// Coalesced events sum their values, so the merged event shows how many events were folded into it
+struct TestCountedEvent
+{
+    explicit TestCountedEvent(uint32_t value) : value(value) {}
+
+    uint32_t value;
+};
+
+
+namespace es
+{
+    template <>
+    struct EventCoalescingTraits<TestCountedEvent>
+    {
+        static inline constexpr bool IS_COALESCIBLE = true;
+
+        static void Merge(TestCountedEvent& newEvent, const TestCountedEvent& oldEvent) noexcept
+        {
+            newEvent.value += oldEvent.value;
+        }
+    };
+}
+
+
+class EventDispatcherTest : public ::testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        es::EventDispatcher::GetInstance().Reset();
+    }
+};
+
+
+TEST_F(EventDispatcherTest, DeliversEveryEventOfEveryProducer)
+{
+    constexpr uint32_t PRODUCERS_COUNT = 8;
+    constexpr uint32_t EVENTS_PER_PRODUCER_COUNT = 50'000;
+
+    es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
+
+    // Listener runs on the main thread only, so plain counters are enough
+    struct DeliveryState
+    {
+        std::array<uint32_t, PRODUCERS_COUNT> nextSequenceIndices = {};
+        uint64_t receivedEventsCount = 0;
+        uint64_t outOfOrderEventsCount = 0;
+    } state;
+
+    es::ListenerID listenerID = dispatcher.Subscribe<TestProducerEvent>([pState = &state](const void* pEvent) {
+        const TestProducerEvent& event = es::EventCast<TestProducerEvent>(pEvent);
+
+        // Each producer has its own FIFO queue, so its events arrive in the order they were posted
+        if (event.sequenceIdx != pState->nextSequenceIndices[event.producerIdx]) {
+            ++pState->outOfOrderEventsCount;
+        }
+
+        pState->nextSequenceIndices[event.producerIdx] = event.sequenceIdx + 1;
+        ++pState->receivedEventsCount;
+    });
+
+    std::atomic<uint32_t> finishedProducersCount = 0;
+    std::vector<std::thread> producers;
+
+    for (uint32_t producerIdx = 0; producerIdx < PRODUCERS_COUNT; ++producerIdx) {
+        producers.emplace_back([&dispatcher, &finishedProducersCount, producerIdx]() {
+            for (uint32_t i = 0; i < EVENTS_PER_PRODUCER_COUNT; ++i) {
+                dispatcher.PostThreadSafe<TestProducerEvent>(producerIdx, i);
+            }
+
+            finishedProducersCount.fetch_add(1, std::memory_order_release);
+        });
+    }
+
+    // Dispatching concurrently with producers exercises partially filled blocks and block hand-over
+    while (finishedProducersCount.load(std::memory_order_acquire) < PRODUCERS_COUNT) {
+        dispatcher.DispatchQueuedEvents();
+    }
+
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    dispatcher.DispatchQueuedEvents();
+
+    EXPECT_EQ(state.receivedEventsCount, uint64_t(PRODUCERS_COUNT) * EVENTS_PER_PRODUCER_COUNT);
+    EXPECT_EQ(state.outOfOrderEventsCount, 0u);
+
+    for (uint32_t nextSequenceIdx : state.nextSequenceIndices) {
+        EXPECT_EQ(nextSequenceIdx, EVENTS_PER_PRODUCER_COUNT);
+    }
+
+    // Nothing is left in the queues
+    dispatcher.DispatchQueuedEvents();
+    EXPECT_EQ(state.receivedEventsCount, uint64_t(PRODUCERS_COUNT) * EVENTS_PER_PRODUCER_COUNT);
+
+    dispatcher.Unsubscribe(listenerID);
+}
+
+
+TEST_F(EventDispatcherTest, CoalescesQueuedEvents)
+{
+    constexpr uint32_t EVENTS_COUNT = 1000;
+
+    es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
+
+    uint32_t dispatchedEventsCount = 0;
+    uint32_t dispatchedValue = 0;
+
+    es::ListenerID listenerID = dispatcher.Subscribe<TestCountedEvent>([&dispatchedEventsCount, &dispatchedValue](const void* pEvent) {
+        ++dispatchedEventsCount;
+        dispatchedValue += es::EventCast<TestCountedEvent>(pEvent).value;
+    });
+
+    for (uint32_t i = 0; i < EVENTS_COUNT; ++i) {
+        dispatcher.Post<TestCountedEvent>(1u);
+    }
+
+    dispatcher.DispatchQueuedEvents();
+
+    EXPECT_EQ(dispatchedEventsCount, 1u);
+    EXPECT_EQ(dispatchedValue, EVENTS_COUNT);
+
+    dispatcher.Unsubscribe(listenerID);
+}
@@ -0,0 +1,429 @@
+#include "pch.h"
+
+#include "core/spatial/dynamic_bvh.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+
+// Volumes closer to a frustum plane than this are skipped: the tree and the reference compute
+// the same plane distances, but a node may be tested with slightly different rounding
+static constexpr float TEST_PLANE_MARGIN = 1e-3f;
+
+
+// Slab test with the same conventions as DynamicBVH::RayCast: the entry distance is clamped to 0 for origins inside
+static bool RayCastAABBRef(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+    const glm::vec3& min, const glm::vec3& max, float& outDistance) noexcept
+{
+    float entry = 0.f;
+    float exit = maxDistance;
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        const float invDir = 1.f / direction[i];
+        const float t0 = (min[i] - origin[i]) * invDir;
+        const float t1 = (max[i] - origin[i]) * invDir;
+
+        entry = std::max(entry, std::min(t0, t1));
+        exit = std::min(exit, std::max(t0, t1));
+    }
+
+    outDistance = entry;
+    return entry <= exit;
+}
+
+
+// Keeps a copy of every proxy, so query results can be checked against a brute force pass over all of them
+class DynamicBVHTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // Camera at the origin looking down -Z
+        m_frustum.ExtractPlanes(glm::perspectiveRH_ZO(glm::radians(70.f), 16.f / 9.f, 0.1f, 200.f));
+    }
+
+
+    glm::vec3 RandomCenter() noexcept
+    {
+        std::uniform_real_distribution<float> positionDist(-200.f, 200.f);
+        return glm::vec3(positionDist(m_rng), positionDist(m_rng), positionDist(m_rng) - 100.f);
+    }
+
+
+    glm::vec3 RandomExtents() noexcept
+    {
+        std::uniform_real_distribution<float> sizeDist(0.1f, 4.f);
+        return glm::vec3(sizeDist(m_rng), sizeDist(m_rng), sizeDist(m_rng));
+    }
+
+
+    // User data of a proxy is its index in m_proxies
+    void AddProxies(uint32_t count) noexcept
+    {
+        for (uint32_t i = 0; i < count; ++i) {
+            const glm::vec3 center = RandomCenter();
+            const glm::vec3 extents = RandomExtents();
+
+            const uint32_t userData = static_cast<uint32_t>(m_proxies.size());
+            m_proxies.emplace_back(TestProxy { m_bvh.CreateProxy(center - extents, center + extents, userData), center - extents, center + extents });
+        }
+    }
+
+
+    void MoveProxy(uint32_t userData, const glm::vec3& min, const glm::vec3& max) noexcept
+    {
+        TestProxy& proxy = m_proxies[userData];
+
+        proxy.min = min;
+        proxy.max = max;
+        m_bvh.UpdateProxy(proxy.ID, min, max);
+    }
+
+
+    void DestroyProxy(uint32_t userData) noexcept
+    {
+        m_bvh.DestroyProxy(m_proxies[userData].ID);
+        m_proxies[userData].ID = BVHProxyID();
+    }
+
+
+    bool IsAlive(uint32_t userData) const noexcept { return m_proxies[userData].ID.IsValid(); }
+
+
+    std::vector<uint32_t> QueryAABBRef(const glm::vec3& min, const glm::vec3& max) const noexcept
+    {
+        std::vector<uint32_t> result;
+
+        for (uint32_t i = 0; i < m_proxies.size(); ++i) {
+            const TestProxy& proxy = m_proxies[i];
+
+            if (IsAlive(i) && glm::all(glm::lessThanEqual(proxy.min, max)) && glm::all(glm::greaterThanEqual(proxy.max, min))) {
+                result.emplace_back(i);
+            }
+        }
+
+        return result;
+    }
+
+
+    // Proxies near a plane are reported in outAmbiguous instead
+    std::vector<uint32_t> QueryFrustumRef(std::vector<uint32_t>& outAmbiguous) const noexcept
+    {
+        std::vector<uint32_t> result;
+        outAmbiguous.clear();
+
+        for (uint32_t i = 0; i < m_proxies.size(); ++i) {
+            if (!IsAlive(i)) {
+                continue;
+            }
+
+            const TestProxy& proxy = m_proxies[i];
+
+            bool isVisible = true;
+            float minMargin = std::numeric_limits<float>::max();
+
+            for (const glm::vec4& plane : m_frustum.planes) {
+                const glm::vec3 corner(plane.x >= 0.f ? proxy.max.x : proxy.min.x, plane.y >= 0.f ? proxy.max.y : proxy.min.y,
+                    plane.z >= 0.f ? proxy.max.z : proxy.min.z);
+                const float margin = glm::dot(glm::vec3(plane), corner) + plane.w;
+
+                isVisible &= margin >= 0.f;
+                minMargin = std::min(minMargin, std::abs(margin));
+            }
+
+            if (minMargin < TEST_PLANE_MARGIN) {
+                outAmbiguous.emplace_back(i);
+            } else if (isVisible) {
+                result.emplace_back(i);
+            }
+        }
+
+        return result;
+    }
+
+
+    void ExpectQueriesMatchBruteForce(uint32_t queriesCount) noexcept
+    {
+        std::vector<uint32_t> result;
+
+        for (uint32_t i = 0; i < queriesCount; ++i) {
+            const glm::vec3 center = RandomCenter();
+            const glm::vec3 extents = RandomExtents() * 8.f;
+
+            m_bvh.QueryAABB(center - extents, center + extents, result);
+            std::sort(result.begin(), result.end());
+
+            ASSERT_EQ(result, QueryAABBRef(center - extents, center + extents)) << "AABB query " << i;
+        }
+
+        std::vector<uint32_t> ambiguous;
+        const std::vector<uint32_t> expected = QueryFrustumRef(ambiguous);
+
+        m_bvh.QueryFrustum(m_frustum, result);
+        std::sort(result.begin(), result.end());
+
+        std::vector<uint32_t> unambiguous;
+        std::set_difference(result.begin(), result.end(), ambiguous.begin(), ambiguous.end(), std::back_inserter(unambiguous));
+
+        ASSERT_FALSE(expected.empty());
+        EXPECT_EQ(unambiguous, expected);
+    }
+
+protected:
+    struct TestProxy
+    {
+        BVHProxyID ID;
+        glm::vec3  min;
+        glm::vec3  max;
+    };
+
+    DynamicBVH m_bvh;
+    Frustum m_frustum;
+
+    std::vector<TestProxy> m_proxies;
+    std::mt19937 m_rng { 42 };
+};
+
+
+TEST_F(DynamicBVHTest, EmptyTreeFindsNothing)
+{
+    std::vector<uint32_t> result = { 1, 2, 3 };
+
+    m_bvh.QueryFrustum(m_frustum, result);
+    EXPECT_TRUE(result.empty());
+
+    m_bvh.QueryAABB(glm::vec3(-1.f), glm::vec3(1.f), result);
+    EXPECT_TRUE(result.empty());
+
+    BVHRayHit hit = {};
+    EXPECT_FALSE(m_bvh.RayCast(M3D_ZEROF3, glm::vec3(0.f, 0.f, -1.f), 100.f, hit));
+
+    m_bvh.Refit();
+    m_bvh.Build();
+
+    EXPECT_EQ(m_bvh.GetProxiesCount(), 0u);
+    EXPECT_EQ(m_bvh.ComputeSAHCost(), 0.f);
+}
+
+
+TEST_F(DynamicBVHTest, InsertedProxiesMatchBruteForce)
+{
+    AddProxies(3000);
+
+    EXPECT_EQ(m_bvh.GetProxiesCount(), 3000u);
+    ExpectQueriesMatchBruteForce(200);
+
+    // The build keeps proxy IDs and user data
+    m_bvh.Build();
+
+    EXPECT_EQ(m_bvh.GetProxiesCount(), 3000u);
+    ExpectQueriesMatchBruteForce(200);
+
+    for (uint32_t i = 0; i < m_proxies.size(); ++i) {
+        ASSERT_TRUE(m_bvh.IsProxyValid(m_proxies[i].ID));
+        ASSERT_EQ(m_bvh.GetProxyUserData(m_proxies[i].ID), i);
+        ASSERT_EQ(m_bvh.GetProxyMin(m_proxies[i].ID), m_proxies[i].min);
+        ASSERT_EQ(m_bvh.GetProxyMax(m_proxies[i].ID), m_proxies[i].max);
+    }
+}
+
+
+TEST_F(DynamicBVHTest, RemovedProxiesAreNotFound)
+{
+    AddProxies(3000);
+    m_bvh.Build();
+
+    std::uniform_int_distribution<uint32_t> proxyDist(0, 2999);
+
+    for (uint32_t i = 0; i < 1500; ++i) {
+        const uint32_t userData = proxyDist(m_rng);
+
+        if (IsAlive(userData)) {
+            const BVHProxyID ID = m_proxies[userData].ID;
+
+            DestroyProxy(userData);
+            EXPECT_FALSE(m_bvh.IsProxyValid(ID));
+        }
+    }
+
+    ExpectQueriesMatchBruteForce(200);
+
+    // Freed slots are reused by new proxies without confusing them with the destroyed ones
+    AddProxies(1000);
+    ExpectQueriesMatchBruteForce(200);
+
+    const uint32_t aliveCount = static_cast<uint32_t>(std::count_if(m_proxies.begin(), m_proxies.end(), [](const TestProxy& proxy) {
+        return proxy.ID.IsValid();
+    }));
+
+    EXPECT_EQ(m_bvh.GetProxiesCount(), aliveCount);
+}
+
+
+TEST_F(DynamicBVHTest, UpdatedProxiesAreFoundBeforeAndAfterRefit)
+{
+    AddProxies(3000);
+    m_bvh.Build();
+
+    std::uniform_int_distribution<uint32_t> proxyDist(0, 2999);
+    std::uniform_real_distribution<float> offsetDist(-3.f, 3.f);
+
+    for (uint32_t frame = 0; frame < 10; ++frame) {
+        // Small moves of many proxies, like objects animated between frames
+        for (uint32_t i = 0; i < 300; ++i) {
+            const uint32_t userData = proxyDist(m_rng);
+            const glm::vec3 offset(offsetDist(m_rng), offsetDist(m_rng), offsetDist(m_rng));
+
+            MoveProxy(userData, m_proxies[userData].min + offset, m_proxies[userData].max + offset);
+        }
+
+        // Ancestors are only grown until the refit, which mustn't make queries miss proxies
+        ExpectQueriesMatchBruteForce(50);
+
+        m_bvh.Refit();
+        ExpectQueriesMatchBruteForce(50);
+    }
+}
+
+
+TEST_F(DynamicBVHTest, RefitAndRotationsKeepBoundsConservative)
+{
+    AddProxies(2000);
+    m_bvh.Build();
+
+    std::uniform_int_distribution<uint32_t> proxyDist(0, 1999);
+
+    uint32_t rotationsCount = 0;
+
+    for (uint32_t frame = 0; frame < 20; ++frame) {
+        // Teleports break the spatial coherence of the built tree, so refits have to rotate subtrees
+        for (uint32_t i = 0; i < 200; ++i) {
+            const uint32_t userData = proxyDist(m_rng);
+            const glm::vec3 center = RandomCenter();
+            const glm::vec3 extents = RandomExtents();
+
+            MoveProxy(userData, center - extents, center + extents);
+        }
+
+        m_bvh.Refit();
+
+        const DynamicBVHStats& stats = m_bvh.GetStats();
+        EXPECT_GT(stats.refitNodesCount, 0u);
+        rotationsCount += stats.rotationsCount;
+
+        // Every proxy is inside the bounds of all its ancestors, so a query of its own bounds reaches it
+        std::vector<uint32_t> result;
+
+        for (uint32_t i = 0; i < m_proxies.size(); ++i) {
+            m_bvh.QueryAABB(m_proxies[i].min, m_proxies[i].max, result);
+            ASSERT_NE(std::find(result.begin(), result.end(), i), result.end()) << "Proxy " << i << " frame " << frame;
+        }
+
+        ExpectQueriesMatchBruteForce(20);
+    }
+
+    EXPECT_GT(rotationsCount, 0u);
+
+    // A refit without changes touches nothing
+    m_bvh.Refit();
+    EXPECT_EQ(m_bvh.GetStats().refitNodesCount, 0u);
+}
+
+
+TEST_F(DynamicBVHTest, RayCastFindsNearestHit)
+{
+    AddProxies(3000);
+    m_bvh.Build();
+
+    std::uniform_real_distribution<float> dirDist(-1.f, 1.f);
+    std::uniform_real_distribution<float> distanceDist(10.f, 500.f);
+
+    uint32_t hitsCount = 0;
+
+    for (uint32_t i = 0; i < 500; ++i) {
+        const glm::vec3 origin = RandomCenter();
+        const glm::vec3 direction = glm::normalize(glm::vec3(dirDist(m_rng), dirDist(m_rng), dirDist(m_rng)));
+        const float maxDistance = distanceDist(m_rng);
+
+        float refDistance = maxDistance;
+        bool isRefHit = false;
+
+        for (const TestProxy& proxy : m_proxies) {
+            float distance = 0.f;
+
+            if (RayCastAABBRef(origin, direction, maxDistance, proxy.min, proxy.max, distance) && distance <= refDistance) {
+                refDistance = distance;
+                isRefHit = true;
+            }
+        }
+
+        BVHRayHit hit = {};
+        const bool isHit = m_bvh.RayCast(origin, direction, maxDistance, hit);
+
+        ASSERT_EQ(isHit, isRefHit) << "Ray " << i;
+
+        if (!isHit) {
+            continue;
+        }
+
+        ++hitsCount;
+
+        // Several proxies may be entered at the same distance, the hit one must be entered there too
+        const TestProxy& hitProxy = m_proxies[hit.userData];
+        float hitProxyDistance = 0.f;
+
+        ASSERT_EQ(hit.proxyID, hitProxy.ID);
+        ASSERT_TRUE(RayCastAABBRef(origin, direction, maxDistance, hitProxy.min, hitProxy.max, hitProxyDistance));
+        EXPECT_NEAR(hit.distance, refDistance, 1e-3f) << "Ray " << i;
+        EXPECT_NEAR(hitProxyDistance, refDistance, 1e-3f) << "Ray " << i;
+    }
+
+    EXPECT_GT(hitsCount, 50u);
+}
+
+
+TEST_F(DynamicBVHTest, RayCastHandlesAxisAlignedRays)
+{
+    const BVHProxyID nearID = m_bvh.CreateProxy(glm::vec3(-1.f, -1.f, -11.f), glm::vec3(1.f, 1.f, -9.f), 0);
+    m_bvh.CreateProxy(glm::vec3(-1.f, -1.f, -21.f), glm::vec3(1.f, 1.f, -19.f), 1);
+
+    BVHRayHit hit = {};
+
+    // Zero direction components must not turn slab distances into NaNs
+    ASSERT_TRUE(m_bvh.RayCast(M3D_ZEROF3, glm::vec3(0.f, 0.f, -2.f), 100.f, hit));
+    EXPECT_EQ(hit.proxyID, nearID);
+    EXPECT_FLOAT_EQ(hit.distance, 4.5f);
+
+    EXPECT_FALSE(m_bvh.RayCast(M3D_ZEROF3, glm::vec3(0.f, 0.f, -1.f), 8.f, hit));
+    EXPECT_FALSE(m_bvh.RayCast(glm::vec3(5.f, 0.f, 0.f), glm::vec3(0.f, 0.f, -1.f), 100.f, hit));
+
+    // The origin inside a proxy hits it at zero distance
+    ASSERT_TRUE(m_bvh.RayCast(glm::vec3(0.f, 0.f, -20.f), glm::vec3(0.f, 0.f, 1.f), 100.f, hit));
+    EXPECT_EQ(hit.userData, 1u);
+    EXPECT_EQ(hit.distance, 0.f);
+}
+
+
+TEST_F(DynamicBVHTest, BuildLowersSAHCostOfInsertedTree)
+{
+    AddProxies(10'000);
+
+    const float insertedCost = m_bvh.ComputeSAHCost();
+
+    m_bvh.Build();
+
+    const float builtCost = m_bvh.ComputeSAHCost();
+    const DynamicBVHStats& stats = m_bvh.GetStats();
+
+    EXPECT_GT(builtCost, 1.f);
+    EXPECT_LT(builtCost, insertedCost);
+
+    EXPECT_EQ(stats.proxiesCount, 10'000u);
+    EXPECT_EQ(stats.nodesCount, m_bvh.GetNodesCount());
+
+    // 4 wide nodes need at least a quarter of the proxies count of nodes
+    EXPECT_GE(stats.nodesCount, 10'000u / 4);
+    EXPECT_LT(stats.nodesCount, 10'000u);
+}
@@ -0,0 +1,20 @@
+#include "pch.h"
+
+#include "utils/debug/eng_log_sys.h"
+
+#include <gtest/gtest.h>
+
+
+// Engine asserts and warnings go through the log system, so it's initialized for all tests.
+// Tests which need other engine systems initialize them in their fixtures
+int main(int argc, char** argv)
+{
+    engInitLogSystem();
+
+    ::testing::InitGoogleTest(&argc, argv);
+    const int result = RUN_ALL_TESTS();
+
+    engTerminateLogSystem();
+
+    return result;
+}
@@ -0,0 +1,272 @@
+#include "pch.h"
+
+#include "render/mem_manager/tlsf_allocator.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+
+
+static std::pair<uint32_t, uint32_t> MapSizeToLists(uint64_t size) noexcept
+{
+    uint32_t firstLevel = 0;
+    uint32_t secondLevel = 0;
+    TLSFAllocator::MapSizeToLists(size, firstLevel, secondLevel);
+
+    return { firstLevel, secondLevel };
+}
+
+
+TEST(TLSFAllocator, MapsSmallSizesLinearly)
+{
+    for (uint32_t size = 0; size < TLSFAllocator::SECOND_LEVEL_COUNT; ++size) {
+        EXPECT_EQ(MapSizeToLists(size), std::make_pair(0u, size)) << "size: " << size;
+    }
+}
+
+
+TEST(TLSFAllocator, MapsPowerOfTwoBoundaries)
+{
+    for (uint32_t bit = TLSFAllocator::SECOND_LEVEL_BITS; bit < 64; ++bit) {
+        const uint64_t powerOfTwo = 1ull << bit;
+        const uint32_t firstLevel = bit - TLSFAllocator::SECOND_LEVEL_BITS + 1;
+
+        EXPECT_EQ(MapSizeToLists(powerOfTwo), std::make_pair(firstLevel, 0u)) << "size: " << powerOfTwo;
+        EXPECT_EQ(MapSizeToLists(powerOfTwo - 1), std::make_pair(firstLevel - 1, TLSFAllocator::SECOND_LEVEL_COUNT - 1)) << "size: " << powerOfTwo - 1;
+    }
+
+    EXPECT_EQ(MapSizeToLists(UINT64_MAX), std::make_pair(TLSFAllocator::FIRST_LEVEL_COUNT - 1, TLSFAllocator::SECOND_LEVEL_COUNT - 1));
+}
+
+
+TEST(TLSFAllocator, MapsSecondLevelRangesLinearly)
+{
+    // [16, 32) is split into 8 lists of 2 sizes each
+    for (uint32_t size = 16; size < 32; ++size) {
+        EXPECT_EQ(MapSizeToLists(size), std::make_pair(2u, (size - 16) / 2)) << "size: " << size;
+    }
+
+    uint32_t prevListIdx = 0;
+
+    for (uint64_t size = 1; size < 64 * 1024; ++size) {
+        const auto [firstLevel, secondLevel] = MapSizeToLists(size);
+        const uint32_t listIdx = firstLevel * TLSFAllocator::SECOND_LEVEL_COUNT + secondLevel;
+
+        ASSERT_GE(listIdx, prevListIdx) << "size: " << size;
+        ASSERT_LE(listIdx, prevListIdx + 1) << "size: " << size;
+
+        prevListIdx = listIdx;
+    }
+}
+
+
+TEST(TLSFAllocator, RoundsRequestUpToNextList)
+{
+    TLSFAllocator allocator;
+    ASSERT_TRUE(allocator.Create(64));
+
+    const TLSFAllocation first = allocator.Allocate(17);
+    const TLSFAllocation separator = allocator.Allocate(1);
+    ASSERT_TRUE(first.IsValid() && separator.IsValid());
+
+    // [0, 17) is free now, but its list [16, 18) may hold regions of 16, so 17 is served by the list above it
+    allocator.Deallocate(first);
+
+    const TLSFAllocation rounded = allocator.Allocate(17);
+    ASSERT_TRUE(rounded.IsValid());
+    EXPECT_EQ(rounded.offset, 18u);
+
+    // The only regions left are exactly 29 and 17 units large, they are found by walking their own lists
+    const TLSFAllocation tail = allocator.Allocate(29);
+    ASSERT_TRUE(tail.IsValid());
+    EXPECT_EQ(tail.offset, 35u);
+
+    const TLSFAllocation exact = allocator.Allocate(17);
+    ASSERT_TRUE(exact.IsValid());
+    EXPECT_EQ(exact.offset, 0u);
+
+    EXPECT_EQ(allocator.GetUsedSize(), allocator.GetSize());
+}
+
+
+TEST(TLSFAllocator, SplitsAndMergesNeighbours)
+{
+    TLSFAllocator allocator;
+    ASSERT_TRUE(allocator.Create(100));
+
+    const TLSFAllocation a = allocator.Allocate(10);
+    const TLSFAllocation b = allocator.Allocate(20);
+    const TLSFAllocation c = allocator.Allocate(30);
+
+    EXPECT_EQ(a.offset, 0u);
+    EXPECT_EQ(b.offset, 10u);
+    EXPECT_EQ(c.offset, 30u);
+    EXPECT_EQ(allocator.GetAllocationSize(b), 20u);
+
+    TLSFAllocatorStats stats = allocator.GetStats();
+    EXPECT_EQ(stats.freeRegionsCount, 1u);
+    EXPECT_EQ(stats.largestFreeRegionSize, 40u);
+    EXPECT_EQ(stats.usedSize, 60u);
+
+    allocator.Deallocate(b);
+    stats = allocator.GetStats();
+    EXPECT_EQ(stats.freeRegionsCount, 2u);
+
+    // Merges with the next free region
+    allocator.Deallocate(a);
+    stats = allocator.GetStats();
+    EXPECT_EQ(stats.freeRegionsCount, 2u);
+    EXPECT_EQ(stats.largestFreeRegionSize, 40u);
+
+    // Merges with both neighbours
+    allocator.Deallocate(c);
+    stats = allocator.GetStats();
+    EXPECT_EQ(stats.freeRegionsCount, 1u);
+    EXPECT_EQ(stats.largestFreeRegionSize, 100u);
+    EXPECT_TRUE(allocator.IsEmpty());
+
+    const TLSFAllocation whole = allocator.Allocate(100);
+    ASSERT_TRUE(whole.IsValid());
+    EXPECT_EQ(whole.offset, 0u);
+}
+
+
+TEST(TLSFAllocator, ReturnsInvalidAllocationWhenExhausted)
+{
+    TLSFAllocator allocator;
+    ASSERT_TRUE(allocator.Create(16));
+
+    EXPECT_FALSE(allocator.Allocate(17).IsValid());
+
+    const TLSFAllocation whole = allocator.Allocate(16);
+    ASSERT_TRUE(whole.IsValid());
+
+    const TLSFAllocation failed = allocator.Allocate(1);
+    EXPECT_FALSE(failed.IsValid());
+
+    // Releasing invalid allocation is a no-op
+    allocator.Deallocate(failed);
+    EXPECT_EQ(allocator.GetAllocationsCount(), 1u);
+    EXPECT_EQ(allocator.GetUsedSize(), 16u);
+
+    allocator.Reset();
+    EXPECT_TRUE(allocator.IsEmpty());
+    EXPECT_TRUE(allocator.Allocate(16).IsValid());
+}
+
+
+// Reference keeps allocations ordered by offset, free regions are the gaps between them
+struct TLSFReference
+{
+    struct Gaps
+    {
+        uint64_t largestSize = 0;
+        uint32_t count = 0;
+    };
+
+    Gaps ComputeGaps(uint64_t size) const noexcept
+    {
+        Gaps gaps = {};
+        uint64_t offset = 0;
+
+        auto addGap = [&gaps](uint64_t gapSize) {
+            if (gapSize > 0) {
+                gaps.largestSize = std::max(gaps.largestSize, gapSize);
+                ++gaps.count;
+            }
+        };
+
+        for (const auto& [allocationOffset, allocationSize] : allocations) {
+            addGap(allocationOffset - offset);
+            offset = allocationOffset + allocationSize;
+        }
+
+        addGap(size - offset);
+
+        return gaps;
+    }
+
+    std::map<uint64_t, uint64_t> allocations;
+    uint64_t usedSize = 0;
+};
+
+
+TEST(TLSFAllocator, MatchesReferenceOnRandomAllocations)
+{
+    constexpr uint64_t ALLOCATOR_SIZE = 1 << 20;
+    constexpr uint32_t OPERATIONS_COUNT = 20000;
+
+    TLSFAllocator allocator;
+    ASSERT_TRUE(allocator.Create(ALLOCATOR_SIZE));
+
+    TLSFReference reference;
+    std::vector<TLSFAllocation> liveAllocations;
+
+    std::mt19937 rng(7);
+    // Mostly small allocations with occasional large ones, so the allocator regularly runs out of space
+    std::uniform_int_distribution<uint64_t> smallSizeDist(1, 512);
+    std::uniform_int_distribution<uint64_t> largeSizeDist(4096, 64 * 1024);
+
+    for (uint32_t op = 0; op < OPERATIONS_COUNT; ++op) {
+        const bool shouldAllocate = liveAllocations.empty() || rng() % 100 < 55;
+
+        if (shouldAllocate) {
+            const uint64_t size = rng() % 16 == 0 ? largeSizeDist(rng) : smallSizeDist(rng);
+            const TLSFAllocation allocation = allocator.Allocate(size);
+
+            if (!allocation.IsValid()) {
+                ASSERT_LT(reference.ComputeGaps(ALLOCATOR_SIZE).largestSize, size) << "Allocation failed while a large enough region was free";
+                continue;
+            }
+
+            ASSERT_LE(allocation.offset + size, ALLOCATOR_SIZE);
+            ASSERT_EQ(allocator.GetAllocationSize(allocation), size);
+
+            const auto nextIt = reference.allocations.lower_bound(allocation.offset);
+            ASSERT_TRUE(nextIt == reference.allocations.end() || allocation.offset + size <= nextIt->first) << "Allocation overlaps the next one";
+
+            if (nextIt != reference.allocations.begin()) {
+                const auto prevIt = std::prev(nextIt);
+                ASSERT_LE(prevIt->first + prevIt->second, allocation.offset) << "Allocation overlaps the previous one";
+            }
+
+            reference.allocations.emplace(allocation.offset, size);
+            reference.usedSize += size;
+
+            liveAllocations.emplace_back(allocation);
+        } else {
+            const size_t idx = rng() % liveAllocations.size();
+            const TLSFAllocation allocation = liveAllocations[idx];
+
+            liveAllocations[idx] = liveAllocations.back();
+            liveAllocations.pop_back();
+
+            reference.usedSize -= reference.allocations[allocation.offset];
+            reference.allocations.erase(allocation.offset);
+
+            allocator.Deallocate(allocation);
+        }
+
+        ASSERT_EQ(allocator.GetUsedSize(), reference.usedSize);
+        ASSERT_EQ(allocator.GetAllocationsCount(), reference.allocations.size());
+
+        if (op % 64 == 0) {
+            // Neighbour free regions are always merged, so free regions are exactly the gaps between allocations
+            const TLSFAllocatorStats stats = allocator.GetStats();
+            const TLSFReference::Gaps gaps = reference.ComputeGaps(ALLOCATOR_SIZE);
+
+            ASSERT_EQ(stats.freeRegionsCount, gaps.count);
+            ASSERT_EQ(stats.largestFreeRegionSize, gaps.largestSize);
+        }
+    }
+
+    for (const TLSFAllocation& allocation : liveAllocations) {
+        allocator.Deallocate(allocation);
+    }
+
+    const TLSFAllocatorStats stats = allocator.GetStats();
+    EXPECT_TRUE(allocator.IsEmpty());
+    EXPECT_EQ(stats.freeRegionsCount, 1u);
+    EXPECT_EQ(stats.largestFreeRegionSize, ALLOCATOR_SIZE);
+}
@@ -0,0 +1,209 @@
+#include "pch.h"
+
+// Frames are recorded by the headless backend, tests are compiled only when engine is built with it
+#if defined(ENG_GL_RECORDING_BACKEND)
+
+#include "render/render_system/render_system.h"
+#include "render/platform/OpenGL/opengl_recording_backend.h"
+
+#include "core/camera/camera_manager.h"
+#include "core/job_system/job_system.h"
+#include "core/window_system/window_system_events.h"
+
+#include "utils/file/async_file_reader.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+
+static constexpr int32_t TEST_FRAMEBUFFER_WIDTH = 1280;
+static constexpr int32_t TEST_FRAMEBUFFER_HEIGHT = 720;
+
+
+// Render system runs without a window, framebuffer size comes from the event the engine sends after init
+class RenderSystemRecordingTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        ASSERT_TRUE(engInitJobSystem());
+        ASSERT_TRUE(engInitAsyncFileReader());
+        ASSERT_TRUE(engInitCameraManager());
+        ASSERT_TRUE(engInitRenderSystem());
+
+        ASSERT_TRUE(engIsOpenGLRecordingBackendInstalled());
+
+        es::EventDispatcher::GetInstance().Notify<EventFramebufferResized>(TEST_FRAMEBUFFER_WIDTH, TEST_FRAMEBUFFER_HEIGHT);
+
+        // The first color pass creates the scene and doesn't draw
+        RecordFrame();
+        RenderSystem::GetInstance().EndFrame();
+    }
+
+
+    static void TearDownTestSuite()
+    {
+        engTerminateRenderSystem();
+        engTerminateCameraManager();
+        engTerminateAsyncFileReader();
+        engTerminateJobSystem();
+    }
+
+
+    // Leaves the frame open, so the command log holds only its commands until EndFrame()
+    static void RecordFrame() noexcept
+    {
+        CameraManager::GetInstance().Update(1.f);
+
+        RenderSystem& renderSystem = RenderSystem::GetInstance();
+
+        renderSystem.BeginFrame();
+        renderSystem.RunDepthPrepass();
+        renderSystem.RunGBufferPass();
+        renderSystem.RunColorPass();
+        renderSystem.RunPostprocessingPass();
+    }
+
+
+    static std::vector<OpenGLRecordedCommand> FindCommands(OpenGLCommandType type) noexcept
+    {
+        std::vector<OpenGLRecordedCommand> result;
+
+        const std::vector<OpenGLRecordedCommand>& commands = engGetOpenGLRecordedCommands();
+        std::copy_if(commands.cbegin(), commands.cend(), std::back_inserter(result), [type](const OpenGLRecordedCommand& command) {
+            return command.type == type;
+        });
+
+        return result;
+    }
+
+
+    static size_t FindFirstCommandIdx(OpenGLCommandType type) noexcept
+    {
+        const std::vector<OpenGLRecordedCommand>& commands = engGetOpenGLRecordedCommands();
+
+        const auto commandIt = std::find_if(commands.cbegin(), commands.cend(), [type](const OpenGLRecordedCommand& command) {
+            return command.type == type;
+        });
+
+        return static_cast<size_t>(std::distance(commands.cbegin(), commandIt));
+    }
+
+
+    void TearDown() override
+    {
+        RenderSystem::GetInstance().EndFrame();
+    }
+};
+
+
+TEST_F(RenderSystemRecordingTest, RecordsGBufferAndPostProcessDraws)
+{
+    RecordFrame();
+
+    const std::vector<OpenGLRecordedCommand>& commands = engGetOpenGLRecordedCommands();
+    const OpenGLRecordingStats& stats = engGetOpenGLRecordingStats();
+
+    ASSERT_FALSE(commands.empty());
+    EXPECT_EQ(stats.commandsCount, commands.size());
+
+    // The cube in front of the camera goes through the indirect GBuffer batch
+    const std::vector<OpenGLRecordedCommand> gBufferDraws = FindCommands(OpenGLCommandType::MULTI_DRAW_ELEMENTS_INDIRECT);
+    ASSERT_EQ(gBufferDraws.size(), 1u);
+
+    // The cube passed the frustum query of the scene BVH, its proxy is created once however many frames were recorded
+    EXPECT_EQ(RenderSystem::GetInstance().GetSceneBVH().GetProxiesCount(), 1u);
+
+    // Post process is a single fullscreen draw from the draw bucket
+    const std::vector<OpenGLRecordedCommand> postProcDraws = FindCommands(OpenGLCommandType::DRAW_ARRAYS_INSTANCED);
+    ASSERT_EQ(postProcDraws.size(), 1u);
+    EXPECT_EQ(postProcDraws[0].args[2], 6u);
+    EXPECT_EQ(postProcDraws[0].args[3], 1u);
+
+    EXPECT_EQ(stats.drawCallsCount, 2u);
+    EXPECT_LT(FindFirstCommandIdx(OpenGLCommandType::MULTI_DRAW_ELEMENTS_INDIRECT), FindFirstCommandIdx(OpenGLCommandType::DRAW_ARRAYS_INSTANCED));
+
+    EXPECT_EQ(commands.back().type, OpenGLCommandType::BLIT_NAMED_FRAMEBUFFER);
+}
+
+
+TEST_F(RenderSystemRecordingTest, ViewportFollowsFramebufferResize)
+{
+    constexpr int32_t RESIZED_WIDTH = 640;
+    constexpr int32_t RESIZED_HEIGHT = 360;
+
+    es::EventDispatcher& dispatcher = es::EventDispatcher::GetInstance();
+
+    dispatcher.Notify<EventFramebufferResized>(RESIZED_WIDTH, RESIZED_HEIGHT);
+    RecordFrame();
+
+    const std::vector<OpenGLRecordedCommand> viewports = FindCommands(OpenGLCommandType::VIEWPORT);
+    ASSERT_FALSE(viewports.empty());
+
+    EXPECT_EQ(viewports.back().args[0], 0u);
+    EXPECT_EQ(viewports.back().args[1], 0u);
+    EXPECT_EQ(viewports.back().args[2], uint64_t(RESIZED_WIDTH));
+    EXPECT_EQ(viewports.back().args[3], uint64_t(RESIZED_HEIGHT));
+
+    // Zero sized framebuffer of a minimized window keeps the last size
+    RenderSystem::GetInstance().EndFrame();
+    dispatcher.Notify<EventFramebufferResized>(0, 0);
+    RecordFrame();
+
+    EXPECT_EQ(FindCommands(OpenGLCommandType::VIEWPORT).back().args[2], uint64_t(RESIZED_WIDTH));
+
+    RenderSystem::GetInstance().EndFrame();
+    dispatcher.Notify<EventFramebufferResized>(TEST_FRAMEBUFFER_WIDTH, TEST_FRAMEBUFFER_HEIGHT);
+    RecordFrame();
+}
+
+
+TEST_F(RenderSystemRecordingTest, BuildsHiZFromPreviousFrameDepth)
+{
+    // Fences are signaled right away on the recording backend, so the second frame builds HiZ from the depth of the first one
+    RecordFrame();
+    RenderSystem::GetInstance().EndFrame();
+    RecordFrame();
+
+    ASSERT_EQ(FindCommands(OpenGLCommandType::GET_TEXTURE_IMAGE).size(), 1u);
+    EXPECT_LT(FindFirstCommandIdx(OpenGLCommandType::MULTI_DRAW_ELEMENTS_INDIRECT), FindFirstCommandIdx(OpenGLCommandType::GET_TEXTURE_IMAGE));
+
+    const HiZOcclusionCuller& occlusionCuller = RenderSystem::GetInstance().GetOcclusionCuller();
+    const HiZBuffer& hiZBuffer = occlusionCuller.GetHiZBuffer();
+
+    ASSERT_TRUE(hiZBuffer.IsValid());
+    EXPECT_EQ(hiZBuffer.GetDepthWidth(), uint32_t(TEST_FRAMEBUFFER_WIDTH));
+    EXPECT_EQ(hiZBuffer.GetDepthHeight(), uint32_t(TEST_FRAMEBUFFER_HEIGHT));
+    EXPECT_EQ(occlusionCuller.GetStats().hiZFrameLatency, 1u);
+    EXPECT_EQ(occlusionCuller.GetStats().readbacksCount, 1u);
+
+    // Readback buffers stay zeroed without GPU, which is the cleared far depth only with inverted Z
+#if defined(ENG_USE_INVERTED_Z)
+    EXPECT_EQ(hiZBuffer.GetStats().occludedCount, 0u);
+    EXPECT_EQ(FindCommands(OpenGLCommandType::MULTI_DRAW_ELEMENTS_INDIRECT).size(), 1u);
+#endif
+}
+
+
+TEST_F(RenderSystemRecordingTest, StatsMatchCommandLog)
+{
+    RecordFrame();
+
+    const std::vector<OpenGLRecordedCommand>& commands = engGetOpenGLRecordedCommands();
+    const OpenGLRecordingStats& stats = engGetOpenGLRecordingStats();
+
+    uint32_t countedCommandsCount = 0;
+
+    for (uint32_t typeIdx = 0; typeIdx < static_cast<uint32_t>(OpenGLCommandType::COUNT); ++typeIdx) {
+        const OpenGLCommandType type = static_cast<OpenGLCommandType>(typeIdx);
+
+        EXPECT_EQ(stats.commandCounts[typeIdx], FindCommands(type).size()) << engGetOpenGLCommandName(type);
+        countedCommandsCount += stats.commandCounts[typeIdx];
+    }
+
+    EXPECT_EQ(countedCommandsCount, commands.size());
+    EXPECT_LE(stats.redundantStateChangesCount, stats.stateChangesCount);
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "pch.h"
+
+#include "utils/data_structures/hash.h"
+
+#include <gtest/gtest.h>
+
+#include <bitset>
+#include <random>
+
+
+// Sizes around every internal boundary: short inputs, 16/128 byte thresholds, stripes and blocks of long inputs
+static constexpr size_t HASH_TEST_SIZES[] = { 0, 1, 3, 4, 8, 9, 16, 17, 33, 64, 127, 128, 129, 240, 1023, 1024, 1025, 4096, 65537 };
+
+
+TEST(HashMem, DoesntDependOnAlignment)
+{
+    std::vector<uint8_t> data(70'000 + 64);
+    std::mt19937 rng(3);
+
+    for (uint8_t& byte : data) {
+        byte = static_cast<uint8_t>(rng());
+    }
+
+    for (size_t size : HASH_TEST_SIZES) {
+        std::vector<uint8_t> aligned(data.begin(), data.begin() + size);
+        const uint64_t expectedHash = amHashMem(aligned.data(), size);
+
+        for (size_t offset = 1; offset < 64; offset += 7) {
+            std::memmove(data.data() + offset, aligned.data(), size);
+            ASSERT_EQ(amHashMem(data.data() + offset, size), expectedHash) << "size: " << size << " offset: " << offset;
+        }
+    }
+}
+
+
+TEST(HashMem, HasNoCollisionsOnStateLikeKeys)
+{
+    // Pipeline and sampler state blocks differ in a few fields, which is the worst case for weak hashes
+    struct StateKey
+    {
+        uint32_t values[12];
+    };
+
+    std::unordered_set<uint64_t> hashes;
+    StateKey key = {};
+
+    for (uint32_t i = 0; i < 200'000; ++i) {
+        key.values[0] = i & 0xF;
+        key.values[5] = (i >> 4) & 0xFF;
+        key.values[11] = i >> 12;
+
+        ASSERT_TRUE(hashes.emplace(amHashMem(&key, sizeof(key))).second) << "Collision at key " << i;
+    }
+}
+
+
+TEST(HashMem, AvalanchesSingleBitFlips)
+{
+    std::mt19937_64 rng(5);
+
+    for (size_t size : HASH_TEST_SIZES) {
+        if (size == 0) {
+            continue;
+        }
+
+        std::vector<uint8_t> data(size);
+
+        for (uint8_t& byte : data) {
+            byte = static_cast<uint8_t>(rng());
+        }
+
+        const uint64_t baseHash = amHashMem(data.data(), size);
+
+        uint64_t flippedBitsCount = 0;
+        const uint32_t samplesCount = 64;
+
+        for (uint32_t sample = 0; sample < samplesCount; ++sample) {
+            const size_t bitIdx = rng() % (size * 8);
+
+            data[bitIdx / 8] ^= static_cast<uint8_t>(1u << (bitIdx % 8));
+            flippedBitsCount += std::bitset<64>(amHashMem(data.data(), size) ^ baseHash).count();
+            data[bitIdx / 8] ^= static_cast<uint8_t>(1u << (bitIdx % 8));
+        }
+
+        // Ideal hash flips 32 of 64 bits on average
+        const double averageFlippedBits = double(flippedBitsCount) / samplesCount;
+        EXPECT_NEAR(averageFlippedBits, 32.0, 4.0) << "size: " << size;
+    }
+}
@@ -0,0 +1,52 @@
+#include "pch.h"
+
+#include "utils/data_structures/inline_function.h"
+
+#include <gtest/gtest.h>
+
+
+TEST(InlineFunction, CallsTriviallyCopyableCallable)
+{
+    int value = 0;
+
+    ds::InlineFunction<void(int)> func = [&value](int x) { value += x; };
+    ds::InlineFunction<void(int)> copy = func;
+
+    func(1);
+    copy(2);
+
+    EXPECT_EQ(value, 3);
+}
+
+
+TEST(InlineFunction, CopiesAndDestroysNonTrivialCallable)
+{
+    std::shared_ptr<int> pValue = std::make_shared<int>(0);
+
+    {
+        ds::InlineFunction<int()> func = [pValue]() { return ++(*pValue); };
+        ds::InlineFunction<int()> copy = func;
+
+        EXPECT_EQ(pValue.use_count(), 3);
+        EXPECT_EQ(func(), 1);
+        EXPECT_EQ(copy(), 2);
+
+        func.Reset();
+        EXPECT_EQ(pValue.use_count(), 2);
+    }
+
+    EXPECT_EQ(pValue.use_count(), 1);
+}
+
+
+TEST(InlineFunction, MovesMoveOnlyCallable)
+{
+    std::unique_ptr<int> pValue = std::make_unique<int>(5);
+
+    ds::InlineFunction<int()> func = [pValue = std::move(pValue)]() { return *pValue; };
+    ds::InlineFunction<int()> moved = std::move(func);
+
+    EXPECT_FALSE(func);
+    ASSERT_TRUE(moved);
+    EXPECT_EQ(moved(), 5);
+}
@@ -0,0 +1,120 @@
+#include "pch.h"
+
+#include "utils/data_structures/strid.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+
+// Names shaped like the engine's resource keys: textures, meshes, shader defines, pipelines, asset paths
+static std::vector<std::string> GenerateStrIDCorpus(const char* pTag, uint32_t countPerPattern) noexcept
+{
+    static const char* PATTERNS[] = {
+        "%s_TEXTURE_%u",
+        "%s/meshes/props/rock_%u.obj",
+        "%s_PASS_GBUFFER_DEFINE_%u",
+        "%s_pipeline_%u_opaque",
+        "%s%u",
+    };
+
+    std::vector<std::string> corpus;
+    corpus.reserve(countPerPattern * std::size(PATTERNS));
+
+    char buffer[128];
+
+    for (const char* pPattern : PATTERNS) {
+        for (uint32_t i = 0; i < countPerPattern; ++i) {
+            snprintf(buffer, sizeof(buffer), pPattern, pTag, i);
+            corpus.emplace_back(buffer);
+        }
+    }
+
+    return corpus;
+}
+
+
+TEST(StrID, LiteralHashMatchesRuntimeHash)
+{
+    static_assert("cube"_sid.Hash() == amHashStr("cube", 4), "_sid must be evaluated at compile time");
+
+    constexpr ds::StrIDLiteral LITERALS[] = { ""_sid, "cube"_sid, "TEST_TEXTURE"_sid, "GBUFFER_ALBEDO_TEX"_sid, "__CONST_RING_BUFFER__"_sid };
+
+    for (const ds::StrIDLiteral& literal : LITERALS) {
+        const std::string str(literal.GetStr());
+
+        EXPECT_EQ(ds::StrID(str).GetId(), literal.GetId()) << str;
+        EXPECT_EQ(ds::StrID(literal).GetId(), literal.GetId()) << str;
+        EXPECT_EQ(amHashStr(str.data(), str.size()), literal.GetId()) << str;
+        EXPECT_STREQ(ds::StrID(literal).CStr(), str.c_str());
+    }
+
+    EXPECT_EQ(ds::WStrID(L"cube").GetId(), (L"cube"_sid).GetId());
+}
+
+
+TEST(StrID, DistinctStringsGetDistinctIDs)
+{
+    const std::vector<std::string> corpus = GenerateStrIDCorpus("collision", 100'000);
+
+    std::unordered_map<uint64_t, const std::string*> idToStr;
+    idToStr.reserve(corpus.size());
+
+    for (const std::string& str : corpus) {
+        const ds::StrID strID(str);
+
+        const auto [it, isInserted] = idToStr.emplace(strID.GetId(), &str);
+        ASSERT_TRUE(isInserted) << "\'" << str << "\' collides with \'" << *it->second << "\'";
+
+        // A colliding string would be resolved to the string stored first
+        ASSERT_STREQ(strID.CStr(), str.c_str());
+    }
+
+    // Interning again returns the same IDs and the same stable pointers
+    for (const std::string& str : corpus) {
+        const ds::StrID strID(str);
+        const ds::StrID sameStrID { std::string_view(str) };
+
+        ASSERT_EQ(strID, sameStrID);
+        ASSERT_EQ(strID.CStr(), sameStrID.CStr());
+    }
+}
+
+
+TEST(StrID, InternsConcurrently)
+{
+    constexpr uint32_t THREADS_COUNT = 8;
+
+    // Threads intern overlapping halves of the corpus, so the same strings are inserted concurrently
+    const std::vector<std::string> corpus = GenerateStrIDCorpus("concurrent", 20'000);
+    std::vector<std::vector<const char*>> threadPointers(THREADS_COUNT);
+
+    std::vector<std::thread> threads;
+
+    for (uint32_t threadIdx = 0; threadIdx < THREADS_COUNT; ++threadIdx) {
+        threads.emplace_back([&corpus, &pointers = threadPointers[threadIdx], threadIdx]() {
+            pointers.resize(corpus.size(), nullptr);
+
+            const size_t first = threadIdx % 2 == 0 ? 0 : corpus.size() / 2;
+
+            for (size_t i = 0; i < corpus.size(); ++i) {
+                const size_t idx = (first + i) % corpus.size();
+                pointers[idx] = ds::StrID(corpus[idx]).CStr();
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (size_t i = 0; i < corpus.size(); ++i) {
+        const char* pStr = threadPointers[0][i];
+
+        ASSERT_STREQ(pStr, corpus[i].c_str());
+
+        for (uint32_t threadIdx = 1; threadIdx < THREADS_COUNT; ++threadIdx) {
+            ASSERT_EQ(threadPointers[threadIdx][i], pStr) << "Each string must be stored once";
+        }
+    }
+}
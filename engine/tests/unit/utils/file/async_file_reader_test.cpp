@@ -0,0 +1,131 @@
+#include "pch.h"
+
+#include "utils/file/async_file_reader.h"
+
+#include <gtest/gtest.h>
+
+
+class AsyncFileReaderTest : public ::testing::Test
+{
+protected:
+    static void SetUpTestSuite()
+    {
+        ASSERT_TRUE(engInitAsyncFileReader());
+    }
+
+
+    static void TearDownTestSuite()
+    {
+        engTerminateAsyncFileReader();
+    }
+
+
+    // Content depends on the file size, so a chunk read into a wrong offset is detected
+    static std::vector<uint8_t> MakeFileData(size_t size) noexcept
+    {
+        std::vector<uint8_t> data(size);
+
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<uint8_t>((i * 131 + size) >> 3);
+        }
+
+        return data;
+    }
+
+
+    static fs::path WriteTestFile(const std::string& name, const std::vector<uint8_t>& data) noexcept
+    {
+        const fs::path dirPath = fs::temp_directory_path() / "engine_test_files";
+
+        std::error_code error;
+        fs::create_directories(dirPath, error);
+
+        const fs::path filepath = dirPath / name;
+
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+        return filepath;
+    }
+};
+
+
+TEST_F(AsyncFileReaderTest, ReadsFilesOfAnySize)
+{
+    // Empty, single page, not page aligned and several read chunks with a partial last one
+    constexpr size_t FILE_SIZES[] = { 0, 4096, 12'345, 3 * 1024 * 1024 + 17 };
+
+    std::vector<std::vector<uint8_t>> expectedDatas;
+    std::vector<FileReadResult> results(std::size(FILE_SIZES));
+
+    for (size_t i = 0; i < std::size(FILE_SIZES); ++i) {
+        expectedDatas.emplace_back(MakeFileData(FILE_SIZES[i]));
+
+        const fs::path filepath = WriteTestFile("async_read_" + std::to_string(i) + ".bin", expectedDatas.back());
+
+        AsyncFileReader::GetInstance().ReadAsync(filepath, [&results, i](FileReadResult& result) {
+            results[i] = std::move(result);
+        });
+    }
+
+    AsyncFileReader::GetInstance().WaitAll();
+
+    for (size_t i = 0; i < std::size(FILE_SIZES); ++i) {
+        const FileReadResult& result = results[i];
+
+        ASSERT_TRUE(result.isSucceeded) << result.filepath;
+        ASSERT_EQ(result.dataSize, FILE_SIZES[i]);
+
+        if (result.dataSize > 0) {
+            EXPECT_EQ(std::memcmp(result.pData.get(), expectedDatas[i].data(), result.dataSize), 0) << result.filepath;
+        }
+    }
+}
+
+
+TEST_F(AsyncFileReaderTest, FailsOnMissingFile)
+{
+    const fs::path validFilepath = WriteTestFile("async_read_valid.bin", MakeFileData(100));
+    const fs::path missingFilepath = fs::temp_directory_path() / "engine_test_files" / "async_read_missing.bin";
+
+    bool isValidSucceeded = false;
+    bool isMissingSucceeded = true;
+
+    // A failed request in the same batch must not affect the others
+    AsyncFileReader::GetInstance().ReadAsync(missingFilepath, [&isMissingSucceeded](FileReadResult& result) {
+        isMissingSucceeded = result.isSucceeded;
+    });
+
+    AsyncFileReader::GetInstance().ReadAsync(validFilepath, [&isValidSucceeded](FileReadResult& result) {
+        isValidSucceeded = result.isSucceeded && result.dataSize == 100;
+    });
+
+    AsyncFileReader::GetInstance().WaitAll();
+
+    EXPECT_FALSE(isMissingSucceeded);
+    EXPECT_TRUE(isValidSucceeded);
+    EXPECT_EQ(AsyncFileReader::GetInstance().GetPendingRequestsCount(), 0u);
+}
+
+
+TEST_F(AsyncFileReaderTest, CompletesManyRequests)
+{
+    // More requests than fit into one batch or one ring
+    constexpr uint32_t REQUESTS_COUNT = 300;
+
+    const fs::path filepath = WriteTestFile("async_read_many.bin", MakeFileData(8192));
+
+    uint32_t succeededCount = 0;
+
+    for (uint32_t i = 0; i < REQUESTS_COUNT; ++i) {
+        const FileReadPriority priority = static_cast<FileReadPriority>(i % static_cast<uint32_t>(FileReadPriority::COUNT));
+
+        AsyncFileReader::GetInstance().ReadAsync(filepath, [&succeededCount](FileReadResult& result) {
+            succeededCount += result.isSucceeded && result.dataSize == 8192 ? 1 : 0;
+        }, priority);
+    }
+
+    AsyncFileReader::GetInstance().WaitAll();
+
+    EXPECT_EQ(succeededCount, REQUESTS_COUNT);
+}
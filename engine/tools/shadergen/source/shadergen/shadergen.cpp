@@ -305,7 +305,7 @@ static void PushSrvTextureDeclToStream(std::stringstream& ss, const char* pFileC
 
 static std::vector<std::cmatch> FindConstBufferDeclMatches(const char* pFileContent, size_t fileSize) noexcept
 {
-    static std::regex CB_PATTERN(R"(DECLARE_CBV\(([^,]+), ([^,]+)\)\s*\{\s*([^{}]+)\s*\})");
+    static std::regex CB_PATTERN(R"(DECLARE_CBV\(([^,()]+), ([^,()]+)\)\s*\{\s*([^{}]+)\s*\})");
     
     return FindPatternMatches(CB_PATTERN, pFileContent, fileSize);
 }
@@ -319,6 +319,36 @@ static std::vector<std::cmatch> FindConstBufferMembersDeclMatches(const char* pC
 }
 
 
+static void PushStructMembersDeclToStream(std::stringstream& ss, const std::string& structName, const std::string& content) noexcept
+{
+    const std::vector<std::cmatch> membersMatches = FindConstBufferMembersDeclMatches(content.c_str(), content.size());
+
+    if (!membersMatches.empty()) {
+        ss << '\n';
+    }
+
+    for (const std::cmatch& memberMatch : membersMatches) {
+        const std::string type = memberMatch[1].str();   
+        const std::string varName = memberMatch[2].str();
+        
+        const char* pType = TranslateGLSLToEngineConstantPrimitiveType(type);
+        if (!pType) {
+            SH_LOG_ERROR("Unknown {} variable {} type: {}", structName.c_str(), varName.c_str(), type.c_str());
+            continue;
+        }
+
+        ss << "    " << pType << ' ' << varName;
+
+        const std::string memberArrayCapture = memberMatch[3].str();
+        if (!memberArrayCapture.empty()) {
+            ss << memberArrayCapture;
+        }
+
+        ss << ";\n";
+    }
+}
+
+
 static void PushConstBufferDeclToStream(std::stringstream& ss, const char* pFileContent, size_t fileSize) noexcept
 {
     const std::vector<std::cmatch> constBuffDeclMatches = FindConstBufferDeclMatches(pFileContent, fileSize);
@@ -328,41 +358,77 @@ static void PushConstBufferDeclToStream(std::stringstream& ss, const char* pFile
         const std::string binding = cbMatch[2].str();
         const std::string content = cbMatch[3].str();
 
-        const std::vector<std::cmatch> constBuffContentsMatches = FindConstBufferMembersDeclMatches(content.c_str(), content.size());
-        
         ss <<
         "struct " << constBufferName << " {\n"
         "    inline static constexpr ShaderResourceBindStruct<ShaderResourceType::TYPE_CONST_BUFFER>" << "_BINDING = { -1, " << binding << " };\n";
         
-        if (!constBuffContentsMatches.empty()) {
-            ss << '\n';
-        }
+        PushStructMembersDeclToStream(ss, constBufferName, content);
 
-        for (const std::cmatch& memberMatch : constBuffContentsMatches) {
-            const std::string type = memberMatch[1].str();   
-            const std::string varName = memberMatch[2].str();
-            
-            const char* pType = TranslateGLSLToEngineConstantPrimitiveType(type);
-            if (!pType) {
-                SH_LOG_ERROR("Unknown const buffer {} variable {} type: {}", constBufferName.c_str(), varName.c_str(), type.c_str());
-                continue;
-            }
+        ss << "};\n"
+        "\n";
+    }
 
-            ss << "    " << pType << ' ' << varName;
+    if (!constBuffDeclMatches.empty()) {
+        ss << '\n';
+    }
+}
 
-            const std::string memberArrayCapture = memberMatch[3].str();
-            if (!memberArrayCapture.empty()) {
-                ss << memberArrayCapture;
-            }
 
-            ss << ";\n";
-        }
+static std::vector<std::cmatch> FindStructDeclMatches(const char* pFileContent, size_t fileSize) noexcept
+{
+    static std::regex STRUCT_PATTERN(R"(DECLARE_STRUCT\(([^,()]+)\)\s*\{\s*([^{}]+)\s*\})");
+    
+    return FindPatternMatches(STRUCT_PATTERN, pFileContent, fileSize);
+}
+
+
+static void PushStructDeclToStream(std::stringstream& ss, const char* pFileContent, size_t fileSize) noexcept
+{
+    const std::vector<std::cmatch> structDeclMatches = FindStructDeclMatches(pFileContent, fileSize);
+
+    for (const std::cmatch& structMatch : structDeclMatches) {
+        const std::string structName = structMatch[1].str();
+        const std::string content = structMatch[2].str();
+
+        ss << "struct " << structName << " {";
+        
+        PushStructMembersDeclToStream(ss, structName, content);
 
         ss << "};\n"
         "\n";
     }
 
-    if (!constBuffDeclMatches.empty()) {
+    if (!structDeclMatches.empty()) {
+        ss << '\n';
+    }
+}
+
+
+static std::vector<std::cmatch> FindUnorderedAccessBufferDeclMatches(const char* pFileContent, size_t fileSize) noexcept
+{
+    static std::regex UAV_PATTERN(R"(DECLARE_UAV\(([^,()]+), ([^,()]+)\))");
+    
+    return FindPatternMatches(UAV_PATTERN, pFileContent, fileSize);
+}
+
+
+// Storage buffer contents are usually runtime sized arrays of DECLARE_STRUCT types, so only the binding is reflected
+static void PushUnorderedAccessBufferDeclToStream(std::stringstream& ss, const char* pFileContent, size_t fileSize) noexcept
+{
+    const std::vector<std::cmatch> uavDeclMatches = FindUnorderedAccessBufferDeclMatches(pFileContent, fileSize);
+
+    for (const std::cmatch& uavMatch : uavDeclMatches) {
+        const std::string bufferName = uavMatch[1].str();
+        const std::string binding = uavMatch[2].str();
+
+        ss <<
+        "struct " << bufferName << " {\n"
+        "    inline static constexpr ShaderResourceBindStruct<ShaderResourceType::TYPE_UNORDERED_ACCESS_BUFFER>" << "_BINDING = { -1, " << binding << " };\n"
+        "};\n"
+        "\n";
+    }
+
+    if (!uavDeclMatches.empty()) {
         ss << '\n';
     }
 }
@@ -506,6 +572,8 @@ void ShaderGen::Generate(const fs::path& inputFilePath, const fs::path& outputFi
     PushSrvVarsDeclToStream(ss, inputText.c_str(), inputText.length() + 1);
     PushSrvTextureDeclToStream(ss, inputText.c_str(), inputText.length() + 1);
     PushConstBufferDeclToStream(ss, inputText.c_str(), inputText.length() + 1);
+    PushStructDeclToStream(ss, inputText.c_str(), inputText.length() + 1);
+    PushUnorderedAccessBufferDeclToStream(ss, inputText.c_str(), inputText.length() + 1);
 
     ss << '\n';
 